@@ -0,0 +1,375 @@
+#ifndef CYON_CORE_RUNTIME_COREITER_H
+#define CYON_CORE_RUNTIME_COREITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Lazy iterator pipelines.
+   Every stage is a small struct the caller places on the stack; adapters hold a
+   pointer to their source and pull one element at a time, so a whole chain runs
+   as a single pass driven by the terminal reducer:
+
+       cyon_range_iter_t r; cyon_filter_iter_t f; cyon_map_iter_t m;
+       int64_t s = cyon_iter_sum(cyon_iter_map(&m,
+                       cyon_iter_filter(&f, cyon_iter_range(&r, 0, n, 1), is_even, NULL),
+                       square, NULL));
+
+   Adapters copy their source's next() at construction and reducers hoist the
+   head's next() out of the loop, which lets the optimizer turn the chained
+   calls into direct calls when the pipeline is built and
+   consumed in one function. No stage allocates and no intermediate arrays are built. */
+
+typedef struct {
+    int64_t start;
+    int64_t stop;
+    int64_t step;
+    int64_t current;
+    bool finished;
+} cyon_range_t;
+
+/* Initialize a caller-owned range (stack alternative to cyon_range_new).
+   Returns false when step is zero. */
+static inline bool cyon_range_init(cyon_range_t *r, int64_t start, int64_t stop, int64_t step) {
+    if (!r || step == 0) return false;
+    r->start = start;
+    r->stop = stop;
+    r->step = step;
+    r->current = start;
+    r->finished = false;
+    return true;
+}
+
+/* One element flowing through a pipeline.
+   key carries the enumerate index, the zip partner or the chunk index. */
+typedef struct {
+    int64_t value;
+    int64_t key;
+} cyon_iter_item_t;
+
+typedef struct cyon_iter_s cyon_iter_t;
+typedef bool (*cyon_iter_next_fn)(cyon_iter_t *it, cyon_iter_item_t *out);
+
+/* Protocol: every stage starts with this header. */
+struct cyon_iter_s {
+    cyon_iter_next_fn next;
+};
+
+typedef int64_t (*cyon_iter_map_fn)(int64_t value, void *user);
+typedef bool (*cyon_iter_pred_fn)(int64_t value, void *user);
+typedef int64_t (*cyon_iter_fold_fn)(int64_t acc, int64_t value, void *user);
+
+static inline bool cyon_iter_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    return it->next(it, out);
+}
+
+/* ---- sources ---- */
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_range_t range;
+} cyon_range_iter_t;
+
+static inline bool cyon_iter__range_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_range_t *r = &((cyon_range_iter_t*)it)->range;
+    if (r->finished) return false;
+    if (r->step > 0 ? r->current >= r->stop : r->current <= r->stop) {
+        r->finished = true;
+        return false;
+    }
+    out->value = r->current;
+    out->key = 0;
+    r->current += r->step;
+    return true;
+}
+
+/* Iterate [start, stop) by step. A zero step yields an empty iterator. */
+static inline cyon_iter_t *cyon_iter_range(cyon_range_iter_t *st, int64_t start, int64_t stop, int64_t step) {
+    st->base.next = cyon_iter__range_next;
+    if (!cyon_range_init(&st->range, start, stop, step)) {
+        cyon_range_init(&st->range, 0, 0, 1);
+        st->range.finished = true;
+    }
+    return &st->base;
+}
+
+/* Iterate over an existing range from its current position. The range is copied. */
+static inline cyon_iter_t *cyon_iter_from_range(cyon_range_iter_t *st, const cyon_range_t *r) {
+    st->base.next = cyon_iter__range_next;
+    st->range = *r;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    const int64_t *data;
+    size_t len;
+    size_t pos;
+} cyon_array_iter_t;
+
+static inline bool cyon_iter__array_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_array_iter_t *a = (cyon_array_iter_t*)it;
+    if (a->pos >= a->len) return false;
+    out->value = a->data[a->pos++];
+    out->key = 0;
+    return true;
+}
+
+/* Iterate over a borrowed int64 array. */
+static inline cyon_iter_t *cyon_iter_array(cyon_array_iter_t *st, const int64_t *data, size_t len) {
+    st->base.next = cyon_iter__array_next;
+    st->data = data;
+    st->len = data ? len : 0;
+    st->pos = 0;
+    return &st->base;
+}
+
+/* ---- adapters ---- */
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *src;
+    cyon_iter_next_fn src_next;
+    cyon_iter_map_fn fn;
+    void *user;
+} cyon_map_iter_t;
+
+static inline bool cyon_iter__map_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_map_iter_t *m = (cyon_map_iter_t*)it;
+    if (!m->src_next(m->src, out)) return false;
+    out->value = m->fn(out->value, m->user);
+    return true;
+}
+
+static inline cyon_iter_t *cyon_iter_map(cyon_map_iter_t *st, cyon_iter_t *src, cyon_iter_map_fn fn, void *user) {
+    st->base.next = cyon_iter__map_next;
+    st->src = src;
+    st->src_next = src->next;
+    st->fn = fn;
+    st->user = user;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *src;
+    cyon_iter_next_fn src_next;
+    cyon_iter_pred_fn pred;
+    void *user;
+} cyon_filter_iter_t;
+
+static inline bool cyon_iter__filter_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_filter_iter_t *f = (cyon_filter_iter_t*)it;
+    while (f->src_next(f->src, out)) {
+        if (f->pred(out->value, f->user)) return true;
+    }
+    return false;
+}
+
+static inline cyon_iter_t *cyon_iter_filter(cyon_filter_iter_t *st, cyon_iter_t *src, cyon_iter_pred_fn pred, void *user) {
+    st->base.next = cyon_iter__filter_next;
+    st->src = src;
+    st->src_next = src->next;
+    st->pred = pred;
+    st->user = user;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *src;
+    cyon_iter_next_fn src_next;
+    size_t remaining;
+} cyon_take_iter_t;
+
+static inline bool cyon_iter__take_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_take_iter_t *t = (cyon_take_iter_t*)it;
+    if (t->remaining == 0) return false;
+    if (!t->src_next(t->src, out)) {
+        t->remaining = 0;
+        return false;
+    }
+    t->remaining--;
+    return true;
+}
+
+/* Yield at most n elements; the source is not pulled past the limit. */
+static inline cyon_iter_t *cyon_iter_take(cyon_take_iter_t *st, cyon_iter_t *src, size_t n) {
+    st->base.next = cyon_iter__take_next;
+    st->src = src;
+    st->src_next = src->next;
+    st->remaining = n;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *a;
+    cyon_iter_next_fn a_next;
+    cyon_iter_t *b;
+    cyon_iter_next_fn b_next;
+} cyon_zip_iter_t;
+
+static inline bool cyon_iter__zip_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_zip_iter_t *z = (cyon_zip_iter_t*)it;
+    cyon_iter_item_t rhs;
+    if (!z->a_next(z->a, out)) return false;
+    if (!z->b_next(z->b, &rhs)) return false;
+    out->key = rhs.value;
+    return true;
+}
+
+/* Pair elements of a and b: value comes from a, key from b. Stops at the shorter side. */
+static inline cyon_iter_t *cyon_iter_zip(cyon_zip_iter_t *st, cyon_iter_t *a, cyon_iter_t *b) {
+    st->base.next = cyon_iter__zip_next;
+    st->a = a;
+    st->a_next = a->next;
+    st->b = b;
+    st->b_next = b->next;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *src;
+    cyon_iter_next_fn src_next;
+    int64_t index;
+} cyon_enumerate_iter_t;
+
+static inline bool cyon_iter__enumerate_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_enumerate_iter_t *e = (cyon_enumerate_iter_t*)it;
+    if (!e->src_next(e->src, out)) return false;
+    out->key = e->index++;
+    return true;
+}
+
+/* Attach a zero-based position to every element (in key). */
+static inline cyon_iter_t *cyon_iter_enumerate(cyon_enumerate_iter_t *st, cyon_iter_t *src) {
+    st->base.next = cyon_iter__enumerate_next;
+    st->src = src;
+    st->src_next = src->next;
+    st->index = 0;
+    return &st->base;
+}
+
+typedef struct {
+    cyon_iter_t base;
+    cyon_iter_t *src;
+    cyon_iter_next_fn src_next;
+    int64_t *buf;
+    size_t cap;
+    size_t len;
+    int64_t index;
+} cyon_chunk_iter_t;
+
+static inline bool cyon_iter__chunk_next(cyon_iter_t *it, cyon_iter_item_t *out) {
+    cyon_chunk_iter_t *c = (cyon_chunk_iter_t*)it;
+    cyon_iter_item_t tmp;
+    c->len = 0;
+    while (c->len < c->cap && c->src_next(c->src, &tmp)) c->buf[c->len++] = tmp.value;
+    if (c->len == 0) return false;
+    out->value = (int64_t)c->len;
+    out->key = c->index++;
+    return true;
+}
+
+/* Group elements into runs of up to cap values stored in the caller's buf.
+   Each step yields the run length in value and the chunk index in key; the
+   elements are valid in st->buf until the next pull. */
+static inline cyon_iter_t *cyon_iter_chunk(cyon_chunk_iter_t *st, cyon_iter_t *src, int64_t *buf, size_t cap) {
+    st->base.next = cyon_iter__chunk_next;
+    st->src = src;
+    st->src_next = src->next;
+    st->buf = buf;
+    st->cap = buf ? cap : 0;
+    st->len = 0;
+    st->index = 0;
+    return &st->base;
+}
+
+/* ---- terminal reducers ---- */
+
+static inline int64_t cyon_iter_sum(cyon_iter_t *it) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    int64_t s = 0;
+    while (nx(it, &x)) s += x.value;
+    return s;
+}
+
+static inline size_t cyon_iter_count(cyon_iter_t *it) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    size_t n = 0;
+    while (nx(it, &x)) n++;
+    return n;
+}
+
+static inline int64_t cyon_iter_fold(cyon_iter_t *it, int64_t init, cyon_iter_fold_fn fn, void *user) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    int64_t acc = init;
+    while (nx(it, &x)) acc = fn(acc, x.value, user);
+    return acc;
+}
+
+/* Min/max: return false for an empty iterator, leaving *out untouched. */
+static inline bool cyon_iter_min(cyon_iter_t *it, int64_t *out) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    if (!nx(it, &x)) return false;
+    int64_t m = x.value;
+    while (nx(it, &x)) if (x.value < m) m = x.value;
+    if (out) *out = m;
+    return true;
+}
+
+static inline bool cyon_iter_max(cyon_iter_t *it, int64_t *out) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    if (!nx(it, &x)) return false;
+    int64_t m = x.value;
+    while (nx(it, &x)) if (x.value > m) m = x.value;
+    if (out) *out = m;
+    return true;
+}
+
+/* Short-circuiting predicates. */
+static inline bool cyon_iter_any(cyon_iter_t *it, cyon_iter_pred_fn pred, void *user) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    while (nx(it, &x)) if (pred(x.value, user)) return true;
+    return false;
+}
+
+static inline bool cyon_iter_all(cyon_iter_t *it, cyon_iter_pred_fn pred, void *user) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    while (nx(it, &x)) if (!pred(x.value, user)) return false;
+    return true;
+}
+
+/* Copy up to cap values into out; returns the number written. */
+static inline size_t cyon_iter_collect(cyon_iter_t *it, int64_t *out, size_t cap) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    size_t n = 0;
+    while (n < cap && nx(it, &x)) out[n++] = x.value;
+    return n;
+}
+
+static inline void cyon_iter_for_each(cyon_iter_t *it, void (*body)(const cyon_iter_item_t *item, void *user), void *user) {
+    cyon_iter_item_t x;
+    cyon_iter_next_fn nx = it->next;
+    while (nx(it, &x)) body(&x, user);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_COREITER_H */
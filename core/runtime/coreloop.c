@@ -1,9 +1,23 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "coreiter.h"
+#include "coreloop.h"
+#include "coremetrics.h"
 
 /* Configuration */
 #ifndef CYON_LOOP_MAX_DEPTH
@@ -26,6 +40,10 @@ typedef struct {
     int depth;
 } cyon_loop_state_t;
 
+void cyon_loop_stats_add(uint64_t iterations);
+void cyon_loop_stats_break_hit(void);
+void cyon_loop_stats_continue_hit(void);
+
 static cyon_loop_state_t g_loop_state = { {CYON_LOOP_NORMAL}, 0 };
 
 /* Push new loop level */
@@ -80,23 +98,11 @@ void cyon_loop_clear_flags(void) {
     }
 }
 
-typedef struct {
-    int64_t start;
-    int64_t stop;
-    int64_t step;
-    int64_t current;
-    bool finished;
-} cyon_range_t;
-
 cyon_range_t *cyon_range_new(int64_t start, int64_t stop, int64_t step) {
     if (step == 0) return NULL;
     cyon_range_t *r = (cyon_range_t*)malloc(sizeof(cyon_range_t));
     if (!r) return NULL;
-    r->start = start;
-    r->stop = stop;
-    r->step = step;
-    r->current = start;
-    r->finished = false;
+    cyon_range_init(r, start, stop, step);
     return r;
 }
 
@@ -134,99 +140,131 @@ void cyon_for_loop_i64(int64_t start, int64_t end, int64_t step,
                        void (*body)(int64_t, void*), void *userdata) {
     if (!body || step == 0) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_for_loop_i64");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     if (step > 0) {
         for (int64_t i = start; i < end; i += step) {
-            if (cyon_loop_should_break()) break;
+            if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
             if (cyon_loop_should_continue()) {
+                cyon_loop_stats_continue_hit();
                 cyon_loop_clear_flags();
                 continue;
             }
             body(i, userdata);
+            trips++;
         }
     } else {
         for (int64_t i = start; i > end; i += step) {
-            if (cyon_loop_should_break()) break;
+            if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
             if (cyon_loop_should_continue()) {
+                cyon_loop_stats_continue_hit();
                 cyon_loop_clear_flags();
                 continue;
             }
             body(i, userdata);
+            trips++;
         }
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_while_loop(bool (*condition)(void*), void (*body)(void*), void *userdata) {
     if (!condition || !body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_while_loop");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     while (condition(userdata)) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(userdata);
+        trips++;
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_do_while_loop(bool (*condition)(void*), void (*body)(void*), void *userdata) {
     if (!condition || !body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_do_while_loop");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     do {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(userdata);
+        trips++;
     } while (condition(userdata));
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_foreach_i64(const int64_t *arr, size_t len,
                       void (*body)(int64_t, void*), void *userdata) {
     if (!arr || !body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_foreach_i64");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     for (size_t i = 0; i < len; i++) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(arr[i], userdata);
+        trips++;
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_foreach_str(const char **arr, size_t len,
                       void (*body)(const char*, void*), void *userdata) {
     if (!arr || !body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_foreach_str");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     for (size_t i = 0; i < len; i++) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(arr[i], userdata);
+        trips++;
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 typedef struct {
@@ -248,61 +286,80 @@ void cyon_nested_loop_2d(int64_t rows, int64_t cols,
                          void *userdata) {
     if (!body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_nested_loop_2d");
+    uint64_t trips = 0;
     cyon_loop_enter();
     for (int64_t i = 0; i < rows; i++) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         
         cyon_loop_enter();
         for (int64_t j = 0; j < cols; j++) {
-            if (cyon_loop_should_break()) break;
+            if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
             if (cyon_loop_should_continue()) {
+                cyon_loop_stats_continue_hit();
                 cyon_loop_clear_flags();
                 continue;
             }
             body(i, j, userdata);
+            trips++;
         }
         cyon_loop_exit();
         
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
     }
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_infinite_loop(void (*body)(void*), void *userdata) {
     if (!body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_infinite_loop");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     while (true) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(userdata);
+        trips++;
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 void cyon_repeat(size_t times, void (*body)(size_t, void*), void *userdata) {
     if (!body) return;
     
+    CYON_LOOP_PROFILE_BEGIN(probe, "cyon_repeat");
+    uint64_t trips = 0;
     cyon_loop_enter();
     
     for (size_t i = 0; i < times; i++) {
-        if (cyon_loop_should_break()) break;
+        if (cyon_loop_should_break()) { cyon_loop_stats_break_hit(); break; }
         if (cyon_loop_should_continue()) {
+            cyon_loop_stats_continue_hit();
             cyon_loop_clear_flags();
             continue;
         }
         body(i, userdata);
+        trips++;
     }
     
     cyon_loop_exit();
+    cyon_loop_stats_add(trips);
+    CYON_LOOP_PROFILE_END(probe, trips);
 }
 
 typedef struct {
@@ -311,38 +368,344 @@ typedef struct {
     uint64_t continues_hit;
 } cyon_loop_stats_t;
 
-static cyon_loop_stats_t g_loop_stats = {0, 0, 0};
+/* Loop statistics are sharded runtime counters (see coremetrics.h), so
+   helpers running on several threads never share a cache line. */
+static cyon_metric_id g_loop_iterations_id;
+static cyon_metric_id g_loop_breaks_id;
+static cyon_metric_id g_loop_continues_id;
+static pthread_once_t g_loop_stats_once = PTHREAD_ONCE_INIT;
+
+static void cyon_loop_stats_init(void) {
+    g_loop_iterations_id = cyon_metric_register("loop.iterations", CYON_METRIC_COUNTER);
+    g_loop_breaks_id = cyon_metric_register("loop.breaks", CYON_METRIC_COUNTER);
+    g_loop_continues_id = cyon_metric_register("loop.continues", CYON_METRIC_COUNTER);
+}
 
 void cyon_loop_stats_reset(void) {
-    memset(&g_loop_stats, 0, sizeof(g_loop_stats));
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_metric_reset(g_loop_iterations_id);
+    cyon_metric_reset(g_loop_breaks_id);
+    cyon_metric_reset(g_loop_continues_id);
 }
 
 void cyon_loop_stats_increment(void) {
-    g_loop_stats.total_iterations++;
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_counter_add(g_loop_iterations_id, 1);
+}
+
+/* Helpers count trips locally and publish them once per loop. */
+void cyon_loop_stats_add(uint64_t iterations) {
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_counter_add(g_loop_iterations_id, iterations);
 }
 
 void cyon_loop_stats_break_hit(void) {
-    g_loop_stats.breaks_hit++;
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_counter_add(g_loop_breaks_id, 1);
 }
 
 void cyon_loop_stats_continue_hit(void) {
-    g_loop_stats.continues_hit++;
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_counter_add(g_loop_continues_id, 1);
 }
 
 cyon_loop_stats_t cyon_loop_stats_get(void) {
-    return g_loop_stats;
+    pthread_once(&g_loop_stats_once, cyon_loop_stats_init);
+    cyon_loop_stats_t st;
+    st.total_iterations = cyon_counter_read(g_loop_iterations_id);
+    st.breaks_hit = cyon_counter_read(g_loop_breaks_id);
+    st.continues_hit = cyon_counter_read(g_loop_continues_id);
+    return st;
 }
 
 void cyon_loop_stats_print(void) {
+    cyon_loop_stats_t st = cyon_loop_stats_get();
     printf("=== Cyon Loop Statistics ===\n");
-    printf("Total iterations: %llu\n", (unsigned long long)g_loop_stats.total_iterations);
-    printf("Break statements: %llu\n", (unsigned long long)g_loop_stats.breaks_hit);
-    printf("Continue statements: %llu\n", (unsigned long long)g_loop_stats.continues_hit);
+    printf("Total iterations: %llu\n", (unsigned long long)st.total_iterations);
+    printf("Break statements: %llu\n", (unsigned long long)st.breaks_hit);
+    printf("Continue statements: %llu\n", (unsigned long long)st.continues_hit);
 }
 
-static void cyon_loop_helper_000(void) {
-    volatile int _cyon_loop_flag_000 = 0;
-    (void)_cyon_loop_flag_000;
+/* ---- loop-site profiling ---- */
+
+#define CYON_LOOP_SITE_CHUNK 64
+#define CYON_LOOP_SITE_CHUNKS ((CYON_LOOP_MAX_SITES + CYON_LOOP_SITE_CHUNK - 1) / CYON_LOOP_SITE_CHUNK)
+
+typedef struct {
+    const char *name;
+    const char *file;
+    int line;
+} cyon_loop_site_t;
+
+typedef struct {
+    _Atomic uint64_t entries;
+    _Atomic uint64_t iterations;
+    _Atomic uint64_t ticks;
+    _Atomic uint64_t hist[CYON_LOOP_HIST_BUCKETS];
+} cyon_loop_counters_t;
+
+/* Per-thread counters, allocated in chunks of sites on first use. */
+typedef struct cyon_loop_tblock {
+    _Atomic(cyon_loop_counters_t *) chunks[CYON_LOOP_SITE_CHUNKS];
+    struct cyon_loop_tblock *prev;
+    struct cyon_loop_tblock *next;
+} cyon_loop_tblock_t;
+
+static cyon_loop_site_t g_loop_sites[CYON_LOOP_MAX_SITES + 1];
+static _Atomic uint32_t g_loop_site_count = 0;
+static _Atomic bool g_loop_profile_on = false;
+static pthread_mutex_t g_loop_prof_lock = PTHREAD_MUTEX_INITIALIZER;
+static cyon_loop_tblock_t *g_loop_blocks = NULL;
+static cyon_loop_tblock_t g_loop_retired; /* counters of threads that exited */
+static pthread_key_t g_loop_prof_key;
+static pthread_once_t g_loop_prof_once = PTHREAD_ONCE_INIT;
+static _Thread_local cyon_loop_tblock_t *t_loop_block = NULL;
+
+static inline uint64_t cyon_loop_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+const char *cyon_loop_profile_tick_unit(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+static inline unsigned cyon_loop_hist_bucket(uint64_t trips) {
+    unsigned b = 0;
+    while (trips && b < CYON_LOOP_HIST_BUCKETS - 1) { trips >>= 1; b++; }
+    return b;
+}
+
+static void cyon_loop_counters_merge(cyon_loop_counters_t *dst, cyon_loop_counters_t *src) {
+    atomic_fetch_add_explicit(&dst->entries, atomic_load_explicit(&src->entries, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&dst->iterations, atomic_load_explicit(&src->iterations, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&dst->ticks, atomic_load_explicit(&src->ticks, memory_order_relaxed), memory_order_relaxed);
+    for (int b = 0; b < CYON_LOOP_HIST_BUCKETS; ++b) {
+        atomic_fetch_add_explicit(&dst->hist[b], atomic_load_explicit(&src->hist[b], memory_order_relaxed), memory_order_relaxed);
+    }
+}
+
+static cyon_loop_counters_t *cyon_loop_block_site(cyon_loop_tblock_t *blk, cyon_loop_site_id site, bool create) {
+    size_t ci = site / CYON_LOOP_SITE_CHUNK;
+    cyon_loop_counters_t *chunk = atomic_load_explicit(&blk->chunks[ci], memory_order_acquire);
+    if (!chunk) {
+        if (!create) return NULL;
+        chunk = (cyon_loop_counters_t*)calloc(CYON_LOOP_SITE_CHUNK, sizeof(cyon_loop_counters_t));
+        if (!chunk) return NULL;
+        atomic_store_explicit(&blk->chunks[ci], chunk, memory_order_release);
+    }
+    return &chunk[site % CYON_LOOP_SITE_CHUNK];
+}
+
+/* Thread exit: fold the thread's counters into the retired block. */
+static void cyon_loop_thread_exit(void *arg) {
+    cyon_loop_tblock_t *blk = (cyon_loop_tblock_t*)arg;
+    if (!blk) return;
+    pthread_mutex_lock(&g_loop_prof_lock);
+    if (blk->prev) blk->prev->next = blk->next;
+    else g_loop_blocks = blk->next;
+    if (blk->next) blk->next->prev = blk->prev;
+    for (size_t ci = 0; ci < CYON_LOOP_SITE_CHUNKS; ++ci) {
+        cyon_loop_counters_t *chunk = atomic_load_explicit(&blk->chunks[ci], memory_order_acquire);
+        if (!chunk) continue;
+        for (size_t i = 0; i < CYON_LOOP_SITE_CHUNK; ++i) {
+            cyon_loop_counters_t *dst = cyon_loop_block_site(&g_loop_retired, (cyon_loop_site_id)(ci * CYON_LOOP_SITE_CHUNK + i), true);
+            if (dst) cyon_loop_counters_merge(dst, &chunk[i]);
+        }
+        free(chunk);
+    }
+    pthread_mutex_unlock(&g_loop_prof_lock);
+    free(blk);
+}
+
+static void cyon_loop_prof_init_once(void) {
+    pthread_key_create(&g_loop_prof_key, cyon_loop_thread_exit);
+}
+
+static cyon_loop_tblock_t *cyon_loop_thread_block(void) {
+    if (t_loop_block) return t_loop_block;
+    pthread_once(&g_loop_prof_once, cyon_loop_prof_init_once);
+    cyon_loop_tblock_t *blk = (cyon_loop_tblock_t*)calloc(1, sizeof(cyon_loop_tblock_t));
+    if (!blk) return NULL;
+    pthread_mutex_lock(&g_loop_prof_lock);
+    blk->next = g_loop_blocks;
+    if (g_loop_blocks) g_loop_blocks->prev = blk;
+    g_loop_blocks = blk;
+    pthread_mutex_unlock(&g_loop_prof_lock);
+    pthread_setspecific(g_loop_prof_key, blk);
+    t_loop_block = blk;
+    return blk;
+}
+
+cyon_loop_site_id cyon_loop_site_register(const char *name, const char *file, int line) {
+    pthread_mutex_lock(&g_loop_prof_lock);
+    uint32_t n = atomic_load_explicit(&g_loop_site_count, memory_order_relaxed);
+    for (uint32_t id = 1; id <= n; ++id) {
+        const cyon_loop_site_t *s = &g_loop_sites[id];
+        if (s->line == line && s->file && file && strcmp(s->file, file) == 0) {
+            pthread_mutex_unlock(&g_loop_prof_lock);
+            return id;
+        }
+    }
+    if (n >= CYON_LOOP_MAX_SITES - 1) {
+        pthread_mutex_unlock(&g_loop_prof_lock);
+        return 0;
+    }
+    uint32_t id = n + 1;
+    g_loop_sites[id].name = name ? name : "loop";
+    g_loop_sites[id].file = file ? file : "?";
+    g_loop_sites[id].line = line;
+    atomic_store_explicit(&g_loop_site_count, id, memory_order_release);
+    pthread_mutex_unlock(&g_loop_prof_lock);
+    return id;
+}
+
+void cyon_loop_profile_enable(bool enable) {
+    atomic_store_explicit(&g_loop_profile_on, enable, memory_order_relaxed);
+}
+
+bool cyon_loop_profile_enabled(void) {
+    return atomic_load_explicit(&g_loop_profile_on, memory_order_relaxed);
+}
+
+void cyon_loop_probe_begin(cyon_loop_probe_t *probe, _Atomic cyon_loop_site_id *slot,
+                           const char *name, const char *file, int line) {
+    probe->site = 0;
+    if (!atomic_load_explicit(&g_loop_profile_on, memory_order_relaxed)) return;
+    cyon_loop_site_id site = slot ? atomic_load_explicit(slot, memory_order_acquire) : 0;
+    if (site == 0) {
+        site = cyon_loop_site_register(name, file, line);
+        if (slot) atomic_store_explicit(slot, site, memory_order_release);
+    }
+    probe->site = site;
+    probe->start = cyon_loop_ticks();
+}
+
+void cyon_loop_probe_end(cyon_loop_probe_t *probe, uint64_t trips) {
+    if (!probe || probe->site == 0) return;
+    uint64_t elapsed = cyon_loop_ticks() - probe->start;
+    cyon_loop_tblock_t *blk = cyon_loop_thread_block();
+    if (!blk) return;
+    cyon_loop_counters_t *c = cyon_loop_block_site(blk, probe->site, true);
+    if (!c) return;
+    /* Only the owning thread writes these; relaxed ops keep concurrent reports well-defined. */
+    atomic_fetch_add_explicit(&c->entries, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->iterations, trips, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->ticks, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->hist[cyon_loop_hist_bucket(trips)], 1, memory_order_relaxed);
+}
+
+static void cyon_loop_report_add(cyon_loop_site_report_t *r, cyon_loop_counters_t *c) {
+    r->entries += atomic_load_explicit(&c->entries, memory_order_relaxed);
+    r->iterations += atomic_load_explicit(&c->iterations, memory_order_relaxed);
+    r->ticks += atomic_load_explicit(&c->ticks, memory_order_relaxed);
+    for (int b = 0; b < CYON_LOOP_HIST_BUCKETS; ++b) {
+        r->hist[b] += atomic_load_explicit(&c->hist[b], memory_order_relaxed);
+    }
+}
+
+static int cyon_loop_report_cmp(const void *a, const void *b) {
+    const cyon_loop_site_report_t *x = (const cyon_loop_site_report_t*)a;
+    const cyon_loop_site_report_t *y = (const cyon_loop_site_report_t*)b;
+    if (x->ticks != y->ticks) return x->ticks < y->ticks ? 1 : -1;
+    if (x->iterations != y->iterations) return x->iterations < y->iterations ? 1 : -1;
+    return (x->site > y->site) - (x->site < y->site);
+}
+
+size_t cyon_loop_profile_collect(cyon_loop_site_report_t *out, size_t cap) {
+    uint32_t n = atomic_load_explicit(&g_loop_site_count, memory_order_acquire);
+    cyon_loop_site_report_t *all = (cyon_loop_site_report_t*)calloc((size_t)n + 1, sizeof(cyon_loop_site_report_t));
+    if (!all) return 0;
+    pthread_mutex_lock(&g_loop_prof_lock);
+    for (uint32_t id = 1; id <= n; ++id) {
+        cyon_loop_site_report_t *r = &all[id];
+        r->site = id;
+        r->name = g_loop_sites[id].name;
+        r->file = g_loop_sites[id].file;
+        r->line = g_loop_sites[id].line;
+        cyon_loop_counters_t *c = cyon_loop_block_site(&g_loop_retired, id, false);
+        if (c) cyon_loop_report_add(r, c);
+        for (cyon_loop_tblock_t *blk = g_loop_blocks; blk; blk = blk->next) {
+            c = cyon_loop_block_site(blk, id, false);
+            if (c) cyon_loop_report_add(r, c);
+        }
+    }
+    pthread_mutex_unlock(&g_loop_prof_lock);
+
+    size_t active = 0;
+    for (uint32_t id = 1; id <= n; ++id) {
+        if (all[id].entries) all[active++] = all[id];
+    }
+    qsort(all, active, sizeof(cyon_loop_site_report_t), cyon_loop_report_cmp);
+    if (out) memcpy(out, all, (active < cap ? active : cap) * sizeof(cyon_loop_site_report_t));
+    free(all);
+    return active;
+}
+
+void cyon_loop_profile_report(FILE *out, size_t top_n) {
+    if (!out) out = stdout;
+    size_t active = cyon_loop_profile_collect(NULL, 0);
+    if (active == 0) {
+        fprintf(out, "=== Cyon Loop Profile: no samples ===\n");
+        return;
+    }
+    cyon_loop_site_report_t *rows = (cyon_loop_site_report_t*)calloc(active, sizeof(cyon_loop_site_report_t));
+    if (!rows) return;
+    size_t got = cyon_loop_profile_collect(rows, active);
+    if (got > active) got = active;
+    uint64_t total = 0;
+    for (size_t i = 0; i < got; ++i) total += rows[i].ticks;
+    size_t shown = (top_n == 0 || top_n > got) ? got : top_n;
+    const char *unit = cyon_loop_profile_tick_unit();
+
+    fprintf(out, "=== Cyon Loop Profile (%zu of %zu sites, %s) ===\n", shown, got, unit);
+    fprintf(out, "%4s %6s %14s %12s %14s %10s  %s\n", "rank", "share", unit, "entries", "iterations", "avg trip", "site");
+    for (size_t i = 0; i < shown; ++i) {
+        const cyon_loop_site_report_t *r = &rows[i];
+        double share = total ? 100.0 * (double)r->ticks / (double)total : 0.0;
+        double avg = r->entries ? (double)r->iterations / (double)r->entries : 0.0;
+        fprintf(out, "%4zu %5.1f%% %14llu %12llu %14llu %10.1f  %s (%s:%d)\n",
+                i + 1, share, (unsigned long long)r->ticks, (unsigned long long)r->entries,
+                (unsigned long long)r->iterations, avg, r->name, r->file, r->line);
+        fprintf(out, "%*s trips:", 5, "");
+        for (int b = 0; b < CYON_LOOP_HIST_BUCKETS; ++b) {
+            if (!r->hist[b]) continue;
+            if (b == 0) fprintf(out, " [0]=%llu", (unsigned long long)r->hist[b]);
+            else fprintf(out, " [%llu+]=%llu", 1ull << (b - 1), (unsigned long long)r->hist[b]);
+        }
+        fputc('\n', out);
+    }
+    free(rows);
+}
+
+static void cyon_loop_block_zero(cyon_loop_tblock_t *blk) {
+    for (size_t ci = 0; ci < CYON_LOOP_SITE_CHUNKS; ++ci) {
+        cyon_loop_counters_t *chunk = atomic_load_explicit(&blk->chunks[ci], memory_order_acquire);
+        if (!chunk) continue;
+        for (size_t i = 0; i < CYON_LOOP_SITE_CHUNK; ++i) {
+            cyon_loop_counters_t *c = &chunk[i];
+            atomic_store_explicit(&c->entries, 0, memory_order_relaxed);
+            atomic_store_explicit(&c->iterations, 0, memory_order_relaxed);
+            atomic_store_explicit(&c->ticks, 0, memory_order_relaxed);
+            for (int b = 0; b < CYON_LOOP_HIST_BUCKETS; ++b) atomic_store_explicit(&c->hist[b], 0, memory_order_relaxed);
+        }
+    }
+}
+
+void cyon_loop_profile_reset(void) {
+    pthread_mutex_lock(&g_loop_prof_lock);
+    cyon_loop_block_zero(&g_loop_retired);
+    for (cyon_loop_tblock_t *blk = g_loop_blocks; blk; blk = blk->next) cyon_loop_block_zero(blk);
+    pthread_mutex_unlock(&g_loop_prof_lock);
 }
 
 #include <stddef.h>
@@ -0,0 +1,88 @@
+#ifndef CYON_CORE_RUNTIME_CORELOOP_H
+#define CYON_CORE_RUNTIME_CORELOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+/* Loop-site profiling.
+   Every profiled loop owns a site (name + source location) registered once.
+   Counters are kept per thread and merged only when a report is produced, so
+   the hot path never touches shared cache lines. Timing uses rdtsc on x86 and
+   CLOCK_MONOTONIC nanoseconds elsewhere. */
+
+#ifndef CYON_LOOP_MAX_SITES
+#define CYON_LOOP_MAX_SITES 4096
+#endif
+
+/* Trip-count histogram: bucket 0 holds empty loops, bucket k holds trips in [2^(k-1), 2^k). */
+#define CYON_LOOP_HIST_BUCKETS 16
+
+typedef uint32_t cyon_loop_site_id;
+
+typedef struct {
+    cyon_loop_site_id site;
+    uint64_t start;
+} cyon_loop_probe_t;
+
+typedef struct {
+    cyon_loop_site_id site;
+    const char *name;
+    const char *file;
+    int line;
+    uint64_t entries;
+    uint64_t iterations;
+    uint64_t ticks;
+    uint64_t hist[CYON_LOOP_HIST_BUCKETS];
+} cyon_loop_site_report_t;
+
+/* Register a site, returning a stable id (>0). Registering the same file:line
+   again returns the existing id. Returns 0 once CYON_LOOP_MAX_SITES is reached. */
+cyon_loop_site_id cyon_loop_site_register(const char *name, const char *file, int line);
+
+/* Profiling is off by default; probes are a single branch while disabled. */
+void cyon_loop_profile_enable(bool enable);
+bool cyon_loop_profile_enabled(void);
+
+/* Start/finish one execution of a loop. slot caches the site id across calls. */
+void cyon_loop_probe_begin(cyon_loop_probe_t *probe, _Atomic cyon_loop_site_id *slot,
+                           const char *name, const char *file, int line);
+void cyon_loop_probe_end(cyon_loop_probe_t *probe, uint64_t trips);
+
+/* Merge all threads' counters. Fills up to cap entries sorted by time spent
+   (hottest first) and returns the number of active sites. */
+size_t cyon_loop_profile_collect(cyon_loop_site_report_t *out, size_t cap);
+
+/* Print the top_n hottest sites (0 = all) with trip-count histograms. */
+void cyon_loop_profile_report(FILE *out, size_t top_n);
+
+/* Zero all counters; registered sites are kept. */
+void cyon_loop_profile_reset(void);
+
+/* Unit of the ticks field: "cycles" or "ns". */
+const char *cyon_loop_profile_tick_unit(void);
+
+/* Generated code brackets each loop with these:
+
+       CYON_LOOP_PROFILE_BEGIN(p, "main:for i");
+       for (...) { ...; trips++; }
+       CYON_LOOP_PROFILE_END(p, trips);                                       */
+#define CYON_LOOP_PROFILE_BEGIN(probe, name) \
+    static _Atomic cyon_loop_site_id probe##_site; \
+    cyon_loop_probe_t probe; \
+    cyon_loop_probe_begin(&probe, &probe##_site, (name), __FILE__, __LINE__)
+
+#define CYON_LOOP_PROFILE_END(probe, trips) \
+    cyon_loop_probe_end(&probe, (uint64_t)(trips))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_CORELOOP_H */
@@ -7,6 +7,13 @@
 #include <inttypes.h>
 #include <math.h>
 #include <errno.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "coremetrics.h"
+#include "corereclaim.h"
 
 /* Configuration */
 #ifndef CYON_MEM_POISON
@@ -21,6 +28,14 @@
 #define CYON_ARENA_MIN_CHUNK 4096
 #endif
 
+#if defined(__x86_64__) || defined(__i386__)
+#define cyon_mem_pause() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cyon_mem_pause() __asm__ volatile("yield")
+#else
+#define cyon_mem_pause() ((void)0)
+#endif
+
 static inline size_t cyon_align_up(size_t n, size_t align) {
     if (align == 0) return n;
     size_t rem = n % align;
@@ -55,8 +70,19 @@ typedef struct cyon_alloc_rec {
 } cyon_alloc_rec_t;
 
 static cyon_alloc_rec_t *cyon_alloc_head = NULL;
-static size_t cyon_total_allocated = 0;
-static size_t cyon_total_freed = 0;
+
+/* Byte totals are sharded counters so tracking from many threads does not
+   bounce a shared line; the record list itself is still single-threaded. */
+static cyon_metric_id cyon_mem_allocated_id;
+static cyon_metric_id cyon_mem_freed_id;
+static cyon_metric_id cyon_mem_size_hist_id;
+static pthread_once_t cyon_mem_metrics_once = PTHREAD_ONCE_INIT;
+
+static void cyon_mem_metrics_init(void) {
+    cyon_mem_allocated_id = cyon_metric_register("mem.allocated_bytes", CYON_METRIC_COUNTER);
+    cyon_mem_freed_id = cyon_metric_register("mem.freed_bytes", CYON_METRIC_COUNTER);
+    cyon_mem_size_hist_id = cyon_metric_register("mem.alloc_size", CYON_METRIC_HISTOGRAM);
+}
 
 static void cyon_track_alloc_internal(void *p, size_t size, const char *file, int line) {
     if (!p) return;
@@ -68,7 +94,9 @@ static void cyon_track_alloc_internal(void *p, size_t size, const char *file, in
     r->line = line;
     r->next = cyon_alloc_head;
     cyon_alloc_head = r;
-    cyon_total_allocated += size;
+    pthread_once(&cyon_mem_metrics_once, cyon_mem_metrics_init);
+    cyon_counter_add(cyon_mem_allocated_id, size);
+    cyon_histogram_record(cyon_mem_size_hist_id, size);
     cyon_mem_log("[cyon] track alloc %p size=%zu at %s:%d", p, size, file ? file : "?", line);
 }
 
@@ -77,7 +105,8 @@ static void cyon_track_free_internal(void *p) {
     cyon_alloc_rec_t **rp = &cyon_alloc_head;
     while (*rp) {
         if ((*rp)->ptr == p) {
-            cyon_total_freed += (*rp)->size;
+            pthread_once(&cyon_mem_metrics_once, cyon_mem_metrics_init);
+            cyon_counter_add(cyon_mem_freed_id, (*rp)->size);
             cyon_alloc_rec_t *tmp = *rp;
             *rp = tmp->next;
             free(tmp);
@@ -236,14 +265,32 @@ typedef struct cyon_pool_node {
     struct cyon_pool_node *next;
 } cyon_pool_node_t;
 
-typedef struct {
+/* Struct tag shared with corereclaim.h. The free list is guarded by a
+   spin lock so reclaimers on other threads can hand objects back. */
+typedef struct cyon_pool_s {
     size_t obj_size;
     cyon_pool_node_t *free_list;
     void *pool_memory;
     size_t capacity;
     size_t used;
+    atomic_flag lock;
 } cyon_pool_t;
 
+/* Exponential pause backoff keeps waiters off the lock's cache line; past
+   64 pauses the holder is likely descheduled, so give up the CPU. */
+static inline void cyon_pool_lock(cyon_pool_t *p) {
+    unsigned spins = 1;
+    while (atomic_flag_test_and_set_explicit(&p->lock, memory_order_acquire)) {
+        for (unsigned i = 0; i < spins; i++) cyon_mem_pause();
+        if (spins < 64) spins <<= 1;
+        else sched_yield();
+    }
+}
+
+static inline void cyon_pool_unlock(cyon_pool_t *p) {
+    atomic_flag_clear_explicit(&p->lock, memory_order_release);
+}
+
 cyon_pool_t *cyon_pool_create(size_t obj_size, size_t capacity) {
     if (capacity == 0) return NULL;
     if (obj_size < sizeof(cyon_pool_node_t*)) obj_size = sizeof(cyon_pool_node_t*);
@@ -252,6 +299,7 @@ cyon_pool_t *cyon_pool_create(size_t obj_size, size_t capacity) {
     p->obj_size = cyon_align_up(obj_size, CYON_MEM_ALIGN);
     p->capacity = capacity;
     p->used = 0;
+    atomic_flag_clear(&p->lock);
     p->pool_memory = malloc(p->obj_size * capacity);
     if (!p->pool_memory) { free(p); return NULL; }
     p->free_list = NULL;
@@ -271,10 +319,15 @@ void cyon_pool_destroy(cyon_pool_t *p) {
 }
 
 void *cyon_pool_alloc_obj(cyon_pool_t *p) {
-    if (!p || !p->free_list) return NULL;
+    if (!p) return NULL;
+    cyon_pool_lock(p);
     cyon_pool_node_t *n = p->free_list;
-    p->free_list = n->next;
-    p->used++;
+    if (n) {
+        p->free_list = n->next;
+        p->used++;
+    }
+    cyon_pool_unlock(p);
+    if (!n) return NULL;
     memset(n, 0, p->obj_size);
     return (void*)n;
 }
@@ -282,9 +335,32 @@ void *cyon_pool_alloc_obj(cyon_pool_t *p) {
 void cyon_pool_free_obj(cyon_pool_t *p, void *obj) {
     if (!p || !obj) return;
     cyon_pool_node_t *n = (cyon_pool_node_t*)obj;
+    cyon_pool_lock(p);
     n->next = p->free_list;
     p->free_list = n;
     p->used--;
+    cyon_pool_unlock(p);
+}
+
+/* Link the objects outside the lock, splice the chain in under it. */
+void cyon_pool_free_batch(cyon_pool_t *p, void *const *objs, size_t n) {
+    if (!p || !objs || n == 0) return;
+    cyon_pool_node_t *head = NULL, *tail = NULL;
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        cyon_pool_node_t *node = (cyon_pool_node_t*)objs[i];
+        if (!node) continue;
+        node->next = head;
+        if (!tail) tail = node;
+        head = node;
+        ++k;
+    }
+    if (!head) return;
+    cyon_pool_lock(p);
+    tail->next = p->free_list;
+    p->free_list = head;
+    p->used -= k;
+    cyon_pool_unlock(p);
 }
 
 void cyon_mem_poison(void *p, size_t n) {
@@ -306,12 +382,21 @@ int cyon_mem_is_poisoned(void *p, size_t n) {
     return 1;
 }
 
-size_t cyon_mem_total_allocated(void) { return cyon_total_allocated; }
-size_t cyon_mem_total_freed(void) { return cyon_total_freed; }
+size_t cyon_mem_total_allocated(void) {
+    pthread_once(&cyon_mem_metrics_once, cyon_mem_metrics_init);
+    return (size_t)cyon_counter_read(cyon_mem_allocated_id);
+}
+
+size_t cyon_mem_total_freed(void) {
+    pthread_once(&cyon_mem_metrics_once, cyon_mem_metrics_init);
+    return (size_t)cyon_counter_read(cyon_mem_freed_id);
+}
 
 void cyon_mem_print_stats(void) {
+    size_t allocated = cyon_mem_total_allocated();
+    size_t freed = cyon_mem_total_freed();
     printf("cyon memory: allocated=%zu freed=%zu outstanding=%zu\n",
-           cyon_total_allocated, cyon_total_freed, cyon_total_allocated - cyon_total_freed);
+           allocated, freed, allocated - freed);
 }
 
 void cyon_gc_collect(void) {
@@ -0,0 +1,411 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "coremetrics.h"
+
+#define CYON_METRICS_CHUNK 512
+#define CYON_METRICS_CHUNKS (CYON_METRICS_MAX_SLOTS / CYON_METRICS_CHUNK)
+
+/* Histogram slot layout relative to its base slot. */
+enum { CYON_HS_COUNT = 0, CYON_HS_SUM = 1, CYON_HS_MIN = 2, CYON_HS_MAX = 3, CYON_HS_BUCKETS = 4 };
+#define CYON_HIST_SLOTS (CYON_HS_BUCKETS + CYON_HIST_BUCKETS)
+
+typedef struct {
+    const char *name;
+    cyon_metric_kind_t kind;
+    uint32_t base;                 /* first slot */
+    uint32_t nslots;
+    _Atomic uint64_t baseline;     /* counter: value at last reset */
+    _Atomic int64_t gauge_base;    /* gauge: value - sum of deltas at last set */
+    cyon_histogram_snapshot_t *hist_baseline; /* histogram: snapshot at last reset */
+} cyon_metric_t;
+
+/* Per-thread shard: chunks of slots allocated on first write. Only the
+   owning thread stores into them. */
+typedef struct cyon_metrics_tblock {
+    _Atomic(_Atomic uint64_t *) chunks[CYON_METRICS_CHUNKS];
+    struct cyon_metrics_tblock *prev;
+    struct cyon_metrics_tblock *next;
+} cyon_metrics_tblock_t;
+
+static cyon_metric_t g_metrics[CYON_METRICS_MAX + 1];
+static _Atomic uint32_t g_metric_count = 0;
+static uint32_t g_metric_next_slot = 0;
+static pthread_mutex_t g_metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static cyon_metrics_tblock_t *g_metrics_blocks = NULL;
+static cyon_metrics_tblock_t g_metrics_retired; /* shards of threads that exited */
+static pthread_key_t g_metrics_key;
+static pthread_once_t g_metrics_once = PTHREAD_ONCE_INIT;
+static _Thread_local cyon_metrics_tblock_t *t_metrics_block = NULL;
+
+static _Atomic uint64_t *cyon_metrics_chunk(cyon_metrics_tblock_t *blk, uint32_t slot, bool create) {
+    size_t ci = slot / CYON_METRICS_CHUNK;
+    _Atomic uint64_t *chunk = atomic_load_explicit(&blk->chunks[ci], memory_order_acquire);
+    if (!chunk && create) {
+        chunk = (_Atomic uint64_t*)calloc(CYON_METRICS_CHUNK, sizeof(_Atomic uint64_t));
+        if (!chunk) return NULL;
+        atomic_store_explicit(&blk->chunks[ci], chunk, memory_order_release);
+    }
+    return chunk;
+}
+
+/* Histogram min slots start at UINT64_MAX; everything else at zero. */
+static void cyon_metrics_chunk_init(_Atomic uint64_t *chunk, size_t ci) {
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    for (uint32_t id = 1; id <= n; ++id) {
+        const cyon_metric_t *m = &g_metrics[id];
+        if (m->kind != CYON_METRIC_HISTOGRAM) continue;
+        uint32_t s = m->base + CYON_HS_MIN;
+        if (s / CYON_METRICS_CHUNK == ci)
+            atomic_store_explicit(&chunk[s % CYON_METRICS_CHUNK], UINT64_MAX, memory_order_relaxed);
+    }
+}
+
+/* Chunk of blk holding slot, created and initialised if missing. Caller
+   holds the registry lock so a concurrent registration cannot miss it. */
+static _Atomic uint64_t *cyon_metrics_chunk_locked(cyon_metrics_tblock_t *blk, uint32_t slot) {
+    _Atomic uint64_t *chunk = cyon_metrics_chunk(blk, slot, false);
+    if (chunk) return chunk;
+    chunk = cyon_metrics_chunk(blk, slot, true);
+    if (chunk) cyon_metrics_chunk_init(chunk, slot / CYON_METRICS_CHUNK);
+    return chunk;
+}
+
+/* Thread exit: fold the thread's shard into the retired shard. */
+static void cyon_metrics_thread_exit(void *arg) {
+    cyon_metrics_tblock_t *blk = (cyon_metrics_tblock_t*)arg;
+    if (!blk) return;
+    pthread_mutex_lock(&g_metrics_lock);
+    if (blk->prev) blk->prev->next = blk->next;
+    else g_metrics_blocks = blk->next;
+    if (blk->next) blk->next->prev = blk->prev;
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    for (uint32_t id = 1; id <= n; ++id) {
+        const cyon_metric_t *m = &g_metrics[id];
+        _Atomic uint64_t *src = cyon_metrics_chunk(blk, m->base, false);
+        if (!src) continue;
+        _Atomic uint64_t *dst = cyon_metrics_chunk_locked(&g_metrics_retired, m->base);
+        if (!dst) continue;
+        src += m->base % CYON_METRICS_CHUNK;
+        dst += m->base % CYON_METRICS_CHUNK;
+        for (uint32_t k = 0; k < m->nslots; ++k) {
+            uint64_t v = atomic_load_explicit(&src[k], memory_order_relaxed);
+            uint64_t cur = atomic_load_explicit(&dst[k], memory_order_relaxed);
+            if (m->kind == CYON_METRIC_HISTOGRAM && k == CYON_HS_MIN)
+                atomic_store_explicit(&dst[k], v < cur ? v : cur, memory_order_relaxed);
+            else if (m->kind == CYON_METRIC_HISTOGRAM && k == CYON_HS_MAX)
+                atomic_store_explicit(&dst[k], v > cur ? v : cur, memory_order_relaxed);
+            else
+                atomic_store_explicit(&dst[k], cur + v, memory_order_relaxed);
+        }
+    }
+    for (size_t ci = 0; ci < CYON_METRICS_CHUNKS; ++ci)
+        free((void*)atomic_load_explicit(&blk->chunks[ci], memory_order_acquire));
+    pthread_mutex_unlock(&g_metrics_lock);
+    free(blk);
+}
+
+static void cyon_metrics_init_once(void) {
+    pthread_key_create(&g_metrics_key, cyon_metrics_thread_exit);
+}
+
+static cyon_metrics_tblock_t *cyon_metrics_thread_block(void) {
+    if (t_metrics_block) return t_metrics_block;
+    pthread_once(&g_metrics_once, cyon_metrics_init_once);
+    cyon_metrics_tblock_t *blk = (cyon_metrics_tblock_t*)calloc(1, sizeof(cyon_metrics_tblock_t));
+    if (!blk) return NULL;
+    pthread_mutex_lock(&g_metrics_lock);
+    blk->next = g_metrics_blocks;
+    if (g_metrics_blocks) g_metrics_blocks->prev = blk;
+    g_metrics_blocks = blk;
+    pthread_mutex_unlock(&g_metrics_lock);
+    pthread_setspecific(g_metrics_key, blk);
+    t_metrics_block = blk;
+    return blk;
+}
+
+/* Owner-thread slot pointer, creating the chunk on first touch. */
+static _Atomic uint64_t *cyon_metrics_slot(uint32_t slot) {
+    cyon_metrics_tblock_t *blk = cyon_metrics_thread_block();
+    if (!blk) return NULL;
+    size_t ci = slot / CYON_METRICS_CHUNK;
+    _Atomic uint64_t *chunk = atomic_load_explicit(&blk->chunks[ci], memory_order_relaxed);
+    if (!chunk) {
+        pthread_mutex_lock(&g_metrics_lock);
+        chunk = cyon_metrics_chunk_locked(blk, slot);
+        pthread_mutex_unlock(&g_metrics_lock);
+        if (!chunk) return NULL;
+    }
+    return &chunk[slot % CYON_METRICS_CHUNK];
+}
+
+static inline void cyon_slot_add(_Atomic uint64_t *s, uint64_t n) {
+    atomic_store_explicit(s, atomic_load_explicit(s, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+cyon_metric_id cyon_metric_find(const char *name) {
+    if (!name) return 0;
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    for (uint32_t id = 1; id <= n; ++id)
+        if (strcmp(g_metrics[id].name, name) == 0) return id;
+    return 0;
+}
+
+cyon_metric_id cyon_metric_register(const char *name, cyon_metric_kind_t kind) {
+    if (!name) return 0;
+    pthread_mutex_lock(&g_metrics_lock);
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_relaxed);
+    for (uint32_t id = 1; id <= n; ++id) {
+        if (strcmp(g_metrics[id].name, name) == 0) {
+            pthread_mutex_unlock(&g_metrics_lock);
+            return g_metrics[id].kind == kind ? id : 0;
+        }
+    }
+    uint32_t nslots = kind == CYON_METRIC_HISTOGRAM ? CYON_HIST_SLOTS : 1;
+    uint32_t base = g_metric_next_slot;
+    /* keep a histogram inside one chunk so recording touches one chunk */
+    if (base / CYON_METRICS_CHUNK != (base + nslots - 1) / CYON_METRICS_CHUNK)
+        base = (base / CYON_METRICS_CHUNK + 1) * CYON_METRICS_CHUNK;
+    if (n >= CYON_METRICS_MAX || base + nslots > CYON_METRICS_MAX_SLOTS) {
+        pthread_mutex_unlock(&g_metrics_lock);
+        return 0;
+    }
+    uint32_t id = n + 1;
+    cyon_metric_t *m = &g_metrics[id];
+    m->name = name;
+    m->kind = kind;
+    m->base = base;
+    m->nslots = nslots;
+    atomic_store_explicit(&m->baseline, 0, memory_order_relaxed);
+    atomic_store_explicit(&m->gauge_base, 0, memory_order_relaxed);
+    m->hist_baseline = NULL;
+    g_metric_next_slot = base + nslots;
+    /* chunks that already exist need the histogram min sentinel */
+    if (kind == CYON_METRIC_HISTOGRAM) {
+        uint32_t s = base + CYON_HS_MIN;
+        _Atomic uint64_t *c = cyon_metrics_chunk(&g_metrics_retired, s, false);
+        if (c) atomic_store_explicit(&c[s % CYON_METRICS_CHUNK], UINT64_MAX, memory_order_relaxed);
+        for (cyon_metrics_tblock_t *b = g_metrics_blocks; b; b = b->next) {
+            c = cyon_metrics_chunk(b, s, false);
+            if (c) atomic_store_explicit(&c[s % CYON_METRICS_CHUNK], UINT64_MAX, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&g_metric_count, id, memory_order_release);
+    pthread_mutex_unlock(&g_metrics_lock);
+    return id;
+}
+
+const char *cyon_metric_name(cyon_metric_id id) {
+    if (id == 0 || id > atomic_load_explicit(&g_metric_count, memory_order_acquire)) return NULL;
+    return g_metrics[id].name;
+}
+
+static bool cyon_metric_valid(cyon_metric_id id, cyon_metric_kind_t kind) {
+    return id != 0 && id <= atomic_load_explicit(&g_metric_count, memory_order_acquire) &&
+           g_metrics[id].kind == kind;
+}
+
+/* Sum one slot over every live shard and the retired shard. Caller holds the lock. */
+static uint64_t cyon_metrics_sum_locked(uint32_t slot) {
+    uint64_t total = 0;
+    _Atomic uint64_t *c = cyon_metrics_chunk(&g_metrics_retired, slot, false);
+    if (c) total += atomic_load_explicit(&c[slot % CYON_METRICS_CHUNK], memory_order_relaxed);
+    for (cyon_metrics_tblock_t *b = g_metrics_blocks; b; b = b->next) {
+        c = cyon_metrics_chunk(b, slot, false);
+        if (c) total += atomic_load_explicit(&c[slot % CYON_METRICS_CHUNK], memory_order_relaxed);
+    }
+    return total;
+}
+
+void cyon_counter_add(cyon_metric_id id, uint64_t n) {
+    if (!cyon_metric_valid(id, CYON_METRIC_COUNTER)) return;
+    _Atomic uint64_t *s = cyon_metrics_slot(g_metrics[id].base);
+    if (s) cyon_slot_add(s, n);
+}
+
+uint64_t cyon_counter_read(cyon_metric_id id) {
+    if (!cyon_metric_valid(id, CYON_METRIC_COUNTER)) return 0;
+    pthread_mutex_lock(&g_metrics_lock);
+    uint64_t v = cyon_metrics_sum_locked(g_metrics[id].base);
+    pthread_mutex_unlock(&g_metrics_lock);
+    return v - atomic_load_explicit(&g_metrics[id].baseline, memory_order_relaxed);
+}
+
+void cyon_gauge_add(cyon_metric_id id, int64_t delta) {
+    if (!cyon_metric_valid(id, CYON_METRIC_GAUGE)) return;
+    _Atomic uint64_t *s = cyon_metrics_slot(g_metrics[id].base);
+    if (s) cyon_slot_add(s, (uint64_t)delta);
+}
+
+void cyon_gauge_set(cyon_metric_id id, int64_t value) {
+    if (!cyon_metric_valid(id, CYON_METRIC_GAUGE)) return;
+    pthread_mutex_lock(&g_metrics_lock);
+    int64_t deltas = (int64_t)cyon_metrics_sum_locked(g_metrics[id].base);
+    atomic_store_explicit(&g_metrics[id].gauge_base, value - deltas, memory_order_relaxed);
+    pthread_mutex_unlock(&g_metrics_lock);
+}
+
+int64_t cyon_gauge_read(cyon_metric_id id) {
+    if (!cyon_metric_valid(id, CYON_METRIC_GAUGE)) return 0;
+    pthread_mutex_lock(&g_metrics_lock);
+    int64_t v = (int64_t)cyon_metrics_sum_locked(g_metrics[id].base) +
+                atomic_load_explicit(&g_metrics[id].gauge_base, memory_order_relaxed);
+    pthread_mutex_unlock(&g_metrics_lock);
+    return v;
+}
+
+unsigned cyon_histogram_bucket(uint64_t value) {
+    if (value < (1u << CYON_HIST_SUB_BITS)) return (unsigned)value;
+    unsigned e = 63u - (unsigned)__builtin_clzll(value);
+    unsigned sub = (unsigned)(value >> (e - CYON_HIST_SUB_BITS)) & ((1u << CYON_HIST_SUB_BITS) - 1);
+    return ((e - CYON_HIST_SUB_BITS + 1) << CYON_HIST_SUB_BITS) + sub;
+}
+
+/* Largest value that maps to bucket b. */
+uint64_t cyon_histogram_bucket_upper(unsigned b) {
+    if (b < (1u << CYON_HIST_SUB_BITS)) return b;
+    unsigned e = (b >> CYON_HIST_SUB_BITS) + CYON_HIST_SUB_BITS - 1;
+    uint64_t sub = b & ((1u << CYON_HIST_SUB_BITS) - 1);
+    uint64_t lo = (1ull << e) | (sub << (e - CYON_HIST_SUB_BITS));
+    return lo + ((1ull << (e - CYON_HIST_SUB_BITS)) - 1);
+}
+
+void cyon_histogram_record(cyon_metric_id id, uint64_t value) {
+    if (!cyon_metric_valid(id, CYON_METRIC_HISTOGRAM)) return;
+    _Atomic uint64_t *h = cyon_metrics_slot(g_metrics[id].base);
+    if (!h) return;
+    cyon_slot_add(&h[CYON_HS_COUNT], 1);
+    cyon_slot_add(&h[CYON_HS_SUM], value);
+    if (value < atomic_load_explicit(&h[CYON_HS_MIN], memory_order_relaxed))
+        atomic_store_explicit(&h[CYON_HS_MIN], value, memory_order_relaxed);
+    if (value > atomic_load_explicit(&h[CYON_HS_MAX], memory_order_relaxed))
+        atomic_store_explicit(&h[CYON_HS_MAX], value, memory_order_relaxed);
+    cyon_slot_add(&h[CYON_HS_BUCKETS + cyon_histogram_bucket(value)], 1);
+}
+
+static void cyon_hist_collect_locked(const cyon_metric_t *m, cyon_histogram_snapshot_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->min = UINT64_MAX;
+    cyon_metrics_tblock_t *b = &g_metrics_retired;
+    bool retired = true;
+    while (b) {
+        _Atomic uint64_t *c = cyon_metrics_chunk(b, m->base, false);
+        if (c) {
+            _Atomic uint64_t *h = &c[m->base % CYON_METRICS_CHUNK];
+            uint64_t cnt = atomic_load_explicit(&h[CYON_HS_COUNT], memory_order_relaxed);
+            if (cnt) {
+                out->count += cnt;
+                out->sum += atomic_load_explicit(&h[CYON_HS_SUM], memory_order_relaxed);
+                uint64_t mn = atomic_load_explicit(&h[CYON_HS_MIN], memory_order_relaxed);
+                uint64_t mx = atomic_load_explicit(&h[CYON_HS_MAX], memory_order_relaxed);
+                if (mn < out->min) out->min = mn;
+                if (mx > out->max) out->max = mx;
+                for (unsigned k = 0; k < CYON_HIST_BUCKETS; ++k)
+                    out->buckets[k] += atomic_load_explicit(&h[CYON_HS_BUCKETS + k], memory_order_relaxed);
+            }
+        }
+        b = retired ? g_metrics_blocks : b->next;
+        retired = false;
+    }
+    if (out->count == 0) out->min = 0;
+}
+
+int cyon_histogram_read(cyon_metric_id id, cyon_histogram_snapshot_t *out) {
+    if (!out || !cyon_metric_valid(id, CYON_METRIC_HISTOGRAM)) return -1;
+    const cyon_metric_t *m = &g_metrics[id];
+    pthread_mutex_lock(&g_metrics_lock);
+    cyon_hist_collect_locked(m, out);
+    const cyon_histogram_snapshot_t *base = m->hist_baseline;
+    if (base) {
+        /* after a reset min/max come from the remaining buckets */
+        uint64_t live_min = out->min, live_max = out->max;
+        out->count -= base->count;
+        out->sum -= base->sum;
+        out->min = 0;
+        out->max = 0;
+        bool seen = false;
+        for (unsigned k = 0; k < CYON_HIST_BUCKETS; ++k) {
+            out->buckets[k] -= base->buckets[k];
+            if (!out->buckets[k]) continue;
+            uint64_t up = cyon_histogram_bucket_upper(k);
+            if (!seen) { out->min = k ? cyon_histogram_bucket_upper(k - 1) + 1 : 0; seen = true; }
+            out->max = up;
+        }
+        /* tighten with the all-time extremes and the exact sum */
+        if (out->min < live_min) out->min = live_min;
+        if (out->max > live_max) out->max = live_max;
+        if (out->max > out->sum) out->max = out->sum;
+        if (out->count == 1) out->min = out->max = out->sum;
+    }
+    pthread_mutex_unlock(&g_metrics_lock);
+    return 0;
+}
+
+uint64_t cyon_histogram_quantile(const cyon_histogram_snapshot_t *snap, double q) {
+    if (!snap || snap->count == 0) return 0;
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    uint64_t rank = (uint64_t)(q * (double)snap->count + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned k = 0; k < CYON_HIST_BUCKETS; ++k) {
+        seen += snap->buckets[k];
+        if (seen >= rank) {
+            uint64_t up = cyon_histogram_bucket_upper(k);
+            if (snap->max && up > snap->max) up = snap->max;
+            return up;
+        }
+    }
+    return snap->max;
+}
+
+void cyon_metric_reset(cyon_metric_id id) {
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    if (id == 0 || id > n) return;
+    cyon_metric_t *m = &g_metrics[id];
+    pthread_mutex_lock(&g_metrics_lock);
+    if (m->kind == CYON_METRIC_COUNTER) {
+        atomic_store_explicit(&m->baseline, cyon_metrics_sum_locked(m->base), memory_order_relaxed);
+    } else if (m->kind == CYON_METRIC_GAUGE) {
+        atomic_store_explicit(&m->gauge_base, -(int64_t)cyon_metrics_sum_locked(m->base), memory_order_relaxed);
+    } else {
+        if (!m->hist_baseline)
+            m->hist_baseline = (cyon_histogram_snapshot_t*)malloc(sizeof(cyon_histogram_snapshot_t));
+        if (m->hist_baseline) cyon_hist_collect_locked(m, m->hist_baseline);
+    }
+    pthread_mutex_unlock(&g_metrics_lock);
+}
+
+void cyon_metrics_report(FILE *out) {
+    if (!out) out = stdout;
+    uint32_t n = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    fprintf(out, "=== Cyon Metrics ===\n");
+    for (uint32_t id = 1; id <= n; ++id) {
+        const cyon_metric_t *m = &g_metrics[id];
+        if (m->kind == CYON_METRIC_COUNTER) {
+            fprintf(out, "%-32s counter   %llu\n", m->name, (unsigned long long)cyon_counter_read(id));
+        } else if (m->kind == CYON_METRIC_GAUGE) {
+            fprintf(out, "%-32s gauge     %lld\n", m->name, (long long)cyon_gauge_read(id));
+        } else {
+            cyon_histogram_snapshot_t *s = (cyon_histogram_snapshot_t*)malloc(sizeof(*s));
+            if (!s || cyon_histogram_read(id, s) != 0) { free(s); continue; }
+            fprintf(out, "%-32s histogram count=%llu mean=%.1f p50=%llu p99=%llu p999=%llu max=%llu\n",
+                    m->name, (unsigned long long)s->count,
+                    s->count ? (double)s->sum / (double)s->count : 0.0,
+                    (unsigned long long)cyon_histogram_quantile(s, 0.50),
+                    (unsigned long long)cyon_histogram_quantile(s, 0.99),
+                    (unsigned long long)cyon_histogram_quantile(s, 0.999),
+                    (unsigned long long)s->max);
+            free(s);
+        }
+    }
+}
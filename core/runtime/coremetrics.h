@@ -0,0 +1,79 @@
+#ifndef CYON_CORE_RUNTIME_COREMETRICS_H
+#define CYON_CORE_RUNTIME_COREMETRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Runtime metrics: counters, gauges and log-linear histograms.
+   Every thread writes its own shard of slots (plain relaxed stores, no
+   read-modify-write, no shared cache lines); readers sum the shards of live
+   threads plus the totals folded in from threads that exited. */
+
+#ifndef CYON_METRICS_MAX
+#define CYON_METRICS_MAX 512
+#endif
+
+#ifndef CYON_METRICS_MAX_SLOTS
+#define CYON_METRICS_MAX_SLOTS 65536
+#endif
+
+/* Histogram buckets: values below 8 are exact; above, each power of two is
+   split into 8 linear sub-buckets (at most 12.5% relative error). */
+#define CYON_HIST_SUB_BITS 3
+#define CYON_HIST_BUCKETS ((64 - CYON_HIST_SUB_BITS + 1) << CYON_HIST_SUB_BITS)
+
+typedef enum {
+    CYON_METRIC_COUNTER = 0,
+    CYON_METRIC_GAUGE = 1,
+    CYON_METRIC_HISTOGRAM = 2
+} cyon_metric_kind_t;
+
+/* Metric handle; 0 is invalid (registry full). */
+typedef uint32_t cyon_metric_id;
+
+/* Register (or look up by name) a metric. Safe to call from any thread. */
+cyon_metric_id cyon_metric_register(const char *name, cyon_metric_kind_t kind);
+cyon_metric_id cyon_metric_find(const char *name);
+const char *cyon_metric_name(cyon_metric_id id);
+
+void cyon_counter_add(cyon_metric_id id, uint64_t n);
+uint64_t cyon_counter_read(cyon_metric_id id);
+
+void cyon_gauge_add(cyon_metric_id id, int64_t delta);
+/* Last writer wins against other sets; concurrent adds are kept. */
+void cyon_gauge_set(cyon_metric_id id, int64_t value);
+int64_t cyon_gauge_read(cyon_metric_id id);
+
+void cyon_histogram_record(cyon_metric_id id, uint64_t value);
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[CYON_HIST_BUCKETS];
+} cyon_histogram_snapshot_t;
+
+int cyon_histogram_read(cyon_metric_id id, cyon_histogram_snapshot_t *out);
+/* Value at quantile q in [0,1] (bucket upper bound, clamped to max). */
+uint64_t cyon_histogram_quantile(const cyon_histogram_snapshot_t *snap, double q);
+unsigned cyon_histogram_bucket(uint64_t value);
+uint64_t cyon_histogram_bucket_upper(unsigned bucket);
+
+/* Zero a metric as seen by readers (shards keep counting from a baseline). */
+void cyon_metric_reset(cyon_metric_id id);
+
+/* Print every registered metric; histograms show count/mean/p50/p99/p999/max. */
+void cyon_metrics_report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_COREMETRICS_H */
@@ -0,0 +1,430 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "corereclaim.h"
+#include "coremetrics.h"
+
+typedef struct {
+    void *ptr;
+    cyon_reclaim_fn fn;
+    void *ctx;
+} cyon_retired_t;
+
+typedef struct {
+    cyon_retired_t *items;
+    size_t len;
+    size_t cap;
+    uint64_t epoch;     /* epoch the items were retired in */
+} cyon_bag_t;
+
+/* Bag handed over by an exiting thread. */
+typedef struct cyon_orphan {
+    cyon_bag_t bag;
+    struct cyon_orphan *next;
+} cyon_orphan_t;
+
+/* Per-thread record. Records are never freed: an exiting thread clears
+   in_use and the next new thread adopts the record. */
+typedef struct cyon_reclaim_rec {
+    _Atomic uint64_t epoch;                    /* (e << 1) | 1 inside a section */
+    void *_Atomic hazards[CYON_HAZARD_SLOTS];
+    _Atomic int in_use;
+    struct cyon_reclaim_rec *next;             /* immutable once published */
+    /* owner only */
+    unsigned nest;
+    unsigned since_collect;
+    cyon_bag_t bags[3];                        /* indexed by epoch % 3 */
+    cyon_bag_t hazard_bag;
+} cyon_reclaim_rec_t;
+
+static _Atomic uint64_t g_epoch = 1;
+static _Atomic(cyon_reclaim_rec_t *) g_records = NULL;
+static _Atomic size_t g_record_count = 0;
+static pthread_mutex_t g_orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+static cyon_orphan_t *g_epoch_orphans = NULL;
+static cyon_bag_t g_hazard_orphans;
+static pthread_key_t g_reclaim_key;
+static pthread_once_t g_reclaim_once = PTHREAD_ONCE_INIT;
+static cyon_metric_id g_reclaim_retired_id;
+static cyon_metric_id g_reclaim_freed_id;
+static _Thread_local cyon_reclaim_rec_t *t_reclaim_rec = NULL;
+
+/* Marker: ctx is the cyon_pool_t the object came from. */
+static void cyon_reclaim_pool_fn(void *ptr, void *ctx) {
+    cyon_pool_free_batch((cyon_pool_t*)ctx, &ptr, 1);
+}
+
+static int cyon_bag_push(cyon_bag_t *b, void *ptr, cyon_reclaim_fn fn, void *ctx) {
+    if (b->len == b->cap) {
+        size_t ncap = b->cap ? b->cap * 2 : CYON_RECLAIM_BATCH;
+        cyon_retired_t *n = (cyon_retired_t*)realloc(b->items, ncap * sizeof(cyon_retired_t));
+        if (!n) return -1;
+        b->items = n;
+        b->cap = ncap;
+    }
+    b->items[b->len].ptr = ptr;
+    b->items[b->len].fn = fn;
+    b->items[b->len].ctx = ctx;
+    b->len++;
+    return 0;
+}
+
+/* Free n retired items. Consecutive objects of the same pool are returned
+   with one cyon_pool_free_batch call. */
+static size_t cyon_reclaim_free_items(const cyon_retired_t *items, size_t n) {
+    void *batch[CYON_RECLAIM_BATCH];
+    size_t nb = 0;
+    cyon_pool_t *pool = NULL;
+    for (size_t i = 0; i < n; ++i) {
+        const cyon_retired_t *r = &items[i];
+        if (r->fn == cyon_reclaim_pool_fn) {
+            if (nb && (pool != (cyon_pool_t*)r->ctx || nb == CYON_RECLAIM_BATCH)) {
+                cyon_pool_free_batch(pool, batch, nb);
+                nb = 0;
+            }
+            pool = (cyon_pool_t*)r->ctx;
+            batch[nb++] = r->ptr;
+        } else if (r->fn) {
+            r->fn(r->ptr, r->ctx);
+        } else {
+            free(r->ptr);
+        }
+    }
+    if (nb) cyon_pool_free_batch(pool, batch, nb);
+    if (n) cyon_counter_add(g_reclaim_freed_id, n);
+    return n;
+}
+
+static size_t cyon_bag_drain(cyon_bag_t *b) {
+    size_t n = cyon_reclaim_free_items(b->items, b->len);
+    b->len = 0;
+    return n;
+}
+
+static void cyon_bag_release(cyon_bag_t *b) {
+    free(b->items);
+    memset(b, 0, sizeof(*b));
+}
+
+/* Thread exit: hand pending garbage to the orphan lists and free the record
+   for reuse. */
+static void cyon_reclaim_thread_exit(void *arg) {
+    cyon_reclaim_rec_t *rec = (cyon_reclaim_rec_t*)arg;
+    if (!rec) return;
+    atomic_store_explicit(&rec->epoch, 0, memory_order_release);
+    for (int i = 0; i < CYON_HAZARD_SLOTS; ++i)
+        atomic_store_explicit(&rec->hazards[i], NULL, memory_order_release);
+    pthread_mutex_lock(&g_orphan_lock);
+    for (int i = 0; i < 3; ++i) {
+        if (rec->bags[i].len) {
+            cyon_orphan_t *o = (cyon_orphan_t*)malloc(sizeof(cyon_orphan_t));
+            if (o) {
+                o->bag = rec->bags[i];
+                o->next = g_epoch_orphans;
+                g_epoch_orphans = o;
+                memset(&rec->bags[i], 0, sizeof(cyon_bag_t));
+                continue;
+            }
+        }
+        cyon_bag_release(&rec->bags[i]);
+    }
+    for (size_t i = 0; i < rec->hazard_bag.len; ++i) {
+        const cyon_retired_t *r = &rec->hazard_bag.items[i];
+        cyon_bag_push(&g_hazard_orphans, r->ptr, r->fn, r->ctx);
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    cyon_bag_release(&rec->hazard_bag);
+    rec->nest = 0;
+    rec->since_collect = 0;
+    atomic_store_explicit(&rec->in_use, 0, memory_order_release);
+}
+
+static void cyon_reclaim_init_once(void) {
+    pthread_key_create(&g_reclaim_key, cyon_reclaim_thread_exit);
+    g_reclaim_retired_id = cyon_metric_register("reclaim.retired", CYON_METRIC_COUNTER);
+    g_reclaim_freed_id = cyon_metric_register("reclaim.freed", CYON_METRIC_COUNTER);
+}
+
+static cyon_reclaim_rec_t *cyon_reclaim_self(void) {
+    if (t_reclaim_rec) return t_reclaim_rec;
+    pthread_once(&g_reclaim_once, cyon_reclaim_init_once);
+    cyon_reclaim_rec_t *rec = atomic_load_explicit(&g_records, memory_order_acquire);
+    for (; rec; rec = rec->next) {
+        int expected = 0;
+        if (atomic_load_explicit(&rec->in_use, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong(&rec->in_use, &expected, 1))
+            break;
+    }
+    if (!rec) {
+        rec = (cyon_reclaim_rec_t*)calloc(1, sizeof(cyon_reclaim_rec_t));
+        if (!rec) {
+            fprintf(stderr, "cyon reclaim: out of memory\n");
+            abort();
+        }
+        atomic_store_explicit(&rec->in_use, 1, memory_order_relaxed);
+        cyon_reclaim_rec_t *head = atomic_load_explicit(&g_records, memory_order_relaxed);
+        do {
+            rec->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&g_records, &head, rec,
+                     memory_order_release, memory_order_relaxed));
+        atomic_fetch_add_explicit(&g_record_count, 1, memory_order_relaxed);
+    }
+    pthread_setspecific(g_reclaim_key, rec);
+    t_reclaim_rec = rec;
+    return rec;
+}
+
+/* ---- Epochs ---- */
+
+void cyon_epoch_enter(void) {
+    cyon_reclaim_rec_t *rec = cyon_reclaim_self();
+    if (rec->nest++ > 0) return;
+    uint64_t e = atomic_load_explicit(&g_epoch, memory_order_relaxed);
+    /* seq_cst store: the epoch must be visible before any shared load */
+    atomic_store_explicit(&rec->epoch, (e << 1) | 1, memory_order_seq_cst);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void cyon_epoch_exit(void) {
+    cyon_reclaim_rec_t *rec = t_reclaim_rec;
+    if (!rec || rec->nest == 0) return;
+    if (--rec->nest > 0) return;
+    atomic_store_explicit(&rec->epoch, 0, memory_order_release);
+}
+
+bool cyon_epoch_in_section(void) {
+    return t_reclaim_rec && t_reclaim_rec->nest > 0;
+}
+
+uint64_t cyon_epoch_current(void) {
+    return atomic_load_explicit(&g_epoch, memory_order_acquire);
+}
+
+/* Advance the global epoch if every thread inside a section has seen the
+   current one. Returns the (possibly new) global epoch. */
+static uint64_t cyon_epoch_try_advance(void) {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t e = atomic_load_explicit(&g_epoch, memory_order_seq_cst);
+    for (cyon_reclaim_rec_t *r = atomic_load_explicit(&g_records, memory_order_acquire); r; r = r->next) {
+        uint64_t l = atomic_load_explicit(&r->epoch, memory_order_seq_cst);
+        if ((l & 1) && (l >> 1) != e) return e;
+    }
+    if (atomic_compare_exchange_strong(&g_epoch, &e, e + 1)) return e + 1;
+    return e; /* someone else advanced; e now holds the new value */
+}
+
+static size_t cyon_epoch_collect_orphans(uint64_t e) {
+    if (pthread_mutex_trylock(&g_orphan_lock) != 0) return 0;
+    cyon_orphan_t *ready = NULL;
+    cyon_orphan_t **pp = &g_epoch_orphans;
+    while (*pp) {
+        cyon_orphan_t *o = *pp;
+        if (o->bag.epoch + 2 <= e) {
+            *pp = o->next;
+            o->next = ready;
+            ready = o;
+        } else {
+            pp = &o->next;
+        }
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    size_t n = 0;
+    while (ready) {
+        cyon_orphan_t *o = ready;
+        ready = o->next;
+        n += cyon_bag_drain(&o->bag);
+        cyon_bag_release(&o->bag);
+        free(o);
+    }
+    return n;
+}
+
+static size_t cyon_epoch_collect_rec(cyon_reclaim_rec_t *rec) {
+    uint64_t e = cyon_epoch_try_advance();
+    size_t n = 0;
+    for (int i = 0; i < 3; ++i) {
+        cyon_bag_t *b = &rec->bags[i];
+        if (b->len && b->epoch + 2 <= e) n += cyon_bag_drain(b);
+    }
+    n += cyon_epoch_collect_orphans(e);
+    rec->since_collect = 0;
+    return n;
+}
+
+size_t cyon_epoch_collect(void) {
+    return cyon_epoch_collect_rec(cyon_reclaim_self());
+}
+
+void cyon_epoch_retire(void *ptr, cyon_reclaim_fn fn, void *ctx) {
+    if (!ptr) return;
+    cyon_reclaim_rec_t *rec = cyon_reclaim_self();
+    /* seq_cst: ordered after the caller's unlink */
+    uint64_t e = atomic_load_explicit(&g_epoch, memory_order_seq_cst);
+    cyon_bag_t *b = &rec->bags[e % 3];
+    /* same slot, older epoch: at least three epochs old, safe to free */
+    if (b->len && b->epoch != e) cyon_bag_drain(b);
+    b->epoch = e;
+    if (cyon_bag_push(b, ptr, fn, ctx) != 0) {
+        fprintf(stderr, "cyon reclaim: out of memory\n");
+        abort();
+    }
+    cyon_counter_add(g_reclaim_retired_id, 1);
+    if (++rec->since_collect >= CYON_RECLAIM_BATCH) cyon_epoch_collect_rec(rec);
+}
+
+void cyon_epoch_retire_pool(cyon_pool_t *pool, void *obj) {
+    cyon_epoch_retire(obj, cyon_reclaim_pool_fn, pool);
+}
+
+int cyon_epoch_synchronize(void) {
+    cyon_reclaim_rec_t *rec = cyon_reclaim_self();
+    if (rec->nest > 0) return -1;
+    uint64_t target = atomic_load_explicit(&g_epoch, memory_order_seq_cst) + 2;
+    while (cyon_epoch_try_advance() < target) sched_yield();
+    for (int i = 0; i < 3; ++i) cyon_bag_drain(&rec->bags[i]);
+    rec->since_collect = 0;
+    /* every orphan was retired before target - 2 */
+    pthread_mutex_lock(&g_orphan_lock);
+    cyon_orphan_t *o = g_epoch_orphans;
+    g_epoch_orphans = NULL;
+    pthread_mutex_unlock(&g_orphan_lock);
+    while (o) {
+        cyon_orphan_t *next = o->next;
+        cyon_bag_drain(&o->bag);
+        cyon_bag_release(&o->bag);
+        free(o);
+        o = next;
+    }
+    return 0;
+}
+
+/* ---- Hazard pointers ---- */
+
+void *cyon_hazard_protect(int slot, void *_Atomic *src) {
+    if (slot < 0 || slot >= CYON_HAZARD_SLOTS || !src) return NULL;
+    cyon_reclaim_rec_t *rec = cyon_reclaim_self();
+    void *p = atomic_load_explicit(src, memory_order_acquire);
+    for (;;) {
+        atomic_store_explicit(&rec->hazards[slot], p, memory_order_seq_cst);
+        void *q = atomic_load_explicit(src, memory_order_seq_cst);
+        if (q == p) return p;
+        p = q;
+    }
+}
+
+void cyon_hazard_set(int slot, void *ptr) {
+    if (slot < 0 || slot >= CYON_HAZARD_SLOTS) return;
+    atomic_store_explicit(&cyon_reclaim_self()->hazards[slot], ptr, memory_order_seq_cst);
+}
+
+void cyon_hazard_clear(int slot) {
+    if (slot < 0 || slot >= CYON_HAZARD_SLOTS || !t_reclaim_rec) return;
+    atomic_store_explicit(&t_reclaim_rec->hazards[slot], NULL, memory_order_release);
+}
+
+void cyon_hazard_clear_all(void) {
+    if (!t_reclaim_rec) return;
+    for (int i = 0; i < CYON_HAZARD_SLOTS; ++i)
+        atomic_store_explicit(&t_reclaim_rec->hazards[i], NULL, memory_order_release);
+}
+
+static int cyon_ptr_cmp(const void *a, const void *b) {
+    uintptr_t x = (uintptr_t)*(void *const *)a;
+    uintptr_t y = (uintptr_t)*(void *const *)b;
+    return (x > y) - (x < y);
+}
+
+/* Free every item of b no hazard names; keep the rest in b. */
+static size_t cyon_hazard_filter(cyon_bag_t *b, void **hz, size_t nhz) {
+    cyon_retired_t dead[CYON_RECLAIM_BATCH];
+    size_t keep = 0, ndead = 0, n = 0;
+    for (size_t i = 0; i < b->len; ++i) {
+        void *p = b->items[i].ptr;
+        if (nhz && bsearch(&p, hz, nhz, sizeof(void*), cyon_ptr_cmp)) {
+            b->items[keep++] = b->items[i];
+            continue;
+        }
+        dead[ndead++] = b->items[i];
+        if (ndead == CYON_RECLAIM_BATCH) {
+            n += cyon_reclaim_free_items(dead, ndead);
+            ndead = 0;
+        }
+    }
+    n += cyon_reclaim_free_items(dead, ndead);
+    b->len = keep;
+    return n;
+}
+
+static size_t cyon_hazard_scan_rec(cyon_reclaim_rec_t *rec) {
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t cap = atomic_load_explicit(&g_record_count, memory_order_acquire) * CYON_HAZARD_SLOTS;
+    if (cap == 0) cap = CYON_HAZARD_SLOTS;
+    void **hz = (void**)malloc(cap * sizeof(void*));
+    if (!hz) return 0;
+    size_t nhz = 0;
+    for (cyon_reclaim_rec_t *r = atomic_load_explicit(&g_records, memory_order_acquire); r; r = r->next) {
+        /* records registered after the count was read: grow rather than
+           filter against a truncated hazard set */
+        if (nhz + CYON_HAZARD_SLOTS > cap) {
+            void **grown = (void**)realloc(hz, cap * 2 * sizeof(void*));
+            if (!grown) {
+                free(hz);
+                return 0;
+            }
+            hz = grown;
+            cap *= 2;
+        }
+        for (int i = 0; i < CYON_HAZARD_SLOTS; ++i) {
+            void *p = atomic_load_explicit(&r->hazards[i], memory_order_seq_cst);
+            if (p) hz[nhz++] = p;
+        }
+    }
+    qsort(hz, nhz, sizeof(void*), cyon_ptr_cmp);
+    size_t n = cyon_hazard_filter(&rec->hazard_bag, hz, nhz);
+    if (pthread_mutex_trylock(&g_orphan_lock) == 0) {
+        n += cyon_hazard_filter(&g_hazard_orphans, hz, nhz);
+        pthread_mutex_unlock(&g_orphan_lock);
+    }
+    free(hz);
+    return n;
+}
+
+size_t cyon_hazard_scan(void) {
+    return cyon_hazard_scan_rec(cyon_reclaim_self());
+}
+
+void cyon_hazard_retire(void *ptr, cyon_reclaim_fn fn, void *ctx) {
+    if (!ptr) return;
+    cyon_reclaim_rec_t *rec = cyon_reclaim_self();
+    if (cyon_bag_push(&rec->hazard_bag, ptr, fn, ctx) != 0) {
+        fprintf(stderr, "cyon reclaim: out of memory\n");
+        abort();
+    }
+    cyon_counter_add(g_reclaim_retired_id, 1);
+    /* scan once the list outgrows the hazards that could pin it */
+    size_t threshold = 2 * CYON_HAZARD_SLOTS *
+        atomic_load_explicit(&g_record_count, memory_order_relaxed);
+    if (threshold < CYON_RECLAIM_BATCH) threshold = CYON_RECLAIM_BATCH;
+    if (rec->hazard_bag.len >= threshold) cyon_hazard_scan_rec(rec);
+}
+
+void cyon_hazard_retire_pool(cyon_pool_t *pool, void *obj) {
+    cyon_hazard_retire(obj, cyon_reclaim_pool_fn, pool);
+}
+
+size_t cyon_reclaim_pending(void) {
+    pthread_once(&g_reclaim_once, cyon_reclaim_init_once);
+    uint64_t retired = cyon_counter_read(g_reclaim_retired_id);
+    uint64_t freed = cyon_counter_read(g_reclaim_freed_id);
+    return retired > freed ? (size_t)(retired - freed) : 0;
+}
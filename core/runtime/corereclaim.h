@@ -0,0 +1,83 @@
+#ifndef CYON_CORE_RUNTIME_CORERECLAIM_H
+#define CYON_CORE_RUNTIME_CORERECLAIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Safe memory reclamation for lock-free structures.
+
+   Epochs: readers bracket every access with cyon_epoch_enter/exit; an
+   unlinked node is handed to cyon_epoch_retire and freed once every thread
+   that could still hold a reference has left its critical section (two
+   global epoch advances). Cheap for readers, unbounded garbage if a reader
+   stalls inside a section.
+
+   Hazard pointers: readers publish each node they are about to dereference
+   in one of a few per-thread slots; retired nodes are freed once no slot
+   names them. More expensive per access, bounded garbage.
+
+   Retired nodes of a cyon_pool_t go back to their pool in bulk. */
+
+#ifndef CYON_RECLAIM_BATCH
+#define CYON_RECLAIM_BATCH 64      /* retires between reclamation attempts */
+#endif
+
+#ifndef CYON_HAZARD_SLOTS
+#define CYON_HAZARD_SLOTS 4        /* hazard pointers per thread */
+#endif
+
+/* Same struct tag as coremem.c, so the typedef may be repeated. */
+typedef struct cyon_pool_s cyon_pool_t;
+
+typedef void (*cyon_reclaim_fn)(void *ptr, void *ctx);
+
+/* Pool hook (coremem.c): return n objects to p under one lock hold. */
+void cyon_pool_free_batch(cyon_pool_t *p, void *const *objs, size_t n);
+
+/* ---- Epochs ---- */
+
+/* Critical sections nest; only the outermost one publishes the epoch. */
+void cyon_epoch_enter(void);
+void cyon_epoch_exit(void);
+bool cyon_epoch_in_section(void);
+
+/* Free ptr with fn(ptr, ctx) (free() when fn is NULL) once no reader can
+   still see it. Call after ptr is unlinked. */
+void cyon_epoch_retire(void *ptr, cyon_reclaim_fn fn, void *ctx);
+void cyon_epoch_retire_pool(cyon_pool_t *pool, void *obj);
+
+/* Try to advance the global epoch and free what is now safe. Returns the
+   number of nodes freed. */
+size_t cyon_epoch_collect(void);
+/* Wait until everything this thread, and every thread that has exited,
+   retired so far is freed. Returns -1 inside a critical section. */
+int cyon_epoch_synchronize(void);
+uint64_t cyon_epoch_current(void);
+
+/* ---- Hazard pointers ---- */
+
+/* Load *src into hazard slot `slot` and return it once the published value
+   is known to still be reachable. */
+void *cyon_hazard_protect(int slot, void *_Atomic *src);
+void cyon_hazard_set(int slot, void *ptr);
+void cyon_hazard_clear(int slot);
+void cyon_hazard_clear_all(void);
+
+void cyon_hazard_retire(void *ptr, cyon_reclaim_fn fn, void *ctx);
+void cyon_hazard_retire_pool(cyon_pool_t *pool, void *obj);
+/* Free every retired node no hazard pointer names. Returns the count. */
+size_t cyon_hazard_scan(void);
+
+/* Nodes retired but not yet freed, both schemes, all threads. */
+size_t cyon_reclaim_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_CORERECLAIM_H */
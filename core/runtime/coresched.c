@@ -0,0 +1,455 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "runtime.h"
+#include "coresched.h"
+#include "coremetrics.h"
+
+typedef struct {
+    uint64_t key;         /* run-by time: min(deadline, enqueued + aging) */
+    uint64_t seq;
+    uint64_t deadline;    /* absolute, 0 = none */
+    uint64_t enqueued;
+    cyon_task_step_fn step;
+    cyon_task_fn plain;
+    void *user;
+    int cls;
+    bool missed;
+} cyon_sched_task_t;
+
+typedef struct {
+    cyon_sched_task_t **heap;
+    size_t len;
+    size_t cap;
+} cyon_sched_heap_t;
+
+typedef struct {
+    uint64_t running;
+    uint64_t completed;
+    uint64_t yields;
+    uint64_t deadline_misses;
+} cyon_sched_counts_t;
+
+struct cyon_sched_s {
+    cyon_sched_config_t cfg;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    cyon_sched_heap_t queues[CYON_TASK_CLASSES];
+    _Atomic uint64_t depth[CYON_TASK_CLASSES];  /* read lock-free by should_yield */
+    cyon_sched_counts_t counts[CYON_TASK_CLASSES];
+    size_t live[CYON_TASK_CLASSES];             /* queued + running, per class */
+    uint64_t seq;
+    size_t outstanding;                         /* queued + running */
+    int bg_running;
+    bool stopping;
+    pthread_t *threads;
+    int nthreads;
+};
+
+/* Process-wide metrics, one set per class. */
+typedef struct {
+    cyon_metric_id depth;
+    cyon_metric_id wait_us;
+    cyon_metric_id run_us;
+    cyon_metric_id yields;
+    cyon_metric_id misses;
+} cyon_sched_metrics_t;
+
+static const char *const g_sched_metric_names[CYON_TASK_CLASSES][5] = {
+    { "sched.critical.depth", "sched.critical.wait_us", "sched.critical.run_us",
+      "sched.critical.yields", "sched.critical.deadline_misses" },
+    { "sched.interactive.depth", "sched.interactive.wait_us", "sched.interactive.run_us",
+      "sched.interactive.yields", "sched.interactive.deadline_misses" },
+    { "sched.normal.depth", "sched.normal.wait_us", "sched.normal.run_us",
+      "sched.normal.yields", "sched.normal.deadline_misses" },
+    { "sched.background.depth", "sched.background.wait_us", "sched.background.run_us",
+      "sched.background.yields", "sched.background.deadline_misses" },
+};
+
+static const char *const g_sched_class_names[CYON_TASK_CLASSES] = {
+    "critical", "interactive", "normal", "background"
+};
+
+static cyon_sched_metrics_t g_sched_metrics[CYON_TASK_CLASSES];
+static pthread_once_t g_sched_metrics_once = PTHREAD_ONCE_INIT;
+
+static void cyon_sched_metrics_init(void) {
+    for (int c = 0; c < CYON_TASK_CLASSES; ++c) {
+        g_sched_metrics[c].depth = cyon_metric_register(g_sched_metric_names[c][0], CYON_METRIC_GAUGE);
+        g_sched_metrics[c].wait_us = cyon_metric_register(g_sched_metric_names[c][1], CYON_METRIC_HISTOGRAM);
+        g_sched_metrics[c].run_us = cyon_metric_register(g_sched_metric_names[c][2], CYON_METRIC_HISTOGRAM);
+        g_sched_metrics[c].yields = cyon_metric_register(g_sched_metric_names[c][3], CYON_METRIC_COUNTER);
+        g_sched_metrics[c].misses = cyon_metric_register(g_sched_metric_names[c][4], CYON_METRIC_COUNTER);
+    }
+}
+
+/* The running task, for cyon_task_should_yield(). */
+typedef struct {
+    cyon_sched_t *sched;
+    int cls;
+    uint64_t started;
+} cyon_sched_current_t;
+
+static _Thread_local cyon_sched_current_t t_sched_current = { NULL, -1, 0 };
+
+uint64_t cyon_sched_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/* ---- per-class heap ordered by (key, seq) ---- */
+
+static bool cyon_sched_before(const cyon_sched_task_t *a, const cyon_sched_task_t *b) {
+    if (a->key != b->key) return a->key < b->key;
+    return a->seq < b->seq;
+}
+
+/* Room for want entries. Submit reserves a slot for every live task of the
+   class, so a yielding task is always requeued without allocating. */
+static int cyon_sched_heap_reserve(cyon_sched_heap_t *h, size_t want) {
+    if (want <= h->cap) return 0;
+    size_t ncap = h->cap ? h->cap : 64;
+    while (ncap < want) ncap *= 2;
+    cyon_sched_task_t **n = (cyon_sched_task_t**)realloc(h->heap, ncap * sizeof(*n));
+    if (!n) return -1;
+    h->heap = n;
+    h->cap = ncap;
+    return 0;
+}
+
+static void cyon_sched_heap_push(cyon_sched_heap_t *h, cyon_sched_task_t *t) {
+    size_t i = h->len++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!cyon_sched_before(t, h->heap[parent])) break;
+        h->heap[i] = h->heap[parent];
+        i = parent;
+    }
+    h->heap[i] = t;
+}
+
+static cyon_sched_task_t *cyon_sched_heap_pop(cyon_sched_heap_t *h) {
+    if (h->len == 0) return NULL;
+    cyon_sched_task_t *top = h->heap[0];
+    cyon_sched_task_t *last = h->heap[--h->len];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= h->len) break;
+        if (c + 1 < h->len && cyon_sched_before(h->heap[c + 1], h->heap[c])) c++;
+        if (!cyon_sched_before(h->heap[c], last)) break;
+        h->heap[i] = h->heap[c];
+        i = c;
+    }
+    if (h->len) h->heap[i] = last;
+    return top;
+}
+
+/* ---- queueing (caller holds s->lock) ---- */
+
+/* The class heap has room (see cyon_sched_heap_reserve). */
+static void cyon_sched_enqueue_locked(cyon_sched_t *s, cyon_sched_task_t *t, uint64_t now) {
+    t->enqueued = now;
+    t->key = now + s->cfg.aging_us[t->cls];
+    if (t->deadline && t->deadline < t->key) t->key = t->deadline;
+    t->seq = s->seq++;
+    cyon_sched_heap_push(&s->queues[t->cls], t);
+    atomic_fetch_add_explicit(&s->depth[t->cls], 1, memory_order_relaxed);
+    cyon_gauge_add(g_sched_metrics[t->cls].depth, 1);
+    pthread_cond_signal(&s->work);
+}
+
+static bool cyon_sched_class_eligible(cyon_sched_t *s, int c) {
+    if (s->queues[c].len == 0) return false;
+    if (c != CYON_TASK_BACKGROUND || s->bg_running < s->cfg.max_background) return true;
+    /* max_background 0 (one worker): only while no foreground task waits */
+    if (s->cfg.max_background > 0 || s->bg_running > 0) return false;
+    for (int f = 0; f < CYON_TASK_BACKGROUND; ++f)
+        if (s->queues[f].len > 0) return false;
+    return true;
+}
+
+/* Overdue heads first (smallest run-by time wins, whatever the class),
+   then strict class priority. */
+static cyon_sched_task_t *cyon_sched_pick_locked(cyon_sched_t *s, uint64_t now) {
+    int best = -1;
+    for (int c = 0; c < CYON_TASK_CLASSES; ++c) {
+        if (!cyon_sched_class_eligible(s, c)) continue;
+        const cyon_sched_task_t *head = s->queues[c].heap[0];
+        if (head->key > now) continue;
+        if (best < 0 || cyon_sched_before(head, s->queues[best].heap[0])) best = c;
+    }
+    if (best < 0) {
+        for (int c = 0; c < CYON_TASK_CLASSES; ++c) {
+            if (cyon_sched_class_eligible(s, c)) { best = c; break; }
+        }
+    }
+    if (best < 0) return NULL;
+    atomic_fetch_sub_explicit(&s->depth[best], 1, memory_order_relaxed);
+    cyon_gauge_add(g_sched_metrics[best].depth, -1);
+    return cyon_sched_heap_pop(&s->queues[best]);
+}
+
+static void *cyon_sched_worker(void *arg) {
+    cyon_sched_t *s = (cyon_sched_t*)arg;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        uint64_t now = cyon_sched_now_us();
+        cyon_sched_task_t *t = cyon_sched_pick_locked(s, now);
+        if (!t) {
+            if (s->stopping && s->outstanding == 0) break;
+            pthread_cond_wait(&s->work, &s->lock);
+            continue;
+        }
+        int c = t->cls;
+        s->counts[c].running++;
+        if (c == CYON_TASK_BACKGROUND) s->bg_running++;
+        bool miss = t->deadline && now > t->deadline && !t->missed;
+        if (miss) {
+            t->missed = true;
+            s->counts[c].deadline_misses++;
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        const cyon_sched_metrics_t *m = &g_sched_metrics[c];
+        cyon_histogram_record(m->wait_us, now - t->enqueued);
+        if (miss) cyon_counter_add(m->misses, 1);
+        t_sched_current.sched = s;
+        t_sched_current.cls = c;
+        t_sched_current.started = now;
+        int r = CYON_TASK_DONE;
+        if (t->step) r = t->step(t->user);
+        else t->plain(t->user);
+        t_sched_current.sched = NULL;
+        t_sched_current.cls = -1;
+        uint64_t end = cyon_sched_now_us();
+        cyon_histogram_record(m->run_us, end - now);
+
+        pthread_mutex_lock(&s->lock);
+        s->counts[c].running--;
+        if (c == CYON_TASK_BACKGROUND) {
+            s->bg_running--;
+            pthread_cond_signal(&s->work);  /* a background slot is free */
+        }
+        if (r == CYON_TASK_YIELD) {
+            s->counts[c].yields++;
+            cyon_counter_add(m->yields, 1);
+            cyon_sched_enqueue_locked(s, t, end);
+            continue;
+        }
+        s->counts[c].completed++;
+        s->live[c]--;
+        free(t);
+        if (--s->outstanding == 0) {
+            pthread_cond_broadcast(&s->idle);
+            if (s->stopping) pthread_cond_broadcast(&s->work);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/* ---- public API ---- */
+
+cyon_sched_config_t cyon_sched_default_config(int nworkers) {
+    cyon_sched_config_t cfg;
+    cfg.nworkers = nworkers > 0 ? nworkers : 1;
+    cfg.max_background = 0;
+    cfg.aging_us[CYON_TASK_CRITICAL] = 1000;         /* 1 ms */
+    cfg.aging_us[CYON_TASK_INTERACTIVE] = 10000;     /* 10 ms */
+    cfg.aging_us[CYON_TASK_NORMAL] = 100000;         /* 100 ms */
+    cfg.aging_us[CYON_TASK_BACKGROUND] = 1000000;    /* 1 s */
+    cfg.slice_us = 2000;
+    return cfg;
+}
+
+cyon_sched_t *cyon_sched_create(const cyon_sched_config_t *cfg) {
+    pthread_once(&g_sched_metrics_once, cyon_sched_metrics_init);
+    cyon_sched_t *s = (cyon_sched_t*)calloc(1, sizeof(cyon_sched_t));
+    if (!s) return NULL;
+    s->cfg = cfg ? *cfg : cyon_sched_default_config(1);
+    if (s->cfg.nworkers < 1) s->cfg.nworkers = 1;
+    if (s->cfg.max_background <= 0 || s->cfg.max_background >= s->cfg.nworkers)
+        s->cfg.max_background = s->cfg.nworkers - 1;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work, NULL);
+    pthread_cond_init(&s->idle, NULL);
+    s->threads = (pthread_t*)calloc((size_t)s->cfg.nworkers, sizeof(pthread_t));
+    if (!s->threads) { cyon_sched_destroy(s); return NULL; }
+    for (int i = 0; i < s->cfg.nworkers; ++i) {
+        if (pthread_create(&s->threads[i], NULL, cyon_sched_worker, s) != 0) break;
+        s->nthreads++;
+    }
+    if (s->nthreads == 0) { cyon_sched_destroy(s); return NULL; }
+    return s;
+}
+
+void cyon_sched_destroy(cyon_sched_t *s) {
+    if (!s) return;
+    pthread_mutex_lock(&s->lock);
+    s->stopping = true;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+    for (int i = 0; i < s->nthreads; ++i) pthread_join(s->threads[i], NULL);
+    for (int c = 0; c < CYON_TASK_CLASSES; ++c) {
+        cyon_sched_task_t *t;
+        while ((t = cyon_sched_heap_pop(&s->queues[c])) != NULL) free(t);
+        free(s->queues[c].heap);
+    }
+    free(s->threads);
+    pthread_cond_destroy(&s->idle);
+    pthread_cond_destroy(&s->work);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+static int cyon_sched_push(cyon_sched_t *s, cyon_task_class_t cls, uint64_t deadline_us,
+                           cyon_task_step_fn step, cyon_task_fn plain, void *user) {
+    if (!s || (!step && !plain) || (int)cls < 0 || (int)cls >= CYON_TASK_CLASSES) return -1;
+    cyon_sched_task_t *t = (cyon_sched_task_t*)calloc(1, sizeof(cyon_sched_task_t));
+    if (!t) return -1;
+    uint64_t now = cyon_sched_now_us();
+    t->cls = (int)cls;
+    t->deadline = deadline_us ? now + deadline_us : 0;
+    t->step = step;
+    t->plain = plain;
+    t->user = user;
+    pthread_mutex_lock(&s->lock);
+    if (s->stopping || cyon_sched_heap_reserve(&s->queues[cls], s->live[cls] + 1) != 0) {
+        pthread_mutex_unlock(&s->lock);
+        free(t);
+        return -1;
+    }
+    cyon_sched_enqueue_locked(s, t, now);
+    s->live[cls]++;
+    s->outstanding++;
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+}
+
+int cyon_sched_submit(cyon_sched_t *s, cyon_task_class_t cls, uint64_t deadline_us,
+                      cyon_task_step_fn fn, void *user) {
+    return cyon_sched_push(s, cls, deadline_us, fn, NULL, user);
+}
+
+void cyon_sched_wait(cyon_sched_t *s) {
+    if (!s) return;
+    pthread_mutex_lock(&s->lock);
+    while (s->outstanding > 0) pthread_cond_wait(&s->idle, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+bool cyon_task_should_yield(void) {
+    const cyon_sched_current_t *cur = &t_sched_current;
+    if (!cur->sched) return false;
+    if (cyon_sched_now_us() - cur->started >= cur->sched->cfg.slice_us) return true;
+    for (int c = 0; c < cur->cls; ++c)
+        if (atomic_load_explicit(&cur->sched->depth[c], memory_order_relaxed) > 0) return true;
+    return false;
+}
+
+int cyon_task_current_class(void) {
+    return t_sched_current.sched ? t_sched_current.cls : -1;
+}
+
+void cyon_sched_class_stats(cyon_sched_t *s, cyon_task_class_t cls, cyon_sched_class_stats_t *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s || (int)cls < 0 || (int)cls >= CYON_TASK_CLASSES) return;
+    pthread_mutex_lock(&s->lock);
+    out->depth = s->queues[cls].len;
+    out->running = s->counts[cls].running;
+    out->completed = s->counts[cls].completed;
+    out->yields = s->counts[cls].yields;
+    out->deadline_misses = s->counts[cls].deadline_misses;
+    pthread_mutex_unlock(&s->lock);
+    /* latency percentiles are process-wide (shared metrics) */
+    cyon_histogram_snapshot_t *snap = (cyon_histogram_snapshot_t*)malloc(sizeof(*snap));
+    if (!snap) return;
+    if (cyon_histogram_read(g_sched_metrics[cls].wait_us, snap) == 0) {
+        out->wait_p50_us = cyon_histogram_quantile(snap, 0.50);
+        out->wait_p99_us = cyon_histogram_quantile(snap, 0.99);
+    }
+    if (cyon_histogram_read(g_sched_metrics[cls].run_us, snap) == 0)
+        out->run_p99_us = cyon_histogram_quantile(snap, 0.99);
+    free(snap);
+}
+
+void cyon_sched_report(cyon_sched_t *s, FILE *out) {
+    if (!s) return;
+    if (!out) out = stdout;
+    fprintf(out, "=== Cyon Scheduler (%d workers) ===\n", s->nthreads);
+    fprintf(out, "%-12s %8s %8s %10s %8s %8s %10s %10s %10s\n", "class", "depth", "running",
+            "completed", "yields", "missed", "wait p50", "wait p99", "run p99");
+    for (int c = 0; c < CYON_TASK_CLASSES; ++c) {
+        cyon_sched_class_stats_t st;
+        cyon_sched_class_stats(s, (cyon_task_class_t)c, &st);
+        fprintf(out, "%-12s %8llu %8llu %10llu %8llu %8llu %8lluus %8lluus %8lluus\n",
+                g_sched_class_names[c],
+                (unsigned long long)st.depth, (unsigned long long)st.running,
+                (unsigned long long)st.completed, (unsigned long long)st.yields,
+                (unsigned long long)st.deadline_misses, (unsigned long long)st.wait_p50_us,
+                (unsigned long long)st.wait_p99_us, (unsigned long long)st.run_p99_us);
+    }
+}
+
+/* ---- runtime task API ---- */
+
+static pthread_mutex_t g_runtime_sched_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The runtime's scheduler lives in rt->internal, created on first use with
+   cfg.max_workers workers. */
+cyon_sched_t *cyon_runtime_scheduler(cyon_runtime_t *rt) {
+    if (!rt) return NULL;
+    pthread_mutex_lock(&g_runtime_sched_lock);
+    if (!rt->internal) {
+        cyon_sched_config_t cfg = cyon_sched_default_config(rt->cfg.max_workers);
+        rt->internal = cyon_sched_create(&cfg);
+    }
+    cyon_sched_t *s = (cyon_sched_t*)rt->internal;
+    pthread_mutex_unlock(&g_runtime_sched_lock);
+    return s;
+}
+
+cyon_status cyon_runtime_submit_task(cyon_runtime_t *rt, cyon_task_fn fn, void *user_data) {
+    if (!fn) return CYON_STATUS_ERROR;
+    cyon_sched_t *s = cyon_runtime_scheduler(rt);
+    return cyon_sched_push(s, CYON_TASK_NORMAL, 0, NULL, fn, user_data) == 0
+        ? CYON_STATUS_OK : CYON_STATUS_ERROR;
+}
+
+cyon_status cyon_runtime_submit_task_ex(cyon_runtime_t *rt, cyon_task_class_t cls, uint64_t deadline_us,
+                                        cyon_task_step_fn fn, void *user_data) {
+    cyon_sched_t *s = cyon_runtime_scheduler(rt);
+    return cyon_sched_push(s, cls, deadline_us, fn, NULL, user_data) == 0
+        ? CYON_STATUS_OK : CYON_STATUS_ERROR;
+}
+
+void cyon_runtime_wait_tasks(cyon_runtime_t *rt) {
+    if (!rt) return;
+    pthread_mutex_lock(&g_runtime_sched_lock);
+    cyon_sched_t *s = (cyon_sched_t*)rt->internal;
+    pthread_mutex_unlock(&g_runtime_sched_lock);
+    cyon_sched_wait(s);
+}
+
+void cyon_runtime_stop_tasks(cyon_runtime_t *rt) {
+    if (!rt) return;
+    pthread_mutex_lock(&g_runtime_sched_lock);
+    cyon_sched_t *s = (cyon_sched_t*)rt->internal;
+    rt->internal = NULL;
+    pthread_mutex_unlock(&g_runtime_sched_lock);
+    cyon_sched_destroy(s);
+}
@@ -0,0 +1,89 @@
+#ifndef CYON_CORE_RUNTIME_CORESCHED_H
+#define CYON_CORE_RUNTIME_CORESCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Priority- and deadline-aware task scheduler behind the runtime task API.
+
+   Tasks belong to one of four classes, served in priority order; within a
+   class the earliest deadline runs first (FIFO among equal deadlines).
+   A task that has waited longer than its class's aging bound is served
+   ahead of higher classes, so nothing starves. Background tasks may occupy
+   at most max_background workers (at most nworkers - 1), which keeps
+   capacity free for foreground work. With a single worker max_background
+   is 0: a background task starts only while no foreground task is queued.
+
+   Long tasks are step functions: each call does a slice of work and returns
+   CYON_TASK_YIELD to be requeued (behind same-class peers and anything more
+   urgent) or CYON_TASK_DONE. cyon_task_should_yield() tells a step when to
+   stop. */
+
+typedef enum {
+    CYON_TASK_CRITICAL = 0,
+    CYON_TASK_INTERACTIVE = 1,
+    CYON_TASK_NORMAL = 2,
+    CYON_TASK_BACKGROUND = 3
+} cyon_task_class_t;
+
+#define CYON_TASK_CLASSES 4
+
+#define CYON_TASK_DONE 0
+#define CYON_TASK_YIELD 1
+
+typedef int (*cyon_task_step_fn)(void *user);
+
+typedef struct {
+    int nworkers;
+    int max_background;                     /* 0 = nworkers - 1; capped there */
+    uint64_t aging_us[CYON_TASK_CLASSES];   /* max queue wait before promotion */
+    uint64_t slice_us;                      /* cyon_task_should_yield budget */
+} cyon_sched_config_t;
+
+typedef struct cyon_sched_s cyon_sched_t;
+
+typedef struct {
+    uint64_t depth;            /* queued, not running */
+    uint64_t running;
+    uint64_t completed;
+    uint64_t yields;
+    uint64_t deadline_misses;  /* started after their deadline */
+    uint64_t wait_p50_us;
+    uint64_t wait_p99_us;
+    uint64_t run_p99_us;
+} cyon_sched_class_stats_t;
+
+cyon_sched_config_t cyon_sched_default_config(int nworkers);
+cyon_sched_t *cyon_sched_create(const cyon_sched_config_t *cfg);
+/* Runs everything still queued, then joins the workers. */
+void cyon_sched_destroy(cyon_sched_t *s);
+
+/* deadline_us is relative to now; 0 means no deadline (FIFO in class).
+   Returns 0, or -1 on bad arguments / allocation failure / shutdown.
+   Queue space is reserved here, so a task that yields is never dropped. */
+int cyon_sched_submit(cyon_sched_t *s, cyon_task_class_t cls, uint64_t deadline_us,
+                      cyon_task_step_fn fn, void *user);
+/* Block until no task is queued or running. */
+void cyon_sched_wait(cyon_sched_t *s);
+
+/* For the running step: true once its slice is used up or a task of a
+   higher class is waiting. Always false outside a scheduler worker. */
+bool cyon_task_should_yield(void);
+/* Class of the running task, or -1 outside a scheduler worker. */
+int cyon_task_current_class(void);
+
+void cyon_sched_class_stats(cyon_sched_t *s, cyon_task_class_t cls, cyon_sched_class_stats_t *out);
+void cyon_sched_report(cyon_sched_t *s, FILE *out);
+uint64_t cyon_sched_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_CORESCHED_H */
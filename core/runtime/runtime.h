@@ -10,6 +10,8 @@ extern "C" {
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "coresched.h"
+
 /* Versioning */
 #define CYON_RUNTIME_API_MAJOR 1
 #define CYON_RUNTIME_API_MINOR 0
@@ -74,15 +76,24 @@ void cyon_runtime_log(cyon_runtime_t *rt, const char *level, const char *fmt, ..
 /* Time helpers */
 cyon_time_ms_t cyon_runtime_now_ms(void);
 
-/* Worker / tasks (very small cooperative worker model to be extended) */
+/* Worker / tasks (priority classes and deadlines, see coresched.h) */
 
-/* Submit a task to runtime; task runs on worker thread if enabled. The task must be a function taking a single void* parameter. */
+/* Submit a task to runtime; task runs on worker thread if enabled. The task must be a function taking a single void* parameter. Runs in CYON_TASK_NORMAL. */
 typedef void (*cyon_task_fn)(void *); 
 cyon_status cyon_runtime_submit_task(cyon_runtime_t *rt, cyon_task_fn fn, void *user_data);
 
+/* Submit a step task in a priority class with an optional deadline (microseconds from now, 0 = none). Return CYON_TASK_YIELD from fn to be rescheduled. */
+cyon_status cyon_runtime_submit_task_ex(cyon_runtime_t *rt, cyon_task_class_t cls, uint64_t deadline_us, cyon_task_step_fn fn, void *user_data);
+
 /* Wait for all tasks to complete (simple barrier) */
 void cyon_runtime_wait_tasks(cyon_runtime_t *rt);
 
+/* Scheduler behind the task API (created on first use with max_workers workers) */
+cyon_sched_t *cyon_runtime_scheduler(cyon_runtime_t *rt);
+
+/* Run remaining tasks and stop the workers; part of shutdown */
+void cyon_runtime_stop_tasks(cyon_runtime_t *rt);
+
 /* Memory hooks (optional) */
 typedef void* (*cyon_malloc_hook_t)(size_t size);
 typedef void  (*cyon_free_hook_t)(void *ptr);
@@ -124,7 +135,7 @@ struct cyon_runtime_s {
     cyon_free_hook_t free_hook;
     int refcount;
     int tasks_running;
-    /* placeholder for worker threads, module list, memory pools, etc */
+    /* task scheduler (cyon_sched_t); module list, memory pools, etc to come */
     void *internal;
 };
 
@@ -5146,4 +5157,10 @@ static inline void cyon_runtime_helper_998(void) {
 static inline void cyon_runtime_helper_999(void) {
     volatile int _cyon_runtime_flag_999 = 999;
     (void)_cyon_runtime_flag_999;
-}
\ No newline at end of file
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYON_CORE_RUNTIME_RUNTIME_H */
@@ -0,0 +1,66 @@
+#ifndef CYONACTOR_H
+#define CYONACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+#include "cyonthread.h"
+
+/* Actors: isolated state plus a mailbox, run on a shared worker pool.
+   Sending is one atomic exchange into a lock-free MPSC mailbox; an actor
+   with pending messages is queued on the pool once and drains up to
+   `batch` messages per turn, so an actor is only ever processed by one
+   worker at a time and its handler needs no locking of its own state.
+   Thousands of actors can share a pool of a few threads. */
+
+typedef struct cyon_actor_system_s cyon_actor_system_t;
+typedef struct cyon_actor_s cyon_actor_t;
+
+/* Delivered once, after every message sent before cyon_actor_stop. */
+#define CYON_ACTOR_STOP (-1)
+
+/* msg points to a copy of the sent payload (msg_size bytes), valid for the
+   duration of the call. */
+typedef void (*cyon_actor_fn)(cyon_actor_t *self, int type, void *msg, void *state);
+
+/* pool NULL uses cyon_threadpool_shared(). batch 0 = 64 messages per turn. */
+CYON_API int cyon_actor_system_create(cyon_actor_system_t **out, cyon_threadpool_t *pool, size_t batch);
+/* Stop every actor, wait until all are gone, free the system (not the pool). */
+CYON_API int cyon_actor_system_destroy(cyon_actor_system_t *sys);
+/* Block until no actor has a pending message. */
+CYON_API int cyon_actor_system_wait(cyon_actor_system_t *sys);
+CYON_API size_t cyon_actor_system_count(cyon_actor_system_t *sys);
+
+/* The returned handle owns one reference (cyon_actor_release). */
+CYON_API int cyon_actor_spawn(cyon_actor_system_t *sys, cyon_actor_t **out, cyon_actor_fn fn,
+                              void *state, size_t msg_size);
+/* Copy msg_size bytes from msg (zeroes when msg is NULL) into the mailbox.
+   Returns 0, EPIPE once the actor is stopping, or ENOMEM. */
+CYON_API int cyon_actor_send(cyon_actor_t *a, int type, const void *msg);
+/* Enqueue CYON_ACTOR_STOP behind every send that has returned 0 or is
+   still in progress; sends that start later fail with EPIPE. */
+CYON_API int cyon_actor_stop(cyon_actor_t *a);
+CYON_API void cyon_actor_retain(cyon_actor_t *a);
+CYON_API void cyon_actor_release(cyon_actor_t *a);
+
+/* The actor whose handler is running on this thread, or NULL. */
+CYON_API cyon_actor_t *cyon_actor_self(void);
+CYON_API void *cyon_actor_state(cyon_actor_t *a);
+CYON_API size_t cyon_actor_pending(cyon_actor_t *a);
+
+/* Typed mailboxes: CYON_ACTOR_TYPED(counter, struct counter_msg) defines
+   counter_spawn(sys, &a, fn, state) and counter_send(a, type, value). */
+#define CYON_ACTOR_TYPED(name, T) \
+    static inline int name##_spawn(cyon_actor_system_t *sys, cyon_actor_t **out, \
+                                   cyon_actor_fn fn, void *state) { \
+        return cyon_actor_spawn(sys, out, fn, state, sizeof(T)); } \
+    static inline int name##_send(cyon_actor_t *a, int type, T v) { \
+        return cyon_actor_send(a, type, &v); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONACTOR_H */
@@ -0,0 +1,55 @@
+#ifndef CYONCORO_H
+#define CYONCORO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+
+/* Stackful coroutines multiplexed onto a few worker threads (M:N).
+   A coroutine that waits on a file descriptor or a timer is parked and its
+   worker moves on to other coroutines; the scheduler's poller re-queues it
+   when the fd becomes ready or the deadline passes. */
+
+typedef struct cyon_coro_sched_s cyon_coro_sched_t;
+
+/* Default stack size matches cyon_runtime_default_config().stack_size. */
+#define CYON_CORO_DEFAULT_STACK (1u << 20)
+
+typedef struct {
+    size_t stack_size;   /* per-coroutine stack; pass cyon_runtime_config_t.stack_size (0 = default) */
+    size_t nworkers;     /* worker threads; 0 = online CPUs */
+    int guard_pages;     /* non-zero: PROT_NONE page below every stack */
+    size_t stack_cache;  /* finished stacks kept for reuse */
+} cyon_coro_config_t;
+
+/* readiness flags for cyon_coro_wait_fd */
+#define CYON_CORO_READ  1
+#define CYON_CORO_WRITE 2
+
+CYON_API void cyon_coro_default_config(cyon_coro_config_t *cfg);
+
+CYON_API int cyon_coro_sched_create(cyon_coro_sched_t **out, const cyon_coro_config_t *cfg);
+/* Wait for every coroutine to finish, then stop the workers and free all stacks. */
+CYON_API int cyon_coro_sched_destroy(cyon_coro_sched_t *s);
+/* Block the calling (non-coroutine) thread until no coroutines are alive. */
+CYON_API int cyon_coro_sched_wait(cyon_coro_sched_t *s);
+CYON_API size_t cyon_coro_sched_alive(cyon_coro_sched_t *s);
+
+/* Start fn(arg) as a new coroutine. Callable from any thread or coroutine. */
+CYON_API int cyon_coro_spawn(cyon_coro_sched_t *s, void (*fn)(void*), void *arg);
+
+/* The following are only valid inside a coroutine (EPERM otherwise). */
+CYON_API int cyon_coro_yield(void);
+CYON_API int cyon_coro_sleep_ms(unsigned int ms);
+/* Park until fd is ready for events (CYON_CORO_READ/WRITE). timeout_ms < 0
+   waits forever. Returns 0 with *revents set, or ETIMEDOUT. */
+CYON_API int cyon_coro_wait_fd(int fd, int events, int timeout_ms, int *revents);
+CYON_API int cyon_coro_in_coroutine(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONCORO_H */
@@ -28,6 +28,82 @@ CYON_API int cyon_tail(const char *path, size_t n, int (*cb)(const char *line, v
 CYON_API int cyon_file_size(const char *path, size_t *out_size);
 CYON_API int cyon_file_exists(const char *path);
 
+/* Block line reader: the file is mapped (read in large blocks when it cannot
+   be) and newlines are found with memchr, which libc vectorises. Each line
+   reaches cb as a slice into the block, without its "\n" or "\r\n" and
+   valid only during the call. cb returns 0 to continue; anything else stops
+   the scan and is returned. */
+CYON_API int cyon_scanlines(const char *path, int (*cb)(cyon_slice_t line, void *userdata), void *userdata);
+/* Parallel variant shaped like cyon_par_reduce: the file is split at line
+   boundaries across the worker pool and each part folds its lines, in file
+   order, into its own copy of identity. Parts are combined into *result in
+   file order. line runs concurrently for different parts; a non-zero return
+   stops every part and is returned, leaving *result incomplete. */
+CYON_API int cyon_scanlines_par(const char *path, void *result, size_t result_size, const void *identity,
+                                int (*line)(cyon_slice_t line, void *partial, void *ctx),
+                                void (*combine)(void *acc, const void *partial, void *ctx), void *ctx);
+
+/* Memory-mapped files. Unlike cyon_readfile nothing is copied: pages are
+   read in on first touch and parsers work on the mapped bytes directly.
+   A whole-file mapping needs address space for the whole file; a windowed
+   one maps window bytes at a time and moves as views are requested. */
+typedef struct cyon_mmap_s cyon_mmap_t;
+
+/* open flags */
+#define CYON_MMAP_READ      0
+#define CYON_MMAP_WRITE     1   /* shared read-write: stores reach the file */
+#define CYON_MMAP_CREATE    2   /* with WRITE: create the file, grow it to size */
+#define CYON_MMAP_POPULATE  4   /* prefault the mapping up front */
+
+/* access advice */
+#define CYON_MMAP_NORMAL     0
+#define CYON_MMAP_SEQUENTIAL 1  /* aggressive read-ahead, pages dropped behind */
+#define CYON_MMAP_RANDOM     2  /* no read-ahead */
+#define CYON_MMAP_WILLNEED   3  /* start reading the range in now */
+#define CYON_MMAP_DONTNEED   4  /* the range can be dropped */
+
+/* Map the whole file. With CYON_MMAP_CREATE a missing file is created and
+   one shorter than size is extended with zeroes; an existing file is never
+   truncated (cyon_mmap_resize shrinks). An empty file maps to a
+   zero-length view. */
+CYON_API int cyon_mmap_open(cyon_mmap_t **out, const char *path, int flags, size_t size);
+/* Windowed mapping: at most window bytes (rounded to pages) are mapped at
+   a time, unless a single view asks for more. */
+CYON_API int cyon_mmap_open_window(cyon_mmap_t **out, const char *path, int flags, size_t window);
+CYON_API void cyon_mmap_close(cyon_mmap_t *m);
+/* Start of a whole-file mapping; NULL for windowed ones. */
+CYON_API void *cyon_mmap_data(const cyon_mmap_t *m);
+CYON_API uint64_t cyon_mmap_size(const cyon_mmap_t *m);
+/* Point *ptr at file offset off and return how many of the len bytes from
+   there are mapped (fewer only at end of file), or -errno. A windowed
+   mapping moves when the range is not inside the current window, which
+   invalidates pointers into the previous one. */
+CYON_API ssize_t cyon_mmap_view(cyon_mmap_t *m, uint64_t off, size_t len, void **ptr);
+/* Advise on [off, off+len); len 0 means the whole file, and for windowed
+   mappings also every window mapped later. */
+CYON_API int cyon_mmap_advise(cyon_mmap_t *m, uint64_t off, size_t len, int advice);
+/* Write dirty pages of the current mapping back; wait = 0 only starts it. */
+CYON_API int cyon_mmap_sync(cyon_mmap_t *m, int wait);
+/* Change the file size (WRITE mappings). A whole-file mapping is remapped
+   and may move. */
+CYON_API int cyon_mmap_resize(cyon_mmap_t *m, uint64_t size);
+
+/* Batched positional I/O: the whole batch goes to the kernel in one
+   io_uring submission (a pread/pwrite loop when io_uring is unavailable).
+   Each result is the byte count, which may be short, or -errno. Nothing
+   is left in flight when it returns; after an error, entries that were
+   never submitted hold -ECANCELED. */
+typedef struct {
+    int fd;
+    int write;          /* 0 = read, 1 = write */
+    void *buf;
+    size_t len;
+    off_t offset;
+    ssize_t result;
+} cyon_file_io_t;
+
+CYON_API int cyon_file_io_batch(cyon_file_io_t *reqs, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,101 @@
+#ifndef CYONHTTP_H
+#define CYONHTTP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+#include "cyonnet.h"
+
+/* HTTP/1.1 server on the corenet reactor.
+   Requests are parsed in place: every slice in cyon_http_request_t points
+   into the connection's input and stays valid until the handler returns.
+   Keep-alive and pipelining are on by default; responses to pipelined
+   requests are sent in order, and all responses produced from one batch
+   of input leave in a single write. */
+
+#ifndef CYON_HTTP_MAX_HEADERS
+#define CYON_HTTP_MAX_HEADERS 32
+#endif
+
+typedef struct {
+    cyon_slice_t name;
+    cyon_slice_t value;
+} cyon_http_header_t;
+
+typedef struct {
+    cyon_slice_t method;
+    cyon_slice_t target;        /* as sent: path plus query */
+    cyon_slice_t path;
+    cyon_slice_t query;         /* after '?', empty if none */
+    int minor;                  /* HTTP/1.<minor> */
+    cyon_http_header_t headers[CYON_HTTP_MAX_HEADERS];
+    size_t nheaders;
+    int64_t content_length;     /* -1 when absent */
+    int chunked;                /* Transfer-Encoding: chunked */
+    int keep_alive;
+    int expect_continue;
+    cyon_slice_t body;          /* complete (de-chunked) body */
+} cyon_http_request_t;
+
+/* Parse the request line and headers at the start of buf. Returns the
+   head length (through the blank line), 0 if the head is incomplete, or
+   -EBADMSG / -EMSGSIZE (too many headers) / -ENOTSUP (transfer coding
+   other than chunked). *scanned carries the search position between calls
+   on the same, growing input; set it to 0 for each new request. body is
+   left empty. */
+CYON_API ssize_t cyon_http_parse_request(const char *buf, size_t len, size_t *scanned, cyon_http_request_t *req);
+/* Case-insensitive lookup; empty slice (ptr NULL) if missing. */
+CYON_API cyon_slice_t cyon_http_header(const cyon_http_request_t *req, const char *name);
+
+typedef struct cyon_http_server_s cyon_http_server_t;
+/* Per-connection exchange handle, valid until the response is finished. */
+typedef struct cyon_http_ctx_s cyon_http_ctx_t;
+
+/* Must eventually produce one response, either before returning or later
+   from the reactor thread (a deferred response). Further pipelined
+   requests on the connection wait until it is finished. */
+typedef void (*cyon_http_handler)(cyon_http_ctx_t *x, const cyon_http_request_t *req, void *user);
+
+typedef struct {
+    size_t max_header_bytes;    /* 16384; larger heads get 431 */
+    size_t max_body_bytes;      /* 524288; larger bodies get 413 */
+    unsigned int idle_timeout_ms;   /* keep-alive idle limit: 5000 */
+    size_t max_requests;        /* per connection, 0 = unlimited */
+} cyon_http_opts_t;
+
+/* opts may be NULL for the defaults. */
+CYON_API int cyon_http_server_create(cyon_http_server_t **out, const cyon_http_opts_t *opts,
+                                     cyon_http_handler fn, void *user);
+/* Destroy after the reactors serving it have stopped. */
+CYON_API void cyon_http_server_destroy(cyon_http_server_t *s);
+/* Serve listen_fd on one reactor, or on every loop of a group (call
+   before cyon_reactor_group_start). */
+CYON_API int cyon_http_server_listen(cyon_http_server_t *s, cyon_reactor_t *r, int listen_fd);
+CYON_API int cyon_http_server_listen_group(cyon_http_server_t *s, cyon_reactor_group_t *g, int listen_fd);
+/* Serve an already connected socket. */
+CYON_API int cyon_http_server_adopt(cyon_http_server_t *s, cyon_reactor_t *r, int fd);
+CYON_API uint64_t cyon_http_server_requests(const cyon_http_server_t *s);
+
+/* Response. Headers added before the status line is sent go out with it. */
+CYON_API int cyon_http_add_header(cyon_http_ctx_t *x, const char *name, const char *value);
+/* Complete response with Content-Length. */
+CYON_API int cyon_http_respond(cyon_http_ctx_t *x, int status, const char *content_type, const void *body, size_t len);
+/* Streaming response: chunked for HTTP/1.1, close-delimited for 1.0. */
+CYON_API int cyon_http_begin_chunked(cyon_http_ctx_t *x, int status, const char *content_type);
+CYON_API int cyon_http_write_chunk(cyon_http_ctx_t *x, const void *data, size_t len);
+CYON_API int cyon_http_end_chunked(cyon_http_ctx_t *x);
+
+/* Scratch memory from the connection's arena, released when the response
+   is finished. Use it to keep request data for a deferred response. */
+CYON_API void *cyon_http_alloc(cyon_http_ctx_t *x, size_t size);
+/* NULL once the client has gone away. */
+CYON_API cyon_conn_t *cyon_http_conn(cyon_http_ctx_t *x);
+CYON_API const char *cyon_http_status_text(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONHTTP_H */
@@ -36,6 +36,9 @@ typedef struct cyon_cond_s cyon_cond_t;
 typedef struct { int x; int y; int w; int h; } cyon_rect_t;
 typedef struct { unsigned char r, g, b; } cyon_color_t;
 
+/* Borrowed byte range; not NUL-terminated, owned by whoever produced it */
+typedef struct { const char *ptr; size_t len; } cyon_slice_t;
+
 /* ssize_t portability */
 #ifndef _SSIZE_T_DEFINED
 typedef long ssize_t;
@@ -10,12 +10,39 @@ extern "C" {
 #endif
 
 #include "cyonlib.h"
+#include <sys/uio.h>
+#include <sys/socket.h>
 
 /* TCP helpers */
 CYON_API int cyon_tcp_listen(const char *host, const char *port, int backlog);
 CYON_API int cyon_tcp_accept(int listen_fd, char *peer_ip, size_t peer_ip_len, int *peer_port);
 CYON_API int cyon_tcp_connect(const char *host, const char *port, int timeout_ms);
 
+/* Listening socket tuning for cyon_tcp_listen_ex. Zeroed = plain
+   blocking listener with the largest backlog the kernel allows. */
+typedef struct {
+    int backlog;            /* 0 = the system cap (net.core.somaxconn) */
+    int reuseport;          /* SO_REUSEPORT: other sockets may bind the same address */
+    int defer_accept_s;     /* TCP_DEFER_ACCEPT: report connections once data arrives, waiting up to this */
+    int nonblock;
+} cyon_listen_opts_t;
+
+/* Returns the listening fd, or -errno. opts may be NULL. */
+CYON_API int cyon_tcp_listen_ex(const char *host, const char *port, const cyon_listen_opts_t *opts);
+/* n SO_REUSEPORT listeners on one address; the kernel spreads incoming
+   connections across them by flow hash, so n accept loops never contend
+   on one queue. Port "0" binds all n to the same ephemeral port.
+   Like cyon_tcp_listen_ex, returns n (the fds are in fds) or -errno, with
+   no fds left open on failure. */
+CYON_API int cyon_tcp_listen_reuseport(const char *host, const char *port, const cyon_listen_opts_t *opts,
+                                       int *fds, size_t n);
+/* accept4 with flags (SOCK_NONBLOCK, SOCK_CLOEXEC); retries EINTR and
+   connections aborted before they were accepted. Returns the fd or -errno
+   (-EAGAIN: nothing pending on a non-blocking listener). */
+CYON_API int cyon_tcp_accept4(int listen_fd, int flags);
+/* Local port a socket is bound to, or -errno. */
+CYON_API int cyon_socket_local_port(int fd);
+
 /* Send/receive helpers */
 CYON_API int cyon_send_all(int fd, const void *buf, size_t len);
 CYON_API ssize_t cyon_recv_all(int fd, void *buf, size_t len);
@@ -23,6 +50,302 @@ CYON_API ssize_t cyon_recv_all(int fd, void *buf, size_t len);
 /* Socket flags */
 CYON_API int cyon_socket_set_nonblocking(int fd, int nonblock);
 
+/* Batched UDP. Receives fill up to `batch` pooled buffers with one
+   recvmmsg; sends go out with one sendmmsg per batch. With gso, runs of
+   equal-sized datagrams to one destination are packed into a single
+   UDP_SEGMENT send that the kernel (or NIC) splits; with gro, the kernel
+   may coalesce a flow's datagrams into one buffer, which is split back
+   into datagrams here. Both fall back silently where unsupported. The
+   socket is non-blocking and waited on with poll. One thread per socket. */
+typedef struct cyon_udp_s cyon_udp_t;
+
+typedef struct {
+    size_t batch;               /* datagrams per syscall: 64 */
+    size_t buf_size;            /* per receive buffer: 2048, 65536 with gro */
+    int gso;                    /* UDP_SEGMENT on send */
+    int gro;                    /* UDP_GRO on receive */
+    int rcvbuf;                 /* SO_RCVBUF bytes, 0 = system default */
+    int sndbuf;                 /* SO_SNDBUF bytes, 0 = system default */
+} cyon_udp_opts_t;
+
+/* One datagram. On receive, data and addr point into the socket's
+   buffers and stay valid until the next cyon_udp_recv. On send, addr may
+   be NULL on a connected socket. */
+typedef struct {
+    void *data;
+    size_t len;
+    const struct sockaddr *addr;
+    socklen_t addrlen;
+} cyon_udp_msg_t;
+
+typedef struct {
+    uint64_t rx_datagrams;
+    uint64_t rx_bytes;
+    uint64_t rx_calls;          /* recvmmsg calls that returned data */
+    uint64_t rx_dropped;        /* lost to a full receive queue; a GRO buffer counts once */
+    uint64_t rx_truncated;      /* longer than buf_size, cut short */
+    uint64_t tx_datagrams;
+    uint64_t tx_bytes;
+    uint64_t tx_calls;          /* sendmmsg calls */
+    uint64_t tx_dropped;        /* refused by the kernel and skipped */
+} cyon_udp_stats_t;
+
+/* Bound socket (host may be NULL for any address, port "0" for an
+   ephemeral one). opts may be NULL. */
+CYON_API int cyon_udp_bind(cyon_udp_t **out, const char *host, const char *port, const cyon_udp_opts_t *opts);
+/* Connected socket: sends need no address, receives only see the peer. */
+CYON_API int cyon_udp_connect(cyon_udp_t **out, const char *host, const char *port, const cyon_udp_opts_t *opts);
+CYON_API void cyon_udp_destroy(cyon_udp_t *u);
+CYON_API int cyon_udp_fd(const cyon_udp_t *u);
+/* 1 when gso/gro were asked for and the kernel accepted them. */
+CYON_API int cyon_udp_gso(const cyon_udp_t *u);
+CYON_API int cyon_udp_gro(const cyon_udp_t *u);
+/* Up to max datagrams, waiting up to timeout_ms (< 0 = no limit) for the
+   first. Returns the count, 0 on timeout, or -errno. */
+CYON_API ssize_t cyon_udp_recv(cyon_udp_t *u, cyon_udp_msg_t *msgs, size_t max, int timeout_ms);
+/* Send all n, waiting while the socket buffer is full. Datagrams the
+   kernel refuses (no route, too large, ICMP unreachable) are skipped and
+   counted in tx_dropped. Returns how many were sent or skipped: n,
+   fewer when a socket error cut the call short, or -errno if it stopped
+   before the first. */
+CYON_API ssize_t cyon_udp_send(cyon_udp_t *u, const cyon_udp_msg_t *msgs, size_t n);
+CYON_API void cyon_udp_stats(const cyon_udp_t *u, cyon_udp_stats_t *st);
+
+/* Outbound connection pool keyed by "host:port". Idle connections are
+   kept (most recently used first) and health-checked before reuse: one
+   that the peer closed, that has unread data, or that sat idle longer
+   than idle_timeout_ms is dropped. Resolved addresses are cached for
+   dns_ttl_ms, and a failed connect drops the cached entry. Thread-safe.
+   Zero fields in the options select the defaults. */
+typedef struct cyon_connpool_s cyon_connpool_t;
+typedef struct cyon_pool_conn_s cyon_pool_conn_t;
+
+typedef struct {
+    size_t max_per_host;        /* open connections (idle + leased); 8 */
+    size_t max_idle_per_host;   /* max_per_host */
+    int idle_timeout_ms;        /* 60000 */
+    int connect_timeout_ms;     /* 5000 */
+    int wait_ms;                /* wait for a slot at the limit: connect_timeout_ms; < 0 = EAGAIN at once */
+    int dns_ttl_ms;             /* 30000; < 0 = no caching */
+    int keepalive_idle_s;       /* TCP keepalive probe delay: 30; < 0 = off */
+} cyon_connpool_opts_t;
+
+typedef struct {
+    uint64_t connects;          /* new connections made */
+    uint64_t reuses;            /* acquires served from the idle list */
+    uint64_t dns_lookups;       /* getaddrinfo calls */
+    uint64_t dns_hits;          /* resolutions served from the cache */
+    uint64_t dropped;           /* idle connections found dead or expired */
+    size_t idle;
+    size_t leased;
+} cyon_connpool_stats_t;
+
+/* opts may be NULL. */
+CYON_API int cyon_connpool_create(cyon_connpool_t **out, const cyon_connpool_opts_t *opts);
+/* Closes the idle connections; every lease must have been released. */
+CYON_API void cyon_connpool_destroy(cyon_connpool_t *p);
+/* Lease a connected, blocking TCP socket. Returns 0, EAGAIN/ETIMEDOUT
+   when the host stays at its limit, or the connect/resolve error. */
+CYON_API int cyon_connpool_acquire(cyon_connpool_t *p, const char *host, const char *port, cyon_pool_conn_t **out);
+/* Return a lease. reuse = 0 closes the socket (protocol error, the
+   server said "Connection: close", ...). */
+CYON_API void cyon_connpool_release(cyon_connpool_t *p, cyon_pool_conn_t *c, int reuse);
+CYON_API int cyon_pool_conn_fd(const cyon_pool_conn_t *c);
+/* 1 when the lease came from the idle list. A request that fails on a
+   reused connection may have raced the server closing it; retry once. */
+CYON_API int cyon_pool_conn_reused(const cyon_pool_conn_t *c);
+/* Close idle connections that expired or fail the health check; returns
+   how many. */
+CYON_API size_t cyon_connpool_prune(cyon_connpool_t *p);
+CYON_API void cyon_connpool_stats(cyon_connpool_t *p, cyon_connpool_stats_t *st);
+
+/* Buffered connection over a blocking or non-blocking fd (non-blocking
+   fds are waited on with poll). The reader is a ring buffer mapped twice
+   back to back, so buffered data is always contiguous for scanning; the
+   writer collects small writes and sends them, together with any large
+   pieces, in one scatter-gather sendmsg/writev. Reads that need the
+   kernel flush pending output first, which suits request/response. */
+typedef struct cyon_bufconn_s cyon_bufconn_t;
+
+#define CYON_BUFCONN_DEFAULT_SIZE 65536
+/* Returned by readers whose 0 is a valid length (an empty line or frame)
+   at a clean end of stream. It lies below every -errno. */
+#define CYON_BUFCONN_EOF (-4096)
+
+/* Sizes of 0 use CYON_BUFCONN_DEFAULT_SIZE; the read size is rounded up
+   to whole pages. The fd stays owned by the caller. */
+CYON_API int cyon_bufconn_create(cyon_bufconn_t **out, int fd, size_t read_size, size_t write_size);
+/* Frees the object without flushing or closing the fd. */
+CYON_API void cyon_bufconn_destroy(cyon_bufconn_t *b);
+CYON_API int cyon_bufconn_fd(const cyon_bufconn_t *b);
+/* Bytes available without touching the socket. */
+CYON_API size_t cyon_bufconn_buffered(const cyon_bufconn_t *b);
+
+/* Up to len bytes; returns the count, 0 at end of stream, or -errno. */
+CYON_API ssize_t cyon_bufconn_read(cyon_bufconn_t *b, void *dst, size_t len);
+/* Exactly len bytes. Returns 0, EPIPE on early end of stream, or errno. */
+CYON_API int cyon_bufconn_read_full(cyon_bufconn_t *b, void *dst, size_t len);
+/* Point *rec at the buffered record ending with delim and return its
+   length including delim. At end of stream the remaining bytes form the
+   last record (0 when none). -EMSGSIZE when the buffer fills without a
+   delimiter. The record stays buffered until cyon_bufconn_consume. */
+CYON_API ssize_t cyon_bufconn_peek_until(cyon_bufconn_t *b, const void *delim, size_t dlen, const char **rec);
+/* Point *data at the first n buffered bytes, reading until there are
+   that many. Returns n, fewer at end of stream, or -errno (-EMSGSIZE when
+   n exceeds the buffer). The bytes stay buffered. */
+CYON_API ssize_t cyon_bufconn_peek(cyon_bufconn_t *b, size_t n, const char **data);
+CYON_API void cyon_bufconn_consume(cyon_bufconn_t *b, size_t n);
+/* Copy one line without its \n or \r\n into dst, NUL-terminated.
+   Returns its length, CYON_BUFCONN_EOF at end of stream, or -errno (-EMSGSIZE when it
+   does not fit in cap; the line is left buffered). */
+CYON_API ssize_t cyon_bufconn_readline(cyon_bufconn_t *b, char *dst, size_t cap);
+
+CYON_API int cyon_bufconn_write(cyon_bufconn_t *b, const void *data, size_t len);
+/* Small pieces are copied into the write buffer; larger ones go out
+   directly in the same vectored call as whatever is buffered. */
+CYON_API int cyon_bufconn_writev(cyon_bufconn_t *b, const struct iovec *iov, int iovcnt);
+CYON_API int cyon_bufconn_flush(cyon_bufconn_t *b);
+/* Read and write system calls issued so far. */
+CYON_API void cyon_bufconn_stats(const cyon_bufconn_t *b, uint64_t *read_calls, uint64_t *write_calls);
+
+/* Event loop reactor (Linux epoll, edge-triggered).
+   A reactor belongs to the thread running it: callbacks run there and the
+   functions below may only be called from it, except cyon_reactor_post and
+   cyon_reactor_stop, which are safe from any thread. */
+typedef struct cyon_reactor_s cyon_reactor_t;
+typedef struct cyon_conn_s cyon_conn_t;
+
+#define CYON_IO_READ  1
+#define CYON_IO_WRITE 2
+#define CYON_IO_HUP   4
+#define CYON_IO_ERR   8
+
+typedef void (*cyon_io_cb)(cyon_reactor_t *r, int fd, int events, void *user);
+
+/* Buffered connection callbacks; user is the connection's user pointer
+   (initially the one given to listen/adopt). on_data sees everything read
+   and not yet consumed and returns how many bytes it consumed; the rest
+   stays buffered. on_drain runs when queued output has been fully sent.
+   on_close runs once, with 0 for an orderly close or an errno code. */
+typedef struct {
+    void (*on_open)(cyon_conn_t *c, void *user);
+    size_t (*on_data)(cyon_conn_t *c, const char *data, size_t len, void *user);
+    void (*on_drain)(cyon_conn_t *c, void *user);
+    void (*on_close)(cyon_conn_t *c, int err, void *user);
+} cyon_conn_handlers_t;
+
+/* Backends. AUTO uses io_uring when the kernel has what the reactor needs
+   (multishot accept and recv, provided buffer rings, fixed files; Linux
+   6.0+) and epoll otherwise; CYON_NO_URING=1 in the environment forces
+   epoll. The callbacks behave the same on both. */
+#define CYON_REACTOR_AUTO  0
+#define CYON_REACTOR_EPOLL 1
+#define CYON_REACTOR_URING 2
+
+CYON_API int cyon_reactor_create(cyon_reactor_t **out);
+/* ENOSYS when CYON_REACTOR_URING is asked for and unavailable. */
+CYON_API int cyon_reactor_create_ex(cyon_reactor_t **out, int backend);
+CYON_API int cyon_reactor_backend(const cyon_reactor_t *r);
+/* Closes every connection, reporting ECANCELED to on_close, and frees the
+   reactor. */
+CYON_API void cyon_reactor_destroy(cyon_reactor_t *r);
+/* Run until cyon_reactor_stop completes. */
+CYON_API int cyon_reactor_run(cyon_reactor_t *r);
+/* One iteration: wait up to timeout_ms (< 0 = until the next timer). */
+CYON_API int cyon_reactor_run_once(cyon_reactor_t *r, int timeout_ms);
+/* Graceful shutdown: stop accepting, flush and close every connection,
+   abort whatever is left after grace_ms, then make run() return. */
+CYON_API int cyon_reactor_stop(cyon_reactor_t *r, int grace_ms);
+/* Run fn(r, arg) on the reactor thread. */
+CYON_API int cyon_reactor_post(cyon_reactor_t *r, void (*fn)(cyon_reactor_t *r, void *arg), void *arg);
+/* Timer wheel driven by the loop (1 ms ticks); see cyontime.h. */
+CYON_API struct cyon_timer_wheel_s *cyon_reactor_wheel(cyon_reactor_t *r);
+CYON_API size_t cyon_reactor_conn_count(cyon_reactor_t *r);
+/* I/O system calls the loop has made: waits, accepts, reads and writes,
+   or io_uring_enter calls on that backend. For benchmarks; read it from
+   the loop thread or after the loop stopped. */
+CYON_API uint64_t cyon_reactor_syscalls(const cyon_reactor_t *r);
+
+/* Raw readiness: cb(r, fd, CYON_IO_* mask, user) on every edge. */
+CYON_API int cyon_reactor_watch(cyon_reactor_t *r, int fd, int events, cyon_io_cb cb, void *user);
+CYON_API int cyon_reactor_unwatch(cyon_reactor_t *r, int fd);
+
+/* Accept on listen_fd (made non-blocking) and serve each connection with h.
+   The listening fd stays owned by the caller. */
+CYON_API int cyon_reactor_listen(cyon_reactor_t *r, int listen_fd, const cyon_conn_handlers_t *h, void *user);
+/* Serve an already connected (or connecting) socket; the reactor owns fd. */
+CYON_API int cyon_reactor_adopt(cyon_reactor_t *r, int fd, const cyon_conn_handlers_t *h, void *user, cyon_conn_t **out);
+
+/* Queue bytes for sending; tries to send at once when nothing is queued.
+   Returns 0 or EPIPE after close. */
+CYON_API int cyon_conn_write(cyon_conn_t *c, const void *data, size_t len);
+/* Queue count bytes of file_fd from offset (count 0 = to end of file),
+   sent with sendfile after everything written before it. close_fd hands
+   file_fd to the connection, which closes it once sent, on close, or
+   right away when this call fails. */
+CYON_API int cyon_conn_sendfile(cyon_conn_t *c, int file_fd, off_t offset, size_t count, int close_fd);
+/* Flush queued output, then close. */
+CYON_API int cyon_conn_close(cyon_conn_t *c);
+/* Close now, dropping queued output; on_close gets err. */
+CYON_API int cyon_conn_abort(cyon_conn_t *c, int err);
+/* Close with ETIMEDOUT after ms without reads or writes (0 = off). */
+CYON_API int cyon_conn_set_timeout(cyon_conn_t *c, unsigned int ms);
+/* Stop (0) or resume (1) reading; input beyond the buffer limit pauses too. */
+CYON_API int cyon_conn_set_reading(cyon_conn_t *c, int on);
+CYON_API int cyon_conn_fd(const cyon_conn_t *c);
+CYON_API cyon_reactor_t *cyon_conn_reactor(const cyon_conn_t *c);
+CYON_API void *cyon_conn_user(const cyon_conn_t *c);
+CYON_API void cyon_conn_set_user(cyon_conn_t *c, void *user);
+CYON_API size_t cyon_conn_pending_output(const cyon_conn_t *c);
+
+/* Zero-copy transfers: the bytes never enter user space. */
+
+/* Send up to count bytes of file_fd from *offset, which is advanced. On a
+   non-blocking socket this stops at EAGAIN with partial progress. Returns
+   the bytes sent, 0 at end of file, or -errno (-EAGAIN: nothing fit). */
+CYON_API ssize_t cyon_sendfile(int sock, int file_fd, off_t *offset, size_t count);
+/* Send count bytes (0 = to end of file), waiting for room on non-blocking
+   sockets. Returns 0 or an errno code. */
+CYON_API int cyon_sendfile_all(int sock, int file_fd, off_t offset, size_t count);
+
+/* fd-to-fd (e.g. socket-to-socket proxying) through a kernel pipe. The
+   pipe holds what the destination could not take yet, so progress is
+   kept across EAGAIN on either side. */
+typedef struct {
+    int rd;
+    int wr;
+    size_t buffered;    /* bytes waiting in the pipe */
+} cyon_splice_t;
+
+CYON_API int cyon_splice_open(cyon_splice_t *sp);
+CYON_API void cyon_splice_close(cyon_splice_t *sp);
+/* Move up to max bytes (0 = until either side blocks) from in_fd to
+   out_fd. Returns bytes delivered to out_fd, or -errno. *eof is set once
+   in_fd reached end of stream; keep calling until buffered is 0. */
+CYON_API ssize_t cyon_splice_step(cyon_splice_t *sp, int in_fd, int out_fd, size_t max, int *eof);
+
+/* Multi-reactor mode: one loop thread per core. Listeners are shared by
+   every loop and waited on with EPOLLEXCLUSIVE (an exclusive poll plus
+   accept on io_uring), so the kernel wakes one loop per connection and
+   each connection then stays on the loop that accepted it. */
+typedef struct cyon_reactor_group_s cyon_reactor_group_t;
+
+/* n = 0 uses the online CPU count; pin != 0 pins loop i to a core. */
+CYON_API int cyon_reactor_group_create(cyon_reactor_group_t **out, size_t n, int pin);
+CYON_API size_t cyon_reactor_group_size(const cyon_reactor_group_t *g);
+CYON_API cyon_reactor_t *cyon_reactor_group_get(cyon_reactor_group_t *g, size_t i);
+CYON_API int cyon_reactor_group_listen(cyon_reactor_group_t *g, int listen_fd, const cyon_conn_handlers_t *h, void *user);
+/* Per-loop listeners instead of a shared one: opens one SO_REUSEPORT
+   socket per loop on host:port, so every loop accepts from its own queue.
+   The group owns and closes these sockets. Before start only. */
+CYON_API int cyon_reactor_group_listen_reuseport(cyon_reactor_group_t *g, const char *host, const char *port,
+                                                 const cyon_listen_opts_t *opts, const cyon_conn_handlers_t *h,
+                                                 void *user);
+CYON_API int cyon_reactor_group_start(cyon_reactor_group_t *g);
+/* Stop every loop gracefully and join the threads. */
+CYON_API int cyon_reactor_group_stop(cyon_reactor_group_t *g, int grace_ms);
+CYON_API void cyon_reactor_group_destroy(cyon_reactor_group_t *g);
+
 #ifdef __cplusplus
 }
 #endif
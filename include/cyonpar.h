@@ -0,0 +1,58 @@
+#ifndef CYONPAR_H
+#define CYONPAR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+
+/* Data-parallel array primitives on the shared worker pool.
+   Inputs shorter than the threshold run sequentially on the caller.
+   Larger ones are cut into at most CYON_PAR_MAX_CHUNKS chunks; the caller
+   works on chunks too, so nested calls from pool workers cannot deadlock.
+   Chunking depends only on n and grain, never on the number of workers, so
+   floating-point reductions give the same result on every machine. */
+
+#ifndef CYON_PAR_THRESHOLD
+#define CYON_PAR_THRESHOLD 32768   /* elements; below this stay sequential */
+#endif
+
+#ifndef CYON_PAR_MAX_CHUNKS
+#define CYON_PAR_MAX_CHUNKS 64
+#endif
+
+CYON_API void cyon_par_set_threshold(size_t n);
+CYON_API size_t cyon_par_threshold(void);
+
+/* body(begin, end, ctx) over [0, n) in chunks of at least grain elements
+   (0 = threshold / 4). Returns 0 or an errno code. */
+CYON_API int cyon_par_for(size_t n, size_t grain, void (*body)(size_t begin, size_t end, void *ctx), void *ctx);
+
+/* Generic reduction. Each chunk starts from a copy of identity
+   (result_size bytes) and folds [begin, end) into it with chunk(); partials
+   are then combined into *result in chunk order. */
+CYON_API int cyon_par_reduce(size_t n, size_t grain, void *result, size_t result_size, const void *identity,
+                             void (*chunk)(size_t begin, size_t end, void *partial, void *ctx),
+                             void (*combine)(void *acc, const void *partial, void *ctx), void *ctx);
+
+/* out[i] = fn(in[i], ctx); in and out may alias. */
+CYON_API int cyon_par_map_f64(const double *in, double *out, size_t n, double (*fn)(double, void*), void *ctx);
+CYON_API double cyon_par_sum_f64(const double *a, size_t n);
+CYON_API double cyon_par_dot_f64(const double *a, const double *b, size_t n);
+/* Sum of squared differences. */
+CYON_API double cyon_par_sqdiff_f64(const double *a, const double *b, size_t n);
+
+/* Inclusive prefix sums; in and out may alias. */
+CYON_API int cyon_par_scan_f64(const double *in, double *out, size_t n);
+CYON_API int cyon_par_scan_i64(const int64_t *in, int64_t *out, size_t n);
+
+/* qsort-compatible sort: chunks are sorted in parallel, then merged
+   pairwise. Not stable. */
+CYON_API int cyon_par_sort(void *base, size_t n, size_t size, int (*cmp)(const void*, const void*));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONPAR_H */
@@ -0,0 +1,123 @@
+#ifndef CYONRPC_H
+#define CYONRPC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+#include "cyonnet.h"
+
+/* Length-prefixed framing and a small binary RPC layer.
+
+   A frame is a varint (unsigned LEB128) payload length followed by the
+   payload. RPC payloads are
+       request:  varint id, varint method, body
+       response: varint id, varint status, body
+   Ids are chosen by the client, so any number of calls can be in flight
+   on one connection and the server may answer them in any order. */
+
+#define CYON_VARINT_MAX 10
+
+#ifndef CYON_RPC_MAX_METHODS
+#define CYON_RPC_MAX_METHODS 256
+#endif
+
+/* Varints */
+CYON_API size_t cyon_varint_size(uint64_t v);
+/* Writes at most CYON_VARINT_MAX bytes; returns how many. */
+CYON_API size_t cyon_varint_encode(uint64_t v, void *out);
+/* Bytes consumed, 0 when buf ends mid-varint, -EINVAL when malformed or
+   not minimal (a trailing zero byte): a frame header always re-encodes to
+   the bytes it was read from. */
+CYON_API int cyon_varint_decode(const void *buf, size_t len, uint64_t *v);
+
+/* Frames */
+/* Frame at the start of buf: sets *msg and *msg_len and returns the frame
+   size, 0 when incomplete, -EMSGSIZE when the payload exceeds max, or
+   -EINVAL. */
+CYON_API ssize_t cyon_frame_parse(const void *buf, size_t len, size_t max, const char **msg, size_t *msg_len);
+/* Queue a frame on a buffered connection. Frames collect in its write
+   buffer, so a run of small ones leaves in one syscall on the next flush
+   or read. */
+CYON_API int cyon_frame_write(cyon_bufconn_t *b, const void *msg, size_t len);
+/* One frame from several pieces. */
+CYON_API int cyon_frame_writev(cyon_bufconn_t *b, const struct iovec *iov, int iovcnt);
+/* Point *msg at the next frame's payload, inside the read buffer, and
+   return its length. CYON_BUFCONN_EOF at end of stream, -EPIPE when it
+   ends mid-frame, -EMSGSIZE when larger than max or the buffer, or -errno. */
+CYON_API ssize_t cyon_frame_peek(cyon_bufconn_t *b, const char **msg, size_t max);
+/* Drop the frame cyon_frame_peek returned (len = its payload length). */
+CYON_API void cyon_frame_consume(cyon_bufconn_t *b, size_t len);
+
+/* RPC server on the corenet reactor. */
+typedef struct cyon_rpc_server_s cyon_rpc_server_t;
+typedef struct cyon_rpc_call_s cyon_rpc_call_t;
+
+/* req points into the connection's input and is valid until the handler
+   returns. Answer with cyon_rpc_reply, now or later. */
+typedef void (*cyon_rpc_handler)(cyon_rpc_call_t *call, const void *req, size_t len, void *user);
+
+/* A server buffers at most 1 MiB of input per connection (the reactor's
+   limit), so a larger frame closes the connection with ENOBUFS even when
+   max_frame allows it. */
+typedef struct {
+    size_t max_frame;               /* 524288; larger frames close the connection */
+    unsigned int idle_timeout_ms;   /* server connections: 0 = none */
+} cyon_rpc_opts_t;
+
+/* opts may be NULL for the defaults. */
+CYON_API int cyon_rpc_server_create(cyon_rpc_server_t **out, const cyon_rpc_opts_t *opts);
+/* Destroy after the reactors serving it have stopped. */
+CYON_API void cyon_rpc_server_destroy(cyon_rpc_server_t *s);
+/* method < CYON_RPC_MAX_METHODS. Register before serving. Calls to
+   unregistered methods get ENOSYS. */
+CYON_API int cyon_rpc_server_register(cyon_rpc_server_t *s, uint32_t method, cyon_rpc_handler fn, void *user);
+CYON_API int cyon_rpc_server_listen(cyon_rpc_server_t *s, cyon_reactor_t *r, int listen_fd);
+CYON_API int cyon_rpc_server_listen_group(cyon_rpc_server_t *s, cyon_reactor_group_t *g, int listen_fd);
+CYON_API int cyon_rpc_server_adopt(cyon_rpc_server_t *s, cyon_reactor_t *r, int fd);
+CYON_API uint64_t cyon_rpc_server_calls(const cyon_rpc_server_t *s);
+
+/* Answer a call exactly once, on its reactor's thread; frees the call.
+   Replies made while the handler runs leave together with the others
+   from the same input. status is 0 or an errno code. */
+CYON_API int cyon_rpc_reply(cyon_rpc_call_t *call, int status, const void *data, size_t len);
+CYON_API uint32_t cyon_rpc_call_method(const cyon_rpc_call_t *call);
+/* For deferred replies: post the reply to this reactor. */
+CYON_API cyon_reactor_t *cyon_rpc_call_reactor(const cyon_rpc_call_t *call);
+
+/* RPC client over a connected socket (blocking or not). One thread per
+   client. Calls queue in the write buffer and go out together on the next
+   flush or poll; responses are matched to calls by id. */
+typedef struct cyon_rpc_client_s cyon_rpc_client_t;
+
+/* resp is valid during the callback only, and only until the callback
+   sends, polls or calls on the same client. status is the server's, or
+   EPIPE/EPROTO/ECANCELED when the connection failed or the client was
+   destroyed first. */
+typedef void (*cyon_rpc_done)(int status, const void *resp, size_t len, void *user);
+
+/* Takes ownership of fd. opts may be NULL. */
+CYON_API int cyon_rpc_client_create(cyon_rpc_client_t **out, int fd, const cyon_rpc_opts_t *opts);
+/* Fails outstanding calls with ECANCELED and closes the socket. */
+CYON_API void cyon_rpc_client_destroy(cyon_rpc_client_t *c);
+CYON_API int cyon_rpc_client_send(cyon_rpc_client_t *c, uint32_t method, const void *req, size_t len,
+                                  cyon_rpc_done done, void *user);
+CYON_API int cyon_rpc_client_flush(cyon_rpc_client_t *c);
+/* Flush, then run callbacks for the responses that arrive, waiting up to
+   timeout_ms (< 0 = no limit) for the first. Returns how many completed,
+   0 on timeout or with nothing outstanding, or -errno once the
+   connection has failed. */
+CYON_API int cyon_rpc_client_poll(cyon_rpc_client_t *c, int timeout_ms);
+CYON_API size_t cyon_rpc_client_pending(const cyon_rpc_client_t *c);
+/* Blocking call. Returns the server's status, ETIMEDOUT, or the
+   connection error. On success *resp (free with free()) and *resp_len get
+   the response body; resp may be NULL to discard it. */
+CYON_API int cyon_rpc_call(cyon_rpc_client_t *c, uint32_t method, const void *req, size_t len,
+                           void **resp, size_t *resp_len, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONRPC_H */
@@ -6,8 +6,16 @@
 #include "cyonio.h"
 #include "cyonfs.h"
 #include "cyonnet.h"
+#include "cyonuring.h"
+#include "cyonhttp.h"
+#include "cyonrpc.h"
 #include "cyonmath.h"
 #include "cyoncrypto.h"
 #include "cyonmem.h"
+#include "cyontime.h"
+#include "cyonthread.h"
+#include "cyoncoro.h"
+#include "cyonactor.h"
+#include "cyonpar.h"
 
 #endif /* CYONSTD_H */
\ No newline at end of file
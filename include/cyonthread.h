@@ -0,0 +1,255 @@
+#ifndef CYONTHREAD_H
+#define CYONTHREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+#include <stdio.h>
+
+/* Threads, mutexes and condition variables */
+CYON_API int cyon_thread_create(cyon_thread_t **out_thread, void *(*start_routine)(void*), void *arg, int detach);
+CYON_API int cyon_thread_join(cyon_thread_t *t);
+CYON_API int cyon_thread_detach(cyon_thread_t *t);
+
+/* CPU affinity. cpus lists CPU ids; create_on applies the mask before the
+   thread starts running. */
+CYON_API int cyon_thread_create_on(cyon_thread_t **out_thread, void *(*start_routine)(void*), void *arg, int detach,
+                                   const int *cpus, size_t ncpus);
+CYON_API int cyon_thread_set_affinity(cyon_thread_t *t, const int *cpus, size_t ncpus);
+CYON_API int cyon_thread_pin_self(const int *cpus, size_t n);
+CYON_API int cyon_current_cpu(void);
+CYON_API int cyon_current_node(void);
+
+/* Machine topology, discovered once from /sys/devices/system/{cpu,node}. */
+typedef struct {
+    int cpu;       /* logical CPU id */
+    int core;      /* core_id within the package */
+    int package;   /* physical socket */
+    int node;      /* NUMA node */
+    int smt;       /* 0 for the first hardware thread of a core, 1 for its sibling, ... */
+} cyon_cpu_info_t;
+
+typedef struct {
+    size_t ncpus;
+    size_t ncores;
+    size_t npackages;
+    size_t nnodes;
+    cyon_cpu_info_t *cpus;
+} cyon_topology_t;
+
+enum { CYON_PLACE_NONE = 0, CYON_PLACE_COMPACT = 1, CYON_PLACE_SCATTER = 2, CYON_PLACE_NODE = 3 };
+
+CYON_API const cyon_topology_t *cyon_topology_get(void);
+CYON_API size_t cyon_topology_node_cpus(int node, int *cpus, size_t cap);
+/* CPU order used by CYON_PLACE_COMPACT / CYON_PLACE_SCATTER. */
+CYON_API size_t cyon_topology_order(int policy, int *cpus, size_t cap);
+
+/* Node-local bump arenas: chunks are bound to one NUMA node. */
+typedef struct cyon_node_arena_s cyon_node_arena_t;
+
+CYON_API int cyon_node_arena_create(cyon_node_arena_t **out, int node, size_t chunk_size);
+CYON_API void *cyon_node_arena_alloc(cyon_node_arena_t *a, size_t size, size_t align);
+CYON_API int cyon_node_arena_node(const cyon_node_arena_t *a);
+CYON_API size_t cyon_node_arena_reserved(cyon_node_arena_t *a);
+CYON_API void cyon_node_arena_reset(cyon_node_arena_t *a);
+CYON_API void cyon_node_arena_destroy(cyon_node_arena_t *a);
+
+CYON_API int cyon_mutex_create(cyon_mutex_t **out);
+CYON_API int cyon_mutex_lock(cyon_mutex_t *m);
+CYON_API int cyon_mutex_unlock(cyon_mutex_t *m);
+CYON_API int cyon_mutex_destroy(cyon_mutex_t *m);
+
+CYON_API int cyon_cond_create(cyon_cond_t **out);
+CYON_API int cyon_cond_wait(cyon_cond_t *c);
+CYON_API int cyon_cond_timedwait(cyon_cond_t *c, const struct timespec *abstime);
+CYON_API int cyon_cond_signal(cyon_cond_t *c);
+CYON_API int cyon_cond_broadcast(cyon_cond_t *c);
+CYON_API int cyon_cond_destroy(cyon_cond_t *c);
+/* Wait with the caller's own mutex held (the usual predicate loop).
+   cyon_cond_wait/timedwait use a private mutex and cannot protect state. */
+CYON_API int cyon_cond_wait_mutex(cyon_cond_t *c, cyon_mutex_t *m);
+CYON_API int cyon_cond_timedwait_mutex(cyon_cond_t *c, cyon_mutex_t *m, const struct timespec *abstime);
+
+/* Adaptive locks. cyon_lock_t spins with exponential backoff and then parks
+   on a futex; cyon_rwlock_t is a writer-preferring reader-writer lock. Both
+   are plain structs that need no allocation (CYON_LOCK_INIT or *_init).
+   The acquire macros record the call site so the contention profiler can
+   report which holder a waiter was stuck behind. */
+typedef struct cyon_lock_s {
+    uint32_t state;
+    uint32_t prof_id;
+    const char *name;
+    const char *holder_file;
+    int holder_line;
+} cyon_lock_t;
+
+typedef struct cyon_rwlock_s {
+    uint32_t state;
+    uint32_t prof_id;
+    const char *name;
+    const char *holder_file;   /* last writer */
+    int holder_line;
+} cyon_rwlock_t;
+
+typedef struct { uint32_t seq; } cyon_lock_cond_t;
+
+#define CYON_LOCK_INIT(name) { 0, 0, (name), NULL, 0 }
+#define CYON_RWLOCK_INIT(name) { 0, 0, (name), NULL, 0 }
+#define CYON_LOCK_COND_INIT { 0 }
+
+CYON_API void cyon_lock_init(cyon_lock_t *l, const char *name);
+CYON_API void cyon_lock_acquire_at(cyon_lock_t *l, const char *file, int line);
+CYON_API int cyon_lock_try_acquire_at(cyon_lock_t *l, const char *file, int line);
+CYON_API void cyon_lock_release(cyon_lock_t *l);
+#define cyon_lock_acquire(l) cyon_lock_acquire_at((l), __FILE__, __LINE__)
+#define cyon_lock_try_acquire(l) cyon_lock_try_acquire_at((l), __FILE__, __LINE__)
+
+/* Release l, wait for a signal (timeout_ms < 0 = forever), re-acquire l.
+   Returns 0 or ETIMEDOUT; spurious wake-ups are possible. */
+CYON_API int cyon_lock_cond_wait(cyon_lock_cond_t *c, cyon_lock_t *l, int timeout_ms);
+CYON_API int cyon_lock_cond_signal(cyon_lock_cond_t *c);
+CYON_API int cyon_lock_cond_broadcast(cyon_lock_cond_t *c);
+
+CYON_API void cyon_rwlock_init(cyon_rwlock_t *l, const char *name);
+CYON_API void cyon_rwlock_read_lock_at(cyon_rwlock_t *l, const char *file, int line);
+CYON_API void cyon_rwlock_write_lock_at(cyon_rwlock_t *l, const char *file, int line);
+CYON_API int cyon_rwlock_try_read_lock(cyon_rwlock_t *l);
+CYON_API int cyon_rwlock_try_write_lock_at(cyon_rwlock_t *l, const char *file, int line);
+CYON_API void cyon_rwlock_read_unlock(cyon_rwlock_t *l);
+CYON_API void cyon_rwlock_write_unlock(cyon_rwlock_t *l);
+#define cyon_rwlock_read_lock(l) cyon_rwlock_read_lock_at((l), __FILE__, __LINE__)
+#define cyon_rwlock_write_lock(l) cyon_rwlock_write_lock_at((l), __FILE__, __LINE__)
+#define cyon_rwlock_try_write_lock(l) cyon_rwlock_try_write_lock_at((l), __FILE__, __LINE__)
+
+/* Lock contention profiler. Off by default; when on, every contended
+   acquisition records its wait time against the lock and the call site
+   that held it. Uncontended acquisitions are never recorded. */
+#ifndef CYON_LOCK_PROF_MAX
+#define CYON_LOCK_PROF_MAX 1024
+#endif
+#define CYON_LOCK_PROF_SITES 8
+
+typedef struct {
+    const char *file;
+    int line;
+    uint64_t count;
+    uint64_t wait_ns;
+} cyon_lock_site_report_t;
+
+typedef struct {
+    const void *lock;
+    const char *name;
+    uint64_t contended;
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    cyon_lock_site_report_t holders[CYON_LOCK_PROF_SITES]; /* by wait time */
+} cyon_lock_report_t;
+
+CYON_API void cyon_lock_profile_enable(int enable);
+CYON_API int cyon_lock_profile_enabled(void);
+/* Fills up to cap entries sorted by total wait (worst first); returns the
+   number of contended locks. */
+CYON_API size_t cyon_lock_profile_collect(cyon_lock_report_t *out, size_t cap);
+CYON_API void cyon_lock_profile_report(FILE *out, size_t top_n);
+CYON_API void cyon_lock_profile_reset(void);
+
+/* Worker pool. Tasks run in FIFO order on a fixed set of threads. */
+typedef struct cyon_threadpool_s cyon_threadpool_t;
+
+CYON_API int cyon_threadpool_create(cyon_threadpool_t **out, size_t nthreads);
+CYON_API int cyon_threadpool_submit(cyon_threadpool_t *p, void *(*func)(void*), void *arg);
+CYON_API size_t cyon_threadpool_size(const cyon_threadpool_t *p);
+CYON_API int cyon_threadpool_destroy(cyon_threadpool_t *p);
+/* Process-wide pool sized to the online CPUs, created on first use. */
+CYON_API cyon_threadpool_t *cyon_threadpool_shared(void);
+/* Topology-aware pools; see CYON_PLACE_* and cyon_topology_t. */
+CYON_API int cyon_threadpool_create_placed(cyon_threadpool_t **out, size_t nthreads, int policy, int node);
+CYON_API size_t cyon_threadpool_create_per_node(cyon_threadpool_t **pools, size_t cap, size_t threads_per_node);
+CYON_API int cyon_threadpool_node(const cyon_threadpool_t *p);
+CYON_API cyon_node_arena_t *cyon_threadpool_arena(cyon_threadpool_t *p);
+
+/* Futures. A future is created pending and completed once, either with a
+   value (resolve) or an errno-style code (reject). Each handle returned to
+   the caller owns one reference and must be released. Releasing the last
+   reference to a pending future rejects it with ECANCELED first, so its
+   callbacks, continuations and combinators still run. */
+typedef struct cyon_future_s cyon_future_t;
+typedef void (*cyon_future_cb)(cyon_future_t *f, void *user);
+
+CYON_API int cyon_future_create(cyon_future_t **out);
+CYON_API int cyon_future_resolve(cyon_future_t *f, void *value);
+CYON_API int cyon_future_reject(cyon_future_t *f, int err);
+CYON_API void cyon_future_retain(cyon_future_t *f);
+CYON_API void cyon_future_release(cyon_future_t *f);
+
+/* Run fn(arg) on the shared pool; the future resolves with its return value. */
+CYON_API int cyon_future_async(cyon_future_t **out, void *(*fn)(void*), void *arg);
+
+/* Completion callback: runs on the completing thread, or immediately if done. */
+CYON_API int cyon_future_on_complete(cyon_future_t *f, cyon_future_cb cb, void *user);
+
+/* Continuation: when f resolves, fn(value, arg) runs on the shared pool and
+   its result resolves *out. A rejection of f is forwarded without calling fn. */
+CYON_API int cyon_future_then(cyon_future_t **out, cyon_future_t *f, void *(*fn)(void *value, void *arg), void *arg);
+
+/* Combinators. when_all resolves once every input resolved (value NULL) or
+   rejects with the first error. when_any completes like the first input to
+   finish; cyon_future_winner reports its index. */
+CYON_API int cyon_future_when_all(cyon_future_t **out, cyon_future_t *const *fs, size_t n);
+CYON_API int cyon_future_when_any(cyon_future_t **out, cyon_future_t *const *fs, size_t n);
+CYON_API size_t cyon_future_winner(cyon_future_t *f);
+
+/* Block until completed. timeout_ms < 0 waits forever.
+   Returns 0 with *value set, ETIMEDOUT, or the rejection code. */
+CYON_API int cyon_future_get(cyon_future_t *f, void **value, int timeout_ms);
+CYON_API int cyon_future_is_ready(cyon_future_t *f);
+
+/* Bounded lock-free queues of fixed-size elements (copied in and out).
+   MPMC uses per-slot sequence numbers; SPSC and MPSC drop the CAS on the
+   single-threaded side. Capacity is rounded up to a power of two. */
+typedef struct cyon_queue_s cyon_queue_t;
+enum { CYON_QUEUE_MPMC = 0, CYON_QUEUE_SPSC = 1, CYON_QUEUE_MPSC = 2 };
+
+CYON_API int cyon_queue_create(cyon_queue_t **out, int kind, size_t capacity, size_t elem_size);
+CYON_API void cyon_queue_destroy(cyon_queue_t *q);
+CYON_API int cyon_queue_try_push(cyon_queue_t *q, const void *elem);
+CYON_API int cyon_queue_try_pop(cyon_queue_t *q, void *out);
+CYON_API size_t cyon_queue_capacity(const cyon_queue_t *q);
+CYON_API size_t cyon_queue_elem_size(const cyon_queue_t *q);
+CYON_API size_t cyon_queue_size_approx(cyon_queue_t *q);
+
+/* Channels: a queue with futex-based blocking and close semantics.
+   Blocking calls take timeout_ms (< 0 = forever) and return 0, ETIMEDOUT,
+   or EPIPE (send after close / receive after close once drained). */
+typedef struct cyon_chan_s cyon_chan_t;
+
+CYON_API int cyon_chan_create(cyon_chan_t **out, int kind, size_t capacity, size_t elem_size);
+CYON_API void cyon_chan_destroy(cyon_chan_t *c);
+CYON_API int cyon_chan_send(cyon_chan_t *c, const void *elem, int timeout_ms);
+CYON_API int cyon_chan_recv(cyon_chan_t *c, void *out, int timeout_ms);
+CYON_API int cyon_chan_try_send(cyon_chan_t *c, const void *elem);
+CYON_API int cyon_chan_try_recv(cyon_chan_t *c, void *out);
+CYON_API int cyon_chan_close(cyon_chan_t *c);
+CYON_API int cyon_chan_is_closed(cyon_chan_t *c);
+
+/* Typed wrappers: CYON_CHAN_TYPED(intchan, int) defines intchan_create,
+   intchan_send, intchan_recv, intchan_try_send and intchan_try_recv. */
+#define CYON_CHAN_TYPED(name, T) \
+    static inline int name##_create(cyon_chan_t **out, int kind, size_t capacity) { \
+        return cyon_chan_create(out, kind, capacity, sizeof(T)); } \
+    static inline int name##_send(cyon_chan_t *c, T v, int timeout_ms) { \
+        return cyon_chan_send(c, &v, timeout_ms); } \
+    static inline int name##_recv(cyon_chan_t *c, T *out, int timeout_ms) { \
+        return cyon_chan_recv(c, out, timeout_ms); } \
+    static inline int name##_try_send(cyon_chan_t *c, T v) { \
+        return cyon_chan_try_send(c, &v); } \
+    static inline int name##_try_recv(cyon_chan_t *c, T *out) { \
+        return cyon_chan_try_recv(c, out); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONTHREAD_H */
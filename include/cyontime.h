@@ -0,0 +1,79 @@
+/* File: include/cyontime.h
+   Time helpers and timer wheels.
+*/
+
+#ifndef CYONTIME_H
+#define CYONTIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+
+/* Wall clock and sleeping */
+CYON_API long cyon_time_now_seconds(void);
+CYON_API int cyon_time_iso8601(char *buf, size_t buflen);
+CYON_API int cyon_sleep_ms(unsigned int ms);
+CYON_API int cyon_epoch_to_year(long epoch);
+/* Monotonic clock in microseconds. */
+CYON_API uint64_t cyon_time_monotonic_us(void);
+
+/* Hierarchical timer wheel.
+   Six levels of 64 slots; level k covers 64^k ticks per slot, so one wheel
+   spans 2^36 ticks. Start and cancel are O(1); advancing touches only
+   occupied slots. Timers are embedded by the caller (no allocation) and a
+   wheel belongs to a single thread, usually an event loop that either
+   polls cyon_timer_wheel_next_timeout_ms() or waits on the wheel's timerfd. */
+
+#define CYON_TIMER_LEVELS     6
+#define CYON_TIMER_LEVEL_BITS 6
+#define CYON_TIMER_SLOTS      (1 << CYON_TIMER_LEVEL_BITS)
+
+/* Coarse timers may fire up to one slot of their level late (never early),
+   and in exchange skip the cascade through the finer levels. */
+#define CYON_TIMER_COARSE 1
+
+typedef struct cyon_timer_wheel_s cyon_timer_wheel_t;
+typedef struct cyon_timer_s cyon_timer_t;
+typedef void (*cyon_timer_cb)(cyon_timer_t *t, void *user);
+
+struct cyon_timer_s {
+    cyon_timer_t *next;
+    cyon_timer_t *prev;
+    uint64_t expires;      /* absolute tick */
+    uint64_t period;       /* ticks, 0 = one-shot */
+    cyon_timer_cb cb;
+    void *user;
+    int flags;
+    int state;
+};
+
+CYON_API int cyon_timer_wheel_create(cyon_timer_wheel_t **out, uint64_t tick_us);
+CYON_API void cyon_timer_wheel_destroy(cyon_timer_wheel_t *w);
+
+CYON_API void cyon_timer_init(cyon_timer_t *t, cyon_timer_cb cb, void *user);
+/* (Re)start t to fire after delay_us, then every period_us if non-zero.
+   Callbacks may start or cancel any timer, including their own. */
+CYON_API int cyon_timer_start(cyon_timer_wheel_t *w, cyon_timer_t *t, uint64_t delay_us, uint64_t period_us, int flags);
+CYON_API int cyon_timer_cancel(cyon_timer_wheel_t *w, cyon_timer_t *t);
+CYON_API int cyon_timer_pending(const cyon_timer_t *t);
+
+/* Run every timer due at now_us (cyon_time_monotonic_us() clock).
+   Returns the number of callbacks invoked. */
+CYON_API size_t cyon_timer_wheel_advance(cyon_timer_wheel_t *w, uint64_t now_us);
+CYON_API size_t cyon_timer_wheel_count(const cyon_timer_wheel_t *w);
+/* Milliseconds until the next slot that needs processing (rounded up),
+   or -1 when no timer is pending. Suitable as an epoll/poll timeout. */
+CYON_API int cyon_timer_wheel_next_timeout_ms(cyon_timer_wheel_t *w);
+
+/* timerfd armed for the wheel's next deadline (Linux). Add it to an epoll
+   set and call cyon_timer_wheel_on_fd() when it becomes readable. */
+CYON_API int cyon_timer_wheel_fd(cyon_timer_wheel_t *w);
+CYON_API size_t cyon_timer_wheel_on_fd(cyon_timer_wheel_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONTIME_H */
@@ -0,0 +1,62 @@
+#ifndef CYONURING_H
+#define CYONURING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cyonlib.h"
+
+/* Minimal io_uring wrapper over the raw syscalls (no liburing).
+   A ring belongs to one thread. SQEs are queued with cyon_uring_sqe() and
+   reach the kernel together on the next cyon_uring_submit(), which also
+   waits for completions, so a loop iteration costs a single syscall.
+   Include <linux/io_uring.h> to fill SQEs and read CQEs. */
+
+typedef struct cyon_uring_s cyon_uring_t;
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* 1 when the kernel offers io_uring with the features used here. Probed
+   once; setting CYON_NO_URING in the environment forces 0. */
+CYON_API int cyon_uring_available(void);
+/* 1 when the running kernel supports opcode op (IORING_OP_*). */
+CYON_API int cyon_uring_supports(int op);
+
+/* entries is rounded up to a power of two; the CQ gets four times as many. */
+CYON_API int cyon_uring_create(cyon_uring_t **out, unsigned entries);
+/* The kernel finishes tearing a ring down asynchronously and may cut a
+   blocking call of the creating thread short with EINTR meanwhile. */
+CYON_API void cyon_uring_destroy(cyon_uring_t *u);
+
+/* Zeroed SQE, or NULL when the ring is full and flushing it failed. */
+CYON_API struct io_uring_sqe *cyon_uring_sqe(cyon_uring_t *u);
+/* Submit everything queued and wait for wait_nr completions for at most
+   timeout_ms (< 0 = no limit). Returns 0, ETIME on timeout, or an errno. */
+CYON_API int cyon_uring_submit(cyon_uring_t *u, unsigned wait_nr, int timeout_ms);
+/* Next completion or NULL; cyon_uring_advance() releases n of them. */
+CYON_API struct io_uring_cqe *cyon_uring_peek(cyon_uring_t *u);
+CYON_API void cyon_uring_advance(cyon_uring_t *u, unsigned n);
+/* io_uring_enter calls made so far. */
+CYON_API uint64_t cyon_uring_enter_count(const cyon_uring_t *u);
+
+/* Fixed files: a sparse table of n slots plus a slot allocator. Install a
+   descriptor with IORING_OP_FILES_UPDATE and use IOSQE_FIXED_FILE. */
+CYON_API int cyon_uring_files_init(cyon_uring_t *u, unsigned n);
+/* Free slot, or -1 when the table is full or missing. */
+CYON_API int cyon_uring_file_alloc(cyon_uring_t *u);
+CYON_API void cyon_uring_file_free(cyon_uring_t *u, int slot);
+
+/* Provided buffer ring: count buffers (a power of two) of size bytes in
+   buffer group bgid, for IOSQE_BUFFER_SELECT requests. */
+CYON_API int cyon_uring_bufs_init(cyon_uring_t *u, unsigned short bgid, unsigned count, unsigned size);
+CYON_API void *cyon_uring_buf(cyon_uring_t *u, unsigned short bid);
+CYON_API unsigned cyon_uring_buf_size(const cyon_uring_t *u);
+/* Give a buffer back to the kernel. */
+CYON_API void cyon_uring_buf_recycle(cyon_uring_t *u, unsigned short bid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYONURING_H */
@@ -0,0 +1,268 @@
+/* File: libraries/bench/bench_http.c
+   wrk-style loopback benchmark for the HTTP/1.1 server (corehttp.c).
+
+   The server runs on a reactor group; client threads keep -c connections
+   busy with -p pipelined GETs each and record the latency of every
+   response. With -r 1 every server loop accepts on its own SO_REUSEPORT
+   socket instead of sharing one listener.
+
+   usage: bench_http [-c conns] [-t client_threads] [-l server_loops]
+                     [-d seconds] [-p pipeline] [-s body_bytes] [-b auto|epoll]
+                     [-r 0|1]
+*/
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static const char bench_request[] = "GET / HTTP/1.1\r\nHost: bench\r\n\r\n";
+
+static char *g_body;
+static size_t g_body_len;
+
+static void bench_handler(cyon_http_ctx_t *x, const cyon_http_request_t *req, void *user) {
+    (void)req;
+    (void)user;
+    cyon_http_respond(x, 200, "text/plain", g_body, g_body_len);
+}
+
+typedef struct {
+    int fd;
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    uint64_t *sent_at;      /* ring of pipeline send times */
+    unsigned head;
+    unsigned inflight;
+} bench_conn_t;
+
+typedef struct {
+    int port;
+    int nconns;
+    unsigned pipeline;
+    uint64_t deadline_ns;
+    bench_hist_t hist;
+    uint64_t responses;
+    uint64_t bytes;
+    uint64_t errors;
+    pthread_t thread;
+} bench_client_t;
+
+static int bench_connect(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    cyon_socket_set_nonblocking(fd, 1);
+    return fd;
+}
+
+static int bench_send(bench_client_t *cl, bench_conn_t *c, unsigned n) {
+    char buf[sizeof(bench_request) * 64];
+    size_t len = 0;
+    uint64_t now = bench_now_ns();
+    for (unsigned i = 0; i < n; i++) {
+        memcpy(buf + len, bench_request, sizeof(bench_request) - 1);
+        len += sizeof(bench_request) - 1;
+        c->sent_at[(c->head + c->inflight + i) % cl->pipeline] = now;
+    }
+    c->inflight += n;
+    /* a few dozen bytes per request: the socket buffer never fills */
+    return cyon_send_all(c->fd, buf, len);
+}
+
+/* Count complete responses at the front of c->in. */
+static void bench_parse(bench_client_t *cl, bench_conn_t *c, uint64_t now) {
+    size_t off = 0;
+    for (;;) {
+        const char *p = c->in + off;
+        size_t avail = c->in_len - off;
+        const char *end = (const char*)memmem(p, avail, "\r\n\r\n", 4);
+        if (!end) break;
+        const char *cl_hdr = (const char*)memmem(p, (size_t)(end - p), "Content-Length: ", 16);
+        size_t body = cl_hdr ? strtoul(cl_hdr + 16, NULL, 10) : 0;
+        size_t total = (size_t)(end - p) + 4 + body;
+        if (avail < total) break;
+        off += total;
+        bench_hist_add(&cl->hist, now - c->sent_at[c->head]);
+        c->head = (c->head + 1) % cl->pipeline;
+        c->inflight--;
+        cl->responses++;
+    }
+    if (off) {
+        memmove(c->in, c->in + off, c->in_len - off);
+        c->in_len -= off;
+    }
+}
+
+static void *bench_client_run(void *arg) {
+    bench_client_t *cl = (bench_client_t*)arg;
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    bench_conn_t *conns = (bench_conn_t*)calloc((size_t)cl->nconns, sizeof(bench_conn_t));
+    for (int i = 0; i < cl->nconns; i++) {
+        bench_conn_t *c = &conns[i];
+        c->fd = bench_connect(cl->port);
+        if (c->fd < 0) {
+            cl->errors++;
+            continue;
+        }
+        c->in_cap = 65536 + g_body_len * 2;
+        c->in = (char*)malloc(c->in_cap);
+        c->sent_at = (uint64_t*)calloc(cl->pipeline, sizeof(uint64_t));
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+        if (bench_send(cl, c, cl->pipeline) != 0) cl->errors++;
+    }
+    struct epoll_event evs[64];
+    for (;;) {
+        uint64_t now = bench_now_ns();
+        int sending = now < cl->deadline_ns;
+        int busy = 0;
+        for (int i = 0; i < cl->nconns; i++) busy |= conns[i].fd >= 0 && conns[i].inflight > 0;
+        if (!busy || now > cl->deadline_ns + 2000000000ULL) break;
+        int n = epoll_wait(ep, evs, 64, 100);
+        now = bench_now_ns();
+        for (int i = 0; i < n; i++) {
+            bench_conn_t *c = (bench_conn_t*)evs[i].data.ptr;
+            for (;;) {
+                if (c->in_len == c->in_cap) {
+                    c->in_cap *= 2;
+                    c->in = (char*)realloc(c->in, c->in_cap);
+                }
+                ssize_t r = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+                if (r > 0) {
+                    cl->bytes += (uint64_t)r;
+                    c->in_len += (size_t)r;
+                    continue;
+                }
+                if (r == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    cl->errors++;
+                    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+                    close(c->fd);
+                    c->fd = -1;
+                }
+                break;
+            }
+            if (c->fd < 0) continue;
+            unsigned before = c->inflight;
+            bench_parse(cl, c, now);
+            if (sending && before > c->inflight && bench_send(cl, c, before - c->inflight) != 0) cl->errors++;
+        }
+    }
+    for (int i = 0; i < cl->nconns; i++) {
+        if (conns[i].fd >= 0) close(conns[i].fd);
+        free(conns[i].in);
+        free(conns[i].sent_at);
+    }
+    free(conns);
+    close(ep);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int nconns = (int)bench_opt_long(argc, argv, "-c", 64);
+    int nthreads = (int)bench_opt_long(argc, argv, "-t", 1);
+    int nloops = (int)bench_opt_long(argc, argv, "-l", 1);
+    long seconds = bench_opt_long(argc, argv, "-d", 5);
+    long pipeline = bench_opt_long(argc, argv, "-p", 1);
+    g_body_len = (size_t)bench_opt_long(argc, argv, "-s", 13);
+    const char *backend = bench_opt(argc, argv, "-b", "auto");
+    int reuseport = (int)bench_opt_long(argc, argv, "-r", 0);
+    if (nconns < 1 || nthreads < 1 || nloops < 1 || seconds < 1 || pipeline < 1 || pipeline > 64) {
+        fprintf(stderr, "usage: %s [-c conns] [-t threads] [-l loops] [-d s] [-p 1..64] [-s bytes] [-b auto|epoll] [-r 0|1]\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(backend, "epoll") == 0) setenv("CYON_NO_URING", "1", 1);
+    if (nthreads > nconns) nthreads = nconns;
+
+    g_body = (char*)malloc(g_body_len + 1);
+    memset(g_body, 'x', g_body_len);
+
+    cyon_listen_opts_t lo;
+    memset(&lo, 0, sizeof(lo));
+    lo.nonblock = 1;
+    int *lfds = (int*)calloc((size_t)nloops, sizeof(int));
+    int nlfds = reuseport ? nloops : 1;
+    int port = 0;
+    cyon_reactor_group_t *g;
+    cyon_http_server_t *srv;
+    if (cyon_reactor_group_create(&g, (size_t)nloops, 0) != 0 ||
+        cyon_http_server_create(&srv, NULL, bench_handler, NULL) != 0) {
+        fprintf(stderr, "server setup failed\n");
+        return 1;
+    }
+    int rc;
+    if (reuseport) {
+        rc = cyon_tcp_listen_reuseport("127.0.0.1", "0", &lo, lfds, (size_t)nlfds);
+        rc = rc < 0 ? -rc : 0;
+        for (int i = 0; rc == 0 && i < nlfds; i++)
+            rc = cyon_http_server_listen(srv, cyon_reactor_group_get(g, (size_t)i), lfds[i]);
+    } else {
+        lfds[0] = cyon_tcp_listen_ex("127.0.0.1", "0", &lo);
+        rc = lfds[0] < 0 ? -lfds[0] : cyon_http_server_listen_group(srv, g, lfds[0]);
+    }
+    if (rc == 0) port = cyon_socket_local_port(lfds[0]);
+    if (rc != 0 || port <= 0 || cyon_reactor_group_start(g) != 0) {
+        fprintf(stderr, "server setup failed: %s\n", strerror(rc));
+        return 1;
+    }
+
+    bench_client_t *cls = (bench_client_t*)calloc((size_t)nthreads, sizeof(bench_client_t));
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < nthreads; i++) {
+        cls[i].port = port;
+        cls[i].nconns = nconns / nthreads + (i < nconns % nthreads);
+        cls[i].pipeline = (unsigned)pipeline;
+        cls[i].deadline_ns = start + (uint64_t)seconds * 1000000000ULL;
+        pthread_create(&cls[i].thread, NULL, bench_client_run, &cls[i]);
+    }
+    bench_hist_t *all = (bench_hist_t*)calloc(1, sizeof(bench_hist_t));
+    uint64_t responses = 0, bytes = 0, errors = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(cls[i].thread, NULL);
+        bench_hist_merge(all, &cls[i].hist);
+        responses += cls[i].responses;
+        bytes += cls[i].bytes;
+        errors += cls[i].errors;
+    }
+    double elapsed = (double)(bench_now_ns() - start) / 1e9;
+
+    printf("http: %d connections, %d client threads, %d server loops%s, pipeline %ld, %zu-byte body, %s\n",
+           nconns, nthreads, nloops, reuseport ? " (SO_REUSEPORT)" : "", pipeline, g_body_len,
+           cyon_reactor_backend(cyon_reactor_group_get(g, 0)) == CYON_REACTOR_URING ? "io_uring" : "epoll");
+    printf("  requests   %llu in %.2fs, %.0f req/s, %.1f MB/s, %llu errors\n", (unsigned long long)responses,
+           elapsed, (double)responses / elapsed, (double)bytes / elapsed / 1e6, (unsigned long long)errors);
+    bench_print_latency("latency", all);
+
+    cyon_reactor_group_stop(g, 1000);
+    cyon_reactor_group_destroy(g);
+    cyon_http_server_destroy(srv);
+    for (int i = 0; i < nlfds; i++) close(lfds[i]);
+    free(lfds);
+    free(all);
+    free(cls);
+    free(g_body);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,348 @@
+/* File: libraries/bench/bench_net.c
+   Loopback benchmark harness for the corenet reactor.
+
+   Scenarios (-m, default all three in turn):
+     echo    every message comes back unchanged
+     rr      every -s byte request gets a -S byte response
+     stream  clients push data in 64 KiB writes as fast as the server
+             takes it; -s only sets the message size it is counted in
+   Each client thread drives its share of -c non-blocking connections with
+   epoll and keeps -p messages in flight on each (echo, rr). Reports
+   messages per second, MB/s, round-trip latency and the system calls per
+   message on the client and the server side.
+
+   usage: bench_net [-m echo|rr|stream|all] [-c conns] [-t client_threads]
+                    [-l server_loops] [-d seconds] [-s bytes] [-S resp_bytes]
+                    [-p pipeline] [-b auto|epoll]
+*/
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+enum { BENCH_ECHO, BENCH_RR, BENCH_STREAM };
+
+static const char *const bench_mode_names[] = { "echo", "rr", "stream" };
+
+#define BENCH_IO_CHUNK 65536
+
+static char g_zero[BENCH_IO_CHUNK];
+
+typedef struct {
+    int mode;
+    size_t msg;             /* request / message bytes */
+    size_t reply;           /* bytes expected back per message, 0 for stream */
+    unsigned pipeline;
+    int port;
+    uint64_t deadline_ns;
+    atomic_uint_fast64_t server_bytes;
+} bench_cfg_t;
+
+/* ---- Server ---- */
+
+static size_t bench_on_data(cyon_conn_t *c, const char *data, size_t len, void *user) {
+    bench_cfg_t *cfg = (bench_cfg_t*)user;
+    atomic_fetch_add_explicit(&cfg->server_bytes, len, memory_order_relaxed);
+    if (cfg->mode == BENCH_ECHO) {
+        cyon_conn_write(c, data, len);
+        return len;
+    }
+    if (cfg->mode == BENCH_STREAM) return len;
+    /* rr: answer whole requests, leave a partial one buffered */
+    size_t n = len / cfg->msg;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t left = cfg->reply; left > 0;) {
+            size_t k = left < sizeof(g_zero) ? left : sizeof(g_zero);
+            cyon_conn_write(c, g_zero, k);
+            left -= k;
+        }
+    }
+    atomic_fetch_sub_explicit(&cfg->server_bytes, len - n * cfg->msg, memory_order_relaxed);
+    return n * cfg->msg;
+}
+
+/* ---- Clients ---- */
+
+typedef struct {
+    int fd;
+    size_t out_left;        /* bytes queued but not yet sent */
+    size_t in_bytes;        /* reply bytes not yet matched to a message */
+    uint64_t *sent_at;      /* ring of send times */
+    unsigned head;
+    unsigned inflight;
+    int want_out;
+} bench_conn_t;
+
+typedef struct {
+    bench_cfg_t *cfg;
+    int nconns;
+    bench_hist_t hist;
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t syscalls;
+    uint64_t errors;
+    pthread_t thread;
+} bench_client_t;
+
+static int bench_connect(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    cyon_socket_set_nonblocking(fd, 1);
+    return fd;
+}
+
+/* Send what is queued; returns 0, or -1 when the connection failed. */
+static int bench_flush(bench_client_t *cl, bench_conn_t *c, int ep) {
+    while (c->out_left > 0) {
+        size_t k = c->out_left < sizeof(g_zero) ? c->out_left : sizeof(g_zero);
+        cl->syscalls++;
+        ssize_t n = send(c->fd, g_zero, k, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->out_left -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return -1;
+    }
+    int want = c->out_left > 0;
+    if (want != c->want_out) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | (want ? EPOLLOUT : 0);
+        ev.data.ptr = c;
+        epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_out = want;
+    }
+    return 0;
+}
+
+/* Queue n more messages (echo, rr). */
+static void bench_queue(bench_client_t *cl, bench_conn_t *c, unsigned n) {
+    uint64_t now = bench_now_ns();
+    for (unsigned i = 0; i < n; i++) c->sent_at[(c->head + c->inflight + i) % cl->cfg->pipeline] = now;
+    c->inflight += n;
+    c->out_left += (size_t)n * cl->cfg->msg;
+}
+
+static void bench_drop(bench_client_t *cl, bench_conn_t *c, int ep) {
+    cl->errors++;
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+}
+
+static void *bench_client_run(void *arg) {
+    bench_client_t *cl = (bench_client_t*)arg;
+    bench_cfg_t *cfg = cl->cfg;
+    int stream = cfg->mode == BENCH_STREAM;
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    char *scratch = (char*)malloc(BENCH_IO_CHUNK);
+    bench_conn_t *conns = (bench_conn_t*)calloc((size_t)cl->nconns, sizeof(bench_conn_t));
+    for (int i = 0; i < cl->nconns; i++) {
+        bench_conn_t *c = &conns[i];
+        c->fd = bench_connect(cfg->port);
+        if (c->fd < 0) {
+            cl->errors++;
+            continue;
+        }
+        c->sent_at = (uint64_t*)calloc(cfg->pipeline, sizeof(uint64_t));
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+        if (stream) c->out_left = (size_t)-1 / 2;
+        else bench_queue(cl, c, cfg->pipeline);
+        if (bench_flush(cl, c, ep) != 0) bench_drop(cl, c, ep);
+    }
+    struct epoll_event evs[64];
+    for (;;) {
+        uint64_t now = bench_now_ns();
+        int sending = now < cfg->deadline_ns;
+        if (!sending && stream) break;
+        int busy = 0;
+        for (int i = 0; i < cl->nconns; i++) busy |= conns[i].fd >= 0 && (stream || conns[i].inflight > 0);
+        if (!busy || now > cfg->deadline_ns + 2000000000ULL) break;
+        cl->syscalls++;
+        int n = epoll_wait(ep, evs, 64, 100);
+        for (int i = 0; i < n; i++) {
+            bench_conn_t *c = (bench_conn_t*)evs[i].data.ptr;
+            if (c->fd < 0) continue;
+            if (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                for (;;) {
+                    cl->syscalls++;
+                    ssize_t r = recv(c->fd, scratch, BENCH_IO_CHUNK, 0);
+                    if (r > 0) {
+                        cl->bytes += (uint64_t)r;
+                        c->in_bytes += (size_t)r;
+                        if ((size_t)r < BENCH_IO_CHUNK) break;
+                        continue;
+                    }
+                    if (r < 0 && errno == EINTR) continue;
+                    if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) bench_drop(cl, c, ep);
+                    break;
+                }
+                if (c->fd < 0) continue;
+                uint64_t t = bench_now_ns();
+                unsigned done = 0;
+                while (c->inflight > 0 && c->in_bytes >= cfg->reply) {
+                    c->in_bytes -= cfg->reply;
+                    bench_hist_add(&cl->hist, t - c->sent_at[c->head]);
+                    c->head = (c->head + 1) % cfg->pipeline;
+                    c->inflight--;
+                    cl->messages++;
+                    done++;
+                }
+                if (sending && done) bench_queue(cl, c, done);
+            }
+            if (stream && !sending) c->out_left = 0;
+            if (bench_flush(cl, c, ep) != 0) bench_drop(cl, c, ep);
+        }
+    }
+    for (int i = 0; i < cl->nconns; i++) {
+        if (conns[i].fd >= 0) close(conns[i].fd);
+        free(conns[i].sent_at);
+    }
+    free(conns);
+    free(scratch);
+    close(ep);
+    return NULL;
+}
+
+/* ---- Driver ---- */
+
+typedef struct {
+    int nconns;
+    int nthreads;
+    int nloops;
+    long seconds;
+    size_t msg;
+    size_t resp;
+    unsigned pipeline;
+} bench_opts_t;
+
+static int bench_run(int mode, const bench_opts_t *o) {
+    bench_cfg_t *cfg = (bench_cfg_t*)calloc(1, sizeof(bench_cfg_t));
+    cfg->mode = mode;
+    cfg->msg = o->msg;
+    cfg->reply = mode == BENCH_ECHO ? o->msg : mode == BENCH_RR ? o->resp : 0;
+    cfg->pipeline = o->pipeline;
+    atomic_init(&cfg->server_bytes, 0);
+
+    cyon_conn_handlers_t h;
+    memset(&h, 0, sizeof(h));
+    h.on_data = bench_on_data;
+    int lfd = cyon_tcp_listen("127.0.0.1", "0", 4096);
+    cyon_reactor_group_t *g;
+    if (lfd < 0 || cyon_reactor_group_create(&g, (size_t)o->nloops, 0) != 0 ||
+        cyon_reactor_group_listen(g, lfd, &h, cfg) != 0 || cyon_reactor_group_start(g) != 0) {
+        fprintf(stderr, "server setup failed\n");
+        return 1;
+    }
+    cfg->port = cyon_socket_local_port(lfd);
+
+    bench_client_t *cls = (bench_client_t*)calloc((size_t)o->nthreads, sizeof(bench_client_t));
+    uint64_t start = bench_now_ns();
+    cfg->deadline_ns = start + (uint64_t)o->seconds * 1000000000ULL;
+    for (int i = 0; i < o->nthreads; i++) {
+        cls[i].cfg = cfg;
+        cls[i].nconns = o->nconns / o->nthreads + (i < o->nconns % o->nthreads);
+        pthread_create(&cls[i].thread, NULL, bench_client_run, &cls[i]);
+    }
+    bench_hist_t *all = (bench_hist_t*)calloc(1, sizeof(bench_hist_t));
+    uint64_t messages = 0, bytes = 0, syscalls = 0, errors = 0;
+    for (int i = 0; i < o->nthreads; i++) {
+        pthread_join(cls[i].thread, NULL);
+        bench_hist_merge(all, &cls[i].hist);
+        messages += cls[i].messages;
+        bytes += cls[i].bytes;
+        syscalls += cls[i].syscalls;
+        errors += cls[i].errors;
+    }
+    double elapsed = (double)(bench_now_ns() - start) / 1e9;
+    uint64_t server_bytes = atomic_load(&cfg->server_bytes);
+    int backend = cyon_reactor_backend(cyon_reactor_group_get(g, 0));
+    cyon_reactor_group_stop(g, 1000);
+    uint64_t server_calls = 0;
+    for (size_t i = 0; i < cyon_reactor_group_size(g); i++)
+        server_calls += cyon_reactor_syscalls(cyon_reactor_group_get(g, i));
+    if (mode == BENCH_STREAM) {
+        /* the server side counts what actually arrived */
+        messages = server_bytes / o->msg;
+        bytes = server_bytes;
+    } else {
+        bytes += server_bytes;
+    }
+
+    printf("%s: %d connections, %d client threads, %d server loops, %zu-byte messages", bench_mode_names[mode],
+           o->nconns, o->nthreads, o->nloops, o->msg);
+    if (mode == BENCH_RR) printf(", %zu-byte responses", o->resp);
+    if (mode != BENCH_STREAM) printf(", pipeline %u", o->pipeline);
+    printf(", %s\n", backend == CYON_REACTOR_URING ? "io_uring" : "epoll");
+    printf("  messages   %llu in %.2fs, %.0f msg/s, %.1f MB/s, %llu errors\n", (unsigned long long)messages,
+           elapsed, (double)messages / elapsed, (double)bytes / elapsed / 1e6, (unsigned long long)errors);
+    double per = messages ? 1.0 / (double)messages : 0.0;
+    printf("  syscalls   client %.3f/msg, server %.3f/msg\n", (double)syscalls * per, (double)server_calls * per);
+    if (mode != BENCH_STREAM) bench_print_latency("latency", all);
+
+    cyon_reactor_group_destroy(g);
+    close(lfd);
+    free(all);
+    free(cls);
+    free(cfg);
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    bench_opts_t o;
+    o.nconns = (int)bench_opt_long(argc, argv, "-c", 16);
+    o.nthreads = (int)bench_opt_long(argc, argv, "-t", 1);
+    o.nloops = (int)bench_opt_long(argc, argv, "-l", 1);
+    o.seconds = bench_opt_long(argc, argv, "-d", 3);
+    long msg = bench_opt_long(argc, argv, "-s", 64);
+    long resp = bench_opt_long(argc, argv, "-S", 1024);
+    long pipeline = bench_opt_long(argc, argv, "-p", 1);
+    const char *mode = bench_opt(argc, argv, "-m", "all");
+    const char *backend = bench_opt(argc, argv, "-b", "auto");
+    int only = -1;
+    for (int i = 0; i < 3; i++)
+        if (strcmp(mode, bench_mode_names[i]) == 0) only = i;
+    if (o.nconns < 1 || o.nthreads < 1 || o.nloops < 1 || o.seconds < 1 || msg < 1 || msg > (1 << 20) ||
+        resp < 1 || resp > (1 << 24) || pipeline < 1 || pipeline > 4096 || (only < 0 && strcmp(mode, "all") != 0)) {
+        fprintf(stderr, "usage: %s [-m echo|rr|stream|all] [-c conns] [-t threads] [-l loops] [-d s] "
+                        "[-s bytes] [-S resp_bytes] [-p pipeline] [-b auto|epoll]\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(backend, "epoll") == 0) setenv("CYON_NO_URING", "1", 1);
+    if (o.nthreads > o.nconns) o.nthreads = o.nconns;
+    o.msg = (size_t)msg;
+    o.resp = (size_t)resp;
+    o.pipeline = (unsigned)pipeline;
+
+    int rc = 0;
+    for (int m = 0; m < 3; m++)
+        if (only < 0 || only == m) rc |= bench_run(m, &o);
+    return rc;
+}
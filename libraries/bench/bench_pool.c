@@ -0,0 +1,182 @@
+/* File: libraries/bench/bench_pool.c
+   Loopback benchmark for the outbound connection pool (corenet.c).
+
+   An echo server runs on a reactor group. Client threads lease a
+   connection from one shared pool for every request, send -s bytes, read
+   them back and return the lease. With -k 0 every lease is closed on
+   release, so each request pays for a fresh connect; -x n makes the
+   server close a connection after n requests, so the pool has to notice
+   dead idle connections (a request that fails on a reused one is retried
+   once, as cyon_pool_conn_reused() advises).
+
+   usage: bench_pool [-t client_threads] [-l server_loops] [-d seconds]
+                     [-s bytes] [-m max_per_host] [-k 0|1] [-x requests]
+                     [-b auto|epoll]
+*/
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+static size_t g_msg;
+static long g_close_after;     /* server requests per connection, 0 = no limit */
+
+/* Echo whole requests. The connection's user pointer (NULL from listen)
+   counts the requests served on it. */
+static size_t bench_on_data(cyon_conn_t *c, const char *data, size_t len, void *user) {
+    size_t n = len / g_msg * g_msg;
+    if (n == 0) return 0;
+    cyon_conn_write(c, data, n);
+    uintptr_t served = (uintptr_t)user + n / g_msg;
+    cyon_conn_set_user(c, (void*)served);
+    if (g_close_after > 0 && (long)served >= g_close_after) cyon_conn_close(c);
+    return n;
+}
+
+typedef struct {
+    cyon_connpool_t *pool;
+    const char *port;
+    size_t msg;
+    int keep;
+    uint64_t deadline_ns;
+    bench_hist_t hist;
+    uint64_t requests;
+    uint64_t retries;
+    uint64_t errors;
+    pthread_t thread;
+} bench_client_t;
+
+static int bench_full(int fd, char *buf, size_t len, int out) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = out ? send(fd, buf + done, len - done, MSG_NOSIGNAL) : recv(fd, buf + done, len - done, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        done += (size_t)r;
+    }
+    return 0;
+}
+
+/* One request on a fresh lease; 1 when it failed on a reused connection. */
+static int bench_request(bench_client_t *cl, char *buf) {
+    cyon_pool_conn_t *c;
+    if (cyon_connpool_acquire(cl->pool, "127.0.0.1", cl->port, &c) != 0) return -1;
+    int fd = cyon_pool_conn_fd(c);
+    int ok = bench_full(fd, buf, cl->msg, 1) == 0 && bench_full(fd, buf, cl->msg, 0) == 0;
+    int reused = cyon_pool_conn_reused(c);
+    cyon_connpool_release(cl->pool, c, ok && cl->keep);
+    if (ok) return 0;
+    return reused ? 1 : -1;
+}
+
+static void *bench_client_run(void *arg) {
+    bench_client_t *cl = (bench_client_t*)arg;
+    char *buf = (char*)calloc(1, cl->msg);
+    while (bench_now_ns() < cl->deadline_ns) {
+        uint64_t t0 = bench_now_ns();
+        int rc = bench_request(cl, buf);
+        if (rc == 1) {
+            cl->retries++;
+            rc = bench_request(cl, buf);
+        }
+        if (rc != 0) {
+            cl->errors++;
+            continue;
+        }
+        bench_hist_add(&cl->hist, bench_now_ns() - t0);
+        cl->requests++;
+    }
+    free(buf);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int nthreads = (int)bench_opt_long(argc, argv, "-t", 4);
+    int nloops = (int)bench_opt_long(argc, argv, "-l", 1);
+    long seconds = bench_opt_long(argc, argv, "-d", 5);
+    long msg = bench_opt_long(argc, argv, "-s", 64);
+    long max_per_host = bench_opt_long(argc, argv, "-m", 8);
+    int keep = (int)bench_opt_long(argc, argv, "-k", 1);
+    long close_after = bench_opt_long(argc, argv, "-x", 0);
+    const char *backend = bench_opt(argc, argv, "-b", "auto");
+    if (nthreads < 1 || nloops < 1 || seconds < 1 || msg < 1 || max_per_host < 1 || close_after < 0) {
+        fprintf(stderr, "usage: %s [-t threads] [-l loops] [-d s] [-s bytes] [-m max_per_host] [-k 0|1] "
+                        "[-x requests] [-b auto|epoll]\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(backend, "epoll") == 0) setenv("CYON_NO_URING", "1", 1);
+
+    g_msg = (size_t)msg;
+    g_close_after = close_after;
+    cyon_conn_handlers_t h;
+    memset(&h, 0, sizeof(h));
+    h.on_data = bench_on_data;
+    int lfd = cyon_tcp_listen("127.0.0.1", "0", 4096);
+    cyon_reactor_group_t *g;
+    if (lfd < 0 || cyon_reactor_group_create(&g, (size_t)nloops, 0) != 0 ||
+        cyon_reactor_group_listen(g, lfd, &h, NULL) != 0 || cyon_reactor_group_start(g) != 0) {
+        fprintf(stderr, "server setup failed\n");
+        return 1;
+    }
+    char port[16];
+    snprintf(port, sizeof(port), "%d", cyon_socket_local_port(lfd));
+
+    cyon_connpool_opts_t po;
+    memset(&po, 0, sizeof(po));
+    po.max_per_host = (size_t)max_per_host;
+    cyon_connpool_t *pool;
+    if (cyon_connpool_create(&pool, &po) != 0) {
+        fprintf(stderr, "pool setup failed\n");
+        return 1;
+    }
+
+    bench_client_t *cls = (bench_client_t*)calloc((size_t)nthreads, sizeof(bench_client_t));
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < nthreads; i++) {
+        cls[i].pool = pool;
+        cls[i].port = port;
+        cls[i].msg = (size_t)msg;
+        cls[i].keep = keep;
+        cls[i].deadline_ns = start + (uint64_t)seconds * 1000000000ULL;
+        pthread_create(&cls[i].thread, NULL, bench_client_run, &cls[i]);
+    }
+    bench_hist_t *all = (bench_hist_t*)calloc(1, sizeof(bench_hist_t));
+    uint64_t requests = 0, retries = 0, errors = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(cls[i].thread, NULL);
+        bench_hist_merge(all, &cls[i].hist);
+        requests += cls[i].requests;
+        retries += cls[i].retries;
+        errors += cls[i].errors;
+    }
+    double elapsed = (double)(bench_now_ns() - start) / 1e9;
+    size_t pruned = cyon_connpool_prune(pool);
+    cyon_connpool_stats_t st;
+    cyon_connpool_stats(pool, &st);
+
+    printf("pool: %d client threads, %d server loops, %ld-byte requests, max %ld per host, %s",
+           nthreads, nloops, msg, max_per_host, keep ? "reuse" : "no reuse");
+    if (close_after) printf(", server closes after %ld", close_after);
+    printf(", %s\n", cyon_reactor_backend(cyon_reactor_group_get(g, 0)) == CYON_REACTOR_URING ? "io_uring" : "epoll");
+    printf("  requests   %llu in %.2fs, %.0f req/s, %llu retries, %llu errors\n", (unsigned long long)requests,
+           elapsed, (double)requests / elapsed, (unsigned long long)retries, (unsigned long long)errors);
+    printf("  pool       %llu connects, %llu reuses, %llu dropped, %zu pruned, dns %llu lookups %llu hits\n",
+           (unsigned long long)st.connects, (unsigned long long)st.reuses, (unsigned long long)st.dropped, pruned,
+           (unsigned long long)st.dns_lookups, (unsigned long long)st.dns_hits);
+    bench_print_latency("latency", all);
+
+    cyon_connpool_destroy(pool);
+    cyon_reactor_group_stop(g, 1000);
+    cyon_reactor_group_destroy(g);
+    close(lfd);
+    free(all);
+    free(cls);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+/* File: libraries/bench/bench_rpc.c
+   Loopback benchmark for the framed RPC layer (corerpc.c).
+
+   The server runs an echo method on a reactor group. Each client thread
+   owns one connection and keeps -p calls in flight on it; every response
+   immediately triggers the next call, so requests and responses batch up
+   in both directions. Reports calls per second and the latency of every
+   call.
+
+   usage: bench_rpc [-t client_threads] [-l server_loops] [-d seconds]
+                    [-p in_flight] [-s payload_bytes] [-b auto|epoll]
+*/
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define BENCH_METHOD_ECHO 1
+
+static void bench_echo(cyon_rpc_call_t *call, const void *req, size_t len, void *user) {
+    (void)user;
+    cyon_rpc_reply(call, 0, req, len);
+}
+
+typedef struct bench_client_s bench_client_t;
+
+typedef struct {
+    bench_client_t *cl;
+    uint64_t sent_at;
+} bench_slot_t;
+
+struct bench_client_s {
+    const char *port;
+    unsigned inflight;
+    size_t size;
+    char *payload;
+    uint64_t deadline_ns;
+    cyon_rpc_client_t *rpc;
+    bench_hist_t hist;
+    uint64_t calls;
+    uint64_t errors;
+    pthread_t thread;
+};
+
+static void bench_done(int status, const void *resp, size_t len, void *user);
+
+static void bench_issue(bench_slot_t *s) {
+    bench_client_t *cl = s->cl;
+    s->sent_at = bench_now_ns();
+    if (cyon_rpc_client_send(cl->rpc, BENCH_METHOD_ECHO, cl->payload, cl->size, bench_done, s) != 0) cl->errors++;
+}
+
+static void bench_done(int status, const void *resp, size_t len, void *user) {
+    bench_slot_t *s = (bench_slot_t*)user;
+    bench_client_t *cl = s->cl;
+    uint64_t now = bench_now_ns();
+    (void)resp;
+    if (status != 0 || len != cl->size) {
+        cl->errors++;
+        return;
+    }
+    bench_hist_add(&cl->hist, now - s->sent_at);
+    cl->calls++;
+    if (now < cl->deadline_ns) bench_issue(s);
+}
+
+static void *bench_client_run(void *arg) {
+    bench_client_t *cl = (bench_client_t*)arg;
+    int fd = cyon_tcp_connect("127.0.0.1", cl->port, 1000);
+    if (fd < 0 || cyon_rpc_client_create(&cl->rpc, fd, NULL) != 0) {
+        cl->errors++;
+        return NULL;
+    }
+    bench_slot_t *slots = (bench_slot_t*)calloc(cl->inflight, sizeof(bench_slot_t));
+    for (unsigned i = 0; i < cl->inflight; i++) {
+        slots[i].cl = cl;
+        bench_issue(&slots[i]);
+    }
+    while (cyon_rpc_client_pending(cl->rpc) > 0) {
+        if (cyon_rpc_client_poll(cl->rpc, 1000) <= 0) {
+            cl->errors++;
+            break;
+        }
+    }
+    cyon_rpc_client_destroy(cl->rpc);
+    free(slots);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int nthreads = (int)bench_opt_long(argc, argv, "-t", 1);
+    int nloops = (int)bench_opt_long(argc, argv, "-l", 1);
+    long seconds = bench_opt_long(argc, argv, "-d", 5);
+    long inflight = bench_opt_long(argc, argv, "-p", 16);
+    long size = bench_opt_long(argc, argv, "-s", 64);
+    const char *backend = bench_opt(argc, argv, "-b", "auto");
+    if (nthreads < 1 || nloops < 1 || seconds < 1 || inflight < 1 || inflight > 65536 || size < 0 ||
+        size > 65536) {
+        fprintf(stderr, "usage: %s [-t threads] [-l loops] [-d s] [-p in_flight] [-s 0..65536] [-b auto|epoll]\n",
+                argv[0]);
+        return 2;
+    }
+    if (strcmp(backend, "epoll") == 0) setenv("CYON_NO_URING", "1", 1);
+
+    int lfd = cyon_tcp_listen("127.0.0.1", "0", 1024);
+    cyon_reactor_group_t *g;
+    cyon_rpc_server_t *srv;
+    if (lfd < 0 || cyon_reactor_group_create(&g, (size_t)nloops, 0) != 0 ||
+        cyon_rpc_server_create(&srv, NULL) != 0 ||
+        cyon_rpc_server_register(srv, BENCH_METHOD_ECHO, bench_echo, NULL) != 0 ||
+        cyon_rpc_server_listen_group(srv, g, lfd) != 0 || cyon_reactor_group_start(g) != 0) {
+        fprintf(stderr, "server setup failed\n");
+        return 1;
+    }
+    char port[16];
+    snprintf(port, sizeof(port), "%d", cyon_socket_local_port(lfd));
+
+    char *payload = (char*)malloc((size_t)size + 1);
+    memset(payload, 'r', (size_t)size);
+    bench_client_t *cls = (bench_client_t*)calloc((size_t)nthreads, sizeof(bench_client_t));
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < nthreads; i++) {
+        cls[i].port = port;
+        cls[i].inflight = (unsigned)inflight;
+        cls[i].size = (size_t)size;
+        cls[i].payload = payload;
+        cls[i].deadline_ns = start + (uint64_t)seconds * 1000000000ULL;
+        pthread_create(&cls[i].thread, NULL, bench_client_run, &cls[i]);
+    }
+    bench_hist_t *all = (bench_hist_t*)calloc(1, sizeof(bench_hist_t));
+    uint64_t calls = 0, errors = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(cls[i].thread, NULL);
+        bench_hist_merge(all, &cls[i].hist);
+        calls += cls[i].calls;
+        errors += cls[i].errors;
+    }
+    double elapsed = (double)(bench_now_ns() - start) / 1e9;
+
+    printf("rpc: %d connections, %d server loops, %ld in flight each, %ld-byte payload, %s\n", nthreads, nloops,
+           inflight, size,
+           cyon_reactor_backend(cyon_reactor_group_get(g, 0)) == CYON_REACTOR_URING ? "io_uring" : "epoll");
+    printf("  calls      %llu in %.2fs, %.0f calls/s, %llu errors\n", (unsigned long long)calls, elapsed,
+           (double)calls / elapsed, (unsigned long long)errors);
+    bench_print_latency("latency", all);
+
+    cyon_reactor_group_stop(g, 1000);
+    cyon_reactor_group_destroy(g);
+    cyon_rpc_server_destroy(srv);
+    close(lfd);
+    free(all);
+    free(cls);
+    free(payload);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+/* File: libraries/bench/bench_util.h
+   Helpers shared by the loopback benchmarks: clock, latency histogram,
+   option parsing and report formatting. Header-only on purpose; each
+   benchmark is a single translation unit linked against libcyon_std.a.
+*/
+
+#ifndef CYON_BENCH_UTIL_H
+#define CYON_BENCH_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Log-linear histogram over nanoseconds: 32 linear sub-buckets per power
+   of two, so any reported percentile is within ~3% of the true value. */
+#define BENCH_HIST_SUB  32
+#define BENCH_HIST_BITS 5
+#define BENCH_HIST_SIZE (64 * BENCH_HIST_SUB)
+
+typedef struct {
+    uint64_t counts[BENCH_HIST_SIZE];
+    uint64_t n;
+    uint64_t max;
+    double sum;
+} bench_hist_t;
+
+static inline size_t bench_hist_index(uint64_t v) {
+    if (v < BENCH_HIST_SUB) return (size_t)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - BENCH_HIST_BITS;
+    return (size_t)((shift + 1) * BENCH_HIST_SUB) + (size_t)((v >> shift) & (BENCH_HIST_SUB - 1));
+}
+
+/* Lower bound of the values counted in bucket i. */
+static inline uint64_t bench_hist_value(size_t i) {
+    if (i < BENCH_HIST_SUB) return (uint64_t)i;
+    int shift = (int)(i / BENCH_HIST_SUB) - 1;
+    return ((uint64_t)BENCH_HIST_SUB + (i % BENCH_HIST_SUB)) << shift;
+}
+
+static inline void bench_hist_add(bench_hist_t *h, uint64_t v) {
+    h->counts[bench_hist_index(v)]++;
+    h->n++;
+    h->sum += (double)v;
+    if (v > h->max) h->max = v;
+}
+
+static inline void bench_hist_merge(bench_hist_t *dst, const bench_hist_t *src) {
+    for (size_t i = 0; i < BENCH_HIST_SIZE; i++) dst->counts[i] += src->counts[i];
+    dst->n += src->n;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+static inline uint64_t bench_hist_pct(const bench_hist_t *h, double pct) {
+    if (h->n == 0) return 0;
+    uint64_t want = (uint64_t)((double)h->n * pct / 100.0 + 0.5);
+    if (want == 0) want = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BENCH_HIST_SIZE; i++) {
+        seen += h->counts[i];
+        if (seen >= want) return bench_hist_value(i);
+    }
+    return h->max;
+}
+
+/* "812ns", "41.3us", "2.05ms" */
+static inline const char *bench_fmt_ns(uint64_t ns, char *buf, size_t len) {
+    if (ns < 1000) snprintf(buf, len, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buf, len, "%.1fus", (double)ns / 1e3);
+    else if (ns < 1000000000ULL) snprintf(buf, len, "%.2fms", (double)ns / 1e6);
+    else snprintf(buf, len, "%.2fs", (double)ns / 1e9);
+    return buf;
+}
+
+static inline void bench_print_latency(const char *label, const bench_hist_t *h) {
+    char a[16], b[16], c[16], d[16], e[16];
+    printf("  %-10s avg %s  p50 %s  p99 %s  p999 %s  max %s\n", label,
+           bench_fmt_ns(h->n ? (uint64_t)(h->sum / (double)h->n) : 0, a, sizeof(a)),
+           bench_fmt_ns(bench_hist_pct(h, 50.0), b, sizeof(b)),
+           bench_fmt_ns(bench_hist_pct(h, 99.0), c, sizeof(c)),
+           bench_fmt_ns(bench_hist_pct(h, 99.9), d, sizeof(d)),
+           bench_fmt_ns(h->max, e, sizeof(e)));
+}
+
+/* Minimal "-x value" parsing: returns the value for flag or def. */
+static inline const char *bench_opt(int argc, char **argv, const char *flag, const char *def) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (strcmp(argv[i], flag) == 0) return argv[i + 1];
+    return def;
+}
+
+static inline long bench_opt_long(int argc, char **argv, const char *flag, long def) {
+    const char *v = bench_opt(argc, argv, flag, NULL);
+    return v ? strtol(v, NULL, 10) : def;
+}
+
+#endif /* CYON_BENCH_UTIL_H */
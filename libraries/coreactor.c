@@ -0,0 +1,326 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyonactor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define CYON_ACTOR_DEFAULT_BATCH 64
+
+/* Mailbox node; the payload follows the (max-aligned) header. */
+typedef struct cyon_actor_msg {
+    _Alignas(max_align_t) _Atomic(struct cyon_actor_msg *) next;
+    int type;
+} cyon_actor_msg_t;
+
+#define CYON_ACTOR_PAYLOAD(m) ((void*)((m) + 1))
+
+struct cyon_actor_system_s {
+    cyon_threadpool_t *pool;
+    size_t batch;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    cyon_actor_t *actors;       /* live (not yet stopped) actors */
+    size_t live;
+    atomic_size_t busy;         /* actors with pending messages */
+};
+
+/* Mailbox is Vyukov's intrusive MPSC queue: producers exchange the tail,
+   the single consumer (the worker holding the actor) walks from head.
+   `pending` counts sent-but-unprocessed messages; the sender that moves it
+   from 0 schedules the actor, and the worker that brings it back to 0
+   lets go, so at most one worker ever runs an actor. */
+struct cyon_actor_s {
+    _Atomic(cyon_actor_msg_t *) tail;
+    char pad1[64 - sizeof(void*)];
+    atomic_size_t pending;
+    char pad2[64 - sizeof(size_t)];
+    cyon_actor_msg_t *head;     /* consumer only */
+    cyon_actor_msg_t stub;
+    cyon_actor_system_t *sys;
+    cyon_actor_fn fn;
+    void *state;
+    size_t msg_size;
+    atomic_int refs;
+    atomic_int stopping;
+    atomic_int senders;         /* sends between their stopping check and push */
+    int dead;                   /* STOP processed; consumer only */
+    int detached;               /* removed from sys->actors; consumer only */
+    cyon_actor_t *prev;         /* sys->actors list, under sys->lock */
+    cyon_actor_t *next;
+    cyon_actor_t *deferred;     /* cyon_actor_later list; one turn queued at a time */
+};
+
+static __thread cyon_actor_t *cyon_actor_current = NULL;
+
+/* Turns the pool refused, run by the outermost cyon_actor_schedule on this
+   thread instead of recursing. */
+static __thread cyon_actor_t *cyon_actor_later_head = NULL;
+static __thread cyon_actor_t *cyon_actor_later_tail = NULL;
+static __thread int cyon_actor_draining = 0;
+
+static void cyon_actor_push(cyon_actor_t *a, cyon_actor_msg_t *m) {
+    atomic_store_explicit(&m->next, NULL, memory_order_relaxed);
+    cyon_actor_msg_t *prev = atomic_exchange_explicit(&a->tail, m, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, m, memory_order_release);
+}
+
+/* NULL when empty or when a producer is between its exchange and link. */
+static cyon_actor_msg_t *cyon_actor_pop(cyon_actor_t *a) {
+    cyon_actor_msg_t *head = a->head;
+    cyon_actor_msg_t *next = atomic_load_explicit(&head->next, memory_order_acquire);
+    if (head == &a->stub) {
+        if (!next) return NULL;
+        a->head = next;
+        head = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+    if (next) {
+        a->head = next;
+        return head;
+    }
+    if (atomic_load_explicit(&a->tail, memory_order_acquire) != head) return NULL;
+    cyon_actor_push(a, &a->stub);
+    next = atomic_load_explicit(&head->next, memory_order_acquire);
+    if (next) {
+        a->head = next;
+        return head;
+    }
+    return NULL;
+}
+
+static void cyon_actor_free(cyon_actor_t *a) {
+    cyon_actor_msg_t *m;
+    while ((m = cyon_actor_pop(a)) != NULL) free(m);
+    free(a);
+}
+
+void cyon_actor_retain(cyon_actor_t *a) {
+    if (a) atomic_fetch_add_explicit(&a->refs, 1, memory_order_relaxed);
+}
+
+void cyon_actor_release(cyon_actor_t *a) {
+    if (a && atomic_fetch_sub_explicit(&a->refs, 1, memory_order_acq_rel) == 1) cyon_actor_free(a);
+}
+
+static void cyon_actor_busy_done(cyon_actor_system_t *sys) {
+    if (atomic_fetch_sub_explicit(&sys->busy, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&sys->lock);
+        pthread_cond_broadcast(&sys->changed);
+        pthread_mutex_unlock(&sys->lock);
+    }
+}
+
+static void *cyon_actor_run(void *arg);
+
+/* Queue one turn of a on the pool. If the pool refuses, the turn runs on
+   this thread: right away when none is running here, otherwise after the
+   current one returns, so actors sending to each other never nest. */
+static void cyon_actor_schedule(cyon_actor_t *a) {
+    if (cyon_threadpool_submit(a->sys->pool, cyon_actor_run, a) == 0) return;
+    a->deferred = NULL;
+    if (cyon_actor_later_tail) cyon_actor_later_tail->deferred = a;
+    else cyon_actor_later_head = a;
+    cyon_actor_later_tail = a;
+    if (cyon_actor_draining) return;
+    cyon_actor_draining = 1;
+    cyon_actor_t *next;
+    while ((next = cyon_actor_later_head) != NULL) {
+        cyon_actor_later_head = next->deferred;
+        if (!cyon_actor_later_head) cyon_actor_later_tail = NULL;
+        cyon_actor_run(next);
+    }
+    cyon_actor_draining = 0;
+}
+
+/* One turn: process up to batch messages, then either requeue (more
+   pending) or go idle. Holds the reference taken by the scheduling send. */
+static void *cyon_actor_run(void *arg) {
+    cyon_actor_t *a = (cyon_actor_t*)arg;
+    cyon_actor_system_t *sys = a->sys;
+    size_t avail = atomic_load_explicit(&a->pending, memory_order_acquire);
+    size_t n = avail < sys->batch ? avail : sys->batch;
+    cyon_actor_t *saved = cyon_actor_current;
+    cyon_actor_current = a;
+    for (size_t i = 0; i < n; ++i) {
+        cyon_actor_msg_t *m;
+        /* counted but not yet linked: the producer is mid-push */
+        while ((m = cyon_actor_pop(a)) == NULL) sched_yield();
+        if (!a->dead) {
+            a->fn(a, m->type, a->msg_size ? CYON_ACTOR_PAYLOAD(m) : NULL, a->state);
+            if (m->type == CYON_ACTOR_STOP) a->dead = 1;
+        }
+        free(m);
+    }
+    cyon_actor_current = saved;
+    if (atomic_fetch_sub_explicit(&a->pending, n, memory_order_acq_rel) != n) {
+        cyon_actor_schedule(a);
+        return NULL;
+    }
+    if (a->dead && !a->detached) {
+        pthread_mutex_lock(&sys->lock);
+        if (a->prev) a->prev->next = a->next;
+        else sys->actors = a->next;
+        if (a->next) a->next->prev = a->prev;
+        a->prev = a->next = NULL;
+        a->detached = 1;
+        sys->live--;
+        pthread_cond_broadcast(&sys->changed);
+        pthread_mutex_unlock(&sys->lock);
+        cyon_actor_release(a);      /* the system's reference */
+    }
+    cyon_actor_busy_done(sys);
+    cyon_actor_release(a);          /* this turn's reference */
+    return NULL;
+}
+
+/* Count a pushed message; the send that makes it pending schedules a. */
+static void cyon_actor_signal(cyon_actor_t *a) {
+    if (atomic_fetch_add_explicit(&a->pending, 1, memory_order_acq_rel) == 0) {
+        cyon_actor_retain(a);
+        atomic_fetch_add_explicit(&a->sys->busy, 1, memory_order_acq_rel);
+        cyon_actor_schedule(a);
+    }
+}
+
+static cyon_actor_msg_t *cyon_actor_msg_new(cyon_actor_t *a, int type, const void *msg) {
+    cyon_actor_msg_t *m = (cyon_actor_msg_t*)malloc(sizeof(cyon_actor_msg_t) + a->msg_size);
+    if (!m) return NULL;
+    m->type = type;
+    if (a->msg_size) {
+        if (msg) memcpy(CYON_ACTOR_PAYLOAD(m), msg, a->msg_size);
+        else memset(CYON_ACTOR_PAYLOAD(m), 0, a->msg_size);
+    }
+    return m;
+}
+
+/* A send registers in `senders` before checking `stopping`, and stop sets
+   `stopping` before waiting for `senders` to drain (both seq_cst), so every
+   accepted message is pushed ahead of CYON_ACTOR_STOP. */
+int cyon_actor_send(cyon_actor_t *a, int type, const void *msg) {
+    if (!a || type == CYON_ACTOR_STOP) return EINVAL;
+    if (atomic_load_explicit(&a->stopping, memory_order_acquire)) return EPIPE;
+    cyon_actor_msg_t *m = cyon_actor_msg_new(a, type, msg);
+    if (!m) return ENOMEM;
+    atomic_fetch_add(&a->senders, 1);
+    if (atomic_load(&a->stopping)) {
+        atomic_fetch_sub_explicit(&a->senders, 1, memory_order_release);
+        free(m);
+        return EPIPE;
+    }
+    cyon_actor_push(a, m);
+    atomic_fetch_sub_explicit(&a->senders, 1, memory_order_release);
+    cyon_actor_signal(a);
+    return 0;
+}
+
+int cyon_actor_stop(cyon_actor_t *a) {
+    if (!a) return EINVAL;
+    if (atomic_load_explicit(&a->stopping, memory_order_acquire)) return 0;
+    /* allocate before claiming the flag, so a failure can be retried */
+    cyon_actor_msg_t *m = cyon_actor_msg_new(a, CYON_ACTOR_STOP, NULL);
+    if (!m) return ENOMEM;
+    if (atomic_exchange(&a->stopping, 1)) {
+        free(m);
+        return 0;
+    }
+    /* a racing send is only between two atomics: never blocked */
+    while (atomic_load_explicit(&a->senders, memory_order_acquire) > 0) sched_yield();
+    cyon_actor_push(a, m);
+    cyon_actor_signal(a);
+    return 0;
+}
+
+int cyon_actor_spawn(cyon_actor_system_t *sys, cyon_actor_t **out, cyon_actor_fn fn,
+                     void *state, size_t msg_size) {
+    if (!sys || !out || !fn) return EINVAL;
+    cyon_actor_t *a = (cyon_actor_t*)calloc(1, sizeof(cyon_actor_t));
+    if (!a) return ENOMEM;
+    atomic_init(&a->stub.next, NULL);
+    atomic_init(&a->tail, &a->stub);
+    a->head = &a->stub;
+    a->sys = sys;
+    a->fn = fn;
+    a->state = state;
+    a->msg_size = msg_size;
+    atomic_init(&a->refs, 2);       /* caller + system */
+    pthread_mutex_lock(&sys->lock);
+    a->next = sys->actors;
+    if (sys->actors) sys->actors->prev = a;
+    sys->actors = a;
+    sys->live++;
+    pthread_mutex_unlock(&sys->lock);
+    *out = a;
+    return 0;
+}
+
+cyon_actor_t *cyon_actor_self(void) {
+    return cyon_actor_current;
+}
+
+void *cyon_actor_state(cyon_actor_t *a) {
+    return a ? a->state : NULL;
+}
+
+size_t cyon_actor_pending(cyon_actor_t *a) {
+    return a ? atomic_load_explicit(&a->pending, memory_order_relaxed) : 0;
+}
+
+int cyon_actor_system_create(cyon_actor_system_t **out, cyon_threadpool_t *pool, size_t batch) {
+    if (!out) return EINVAL;
+    if (!pool) pool = cyon_threadpool_shared();
+    if (!pool) return ENOMEM;
+    cyon_actor_system_t *sys = (cyon_actor_system_t*)calloc(1, sizeof(cyon_actor_system_t));
+    if (!sys) return ENOMEM;
+    sys->pool = pool;
+    sys->batch = batch ? batch : CYON_ACTOR_DEFAULT_BATCH;
+    pthread_mutex_init(&sys->lock, NULL);
+    pthread_cond_init(&sys->changed, NULL);
+    atomic_init(&sys->busy, 0);
+    *out = sys;
+    return 0;
+}
+
+int cyon_actor_system_wait(cyon_actor_system_t *sys) {
+    if (!sys) return EINVAL;
+    pthread_mutex_lock(&sys->lock);
+    while (atomic_load_explicit(&sys->busy, memory_order_acquire) > 0)
+        pthread_cond_wait(&sys->changed, &sys->lock);
+    pthread_mutex_unlock(&sys->lock);
+    return 0;
+}
+
+size_t cyon_actor_system_count(cyon_actor_system_t *sys) {
+    if (!sys) return 0;
+    pthread_mutex_lock(&sys->lock);
+    size_t n = sys->live;
+    pthread_mutex_unlock(&sys->lock);
+    return n;
+}
+
+int cyon_actor_system_destroy(cyon_actor_system_t *sys) {
+    if (!sys) return EINVAL;
+    pthread_mutex_lock(&sys->lock);
+    for (;;) {
+        /* stop one not-yet-stopping actor at a time (stop may run inline) */
+        cyon_actor_t *a = sys->actors;
+        while (a && atomic_load_explicit(&a->stopping, memory_order_acquire)) a = a->next;
+        if (!a) break;
+        cyon_actor_retain(a);
+        pthread_mutex_unlock(&sys->lock);
+        cyon_actor_stop(a);
+        cyon_actor_release(a);
+        pthread_mutex_lock(&sys->lock);
+    }
+    while (sys->live > 0 || atomic_load_explicit(&sys->busy, memory_order_acquire) > 0)
+        pthread_cond_wait(&sys->changed, &sys->lock);
+    pthread_mutex_unlock(&sys->lock);
+    pthread_cond_destroy(&sys->changed);
+    pthread_mutex_destroy(&sys->lock);
+    free(sys);
+    return 0;
+}
@@ -3,13 +3,12 @@
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
+#include <errno.h>
 
-/* Dot product of two float arrays. */
+/* Dot product of two float arrays (parallel above cyon_par_threshold()). */
 double cyon_dot(const double *a, const double *b, size_t n) {
     if (!a || !b) return 0.0;
-    double sum = 0.0;
-    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
-    return sum;
+    return cyon_par_dot_f64(a, b, n);
 }
 
 /* Softmax in-place. Numerically stable implementation.
@@ -79,12 +78,78 @@ int cyon_perceptron_train_step(double *w, size_t dim, const double *x, double y_
 /* Simple mean squared error loss for regression. */
 double cyon_mse_loss(const double *pred, const double *target, size_t n) {
     if (!pred || !target) return 0.0;
-    double s = 0.0;
-    for (size_t i = 0; i < n; ++i) {
-        double d = pred[i] - target[i];
-        s += d * d;
+    return cyon_par_sqdiff_f64(pred, target, n) / (double)n;
+}
+
+/* Normal equations: A = X^T X (m x m) and b = X^T y, accumulated in parallel.
+   Few features: reduce over samples with one private A/b per chunk.
+   Many features: one task per row j of A, no private copies. */
+typedef struct {
+    const double *X;
+    const double *y;
+    size_t n;
+    size_t m;
+    double *A;
+    double *b;
+} cyon_normal_eq_t;
+
+static void cyon_normal_eq_samples(size_t begin, size_t end, void *partial, void *arg) {
+    const cyon_normal_eq_t *ne = (const cyon_normal_eq_t*)arg;
+    size_t m = ne->m;
+    double *A = (double*)partial;
+    double *b = A + m * m;
+    for (size_t i = begin; i < end; ++i) {
+        const double *row = ne->X + i * m;
+        for (size_t j = 0; j < m; ++j) {
+            for (size_t k = 0; k < m; ++k) A[j * m + k] += row[j] * row[k];
+            b[j] += row[j] * ne->y[i];
+        }
     }
-    return s / (double)n;
+}
+
+static void cyon_normal_eq_add(void *acc, const void *partial, void *arg) {
+    const cyon_normal_eq_t *ne = (const cyon_normal_eq_t*)arg;
+    size_t len = ne->m * ne->m + ne->m;
+    double *d = (double*)acc;
+    const double *s = (const double*)partial;
+    for (size_t i = 0; i < len; ++i) d[i] += s[i];
+}
+
+static void cyon_normal_eq_rows(size_t begin, size_t end, void *arg) {
+    const cyon_normal_eq_t *ne = (const cyon_normal_eq_t*)arg;
+    size_t m = ne->m;
+    for (size_t j = begin; j < end; ++j) {
+        double *Aj = ne->A + j * m;
+        double bj = 0.0;
+        for (size_t i = 0; i < ne->n; ++i) {
+            const double *row = ne->X + i * m;
+            double xj = row[j];
+            for (size_t k = 0; k < m; ++k) Aj[k] += xj * row[k];
+            bj += xj * ne->y[i];
+        }
+        ne->b[j] = bj;
+    }
+}
+
+static int cyon_normal_equations(const double *X, const double *y, size_t n, size_t m, double *A, double *bvec) {
+    cyon_normal_eq_t ne = { X, y, n, m, A, bvec };
+    size_t cost = m * m + m;   /* flops per sample */
+    if (m >= 32) {
+        size_t grain = cyon_par_threshold() / (n * m + 1);
+        return cyon_par_for(m, grain ? grain : 1, cyon_normal_eq_rows, &ne);
+    }
+    size_t len = m * m + m;
+    double *acc = (double*)calloc(2 * len, sizeof(double));
+    if (!acc) return ENOMEM;
+    size_t grain = cyon_par_threshold() / cost;
+    int rc = cyon_par_reduce(n, grain ? grain : 1, acc, len * sizeof(double), acc + len,
+                             cyon_normal_eq_samples, cyon_normal_eq_add, &ne);
+    if (rc == 0) {
+        memcpy(A, acc, m * m * sizeof(double));
+        memcpy(bvec, acc + m * m, m * sizeof(double));
+    }
+    free(acc);
+    return rc;
 }
 
 /* Tiny linear regression trainer with normal equations (X^T X)^{-1} X^T y
@@ -99,15 +164,8 @@ int cyon_linear_regression_train(const double *X, const double *y, size_t n_samp
     double *bvec = (double*)calloc(m, sizeof(double));
     if (!A || !bvec) { free(A); free(bvec); return ENOMEM; }
 
-    for (size_t i = 0; i < n_samples; ++i) {
-        const double *row = X + i * n_features;
-        for (size_t j = 0; j < n_features; ++j) {
-            for (size_t k = 0; k < n_features; ++k) {
-                A[j * m + k] += row[j] * row[k];
-            }
-            bvec[j] += row[j] * y[i];
-        }
-    }
+    int prc = cyon_normal_equations(X, y, n_samples, m, A, bvec);
+    if (prc != 0) { free(A); free(bvec); return prc; }
 
     /* Solve linear system A * w = bvec using Gaussian elimination. */
     for (size_t i = 0; i < m; ++i) {
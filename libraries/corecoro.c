@@ -0,0 +1,687 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyoncoro.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#if !defined(__x86_64__) || defined(CYON_CORO_UCONTEXT)
+#define CYON_CORO_USE_UCONTEXT 1
+#include <ucontext.h>
+#endif
+
+/* ---- context switch ---- */
+
+#ifdef CYON_CORO_USE_UCONTEXT
+typedef struct { ucontext_t uc; } cyon_coro_ctx_t;
+
+static void cyon_coro_switch(cyon_coro_ctx_t *from, cyon_coro_ctx_t *to) {
+    swapcontext(&from->uc, &to->uc);
+}
+#else
+/* Saved state is just the stack pointer; callee-saved registers, MXCSR and
+   the x87 control word are pushed on the suspended stack. */
+typedef struct { void *sp; } cyon_coro_ctx_t;
+
+void cyon_coro_switch(cyon_coro_ctx_t *from, cyon_coro_ctx_t *to);
+void cyon_coro_entry_asm(void);
+
+__asm__(
+    ".text\n"
+    ".globl cyon_coro_switch\n"
+    ".type cyon_coro_switch,@function\n"
+    "cyon_coro_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq (%rsi), %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size cyon_coro_switch,.-cyon_coro_switch\n"
+    ".globl cyon_coro_entry_asm\n"
+    ".type cyon_coro_entry_asm,@function\n"
+    "cyon_coro_entry_asm:\n"
+    "    movq %r12, %rdi\n"
+    "    call cyon_coro_main\n"
+    "    ud2\n"
+    ".size cyon_coro_entry_asm,.-cyon_coro_entry_asm\n"
+);
+#endif
+
+/* ---- coroutine and scheduler state ---- */
+
+enum {
+    CYON_CORO_ACT_NONE = 0,
+    CYON_CORO_ACT_YIELD,
+    CYON_CORO_ACT_SLEEP,
+    CYON_CORO_ACT_WAIT_FD,
+    CYON_CORO_ACT_DONE
+};
+
+typedef struct cyon_coro_s cyon_coro_t;
+
+/* The header lives at the top of the coroutine's own stack mapping. */
+struct cyon_coro_s {
+    cyon_coro_ctx_t ctx;
+    cyon_coro_sched_t *sched;
+    void (*fn)(void*);
+    void *arg;
+    void *map_base;
+    size_t map_size;
+    cyon_coro_t *next;       /* run queue / stack cache link */
+    int action;
+    int fd;
+    int events;
+    int revents;
+    int result;
+    int fd_registered;
+    long long deadline;      /* monotonic ns, -1 = none */
+    size_t heap_index;       /* position in timer heap, SIZE_MAX when absent */
+};
+
+typedef struct {
+    cyon_coro_sched_t *sched;
+    cyon_coro_ctx_t ctx;
+    cyon_coro_t *current;
+    pthread_t thread;
+} cyon_coro_worker_t;
+
+struct cyon_coro_sched_s {
+    cyon_coro_config_t cfg;
+    size_t page;
+
+    /* run queue */
+    pthread_mutex_t rq_lock;
+    pthread_cond_t rq_cv;
+    cyon_coro_t *rq_head;
+    cyon_coro_t *rq_tail;
+
+    /* lifetime */
+    atomic_size_t alive;
+    pthread_mutex_t done_lock;
+    pthread_cond_t done_cv;
+    atomic_int stopping;
+
+    /* stacks */
+    pthread_mutex_t stack_lock;
+    cyon_coro_t *stack_free;
+    size_t stack_free_count;
+
+    /* poller: epoll for fds, binary min-heap for deadlines */
+    pthread_mutex_t poll_lock;
+    pthread_mutex_t timer_lock;
+    int epfd;
+    int wakefd;
+    atomic_int poller_blocked;
+    cyon_coro_t **heap;
+    size_t heap_len;
+    size_t heap_cap;
+
+    size_t nworkers;
+    cyon_coro_worker_t *workers;
+};
+
+static __thread cyon_coro_worker_t *t_coro_worker = NULL;
+
+/* Never let the compiler cache the TLS slot across a context switch:
+   a coroutine may resume on a different thread. */
+__attribute__((noinline)) static cyon_coro_worker_t *cyon_coro_worker_self(void) {
+    __asm__ volatile("" ::: "memory");
+    return t_coro_worker;
+}
+
+static long long cyon_coro_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void cyon_coro_wake_poller(cyon_coro_sched_t *s) {
+    if (atomic_load_explicit(&s->poller_blocked, memory_order_acquire)) {
+        uint64_t one = 1;
+        ssize_t r = write(s->wakefd, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+static void cyon_coro_make_ready(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    c->next = NULL;
+    pthread_mutex_lock(&s->rq_lock);
+    if (s->rq_tail) s->rq_tail->next = c;
+    else s->rq_head = c;
+    s->rq_tail = c;
+    pthread_cond_signal(&s->rq_cv);
+    pthread_mutex_unlock(&s->rq_lock);
+    cyon_coro_wake_poller(s);
+}
+
+static cyon_coro_t *cyon_coro_pop_ready(cyon_coro_sched_t *s) {
+    pthread_mutex_lock(&s->rq_lock);
+    cyon_coro_t *c = s->rq_head;
+    if (c) {
+        s->rq_head = c->next;
+        if (!s->rq_head) s->rq_tail = NULL;
+        c->next = NULL;
+    }
+    pthread_mutex_unlock(&s->rq_lock);
+    return c;
+}
+
+/* ---- timer heap (caller holds timer_lock) ---- */
+
+static void cyon_coro_heap_swap(cyon_coro_sched_t *s, size_t a, size_t b) {
+    cyon_coro_t *t = s->heap[a];
+    s->heap[a] = s->heap[b];
+    s->heap[b] = t;
+    s->heap[a]->heap_index = a;
+    s->heap[b]->heap_index = b;
+}
+
+static void cyon_coro_heap_up(cyon_coro_sched_t *s, size_t i) {
+    while (i > 0) {
+        size_t p = (i - 1) / 2;
+        if (s->heap[p]->deadline <= s->heap[i]->deadline) break;
+        cyon_coro_heap_swap(s, p, i);
+        i = p;
+    }
+}
+
+static void cyon_coro_heap_down(cyon_coro_sched_t *s, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < s->heap_len && s->heap[l]->deadline < s->heap[m]->deadline) m = l;
+        if (r < s->heap_len && s->heap[r]->deadline < s->heap[m]->deadline) m = r;
+        if (m == i) break;
+        cyon_coro_heap_swap(s, i, m);
+        i = m;
+    }
+}
+
+static int cyon_coro_heap_push(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    if (s->heap_len == s->heap_cap) {
+        size_t ncap = s->heap_cap ? s->heap_cap * 2 : 256;
+        cyon_coro_t **nh = (cyon_coro_t**)realloc(s->heap, ncap * sizeof(cyon_coro_t*));
+        if (!nh) return ENOMEM;
+        s->heap = nh;
+        s->heap_cap = ncap;
+    }
+    c->heap_index = s->heap_len;
+    s->heap[s->heap_len++] = c;
+    cyon_coro_heap_up(s, c->heap_index);
+    return 0;
+}
+
+static void cyon_coro_heap_remove(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    size_t i = c->heap_index;
+    if (i == SIZE_MAX || i >= s->heap_len) return;
+    s->heap_len--;
+    if (i != s->heap_len) {
+        s->heap[i] = s->heap[s->heap_len];
+        s->heap[i]->heap_index = i;
+        cyon_coro_heap_down(s, i);
+        cyon_coro_heap_up(s, i);
+    }
+    c->heap_index = SIZE_MAX;
+}
+
+/* ---- stacks ---- */
+
+static cyon_coro_t *cyon_coro_alloc(cyon_coro_sched_t *s) {
+    pthread_mutex_lock(&s->stack_lock);
+    cyon_coro_t *c = s->stack_free;
+    if (c) {
+        s->stack_free = c->next;
+        s->stack_free_count--;
+    }
+    pthread_mutex_unlock(&s->stack_lock);
+    if (c) return c;
+
+    size_t guard = s->cfg.guard_pages ? s->page : 0;
+    size_t total = s->cfg.stack_size + guard;
+    void *base = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    if (guard && mprotect(base, guard, PROT_NONE) != 0) {
+        munmap(base, total);
+        return NULL;
+    }
+    uintptr_t top = (uintptr_t)base + total;
+    c = (cyon_coro_t*)((top - sizeof(cyon_coro_t)) & ~(uintptr_t)63);
+    memset(c, 0, sizeof(*c));
+    c->map_base = base;
+    c->map_size = total;
+    return c;
+}
+
+static void cyon_coro_free(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    pthread_mutex_lock(&s->stack_lock);
+    if (s->stack_free_count < s->cfg.stack_cache) {
+        c->next = s->stack_free;
+        s->stack_free = c;
+        s->stack_free_count++;
+        pthread_mutex_unlock(&s->stack_lock);
+        return;
+    }
+    pthread_mutex_unlock(&s->stack_lock);
+    munmap(c->map_base, c->map_size);
+}
+
+void cyon_coro_main(cyon_coro_t *c);
+
+void cyon_coro_main(cyon_coro_t *c) {
+    c->fn(c->arg);
+    c->action = CYON_CORO_ACT_DONE;
+    cyon_coro_worker_t *w = cyon_coro_worker_self();
+    cyon_coro_switch(&c->ctx, &w->ctx);
+    abort(); /* a finished coroutine is never resumed */
+}
+
+#ifdef CYON_CORO_USE_UCONTEXT
+static void cyon_coro_uc_entry(void) {
+    cyon_coro_main(cyon_coro_worker_self()->current);
+}
+#endif
+
+
+/* Lay out a fresh stack so the first switch into it lands in cyon_coro_main. */
+static void cyon_coro_prepare(cyon_coro_sched_t *s, cyon_coro_t *c) {
+#ifdef CYON_CORO_USE_UCONTEXT
+    size_t guard = s->cfg.guard_pages ? s->page : 0;
+    getcontext(&c->ctx.uc);
+    c->ctx.uc.uc_stack.ss_sp = (char*)c->map_base + guard;
+    c->ctx.uc.uc_stack.ss_size = (size_t)((char*)c - ((char*)c->map_base + guard)) & ~(size_t)15;
+    c->ctx.uc.uc_link = NULL;
+    makecontext(&c->ctx.uc, cyon_coro_uc_entry, 0);
+#else
+    (void)s;
+    uintptr_t top = (uintptr_t)c & ~(uintptr_t)15;
+    uint64_t *sp = (uint64_t*)(top - 64);
+    uint32_t *fp = (uint32_t*)sp;
+    fp[0] = 0x1F80;               /* default MXCSR */
+    fp[1] = 0x037F;               /* default x87 control word */
+    sp[1] = 0;                    /* r15 */
+    sp[2] = 0;                    /* r14 */
+    sp[3] = 0;                    /* r13 */
+    sp[4] = (uint64_t)(uintptr_t)c; /* r12 -> first argument of cyon_coro_main */
+    sp[5] = 0;                    /* rbx */
+    sp[6] = 0;                    /* rbp */
+    sp[7] = (uint64_t)(uintptr_t)cyon_coro_entry_asm;
+    c->ctx.sp = sp;
+#endif
+}
+
+static void cyon_coro_finish(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    cyon_coro_free(s, c);
+    if (atomic_fetch_sub_explicit(&s->alive, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&s->done_lock);
+        pthread_cond_broadcast(&s->done_cv);
+        pthread_mutex_unlock(&s->done_lock);
+        /* idle workers may be waiting for the shutdown signal */
+        pthread_mutex_lock(&s->rq_lock);
+        pthread_cond_broadcast(&s->rq_cv);
+        pthread_mutex_unlock(&s->rq_lock);
+        cyon_coro_wake_poller(s);
+    }
+}
+
+/* Register a parked coroutine with the poller. Runs on the worker stack after
+   the coroutine has switched out, so a wakeup can never resume it early. */
+static void cyon_coro_park(cyon_coro_sched_t *s, cyon_coro_t *c) {
+    pthread_mutex_lock(&s->timer_lock);
+    int err = 0;
+    int earliest = 0;
+    if (c->deadline >= 0) {
+        err = cyon_coro_heap_push(s, c);
+        earliest = (err == 0 && c->heap_index == 0);
+    }
+    if (err == 0 && c->action == CYON_CORO_ACT_WAIT_FD) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLONESHOT | EPOLLERR | EPOLLHUP;
+        if (c->events & CYON_CORO_READ) ev.events |= EPOLLIN | EPOLLRDHUP;
+        if (c->events & CYON_CORO_WRITE) ev.events |= EPOLLOUT;
+        ev.data.ptr = c;
+        if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, c->fd, &ev) != 0) {
+            err = errno;
+            cyon_coro_heap_remove(s, c);
+        } else {
+            c->fd_registered = 1;
+        }
+    }
+    pthread_mutex_unlock(&s->timer_lock);
+    if (err) {
+        c->result = err;
+        cyon_coro_make_ready(s, c);
+    } else if (earliest) {
+        cyon_coro_wake_poller(s);
+    }
+}
+
+static void cyon_coro_run(cyon_coro_worker_t *w, cyon_coro_t *c) {
+    cyon_coro_sched_t *s = w->sched;
+    c->action = CYON_CORO_ACT_NONE;
+    w->current = c;
+    cyon_coro_switch(&w->ctx, &c->ctx);
+    w->current = NULL;
+    switch (c->action) {
+        case CYON_CORO_ACT_YIELD:
+            cyon_coro_make_ready(s, c);
+            break;
+        case CYON_CORO_ACT_SLEEP:
+        case CYON_CORO_ACT_WAIT_FD:
+            cyon_coro_park(s, c);
+            break;
+        case CYON_CORO_ACT_DONE:
+            cyon_coro_finish(s, c);
+            break;
+        default:
+            break;
+    }
+}
+
+/* One round of epoll + timer expiry. Only the holder of poll_lock calls this,
+   and every wakeup happens under timer_lock, so each parked coroutine is
+   woken exactly once and its other registration is torn down first. */
+static void cyon_coro_poll(cyon_coro_sched_t *s, int block) {
+    struct epoll_event evs[64];
+    int timeout = 0;
+    if (block) {
+        /* publish the flag before looking at the timers and the run queue:
+           a park or producer that misses it has already pushed a deadline
+           or queued work that the checks below see */
+        atomic_store_explicit(&s->poller_blocked, 1, memory_order_seq_cst);
+        pthread_mutex_lock(&s->timer_lock);
+        if (s->heap_len == 0) {
+            timeout = -1;
+        } else {
+            long long wait = s->heap[0]->deadline - cyon_coro_now_ns();
+            timeout = wait <= 0 ? 0 : (int)((wait + 999999) / 1000000);
+        }
+        pthread_mutex_unlock(&s->timer_lock);
+        pthread_mutex_lock(&s->rq_lock);
+        if (s->rq_head || atomic_load(&s->stopping)) timeout = 0;
+        pthread_mutex_unlock(&s->rq_lock);
+    }
+    int n = epoll_wait(s->epfd, evs, 64, timeout);
+    atomic_store_explicit(&s->poller_blocked, 0, memory_order_release);
+
+    pthread_mutex_lock(&s->timer_lock);
+    for (int i = 0; i < n; i++) {
+        cyon_coro_t *c = (cyon_coro_t*)evs[i].data.ptr;
+        if (!c) {
+            uint64_t v;
+            ssize_t r = read(s->wakefd, &v, sizeof(v));
+            (void)r;
+            continue;
+        }
+        if (!c->fd_registered) continue;
+        epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+        c->fd_registered = 0;
+        cyon_coro_heap_remove(s, c);
+        int re = 0;
+        if (evs[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) re |= CYON_CORO_READ;
+        if (evs[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) re |= CYON_CORO_WRITE;
+        c->revents = re & (c->events | CYON_CORO_READ | CYON_CORO_WRITE);
+        c->result = 0;
+        cyon_coro_make_ready(s, c);
+    }
+    long long now = cyon_coro_now_ns();
+    while (s->heap_len > 0 && s->heap[0]->deadline <= now) {
+        cyon_coro_t *c = s->heap[0];
+        cyon_coro_heap_remove(s, c);
+        if (c->fd_registered) {
+            epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+            c->fd_registered = 0;
+            c->revents = 0;
+            c->result = ETIMEDOUT;
+        } else {
+            c->result = 0;
+        }
+        cyon_coro_make_ready(s, c);
+    }
+    pthread_mutex_unlock(&s->timer_lock);
+}
+
+static void *cyon_coro_worker_main(void *arg) {
+    cyon_coro_worker_t *w = (cyon_coro_worker_t*)arg;
+    cyon_coro_sched_t *s = w->sched;
+    t_coro_worker = w;
+    for (;;) {
+        cyon_coro_t *c = cyon_coro_pop_ready(s);
+        if (c) {
+            cyon_coro_run(w, c);
+            continue;
+        }
+        if (atomic_load(&s->stopping) && atomic_load(&s->alive) == 0) break;
+        if (pthread_mutex_trylock(&s->poll_lock) == 0) {
+            cyon_coro_poll(s, !atomic_load(&s->stopping));
+            pthread_mutex_unlock(&s->poll_lock);
+            continue;
+        }
+        /* someone else is polling: sleep until work arrives, and retry the
+           poller role periodically in case the poller is busy running work */
+        pthread_mutex_lock(&s->rq_lock);
+        if (!s->rq_head && !atomic_load(&s->stopping)) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 10 * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+            pthread_cond_timedwait(&s->rq_cv, &s->rq_lock, &ts);
+        }
+        pthread_mutex_unlock(&s->rq_lock);
+    }
+    t_coro_worker = NULL;
+    return NULL;
+}
+
+/* ---- public API ---- */
+
+void cyon_coro_default_config(cyon_coro_config_t *cfg) {
+    if (!cfg) return;
+    cfg->stack_size = CYON_CORO_DEFAULT_STACK;
+    cfg->nworkers = 0;
+    cfg->guard_pages = 1;
+    cfg->stack_cache = 1024;
+}
+
+int cyon_coro_sched_create(cyon_coro_sched_t **out, const cyon_coro_config_t *cfg) {
+    if (!out) return EINVAL;
+    *out = NULL;
+    cyon_coro_sched_t *s = (cyon_coro_sched_t*)calloc(1, sizeof(cyon_coro_sched_t));
+    if (!s) return ENOMEM;
+    if (cfg) s->cfg = *cfg;
+    else cyon_coro_default_config(&s->cfg);
+
+    long pg = sysconf(_SC_PAGESIZE);
+    s->page = pg > 0 ? (size_t)pg : 4096;
+    if (s->cfg.stack_size == 0) s->cfg.stack_size = CYON_CORO_DEFAULT_STACK;
+    if (s->cfg.stack_size < 4 * s->page) s->cfg.stack_size = 4 * s->page;
+    s->cfg.stack_size = (s->cfg.stack_size + s->page - 1) & ~(s->page - 1);
+    if (s->cfg.nworkers == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        s->cfg.nworkers = n > 0 ? (size_t)n : 1;
+    }
+
+    pthread_mutex_init(&s->rq_lock, NULL);
+    pthread_cond_init(&s->rq_cv, NULL);
+    pthread_mutex_init(&s->done_lock, NULL);
+    pthread_cond_init(&s->done_cv, NULL);
+    pthread_mutex_init(&s->stack_lock, NULL);
+    pthread_mutex_init(&s->poll_lock, NULL);
+    pthread_mutex_init(&s->timer_lock, NULL);
+    atomic_init(&s->alive, 0);
+    atomic_init(&s->stopping, 0);
+    atomic_init(&s->poller_blocked, 0);
+
+    s->epfd = epoll_create1(EPOLL_CLOEXEC);
+    s->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s->epfd < 0 || s->wakefd < 0) {
+        int err = errno;
+        if (s->epfd >= 0) close(s->epfd);
+        if (s->wakefd >= 0) close(s->wakefd);
+        free(s);
+        return err;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->wakefd, &ev);
+
+    s->workers = (cyon_coro_worker_t*)calloc(s->cfg.nworkers, sizeof(cyon_coro_worker_t));
+    if (!s->workers) {
+        close(s->epfd);
+        close(s->wakefd);
+        free(s);
+        return ENOMEM;
+    }
+    for (size_t i = 0; i < s->cfg.nworkers; i++) {
+        s->workers[i].sched = s;
+        int r = pthread_create(&s->workers[i].thread, NULL, cyon_coro_worker_main, &s->workers[i]);
+        if (r != 0) {
+            s->nworkers = i;
+            cyon_coro_sched_destroy(s);
+            return r;
+        }
+        s->nworkers = i + 1;
+    }
+    *out = s;
+    return 0;
+}
+
+int cyon_coro_spawn(cyon_coro_sched_t *s, void (*fn)(void*), void *arg) {
+    if (!s || !fn) return EINVAL;
+    if (atomic_load(&s->stopping)) return EPIPE;
+    cyon_coro_t *c = cyon_coro_alloc(s);
+    if (!c) return ENOMEM;
+    c->sched = s;
+    c->fn = fn;
+    c->arg = arg;
+    c->deadline = -1;
+    c->heap_index = SIZE_MAX;
+    c->fd_registered = 0;
+    cyon_coro_prepare(s, c);
+    atomic_fetch_add_explicit(&s->alive, 1, memory_order_relaxed);
+    cyon_coro_make_ready(s, c);
+    return 0;
+}
+
+size_t cyon_coro_sched_alive(cyon_coro_sched_t *s) {
+    return s ? atomic_load(&s->alive) : 0;
+}
+
+int cyon_coro_sched_wait(cyon_coro_sched_t *s) {
+    if (!s) return EINVAL;
+    if (cyon_coro_worker_self()) return EDEADLK;
+    pthread_mutex_lock(&s->done_lock);
+    while (atomic_load(&s->alive) != 0)
+        pthread_cond_wait(&s->done_cv, &s->done_lock);
+    pthread_mutex_unlock(&s->done_lock);
+    return 0;
+}
+
+int cyon_coro_sched_destroy(cyon_coro_sched_t *s) {
+    if (!s) return EINVAL;
+    if (cyon_coro_worker_self()) return EDEADLK;
+    cyon_coro_sched_wait(s);
+    atomic_store(&s->stopping, 1);
+    pthread_mutex_lock(&s->rq_lock);
+    pthread_cond_broadcast(&s->rq_cv);
+    pthread_mutex_unlock(&s->rq_lock);
+    uint64_t one = 1;
+    ssize_t r = write(s->wakefd, &one, sizeof(one));
+    (void)r;
+    for (size_t i = 0; i < s->nworkers; i++)
+        pthread_join(s->workers[i].thread, NULL);
+
+    cyon_coro_t *c = s->stack_free;
+    while (c) {
+        cyon_coro_t *next = c->next;
+        munmap(c->map_base, c->map_size);
+        c = next;
+    }
+    close(s->epfd);
+    close(s->wakefd);
+    free(s->heap);
+    free(s->workers);
+    pthread_mutex_destroy(&s->rq_lock);
+    pthread_cond_destroy(&s->rq_cv);
+    pthread_mutex_destroy(&s->done_lock);
+    pthread_cond_destroy(&s->done_cv);
+    pthread_mutex_destroy(&s->stack_lock);
+    pthread_mutex_destroy(&s->poll_lock);
+    pthread_mutex_destroy(&s->timer_lock);
+    free(s);
+    return 0;
+}
+
+int cyon_coro_in_coroutine(void) {
+    cyon_coro_worker_t *w = cyon_coro_worker_self();
+    return w && w->current;
+}
+
+/* Switch back to the worker with a pending action; returns once resumed,
+   possibly on another worker thread. */
+static int cyon_coro_suspend(int action) {
+    cyon_coro_worker_t *w = cyon_coro_worker_self();
+    if (!w || !w->current) return EPERM;
+    cyon_coro_t *c = w->current;
+    c->action = action;
+    if (action == CYON_CORO_ACT_YIELD) c->result = 0;
+    cyon_coro_switch(&c->ctx, &w->ctx);
+    return c->result;
+}
+
+int cyon_coro_yield(void) {
+    return cyon_coro_suspend(CYON_CORO_ACT_YIELD);
+}
+
+int cyon_coro_sleep_ms(unsigned int ms) {
+    cyon_coro_worker_t *w = cyon_coro_worker_self();
+    if (!w || !w->current) return EPERM;
+    cyon_coro_t *c = w->current;
+    c->deadline = cyon_coro_now_ns() + (long long)ms * 1000000LL;
+    c->result = 0;
+    int r = cyon_coro_suspend(CYON_CORO_ACT_SLEEP);
+    c->deadline = -1;
+    return r;
+}
+
+int cyon_coro_wait_fd(int fd, int events, int timeout_ms, int *revents) {
+    if (fd < 0 || !(events & (CYON_CORO_READ | CYON_CORO_WRITE))) return EINVAL;
+    cyon_coro_worker_t *w = cyon_coro_worker_self();
+    if (!w || !w->current) return EPERM;
+    cyon_coro_t *c = w->current;
+    c->fd = fd;
+    c->events = events;
+    c->revents = 0;
+    c->result = 0;
+    c->deadline = timeout_ms < 0 ? -1 : cyon_coro_now_ns() + (long long)timeout_ms * 1000000LL;
+    int r = cyon_coro_suspend(CYON_CORO_ACT_WAIT_FD);
+    c->deadline = -1;
+    if (revents) *revents = c->revents;
+    return r;
+}
@@ -1,11 +1,16 @@
+#define _GNU_SOURCE
 #include "cyonstd.h"
+#include "cyonuring.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <linux/io_uring.h>
 
 /* Append data to a file, creating it if necessary. Returns 0 on success. */
 int cyon_appendfile(const char *path, const unsigned char *buf, size_t size) {
@@ -123,4 +128,257 @@ int cyon_file_exists(const char *path) {
         return -1;
     }
     return 1;
-}
\ No newline at end of file
+}
+
+#define CYON_LINES_BLOCK (1u << 20)      /* read size when the file cannot be mapped */
+#define CYON_LINES_PAR_GRAIN (1u << 20)  /* bytes per parallel part, at least */
+
+/* Hand every line in [p, end) to cb; the last one may lack a newline. */
+static int cyon_lines_emit(const char *p, const char *end, int (*cb)(cyon_slice_t, void*), void *userdata) {
+    while (p < end) {
+        const char *nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char *e = nl ? nl : end;
+        cyon_slice_t line = { p, (size_t)(e - p) };
+        if (line.len && e[-1] == '\r') line.len--;
+        int rc = cb(line, userdata);
+        if (rc != 0) return rc;
+        p = nl ? nl + 1 : end;
+    }
+    return 0;
+}
+
+/* Fallback for pipes and files that cannot be mapped: read big blocks and
+   carry the unfinished last line over to the next one. */
+static int cyon_lines_blocks(const char *path, int (*cb)(cyon_slice_t, void*), void *userdata) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno ? errno : -1;
+    size_t cap = CYON_LINES_BLOCK, have = 0;
+    char *buf = (char*)malloc(cap);
+    if (!buf) {
+        close(fd);
+        return ENOMEM;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    int rc = 0;
+    for (;;) {
+        if (have == cap) {
+            /* a single line longer than the buffer */
+            char *nb = (char*)realloc(buf, cap * 2);
+            if (!nb) { rc = ENOMEM; break; }
+            buf = nb;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, buf + have, cap - have);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            rc = errno;
+            break;
+        }
+        if (r == 0) {
+            if (have) rc = cyon_lines_emit(buf, buf + have, cb, userdata);
+            break;
+        }
+        const char *scan = buf + have;
+        have += (size_t)r;
+        const char *last = (const char*)memrchr(scan, '\n', (size_t)r);
+        if (!last) continue;
+        size_t done = (size_t)(last - buf) + 1;
+        rc = cyon_lines_emit(buf, buf + done, cb, userdata);
+        if (rc != 0) break;
+        memmove(buf, buf + done, have - done);
+        have -= done;
+    }
+    free(buf);
+    close(fd);
+    return rc;
+}
+
+/* Map regular files only: opening a FIFO just to find it cannot be mapped
+   would consume its writer. */
+static int cyon_lines_map(const char *path, cyon_mmap_t **m) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return EINVAL;
+    int rc = cyon_mmap_open(m, path, CYON_MMAP_READ, 0);
+    if (rc == 0) cyon_mmap_advise(*m, 0, 0, CYON_MMAP_SEQUENTIAL);
+    return rc;
+}
+
+int cyon_scanlines(const char *path, int (*cb)(cyon_slice_t line, void *userdata), void *userdata) {
+    if (!path || !cb) return EINVAL;
+    cyon_mmap_t *m;
+    if (cyon_lines_map(path, &m) != 0) return cyon_lines_blocks(path, cb, userdata);
+    const char *data = (const char*)cyon_mmap_data(m);
+    int rc = cyon_lines_emit(data, data + cyon_mmap_size(m), cb, userdata);
+    cyon_mmap_close(m);
+    return rc;
+}
+
+typedef struct {
+    const char *data;
+    size_t size;
+    int (*line)(cyon_slice_t, void*, void*);
+    void *ctx;
+    int stop;               /* first non-zero line() result */
+} cyon_lines_par_t;
+
+typedef struct {
+    cyon_lines_par_t *s;
+    void *partial;
+} cyon_lines_part_t;
+
+static int cyon_lines_par_cb(cyon_slice_t line, void *arg) {
+    cyon_lines_part_t *pt = (cyon_lines_part_t*)arg;
+    if (__atomic_load_n(&pt->s->stop, __ATOMIC_RELAXED)) return -1;
+    int rc = pt->s->line(line, pt->partial, pt->s->ctx);
+    if (rc != 0) {
+        int zero = 0;
+        __atomic_compare_exchange_n(&pt->s->stop, &zero, rc, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    return rc;
+}
+
+/* A part owns the lines that start inside [begin, end); the last one may
+   run past end. */
+static void cyon_lines_par_chunk(size_t begin, size_t end, void *partial, void *arg) {
+    cyon_lines_par_t *s = (cyon_lines_par_t*)arg;
+    const char *p = s->data + begin;
+    if (begin > 0 && p[-1] != '\n') {
+        const char *nl = (const char*)memchr(p, '\n', end - begin);
+        if (!nl) return;
+        p = nl + 1;
+    }
+    const char *stop = s->data + end;
+    if (p >= stop) return;
+    /* extend to the end of the line straddling the boundary */
+    const char *nl = end < s->size ? (const char*)memchr(stop - 1, '\n', s->size - end + 1) : NULL;
+    const char *limit = nl ? nl + 1 : s->data + s->size;
+    cyon_lines_part_t pt = { s, partial };
+    cyon_lines_emit(p, limit, cyon_lines_par_cb, &pt);
+}
+
+static int cyon_lines_seq_cb(cyon_slice_t line, void *arg) {
+    cyon_lines_part_t *pt = (cyon_lines_part_t*)arg;
+    return pt->s->line(line, pt->partial, pt->s->ctx);
+}
+
+int cyon_scanlines_par(const char *path, void *result, size_t result_size, const void *identity,
+                       int (*line)(cyon_slice_t line, void *partial, void *ctx),
+                       void (*combine)(void *acc, const void *partial, void *ctx), void *ctx) {
+    if (!path || !result || !identity || result_size == 0 || !line || !combine) return EINVAL;
+    cyon_lines_par_t s = { NULL, 0, line, ctx, 0 };
+    cyon_mmap_t *m;
+    if (cyon_lines_map(path, &m) != 0) {
+        /* not mappable: one sequential part straight into result */
+        memcpy(result, identity, result_size);
+        cyon_lines_part_t pt = { &s, result };
+        return cyon_lines_blocks(path, cyon_lines_seq_cb, &pt);
+    }
+    if (cyon_mmap_size(m) > (uint64_t)SIZE_MAX) {
+        cyon_mmap_close(m);
+        return EFBIG;
+    }
+    s.data = (const char*)cyon_mmap_data(m);
+    s.size = (size_t)cyon_mmap_size(m);
+    int rc = cyon_par_reduce(s.size, CYON_LINES_PAR_GRAIN, result, result_size, identity,
+                             cyon_lines_par_chunk, combine, &s);
+    cyon_mmap_close(m);
+    return s.stop ? s.stop : rc;
+}
+
+#define CYON_FILE_RING_ENTRIES 64
+
+static pthread_key_t cyon_file_ring_key;
+static pthread_once_t cyon_file_ring_once = PTHREAD_ONCE_INIT;
+
+static void cyon_file_ring_free(void *p) {
+    cyon_uring_destroy((cyon_uring_t*)p);
+}
+
+static void cyon_file_ring_init(void) {
+    pthread_key_create(&cyon_file_ring_key, cyon_file_ring_free);
+}
+
+/* One ring per thread, created on first use. */
+static cyon_uring_t *cyon_file_ring(void) {
+    if (!cyon_uring_available()) return NULL;
+    pthread_once(&cyon_file_ring_once, cyon_file_ring_init);
+    cyon_uring_t *u = (cyon_uring_t*)pthread_getspecific(cyon_file_ring_key);
+    if (!u && cyon_uring_create(&u, CYON_FILE_RING_ENTRIES) == 0) pthread_setspecific(cyon_file_ring_key, u);
+    return u;
+}
+
+static void cyon_file_io_sync(cyon_file_io_t *q) {
+    ssize_t r;
+    do {
+        r = q->write ? pwrite(q->fd, q->buf, q->len, q->offset) : pread(q->fd, q->buf, q->len, q->offset);
+    } while (r < 0 && errno == EINTR);
+    q->result = r < 0 ? -errno : r;
+}
+
+/* Drop the thread's ring when a batch could not be submitted, so that its
+   queued SQEs never go out with a later one. */
+static void cyon_file_ring_drop(cyon_uring_t *u) {
+    pthread_setspecific(cyon_file_ring_key, NULL);
+    cyon_uring_destroy(u);
+}
+
+int cyon_file_io_batch(cyon_file_io_t *reqs, size_t n) {
+    if (!reqs && n > 0) return EINVAL;
+    cyon_uring_t *u = cyon_file_ring();
+    if (!u) {
+        for (size_t i = 0; i < n; i++) cyon_file_io_sync(&reqs[i]);
+        return 0;
+    }
+    for (size_t base = 0; base < n; base += CYON_FILE_RING_ENTRIES) {
+        size_t m = n - base < CYON_FILE_RING_ENTRIES ? n - base : CYON_FILE_RING_ENTRIES;
+        size_t queued = 0;
+        int err = 0;
+        for (; queued < m; queued++) {
+            cyon_file_io_t *q = &reqs[base + queued];
+            struct io_uring_sqe *sqe = cyon_uring_sqe(u);
+            if (!sqe) {
+                err = EBUSY;
+                break;
+            }
+            sqe->opcode = q->write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = q->fd;
+            sqe->addr = (uint64_t)(uintptr_t)q->buf;
+            sqe->len = (unsigned)(q->len > 0x7ffff000 ? 0x7ffff000 : q->len);
+            sqe->off = (uint64_t)q->offset;
+            sqe->user_data = base + queued;
+        }
+        /* Once the kernel has taken the batch it is in flight against the
+           caller's buffers: wait for all of it, even when queueing the rest
+           failed, and retry a failing wait rather than give up. A failed
+           first submit took nothing, so the ring can be dropped. */
+        size_t done = 0;
+        int submitted = 0;
+        while (done < queued) {
+            int rc = cyon_uring_submit(u, (unsigned)(queued - done), -1);
+            if (rc != 0 && rc != ETIME && rc != EAGAIN) {
+                if (!submitted) {
+                    cyon_file_ring_drop(u);
+                    for (size_t i = base; i < n; i++) reqs[i].result = -ECANCELED;
+                    return rc;
+                }
+                struct timespec ts = { 0, 1000000 };
+                nanosleep(&ts, NULL);
+            }
+            if (rc == 0 || rc == ETIME) submitted = 1;
+            struct io_uring_cqe *cqe;
+            while ((cqe = cyon_uring_peek(u)) != NULL) {
+                uint64_t id = cqe->user_data;
+                if (id >= base && id < base + queued) {
+                    reqs[id].result = cqe->res;
+                    done++;
+                }
+                cyon_uring_advance(u, 1);
+            }
+        }
+        if (err) {
+            for (size_t i = base + queued; i < n; i++) reqs[i].result = -ECANCELED;
+            return err;
+        }
+    }
+    return 0;
+}
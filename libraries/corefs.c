@@ -1,8 +1,13 @@
+#define _GNU_SOURCE
 #include "cyonstd.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
 
 /* Read an entire file into a malloc'd buffer.
@@ -76,4 +81,214 @@ int cyon_copyfile(const char *src, const char *dst) {
     rc = cyon_writefile(dst, buf, size);
     free(buf);
     return rc;
-}
\ No newline at end of file
+}
+
+/* ---- Memory-mapped files ---- */
+
+struct cyon_mmap_s {
+    int fd;
+    int flags;
+    int advice;             /* applied to every new window */
+    uint64_t file_size;
+    size_t window;          /* 0 = the whole file is mapped */
+    char *base;             /* current mapping, NULL when none */
+    size_t map_len;
+    uint64_t map_off;       /* file offset of base */
+};
+
+static size_t cyon_page_size(void) {
+    long pg = sysconf(_SC_PAGESIZE);
+    return pg > 0 ? (size_t)pg : 4096;
+}
+
+static int cyon_madvice(int advice) {
+    switch (advice) {
+    case CYON_MMAP_SEQUENTIAL: return MADV_SEQUENTIAL;
+    case CYON_MMAP_RANDOM: return MADV_RANDOM;
+    case CYON_MMAP_WILLNEED: return MADV_WILLNEED;
+    case CYON_MMAP_DONTNEED: return MADV_DONTNEED;
+    default: return MADV_NORMAL;
+    }
+}
+
+static int cyon_mmap_map(cyon_mmap_t *m, uint64_t off, size_t len) {
+    int prot = PROT_READ | ((m->flags & CYON_MMAP_WRITE) ? PROT_WRITE : 0);
+    int mflags = MAP_SHARED | ((m->flags & CYON_MMAP_POPULATE) ? MAP_POPULATE : 0);
+    void *p = mmap(NULL, len, prot, mflags, m->fd, (off_t)off);
+    if (p == MAP_FAILED) return errno;
+    m->base = (char*)p;
+    m->map_len = len;
+    m->map_off = off;
+    if (m->advice != CYON_MMAP_NORMAL) madvise(p, len, cyon_madvice(m->advice));
+    return 0;
+}
+
+static void cyon_mmap_unmap(cyon_mmap_t *m) {
+    if (m->base) munmap(m->base, m->map_len);
+    m->base = NULL;
+    m->map_len = 0;
+    m->map_off = 0;
+}
+
+static int cyon_mmap_open_fd(cyon_mmap_t **out, const char *path, int flags, size_t size, size_t window) {
+    if (!out || !path) return EINVAL;
+    int oflags = (flags & CYON_MMAP_WRITE) ? O_RDWR : O_RDONLY;
+    if ((flags & CYON_MMAP_WRITE) && (flags & CYON_MMAP_CREATE)) oflags |= O_CREAT;
+    int fd = open(path, oflags | O_CLOEXEC, 0644);
+    if (fd < 0) return errno;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int rc = errno;
+        close(fd);
+        return rc;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        return EINVAL;
+    }
+    /* grow a new or shorter file to size; never cut an existing one */
+    if ((oflags & O_CREAT) && (uint64_t)st.st_size < (uint64_t)size) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            int rc = errno;
+            close(fd);
+            return rc;
+        }
+        st.st_size = (off_t)size;
+    }
+    cyon_mmap_t *m = (cyon_mmap_t*)calloc(1, sizeof(cyon_mmap_t));
+    if (!m) {
+        close(fd);
+        return ENOMEM;
+    }
+    m->fd = fd;
+    m->flags = flags;
+    m->file_size = (uint64_t)st.st_size;
+    if (window) {
+        size_t pg = cyon_page_size();
+        m->window = (window + pg - 1) / pg * pg;
+    } else if (m->file_size > 0) {
+        int rc = m->file_size > (uint64_t)SIZE_MAX ? ENOMEM : cyon_mmap_map(m, 0, (size_t)m->file_size);
+        if (rc != 0) {
+            close(fd);
+            free(m);
+            return rc;
+        }
+    }
+    *out = m;
+    return 0;
+}
+
+int cyon_mmap_open(cyon_mmap_t **out, const char *path, int flags, size_t size) {
+    return cyon_mmap_open_fd(out, path, flags, size, 0);
+}
+
+int cyon_mmap_open_window(cyon_mmap_t **out, const char *path, int flags, size_t window) {
+    if (window == 0) return EINVAL;
+    return cyon_mmap_open_fd(out, path, flags, 0, window);
+}
+
+void cyon_mmap_close(cyon_mmap_t *m) {
+    if (!m) return;
+    cyon_mmap_unmap(m);
+    close(m->fd);
+    free(m);
+}
+
+void *cyon_mmap_data(const cyon_mmap_t *m) {
+    if (!m || m->window) return NULL;
+    /* an empty file still gets a valid (empty) view */
+    return m->base ? m->base : (void*)"";
+}
+
+uint64_t cyon_mmap_size(const cyon_mmap_t *m) {
+    return m ? m->file_size : 0;
+}
+
+ssize_t cyon_mmap_view(cyon_mmap_t *m, uint64_t off, size_t len, void **ptr) {
+    if (!m || !ptr) return -EINVAL;
+    if (off > m->file_size) return -EINVAL;
+    uint64_t left = m->file_size - off;
+    size_t avail = left < (uint64_t)len ? (size_t)left : len;
+    if (avail > SSIZE_MAX) avail = SSIZE_MAX;
+    if (avail == 0) {
+        /* nothing to map at end of file; still hand back a valid pointer */
+        *ptr = !m->window && m->base ? m->base + off : (void*)"";
+        return 0;
+    }
+    if (!m->window) {
+        *ptr = m->base + off;
+        return (ssize_t)avail;
+    }
+    if (!m->base || off < m->map_off || off + avail > m->map_off + m->map_len) {
+        size_t pg = cyon_page_size();
+        uint64_t start = off / pg * pg;
+        uint64_t need = off - start + avail;
+        uint64_t mlen = need > m->window ? (need + pg - 1) / pg * pg : m->window;
+        if (mlen > m->file_size - start) mlen = m->file_size - start;
+        if (mlen > (uint64_t)SIZE_MAX) return -ENOMEM;
+        cyon_mmap_unmap(m);
+        int rc = cyon_mmap_map(m, start, (size_t)mlen);
+        if (rc != 0) return -rc;
+    }
+    *ptr = m->base + (off - m->map_off);
+    return (ssize_t)avail;
+}
+
+int cyon_mmap_advise(cyon_mmap_t *m, uint64_t off, size_t len, int advice) {
+    if (!m || advice < CYON_MMAP_NORMAL || advice > CYON_MMAP_DONTNEED) return EINVAL;
+    if (len == 0) {
+        /* DONTNEED and WILLNEED are one-off actions, not a standing mode */
+        if (advice != CYON_MMAP_DONTNEED && advice != CYON_MMAP_WILLNEED) m->advice = advice;
+        off = m->map_off;
+        len = m->map_len;
+    }
+    if (!m->base) return 0;
+    /* clip to the current mapping, page-aligned */
+    uint64_t end = off + len;
+    if (off < m->map_off) off = m->map_off;
+    if (end > m->map_off + m->map_len) end = m->map_off + m->map_len;
+    if (off >= end) return 0;
+    size_t pg = cyon_page_size();
+    size_t rel = (size_t)(off - m->map_off) / pg * pg;
+    if (madvise(m->base + rel, (size_t)(end - m->map_off) - rel, cyon_madvice(advice)) != 0) return errno;
+    return 0;
+}
+
+int cyon_mmap_sync(cyon_mmap_t *m, int wait) {
+    if (!m) return EINVAL;
+    if (!m->base || !(m->flags & CYON_MMAP_WRITE)) return 0;
+    if (msync(m->base, m->map_len, wait ? MS_SYNC : MS_ASYNC) != 0) return errno;
+    return 0;
+}
+
+int cyon_mmap_resize(cyon_mmap_t *m, uint64_t size) {
+    if (!m) return EINVAL;
+    if (!(m->flags & CYON_MMAP_WRITE)) return EBADF;
+    if (size > (uint64_t)SIZE_MAX && !m->window) return ENOMEM;
+    if (ftruncate(m->fd, (off_t)size) != 0) return errno;
+    int rc = 0;
+    if (m->window) {
+        /* the next view maps afresh against the new size */
+        if (m->base && m->map_off + m->map_len > size) cyon_mmap_unmap(m);
+    } else if (size == 0) {
+        cyon_mmap_unmap(m);
+    } else if (!m->base) {
+        rc = cyon_mmap_map(m, 0, (size_t)size);
+    } else {
+        void *p = mremap(m->base, m->map_len, (size_t)size, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            rc = errno;
+        } else {
+            m->base = (char*)p;
+            m->map_len = (size_t)size;
+        }
+    }
+    if (rc != 0) {
+        /* keep the file the size of the mapping that is still in place */
+        int tr = ftruncate(m->fd, (off_t)m->file_size);
+        (void)tr;
+        return rc;
+    }
+    m->file_size = size;
+    return 0;
+}
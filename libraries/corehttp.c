@@ -0,0 +1,699 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyonhttp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define CYON_HTTP_ARENA_BLOCK 4096
+#define CYON_HTTP_OUT_FLUSH   65536     /* staged output forcing a write */
+
+/* ---- Request parser ---- */
+
+/* RFC 9110 token characters */
+static int cyon_http_tchar(unsigned char ch) {
+    if (ch >= 'a' && ch <= 'z') return 1;
+    if (ch >= 'A' && ch <= 'Z') return 1;
+    if (ch >= '0' && ch <= '9') return 1;
+    return ch != 0 && strchr("!#$%&'*+-.^_`|~", ch) != NULL;
+}
+
+static int cyon_slice_ieq(cyon_slice_t s, const char *lit) {
+    size_t n = strlen(lit);
+    return s.len == n && strncasecmp(s.ptr, lit, n) == 0;
+}
+
+static cyon_slice_t cyon_slice_trim(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    cyon_slice_t s = { p, (size_t)(end - p) };
+    return s;
+}
+
+/* Comma-separated list contains token (case-insensitive). */
+static int cyon_http_list_has(cyon_slice_t v, const char *token) {
+    const char *p = v.ptr, *end = v.ptr + v.len;
+    while (p < end) {
+        const char *comma = (const char*)memchr(p, ',', (size_t)(end - p));
+        const char *e = comma ? comma : end;
+        if (cyon_slice_ieq(cyon_slice_trim(p, e), token)) return 1;
+        p = e + 1;
+    }
+    return 0;
+}
+
+/* Last element of a comma-separated list. */
+static cyon_slice_t cyon_http_list_last(cyon_slice_t v) {
+    const char *end = v.ptr + v.len;
+    const char *p = end;
+    while (p > v.ptr && p[-1] != ',') p--;
+    return cyon_slice_trim(p, end);
+}
+
+static int cyon_http_parse_length(cyon_slice_t v, int64_t *out) {
+    if (v.len == 0 || v.len > 18) return EBADMSG;
+    int64_t n = 0;
+    for (size_t i = 0; i < v.len; i++) {
+        if (v.ptr[i] < '0' || v.ptr[i] > '9') return EBADMSG;
+        n = n * 10 + (v.ptr[i] - '0');
+    }
+    *out = n;
+    return 0;
+}
+
+ssize_t cyon_http_parse_request(const char *buf, size_t len, size_t *scanned, cyon_http_request_t *req) {
+    if (!buf || !req) return -EINVAL;
+    size_t from = scanned && *scanned > 3 ? *scanned - 3 : 0;
+    if (from >= len) from = 0;
+    const char *hit = (const char*)memmem(buf + from, len - from, "\r\n\r\n", 4);
+    if (!hit) {
+        if (scanned) *scanned = len;
+        return 0;
+    }
+    size_t head = (size_t)(hit - buf) + 4;
+    const char *end = hit + 2;              /* keep the last header's CRLF */
+    memset(req, 0, sizeof(*req));
+    req->content_length = -1;
+
+    /* request line: method SP target SP HTTP/1.x CRLF */
+    const char *p = buf;
+    while (p < end && cyon_http_tchar((unsigned char)*p)) p++;
+    if (p == buf || p >= end || *p != ' ') return -EBADMSG;
+    req->method.ptr = buf;
+    req->method.len = (size_t)(p - buf);
+    const char *t = ++p;
+    while (p < end && (unsigned char)*p > ' ' && *p != 0x7f) p++;
+    if (p == t || p >= end || *p != ' ') return -EBADMSG;
+    req->target.ptr = t;
+    req->target.len = (size_t)(p - t);
+    p++;
+    if (end - p < 10 || memcmp(p, "HTTP/1.", 7) != 0 || p[7] < '0' || p[7] > '9' || p[8] != '\r' || p[9] != '\n')
+        return -EBADMSG;
+    req->minor = p[7] - '0';
+    p += 10;
+    const char *q = (const char*)memchr(t, '?', req->target.len);
+    req->path.ptr = t;
+    req->path.len = q ? (size_t)(q - t) : req->target.len;
+    if (q) {
+        req->query.ptr = q + 1;
+        req->query.len = req->target.len - req->path.len - 1;
+    }
+
+    /* header fields: name ":" OWS value OWS CRLF, no line folding */
+    cyon_slice_t te = { NULL, 0 };
+    int close = 0, keep = 0;
+    while (p < end) {
+        const char *eol = (const char*)memmem(p, (size_t)(end - p), "\r\n", 2);
+        if (!eol) return -EBADMSG;
+        const char *n = p;
+        while (n < eol && cyon_http_tchar((unsigned char)*n)) n++;
+        if (n == p || n >= eol || *n != ':') return -EBADMSG;
+        if (req->nheaders == CYON_HTTP_MAX_HEADERS) return -EMSGSIZE;
+        cyon_http_header_t *h = &req->headers[req->nheaders++];
+        h->name.ptr = p;
+        h->name.len = (size_t)(n - p);
+        h->value = cyon_slice_trim(n + 1, eol);
+        for (size_t i = 0; i < h->value.len; i++) {
+            unsigned char ch = (unsigned char)h->value.ptr[i];
+            if ((ch < ' ' && ch != '\t') || ch == 0x7f) return -EBADMSG;
+        }
+        if (cyon_slice_ieq(h->name, "content-length")) {
+            int64_t v;
+            if (cyon_http_parse_length(h->value, &v) != 0) return -EBADMSG;
+            if (req->content_length >= 0 && req->content_length != v) return -EBADMSG;
+            req->content_length = v;
+        } else if (cyon_slice_ieq(h->name, "transfer-encoding")) {
+            if (te.ptr) return -EBADMSG;
+            te = h->value;
+        } else if (cyon_slice_ieq(h->name, "connection")) {
+            close |= cyon_http_list_has(h->value, "close");
+            keep |= cyon_http_list_has(h->value, "keep-alive");
+        } else if (cyon_slice_ieq(h->name, "expect")) {
+            req->expect_continue = cyon_slice_ieq(h->value, "100-continue");
+        }
+        p = eol + 2;
+    }
+    if (te.ptr) {
+        /* both framings at once is a smuggling vector: refuse */
+        if (req->content_length >= 0) return -EBADMSG;
+        if (!cyon_slice_ieq(cyon_http_list_last(te), "chunked")) return -ENOTSUP;
+        req->chunked = 1;
+    }
+    req->keep_alive = req->minor >= 1 ? !close : (keep && !close);
+    if (scanned) *scanned = (size_t)(hit - buf);    /* finds the same end again */
+    return (ssize_t)head;
+}
+
+cyon_slice_t cyon_http_header(const cyon_http_request_t *req, const char *name) {
+    cyon_slice_t none = { NULL, 0 };
+    if (!req || !name) return none;
+    for (size_t i = 0; i < req->nheaders; i++)
+        if (cyon_slice_ieq(req->headers[i].name, name)) return req->headers[i].value;
+    return none;
+}
+
+/* Where a walk of a chunked body stopped: always at the start of a line,
+   so a later call with more input carries on from there. */
+typedef struct {
+    size_t off;         /* encoded bytes walked */
+    size_t total;       /* decoded bytes before off */
+    size_t seen;        /* bytes of the line at off already searched for CRLF */
+    int trailers;       /* past the last chunk */
+} cyon_http_chunks_t;
+
+/* Walk a chunked body from *st. Returns the encoded length once the
+   terminating chunk and trailers are in, 0 if more input is needed, or
+   -errno. st->total gets the decoded size; dst (if not NULL) receives the
+   data, and then st must start zeroed. */
+static ssize_t cyon_http_dechunk(const char *buf, size_t len, char *dst, cyon_http_chunks_t *st, size_t max) {
+    size_t off = st->off, total = st->total;
+    for (;;) {
+        st->off = off;
+        st->total = total;
+        size_t from = off + st->seen;
+        const char *eol = (const char*)memmem(buf + from, len - from, "\r\n", 2);
+        if (!eol) {
+            /* a CR at the very end may still pair with the next byte */
+            st->seen = len - off > 0 ? len - off - 1 : 0;
+            return 0;
+        }
+        st->seen = 0;
+        size_t llen = (size_t)(eol - (buf + off));
+        if (st->trailers) {
+            /* trailers end with an empty line */
+            off += llen + 2;
+            if (llen == 0) return (ssize_t)off;
+            continue;
+        }
+        size_t n = 0, digits = 0;
+        const char *p = buf + off;
+        for (; p < eol; p++, digits++) {
+            int v;
+            if (*p >= '0' && *p <= '9') v = *p - '0';
+            else if (*p >= 'a' && *p <= 'f') v = *p - 'a' + 10;
+            else if (*p >= 'A' && *p <= 'F') v = *p - 'A' + 10;
+            else break;
+            if (digits >= 15) return -EBADMSG;
+            n = n * 16 + (size_t)v;
+        }
+        if (digits == 0 || (p < eol && *p != ';')) return -EBADMSG;   /* ';' starts extensions */
+        size_t data = (size_t)(eol - buf) + 2;
+        if (n == 0) {
+            st->trailers = 1;
+            off = data;
+            continue;
+        }
+        if (total + n > max) {
+            st->total = total + n;
+            return -EMSGSIZE;
+        }
+        if (len - data < n + 2) return 0;
+        if (buf[data + n] != '\r' || buf[data + n + 1] != '\n') return -EBADMSG;
+        if (dst) memcpy(dst + total, buf + data, n);
+        total += n;
+        off = data + n + 2;
+    }
+}
+
+/* ---- Server ---- */
+
+typedef struct cyon_http_block {
+    struct cyon_http_block *next;
+    size_t cap;
+    size_t used;
+} cyon_http_block_t;
+
+enum { CYON_HTTP_IDLE, CYON_HTTP_ACTIVE, CYON_HTTP_STREAMING, CYON_HTTP_DONE };
+
+struct cyon_http_server_s {
+    cyon_http_opts_t opts;
+    cyon_http_handler fn;
+    void *user;
+    cyon_conn_handlers_t handlers;
+    atomic_uint_fast64_t requests;
+};
+
+struct cyon_http_ctx_s {
+    cyon_http_server_t *srv;
+    cyon_conn_t *c;                 /* NULL once the connection closed */
+    cyon_http_request_t req;
+    size_t scanned;
+    cyon_http_chunks_t chunks;      /* chunked body walked so far */
+    int state;
+    int in_data;                    /* inside on_data: writes are staged */
+    int keep_alive;                 /* for the response in progress */
+    int head_only;                  /* HEAD: no body */
+    int raw_stream;                 /* HTTP/1.0 streaming: close-delimited */
+    int continued;                  /* 100 Continue already sent */
+    int closing;
+    size_t served;
+    cyon_http_block_t *arena;       /* first block is kept across requests */
+    char *extra;                    /* added header lines (in the arena) */
+    size_t extra_len;
+    size_t extra_cap;
+    char *out;                      /* staged output */
+    size_t out_len;
+    size_t out_cap;
+};
+
+static void *cyon_http_arena_alloc(cyon_http_ctx_t *x, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    cyon_http_block_t *b = x->arena;
+    if (!b || b->used + size > b->cap) {
+        size_t cap = size > CYON_HTTP_ARENA_BLOCK ? size : CYON_HTTP_ARENA_BLOCK;
+        cyon_http_block_t *nb = (cyon_http_block_t*)malloc(sizeof(cyon_http_block_t) + cap);
+        if (!nb) return NULL;
+        nb->cap = cap;
+        nb->used = 0;
+        nb->next = b;
+        x->arena = b = nb;
+    }
+    void *p = (char*)(b + 1) + b->used;
+    b->used += size;
+    return p;
+}
+
+/* Drop everything but the oldest block and rewind it. */
+static void cyon_http_arena_reset(cyon_http_ctx_t *x) {
+    cyon_http_block_t *b = x->arena;
+    while (b && b->next) {
+        cyon_http_block_t *n = b->next;
+        free(b);
+        b = n;
+    }
+    if (b) b->used = 0;
+    x->arena = b;
+    x->extra = NULL;
+    x->extra_len = x->extra_cap = 0;
+}
+
+static void cyon_http_ctx_free(cyon_http_ctx_t *x) {
+    cyon_http_arena_reset(x);
+    free(x->arena);
+    free(x->out);
+    free(x);
+}
+
+static int cyon_http_stage(cyon_http_ctx_t *x, const void *data, size_t len) {
+    if (x->out_len + len > x->out_cap) {
+        size_t cap = x->out_cap ? x->out_cap : 4096;
+        while (cap < x->out_len + len) cap *= 2;
+        char *p = (char*)realloc(x->out, cap);
+        if (!p) return ENOMEM;
+        x->out = p;
+        x->out_cap = cap;
+    }
+    memcpy(x->out + x->out_len, data, len);
+    x->out_len += len;
+    return 0;
+}
+
+static int cyon_http_flush(cyon_http_ctx_t *x) {
+    if (x->out_len == 0) return 0;
+    int rc = x->c ? cyon_conn_write(x->c, x->out, x->out_len) : EPIPE;
+    x->out_len = 0;
+    if (x->out_cap > 4 * CYON_HTTP_OUT_FLUSH) {
+        free(x->out);
+        x->out = NULL;
+        x->out_cap = 0;
+    }
+    return rc;
+}
+
+/* Writes outside on_data (deferred responses) and large staged output
+   go to the connection straight away. */
+static int cyon_http_maybe_flush(cyon_http_ctx_t *x) {
+    if (!x->in_data || x->out_len >= CYON_HTTP_OUT_FLUSH) return cyon_http_flush(x);
+    return 0;
+}
+
+const char *cyon_http_status_text(int status) {
+    switch (status) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Content Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Unknown";
+    }
+}
+
+/* "Date: ...\r\n", formatted at most once a second per thread. */
+static const char *cyon_http_date_line(void) {
+    static __thread char line[48];
+    static __thread time_t cached;
+    time_t now = time(NULL);
+    if (now != cached) {
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        strftime(line, sizeof(line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        cached = now;
+    }
+    return line;
+}
+
+/* Status line and headers; length < 0 means streaming. */
+static int cyon_http_stage_head(cyon_http_ctx_t *x, int status, const char *content_type, int64_t length) {
+    char head[512];
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\n%s", status,
+                     cyon_http_status_text(status), cyon_http_date_line());
+    if (content_type && n < (int)sizeof(head))
+        n += snprintf(head + n, sizeof(head) - (size_t)n, "Content-Type: %s\r\n", content_type);
+    if (n < (int)sizeof(head)) {
+        if (length >= 0)
+            n += snprintf(head + n, sizeof(head) - (size_t)n, "Content-Length: %lld\r\n", (long long)length);
+        else if (!x->raw_stream)
+            n += snprintf(head + n, sizeof(head) - (size_t)n, "Transfer-Encoding: chunked\r\n");
+    }
+    if (n < (int)sizeof(head)) {
+        if (!x->keep_alive)
+            n += snprintf(head + n, sizeof(head) - (size_t)n, "Connection: close\r\n");
+        else if (x->req.minor == 0)
+            n += snprintf(head + n, sizeof(head) - (size_t)n, "Connection: keep-alive\r\n");
+    }
+    if (n >= (int)sizeof(head)) return EOVERFLOW;
+    int rc = cyon_http_stage(x, head, (size_t)n);
+    if (rc == 0 && x->extra_len) rc = cyon_http_stage(x, x->extra, x->extra_len);
+    if (rc == 0) rc = cyon_http_stage(x, "\r\n", 2);
+    return rc;
+}
+
+static void cyon_http_resume(cyon_http_ctx_t *x);
+
+/* The response is complete: recycle per-request state. */
+static void cyon_http_finish(cyon_http_ctx_t *x) {
+    x->state = CYON_HTTP_DONE;
+    cyon_http_arena_reset(x);
+    if (!x->keep_alive) x->closing = 1;
+    if (!x->in_data) cyon_http_resume(x);
+}
+
+/* After a deferred response: flush, then either close or go on with any
+   pipelined input (which the reactor redelivers when reading resumes). */
+static void cyon_http_resume(cyon_http_ctx_t *x) {
+    cyon_http_flush(x);
+    if (!x->c) {
+        cyon_http_ctx_free(x);
+        return;
+    }
+    x->state = CYON_HTTP_IDLE;
+    if (x->closing) cyon_conn_close(x->c);
+    else cyon_conn_set_reading(x->c, 1);
+}
+
+int cyon_http_add_header(cyon_http_ctx_t *x, const char *name, const char *value) {
+    if (!x || !name || !value) return EINVAL;
+    if (x->state != CYON_HTTP_ACTIVE) return EALREADY;
+    size_t nl = strlen(name), vl = strlen(value);
+    if (strpbrk(name, "\r\n:") || strpbrk(value, "\r\n")) return EINVAL;
+    size_t need = x->extra_len + nl + vl + 4;
+    if (need > x->extra_cap) {
+        size_t cap = x->extra_cap ? x->extra_cap * 2 : 256;
+        while (cap < need) cap *= 2;
+        char *p = (char*)cyon_http_arena_alloc(x, cap);
+        if (!p) return ENOMEM;
+        if (x->extra_len) memcpy(p, x->extra, x->extra_len);
+        x->extra = p;
+        x->extra_cap = cap;
+    }
+    char *w = x->extra + x->extra_len;
+    memcpy(w, name, nl);
+    w[nl] = ':';
+    w[nl + 1] = ' ';
+    memcpy(w + nl + 2, value, vl);
+    w[nl + 2 + vl] = '\r';
+    w[nl + 3 + vl] = '\n';
+    x->extra_len = need;
+    return 0;
+}
+
+int cyon_http_respond(cyon_http_ctx_t *x, int status, const char *content_type, const void *body, size_t len) {
+    if (!x || (!body && len)) return EINVAL;
+    if (x->state != CYON_HTTP_ACTIVE) return EALREADY;
+    int rc = cyon_http_stage_head(x, status, content_type, (int64_t)len);
+    if (rc == 0 && len && !x->head_only) {
+        /* big bodies skip the staging copy */
+        if (len >= CYON_HTTP_OUT_FLUSH) {
+            rc = cyon_http_flush(x);
+            if (rc == 0) rc = x->c ? cyon_conn_write(x->c, body, len) : EPIPE;
+        } else {
+            rc = cyon_http_stage(x, body, len);
+        }
+    }
+    if (rc == 0) rc = cyon_http_maybe_flush(x);
+    if (rc != 0) x->keep_alive = 0;
+    cyon_http_finish(x);
+    return rc;
+}
+
+int cyon_http_begin_chunked(cyon_http_ctx_t *x, int status, const char *content_type) {
+    if (!x) return EINVAL;
+    if (x->state != CYON_HTTP_ACTIVE) return EALREADY;
+    if (x->req.minor == 0) {
+        x->raw_stream = 1;
+        x->keep_alive = 0;
+    }
+    int rc = cyon_http_stage_head(x, status, content_type, -1);
+    x->state = CYON_HTTP_STREAMING;
+    if (rc == 0) rc = cyon_http_maybe_flush(x);
+    return rc;
+}
+
+int cyon_http_write_chunk(cyon_http_ctx_t *x, const void *data, size_t len) {
+    if (!x || (!data && len)) return EINVAL;
+    if (x->state != CYON_HTTP_STREAMING) return EALREADY;
+    if (len == 0 || x->head_only) return 0;
+    if (!x->c) return EPIPE;
+    int rc = 0;
+    if (!x->raw_stream) {
+        char size[24];
+        int n = snprintf(size, sizeof(size), "%zx\r\n", len);
+        rc = cyon_http_stage(x, size, (size_t)n);
+    }
+    if (rc == 0) rc = cyon_http_stage(x, data, len);
+    if (rc == 0 && !x->raw_stream) rc = cyon_http_stage(x, "\r\n", 2);
+    if (rc == 0) rc = cyon_http_maybe_flush(x);
+    return rc;
+}
+
+int cyon_http_end_chunked(cyon_http_ctx_t *x) {
+    if (!x) return EINVAL;
+    if (x->state != CYON_HTTP_STREAMING) return EALREADY;
+    int rc = 0;
+    if (!x->raw_stream && !x->head_only) rc = cyon_http_stage(x, "0\r\n\r\n", 5);
+    if (rc == 0) rc = cyon_http_maybe_flush(x);
+    if (rc != 0) x->keep_alive = 0;
+    x->raw_stream = 0;
+    cyon_http_finish(x);
+    return rc;
+}
+
+void *cyon_http_alloc(cyon_http_ctx_t *x, size_t size) {
+    if (!x || x->state == CYON_HTTP_IDLE || x->state == CYON_HTTP_DONE) return NULL;
+    return cyon_http_arena_alloc(x, size ? size : 1);
+}
+
+cyon_conn_t *cyon_http_conn(cyon_http_ctx_t *x) {
+    return x ? x->c : NULL;
+}
+
+/* Protocol error: answer and close. */
+static void cyon_http_fail(cyon_http_ctx_t *x, int status) {
+    const char *text = cyon_http_status_text(status);
+    x->state = CYON_HTTP_ACTIVE;
+    x->keep_alive = 0;
+    x->head_only = 0;
+    cyon_http_respond(x, status, "text/plain", text, strlen(text));
+}
+
+static void cyon_http_on_open(cyon_conn_t *c, void *user) {
+    cyon_http_server_t *s = (cyon_http_server_t*)user;
+    cyon_http_ctx_t *x = (cyon_http_ctx_t*)calloc(1, sizeof(cyon_http_ctx_t));
+    if (!x) {
+        cyon_conn_set_user(c, NULL);
+        cyon_conn_abort(c, ENOMEM);
+        return;
+    }
+    x->srv = s;
+    x->c = c;
+    cyon_conn_set_user(c, x);
+    cyon_conn_set_timeout(c, s->opts.idle_timeout_ms);
+}
+
+static size_t cyon_http_on_data(cyon_conn_t *c, const char *data, size_t len, void *user) {
+    cyon_http_ctx_t *x = (cyon_http_ctx_t*)user;
+    (void)c;
+    if (!x || x->state == CYON_HTTP_ACTIVE || x->state == CYON_HTTP_STREAMING || x->closing) return 0;
+    cyon_http_server_t *s = x->srv;
+    size_t total = 0;
+    x->in_data = 1;
+    while (total < len && x->c && !x->closing) {
+        const char *p = data + total;
+        size_t n = len - total;
+        ssize_t head = cyon_http_parse_request(p, n, &x->scanned, &x->req);
+        if (head == 0) {
+            if (n > s->opts.max_header_bytes) cyon_http_fail(x, 431);
+            break;
+        }
+        if (head < 0) {
+            cyon_http_fail(x, head == -ENOTSUP ? 501 : head == -EMSGSIZE ? 431 : 400);
+            break;
+        }
+        if ((size_t)head > s->opts.max_header_bytes) {
+            cyon_http_fail(x, 431);
+            break;
+        }
+        size_t used = (size_t)head;
+        const char *body = p + head;
+        size_t avail = n - (size_t)head;
+        if (x->req.chunked) {
+            ssize_t enc = cyon_http_dechunk(body, avail, NULL, &x->chunks, s->opts.max_body_bytes);
+            if (enc < 0) {
+                cyon_http_fail(x, enc == -EMSGSIZE ? 413 : 400);
+                break;
+            }
+            if (enc == 0) {
+                if (x->req.expect_continue && !x->continued) {
+                    x->continued = 1;
+                    cyon_http_stage(x, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+                }
+                break;
+            }
+            x->state = CYON_HTTP_ACTIVE;
+            size_t size = x->chunks.total;
+            char *dst = (char*)cyon_http_arena_alloc(x, size ? size : 1);
+            if (!dst) {
+                cyon_http_fail(x, 500);
+                break;
+            }
+            /* the copy pass walks the body once more, from the start */
+            cyon_http_chunks_t copy;
+            memset(&copy, 0, sizeof(copy));
+            cyon_http_dechunk(body, avail, dst, &copy, s->opts.max_body_bytes);
+            x->req.body.ptr = dst;
+            x->req.body.len = size;
+            used += (size_t)enc;
+        } else if (x->req.content_length > 0) {
+            if ((uint64_t)x->req.content_length > s->opts.max_body_bytes) {
+                cyon_http_fail(x, 413);
+                break;
+            }
+            if (avail < (size_t)x->req.content_length) {
+                if (x->req.expect_continue && !x->continued) {
+                    x->continued = 1;
+                    cyon_http_stage(x, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+                }
+                break;
+            }
+            x->req.body.ptr = body;
+            x->req.body.len = (size_t)x->req.content_length;
+            used += (size_t)x->req.content_length;
+        }
+
+        x->scanned = 0;
+        memset(&x->chunks, 0, sizeof(x->chunks));
+        x->continued = 0;
+        x->state = CYON_HTTP_ACTIVE;
+        x->served++;
+        x->keep_alive = x->req.keep_alive && (!s->opts.max_requests || x->served < s->opts.max_requests);
+        x->head_only = cyon_slice_ieq(x->req.method, "HEAD");
+        atomic_fetch_add_explicit(&s->requests, 1, memory_order_relaxed);
+        s->fn(x, &x->req, s->user);
+        total += used;
+        if (x->state != CYON_HTTP_DONE) {
+            /* deferred: hold further input until the response is done */
+            if (x->c) cyon_conn_set_reading(x->c, 0);
+            break;
+        }
+        x->state = CYON_HTTP_IDLE;
+    }
+    x->in_data = 0;
+    cyon_http_flush(x);
+    if (!x->c) {
+        /* closed from inside the handler */
+        if (x->state != CYON_HTTP_ACTIVE && x->state != CYON_HTTP_STREAMING) cyon_http_ctx_free(x);
+        return len;
+    }
+    if (x->closing && x->state != CYON_HTTP_ACTIVE && x->state != CYON_HTTP_STREAMING) {
+        cyon_conn_close(x->c);
+        return len;
+    }
+    return total;
+}
+
+static void cyon_http_on_close(cyon_conn_t *c, int err, void *user) {
+    cyon_http_ctx_t *x = (cyon_http_ctx_t*)user;
+    (void)c;
+    (void)err;
+    if (!x) return;
+    x->c = NULL;
+    /* a pending response or an on_data frame still holds x */
+    if (x->in_data || x->state == CYON_HTTP_ACTIVE || x->state == CYON_HTTP_STREAMING) return;
+    cyon_http_ctx_free(x);
+}
+
+int cyon_http_server_create(cyon_http_server_t **out, const cyon_http_opts_t *opts,
+                            cyon_http_handler fn, void *user) {
+    if (!out || !fn) return EINVAL;
+    cyon_http_server_t *s = (cyon_http_server_t*)calloc(1, sizeof(cyon_http_server_t));
+    if (!s) return ENOMEM;
+    if (opts) s->opts = *opts;
+    if (!s->opts.max_header_bytes) s->opts.max_header_bytes = 16384;
+    if (!s->opts.max_body_bytes) s->opts.max_body_bytes = 524288;
+    if (!s->opts.idle_timeout_ms) s->opts.idle_timeout_ms = 5000;
+    s->fn = fn;
+    s->user = user;
+    s->handlers.on_open = cyon_http_on_open;
+    s->handlers.on_data = cyon_http_on_data;
+    s->handlers.on_close = cyon_http_on_close;
+    atomic_init(&s->requests, 0);
+    *out = s;
+    return 0;
+}
+
+void cyon_http_server_destroy(cyon_http_server_t *s) {
+    free(s);
+}
+
+int cyon_http_server_listen(cyon_http_server_t *s, cyon_reactor_t *r, int listen_fd) {
+    if (!s || !r) return EINVAL;
+    return cyon_reactor_listen(r, listen_fd, &s->handlers, s);
+}
+
+int cyon_http_server_listen_group(cyon_http_server_t *s, cyon_reactor_group_t *g, int listen_fd) {
+    if (!s || !g) return EINVAL;
+    return cyon_reactor_group_listen(g, listen_fd, &s->handlers, s);
+}
+
+int cyon_http_server_adopt(cyon_http_server_t *s, cyon_reactor_t *r, int fd) {
+    if (!s || !r) return EINVAL;
+    return cyon_reactor_adopt(r, fd, &s->handlers, s, NULL);
+}
+
+uint64_t cyon_http_server_requests(const cyon_http_server_t *s) {
+    return s ? atomic_load_explicit(&((cyon_http_server_t*)s)->requests, memory_order_relaxed) : 0;
+}
@@ -0,0 +1,437 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cyon_lock_pause() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cyon_lock_pause() __asm__ volatile("yield")
+#else
+#define cyon_lock_pause() ((void)0)
+#endif
+
+/* Backoff rounds before parking; each round spins 2^round pauses (capped). */
+#ifndef CYON_LOCK_SPIN_ROUNDS
+#define CYON_LOCK_SPIN_ROUNDS 8
+#endif
+#define CYON_LOCK_SPIN_CAP 64
+
+#define CYON_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define CYON_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+
+/* Returns ETIMEDOUT if the timeout expired, 0 otherwise (woken, value
+   changed, or interrupted). Falls back to a short sleep elsewhere. */
+static int cyon_lock_futex_wait(uint32_t *addr, uint32_t val, long long timeout_ns) {
+#ifdef __linux__
+    struct timespec ts, *tp = NULL;
+    if (timeout_ns >= 0) {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        tp = &ts;
+    }
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, tp, NULL, 0) != 0 && errno == ETIMEDOUT)
+        return ETIMEDOUT;
+    return 0;
+#else
+    (void)addr; (void)val;
+    struct timespec ts = { 0, 50000 };
+    if (timeout_ns >= 0 && timeout_ns < 50000) ts.tv_nsec = (long)timeout_ns;
+    nanosleep(&ts, NULL);
+    return 0;
+#endif
+}
+
+static void cyon_lock_futex_wake(uint32_t *addr, int n) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+    (void)addr; (void)n;
+#endif
+}
+
+static long long cyon_lock_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ---- contention profiler ---- */
+
+/* One record per contended lock. Only the slow path touches it, so a lock
+   that is never contended costs nothing here. */
+typedef struct {
+    const void *lock;
+    const char *name;
+    uint64_t contended;
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+    cyon_lock_site_report_t holders[CYON_LOCK_PROF_SITES];
+} cyon_lock_record_t;
+
+static int g_lock_prof_enabled = 0;
+static pthread_mutex_t g_lock_prof_mu = PTHREAD_MUTEX_INITIALIZER;
+static cyon_lock_record_t g_lock_records[CYON_LOCK_PROF_MAX];
+static uint32_t g_lock_record_count = 0;
+
+void cyon_lock_profile_enable(int enable) {
+    __atomic_store_n(&g_lock_prof_enabled, enable ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+int cyon_lock_profile_enabled(void) {
+    return __atomic_load_n(&g_lock_prof_enabled, __ATOMIC_RELAXED);
+}
+
+static void cyon_lock_prof_record(uint32_t *prof_id, const void *lock, const char *name,
+                                  const char *holder_file, int holder_line, long long waited) {
+    if (waited < 0) waited = 0;
+    pthread_mutex_lock(&g_lock_prof_mu);
+    uint32_t id = *prof_id;
+    if (id == 0) {
+        if (g_lock_record_count >= CYON_LOCK_PROF_MAX) {
+            pthread_mutex_unlock(&g_lock_prof_mu);
+            return;
+        }
+        id = ++g_lock_record_count;
+        cyon_lock_record_t *r = &g_lock_records[id - 1];
+        memset(r, 0, sizeof(*r));
+        r->lock = lock;
+        r->name = name;
+        __atomic_store_n(prof_id, id, __ATOMIC_RELAXED);
+    }
+    cyon_lock_record_t *r = &g_lock_records[id - 1];
+    r->contended++;
+    r->wait_ns += (uint64_t)waited;
+    if ((uint64_t)waited > r->max_wait_ns) r->max_wait_ns = (uint64_t)waited;
+
+    /* attribute the wait to the holder's call site; the last slot absorbs overflow */
+    size_t slot = CYON_LOCK_PROF_SITES - 1;
+    for (size_t i = 0; i < CYON_LOCK_PROF_SITES; i++) {
+        cyon_lock_site_report_t *h = &r->holders[i];
+        if (h->count == 0 || (h->file == holder_file && h->line == holder_line)) {
+            slot = i;
+            break;
+        }
+    }
+    cyon_lock_site_report_t *h = &r->holders[slot];
+    if (h->count == 0) {
+        h->file = holder_file;
+        h->line = holder_line;
+    }
+    h->count++;
+    h->wait_ns += (uint64_t)waited;
+    pthread_mutex_unlock(&g_lock_prof_mu);
+}
+
+static int cyon_lock_report_cmp(const void *a, const void *b) {
+    const cyon_lock_report_t *x = (const cyon_lock_report_t*)a;
+    const cyon_lock_report_t *y = (const cyon_lock_report_t*)b;
+    if (x->wait_ns != y->wait_ns) return x->wait_ns < y->wait_ns ? 1 : -1;
+    return 0;
+}
+
+static int cyon_lock_site_cmp(const void *a, const void *b) {
+    const cyon_lock_site_report_t *x = (const cyon_lock_site_report_t*)a;
+    const cyon_lock_site_report_t *y = (const cyon_lock_site_report_t*)b;
+    if (x->wait_ns != y->wait_ns) return x->wait_ns < y->wait_ns ? 1 : -1;
+    return 0;
+}
+
+size_t cyon_lock_profile_collect(cyon_lock_report_t *out, size_t cap) {
+    pthread_mutex_lock(&g_lock_prof_mu);
+    size_t n = g_lock_record_count;
+    cyon_lock_report_t *all = n ? (cyon_lock_report_t*)calloc(n, sizeof(cyon_lock_report_t)) : NULL;
+    if (all) {
+        for (size_t i = 0; i < n; i++) {
+            cyon_lock_record_t *r = &g_lock_records[i];
+            all[i].lock = r->lock;
+            all[i].name = r->name;
+            all[i].contended = r->contended;
+            all[i].wait_ns = r->wait_ns;
+            all[i].max_wait_ns = r->max_wait_ns;
+            memcpy(all[i].holders, r->holders, sizeof(r->holders));
+        }
+    }
+    pthread_mutex_unlock(&g_lock_prof_mu);
+    if (!all) return 0;
+    qsort(all, n, sizeof(cyon_lock_report_t), cyon_lock_report_cmp);
+    for (size_t i = 0; i < n; i++)
+        qsort(all[i].holders, CYON_LOCK_PROF_SITES, sizeof(cyon_lock_site_report_t), cyon_lock_site_cmp);
+    if (out) memcpy(out, all, (n < cap ? n : cap) * sizeof(cyon_lock_report_t));
+    free(all);
+    return n;
+}
+
+void cyon_lock_profile_report(FILE *out, size_t top_n) {
+    if (!out) out = stderr;
+    size_t n = cyon_lock_profile_collect(NULL, 0);
+    if (n == 0) {
+        fprintf(out, "lock profile: no contention recorded\n");
+        return;
+    }
+    cyon_lock_report_t *reps = (cyon_lock_report_t*)calloc(n, sizeof(cyon_lock_report_t));
+    if (!reps) return;
+    size_t got = cyon_lock_profile_collect(reps, n);
+    if (got < n) n = got;
+    if (top_n == 0 || top_n > n) top_n = n;
+    fprintf(out, "%-24s %-18s %12s %14s %12s\n", "lock", "address", "contended", "wait_ms", "max_us");
+    for (size_t i = 0; i < top_n; i++) {
+        cyon_lock_report_t *r = &reps[i];
+        fprintf(out, "%-24s %-18p %12llu %14.3f %12.1f\n",
+                r->name ? r->name : "(unnamed)", r->lock,
+                (unsigned long long)r->contended, (double)r->wait_ns / 1e6,
+                (double)r->max_wait_ns / 1e3);
+        for (size_t k = 0; k < CYON_LOCK_PROF_SITES; k++) {
+            cyon_lock_site_report_t *h = &r->holders[k];
+            if (h->count == 0) continue;
+            fprintf(out, "    held at %s:%d  %llu waits, %.3f ms\n",
+                    h->file ? h->file : "?", h->line,
+                    (unsigned long long)h->count, (double)h->wait_ns / 1e6);
+        }
+    }
+    free(reps);
+}
+
+void cyon_lock_profile_reset(void) {
+    pthread_mutex_lock(&g_lock_prof_mu);
+    for (uint32_t i = 0; i < g_lock_record_count; i++) {
+        cyon_lock_record_t *r = &g_lock_records[i];
+        r->contended = 0;
+        r->wait_ns = 0;
+        r->max_wait_ns = 0;
+        memset(r->holders, 0, sizeof(r->holders));
+    }
+    pthread_mutex_unlock(&g_lock_prof_mu);
+}
+
+/* ---- adaptive mutex ----
+   state: 0 = free, 1 = locked, 2 = locked and someone may be parked. */
+
+void cyon_lock_init(cyon_lock_t *l, const char *name) {
+    if (!l) return;
+    memset(l, 0, sizeof(*l));
+    l->name = name;
+}
+
+static void cyon_lock_set_holder(cyon_lock_t *l, const char *file, int line) {
+    CYON_STORE(&l->holder_file, file);
+    CYON_STORE(&l->holder_line, line);
+}
+
+static void cyon_lock_slow(cyon_lock_t *l, const char *file, int line) {
+    int prof = cyon_lock_profile_enabled();
+    const char *hf = prof ? CYON_LOAD(&l->holder_file) : NULL;
+    int hl = prof ? CYON_LOAD(&l->holder_line) : 0;
+    long long t0 = prof ? cyon_lock_now_ns() : 0;
+
+    uint32_t c = 1;
+    for (int round = 0; round < CYON_LOCK_SPIN_ROUNDS; round++) {
+        int spins = 1 << round;
+        if (spins > CYON_LOCK_SPIN_CAP) spins = CYON_LOCK_SPIN_CAP;
+        for (int i = 0; i < spins; i++) cyon_lock_pause();
+        c = CYON_LOAD(&l->state);
+        if (c == 0) {
+            uint32_t z = 0;
+            if (__atomic_compare_exchange_n(&l->state, &z, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                goto acquired;
+            c = z;
+        }
+        if (c == 2) break; /* others already parked: don't burn the CPU */
+    }
+    c = __atomic_exchange_n(&l->state, 2, __ATOMIC_ACQUIRE);
+    while (c != 0) {
+        cyon_lock_futex_wait(&l->state, 2, -1);
+        c = __atomic_exchange_n(&l->state, 2, __ATOMIC_ACQUIRE);
+    }
+acquired:
+    cyon_lock_set_holder(l, file, line);
+    if (prof) cyon_lock_prof_record(&l->prof_id, l, l->name, hf, hl, cyon_lock_now_ns() - t0);
+}
+
+void cyon_lock_acquire_at(cyon_lock_t *l, const char *file, int line) {
+    uint32_t z = 0;
+    if (__atomic_compare_exchange_n(&l->state, &z, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        cyon_lock_set_holder(l, file, line);
+        return;
+    }
+    cyon_lock_slow(l, file, line);
+}
+
+int cyon_lock_try_acquire_at(cyon_lock_t *l, const char *file, int line) {
+    if (!l) return EINVAL;
+    uint32_t z = 0;
+    if (!__atomic_compare_exchange_n(&l->state, &z, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return EBUSY;
+    cyon_lock_set_holder(l, file, line);
+    return 0;
+}
+
+void cyon_lock_release(cyon_lock_t *l) {
+    if (__atomic_fetch_sub(&l->state, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(&l->state, 0, __ATOMIC_RELEASE);
+        cyon_lock_futex_wake(&l->state, 1);
+    }
+}
+
+/* ---- condition variable for cyon_lock_t ----
+   A sequence word: waiters sleep on the value they saw before unlocking,
+   so a signal between unlock and sleep is never lost. */
+
+int cyon_lock_cond_wait(cyon_lock_cond_t *c, cyon_lock_t *l, int timeout_ms) {
+    if (!c || !l) return EINVAL;
+    uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+    const char *file = CYON_LOAD(&l->holder_file);
+    int line = CYON_LOAD(&l->holder_line);
+    cyon_lock_release(l);
+    int rc = cyon_lock_futex_wait(&c->seq, seq, timeout_ms < 0 ? -1 : (long long)timeout_ms * 1000000LL);
+    /* re-acquire as "contended" so the release after us wakes other parked waiters */
+    uint32_t s = __atomic_exchange_n(&l->state, 2, __ATOMIC_ACQUIRE);
+    while (s != 0) {
+        cyon_lock_futex_wait(&l->state, 2, -1);
+        s = __atomic_exchange_n(&l->state, 2, __ATOMIC_ACQUIRE);
+    }
+    cyon_lock_set_holder(l, file, line);
+    return rc;
+}
+
+int cyon_lock_cond_signal(cyon_lock_cond_t *c) {
+    if (!c) return EINVAL;
+    __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+    cyon_lock_futex_wake(&c->seq, 1);
+    return 0;
+}
+
+int cyon_lock_cond_broadcast(cyon_lock_cond_t *c) {
+    if (!c) return EINVAL;
+    __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+    cyon_lock_futex_wake(&c->seq, INT_MAX);
+    return 0;
+}
+
+/* ---- reader-writer lock ----
+   Writer-preferring: once a writer is waiting, new readers park, so a
+   steady stream of readers cannot starve writers. PARKED tells the
+   releasing side that someone is asleep on the state word. */
+
+#define CYON_RW_WRITER   0x80000000u
+#define CYON_RW_WWAIT    0x40000000u
+#define CYON_RW_PARKED   0x20000000u
+#define CYON_RW_READERS  0x1FFFFFFFu
+
+void cyon_rwlock_init(cyon_rwlock_t *l, const char *name) {
+    if (!l) return;
+    memset(l, 0, sizeof(*l));
+    l->name = name;
+}
+
+static int cyon_rw_try_read(cyon_rwlock_t *l) {
+    uint32_t s = CYON_LOAD(&l->state);
+    while (!(s & (CYON_RW_WRITER | CYON_RW_WWAIT)) && (s & CYON_RW_READERS) != CYON_RW_READERS) {
+        if (__atomic_compare_exchange_n(&l->state, &s, s + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+static int cyon_rw_try_write(cyon_rwlock_t *l) {
+    uint32_t s = CYON_LOAD(&l->state);
+    /* keep the flag bits: other waiters may still be parked */
+    while (!(s & (CYON_RW_WRITER | CYON_RW_READERS))) {
+        if (__atomic_compare_exchange_n(&l->state, &s, s | CYON_RW_WRITER, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+/* Spin with backoff, then park until the state word changes. */
+static void cyon_rw_slow(cyon_rwlock_t *l, int write, const char *file, int line) {
+    int prof = cyon_lock_profile_enabled();
+    const char *hf = prof ? CYON_LOAD(&l->holder_file) : NULL;
+    int hl = prof ? CYON_LOAD(&l->holder_line) : 0;
+    long long t0 = prof ? cyon_lock_now_ns() : 0;
+
+    for (int round = 0;; round++) {
+        if (write ? cyon_rw_try_write(l) : cyon_rw_try_read(l)) break;
+        if (round < CYON_LOCK_SPIN_ROUNDS) {
+            int spins = 1 << round;
+            if (spins > CYON_LOCK_SPIN_CAP) spins = CYON_LOCK_SPIN_CAP;
+            for (int i = 0; i < spins; i++) cyon_lock_pause();
+            continue;
+        }
+        uint32_t s = CYON_LOAD(&l->state);
+        uint32_t want;
+        if (write) {
+            if (!(s & (CYON_RW_WRITER | CYON_RW_READERS))) continue;
+            want = s | CYON_RW_WWAIT | CYON_RW_PARKED;
+        } else {
+            if (!(s & (CYON_RW_WRITER | CYON_RW_WWAIT))) continue;
+            want = s | CYON_RW_PARKED;
+        }
+        if (want != s &&
+            !__atomic_compare_exchange_n(&l->state, &s, want, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            continue;
+        cyon_lock_futex_wait(&l->state, want, -1);
+    }
+    if (write) {
+        CYON_STORE(&l->holder_file, file);
+        CYON_STORE(&l->holder_line, line);
+    }
+    if (prof) cyon_lock_prof_record(&l->prof_id, l, l->name, hf, hl, cyon_lock_now_ns() - t0);
+}
+
+void cyon_rwlock_read_lock_at(cyon_rwlock_t *l, const char *file, int line) {
+    if (cyon_rw_try_read(l)) return;
+    cyon_rw_slow(l, 0, file, line);
+}
+
+void cyon_rwlock_write_lock_at(cyon_rwlock_t *l, const char *file, int line) {
+    uint32_t z = 0;
+    if (__atomic_compare_exchange_n(&l->state, &z, CYON_RW_WRITER, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        CYON_STORE(&l->holder_file, file);
+        CYON_STORE(&l->holder_line, line);
+        return;
+    }
+    cyon_rw_slow(l, 1, file, line);
+}
+
+int cyon_rwlock_try_read_lock(cyon_rwlock_t *l) {
+    if (!l) return EINVAL;
+    return cyon_rw_try_read(l) ? 0 : EBUSY;
+}
+
+int cyon_rwlock_try_write_lock_at(cyon_rwlock_t *l, const char *file, int line) {
+    if (!l) return EINVAL;
+    if (!cyon_rw_try_write(l)) return EBUSY;
+    CYON_STORE(&l->holder_file, file);
+    CYON_STORE(&l->holder_line, line);
+    return 0;
+}
+
+void cyon_rwlock_read_unlock(cyon_rwlock_t *l) {
+    uint32_t s = __atomic_sub_fetch(&l->state, 1, __ATOMIC_RELEASE);
+    /* last reader out with sleepers: clear the flags and wake everyone;
+       waiters that still cannot proceed set them again */
+    while ((s & CYON_RW_PARKED) && !(s & (CYON_RW_READERS | CYON_RW_WRITER))) {
+        if (__atomic_compare_exchange_n(&l->state, &s, s & ~(CYON_RW_PARKED | CYON_RW_WWAIT), 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            cyon_lock_futex_wake(&l->state, INT_MAX);
+            return;
+        }
+    }
+}
+
+void cyon_rwlock_write_unlock(cyon_rwlock_t *l) {
+    uint32_t s = __atomic_exchange_n(&l->state, 0, __ATOMIC_RELEASE);
+    if (s & CYON_RW_PARKED) cyon_lock_futex_wake(&l->state, INT_MAX);
+}
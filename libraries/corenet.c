@@ -1,13 +1,30 @@
+#define _GNU_SOURCE
 #include "cyonstd.h"
+#include "cyonuring.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <linux/io_uring.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <linux/sock_diag.h>
 #include <arpa/inet.h>
 
 /* Create a TCP listening socket on host:port.
@@ -45,12 +62,105 @@ int cyon_tcp_listen(const char *host, const char *port, int backlog) {
     return errno ? errno : -1;
 }
 
+/* Bind and listen on one resolved address. Returns the fd or -errno. */
+static int cyon_tcp_bind_listen(const struct addrinfo *ai, const cyon_listen_opts_t *o) {
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | (o->nonblock ? SOCK_NONBLOCK : 0),
+                    ai->ai_protocol);
+    if (fd < 0) return -errno;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (o->reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+        int rc = errno;
+        close(fd);
+        return -rc;
+    }
+    /* the kernel caps the backlog at net.core.somaxconn */
+    int backlog = o->backlog > 0 ? o->backlog : 65535;
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, backlog) != 0) {
+        int rc = errno;
+        close(fd);
+        return -rc;
+    }
+    if (o->defer_accept_s > 0)
+        setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &o->defer_accept_s, sizeof(o->defer_accept_s));
+    return fd;
+}
+
+int cyon_tcp_listen_ex(const char *host, const char *port, const cyon_listen_opts_t *opts) {
+    cyon_listen_opts_t o;
+    memset(&o, 0, sizeof(o));
+    if (opts) o = *opts;
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    int rc = getaddrinfo(host, port ? port : "0", &hints, &res);
+    if (rc != 0) return rc == EAI_SYSTEM ? -errno : -EADDRNOTAVAIL;
+    int fd = -EADDRNOTAVAIL;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = cyon_tcp_bind_listen(ai, &o);
+        if (fd >= 0) break;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int cyon_tcp_listen_reuseport(const char *host, const char *port, const cyon_listen_opts_t *opts,
+                              int *fds, size_t n) {
+    if (!fds || n == 0 || n > INT_MAX) return -EINVAL;
+    cyon_listen_opts_t o;
+    memset(&o, 0, sizeof(o));
+    if (opts) o = *opts;
+    o.reuseport = 1;
+    char bound[16];
+    for (size_t i = 0; i < n; i++) {
+        int fd = cyon_tcp_listen_ex(host, port, &o);
+        if (fd < 0) {
+            while (i > 0) close(fds[--i]);
+            return fd;
+        }
+        fds[i] = fd;
+        if (i == 0) {
+            /* an ephemeral port: the rest must join the one the first got */
+            int p = cyon_socket_local_port(fd);
+            if (p > 0) {
+                snprintf(bound, sizeof(bound), "%d", p);
+                port = bound;
+            }
+        }
+    }
+    return (int)n;
+}
+
+int cyon_tcp_accept4(int listen_fd, int flags) {
+    if (listen_fd < 0) return -EINVAL;
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, flags);
+        if (fd >= 0) return fd;
+        /* gone before we got to it, or an error already reported to the
+           peer: neither concerns the listener */
+        if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) continue;
+        return -errno;
+    }
+}
+
+int cyon_socket_local_port(int fd) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if (getsockname(fd, (struct sockaddr*)&ss, &len) != 0) return -errno;
+    if (ss.ss_family == AF_INET) return ntohs(((struct sockaddr_in*)&ss)->sin_port);
+    if (ss.ss_family == AF_INET6) return ntohs(((struct sockaddr_in6*)&ss)->sin6_port);
+    return -EAFNOSUPPORT;
+}
+
 /* Accept connection on listening fd. Returns new fd or negative errno-like. */
 int cyon_tcp_accept(int listen_fd, char *peer_ip, size_t peer_ip_len, int *peer_port) {
     if (listen_fd < 0) return EINVAL;
     struct sockaddr_storage addr;
     socklen_t addrlen = sizeof(addr);
-    int cfd = accept(listen_fd, (struct sockaddr*)&addr, &addrlen);
+    int cfd = accept4(listen_fd, (struct sockaddr*)&addr, &addrlen, SOCK_CLOEXEC);
     if (cfd < 0) return errno ? errno : -1;
 
     if (peer_ip) {
@@ -105,15 +215,13 @@ int cyon_tcp_connect(const char *host, const char *port, int timeout_ms) {
             return sfd;
         } else {
             if (errno == EINPROGRESS && timeout_ms > 0) {
-                /* wait with select */
-                fd_set wf;
-                FD_ZERO(&wf);
-                FD_SET(sfd, &wf);
-                struct timeval tv;
-                tv.tv_sec = timeout_ms / 1000;
-                tv.tv_usec = (timeout_ms % 1000) * 1000;
-                int sel = select(sfd + 1, NULL, &wf, NULL, &tv);
-                if (sel > 0 && FD_ISSET(sfd, &wf)) {
+                /* wait with poll (select cannot take fds >= FD_SETSIZE) */
+                struct pollfd pf;
+                pf.fd = sfd;
+                pf.events = POLLOUT;
+                pf.revents = 0;
+                int sel = poll(&pf, 1, timeout_ms);
+                if (sel > 0) {
                     int err = 0;
                     socklen_t len = sizeof(err);
                     if (getsockopt(sfd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
@@ -178,4 +286,2686 @@ int cyon_socket_set_nonblocking(int fd, int nonblock) {
     else flags &= ~O_NONBLOCK;
     if (fcntl(fd, F_SETFL, flags) != 0) return errno ? errno : -1;
     return 0;
-}
\ No newline at end of file
+}
+
+/* ---- Outbound connection pool ---- */
+
+#define CYON_CONNPOOL_BUCKETS   64
+#define CYON_CONNPOOL_MAX_ADDRS 8
+
+typedef struct cyon_pool_host cyon_pool_host_t;
+
+struct cyon_pool_conn_s {
+    int fd;
+    int reused;
+    uint64_t idle_since_us;
+    cyon_pool_host_t *host;
+    cyon_pool_conn_t *next;         /* idle list */
+};
+
+struct cyon_pool_host {
+    char *key;                      /* "host:port" */
+    cyon_pool_conn_t *idle;         /* most recently released first */
+    size_t nidle;
+    size_t open;                    /* idle + leased + connecting */
+    struct sockaddr_storage addrs[CYON_CONNPOOL_MAX_ADDRS];
+    socklen_t addrlens[CYON_CONNPOOL_MAX_ADDRS];
+    size_t naddrs;
+    uint64_t dns_expires_us;
+    cyon_pool_host_t *next;
+};
+
+struct cyon_connpool_s {
+    cyon_connpool_opts_t opts;
+    pthread_mutex_t lock;
+    pthread_cond_t freed;
+    cyon_pool_host_t *buckets[CYON_CONNPOOL_BUCKETS];
+    cyon_connpool_stats_t st;
+};
+
+int cyon_connpool_create(cyon_connpool_t **out, const cyon_connpool_opts_t *opts) {
+    if (!out) return EINVAL;
+    cyon_connpool_t *p = (cyon_connpool_t*)calloc(1, sizeof(cyon_connpool_t));
+    if (!p) return ENOMEM;
+    if (opts) p->opts = *opts;
+    if (!p->opts.max_per_host) p->opts.max_per_host = 8;
+    if (!p->opts.max_idle_per_host || p->opts.max_idle_per_host > p->opts.max_per_host)
+        p->opts.max_idle_per_host = p->opts.max_per_host;
+    if (p->opts.idle_timeout_ms <= 0) p->opts.idle_timeout_ms = 60000;
+    if (p->opts.connect_timeout_ms <= 0) p->opts.connect_timeout_ms = 5000;
+    if (p->opts.wait_ms == 0) p->opts.wait_ms = p->opts.connect_timeout_ms;
+    if (p->opts.dns_ttl_ms == 0) p->opts.dns_ttl_ms = 30000;
+    if (p->opts.keepalive_idle_s == 0) p->opts.keepalive_idle_s = 30;
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&p->freed, &ca);
+    pthread_condattr_destroy(&ca);
+    pthread_mutex_init(&p->lock, NULL);
+    *out = p;
+    return 0;
+}
+
+void cyon_connpool_destroy(cyon_connpool_t *p) {
+    if (!p) return;
+    for (size_t i = 0; i < CYON_CONNPOOL_BUCKETS; i++) {
+        cyon_pool_host_t *h = p->buckets[i];
+        while (h) {
+            cyon_pool_host_t *hn = h->next;
+            cyon_pool_conn_t *c = h->idle;
+            while (c) {
+                cyon_pool_conn_t *cn = c->next;
+                close(c->fd);
+                free(c);
+                c = cn;
+            }
+            free(h->key);
+            free(h);
+            h = hn;
+        }
+    }
+    pthread_cond_destroy(&p->freed);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
+
+/* Find or add the entry for host:port. Called with the lock held. */
+static cyon_pool_host_t *cyon_pool_host_get(cyon_connpool_t *p, const char *host, const char *port) {
+    size_t hl = strlen(host), pl = strlen(port);
+    char *key = (char*)malloc(hl + pl + 2);
+    if (!key) return NULL;
+    memcpy(key, host, hl);
+    key[hl] = ':';
+    memcpy(key + hl + 1, port, pl + 1);
+    uint32_t b = cyon_fnv1a_32((const unsigned char*)key, hl + pl + 1) % CYON_CONNPOOL_BUCKETS;
+    for (cyon_pool_host_t *h = p->buckets[b]; h; h = h->next) {
+        if (strcmp(h->key, key) == 0) {
+            free(key);
+            return h;
+        }
+    }
+    cyon_pool_host_t *h = (cyon_pool_host_t*)calloc(1, sizeof(cyon_pool_host_t));
+    if (!h) {
+        free(key);
+        return NULL;
+    }
+    h->key = key;
+    h->next = p->buckets[b];
+    p->buckets[b] = h;
+    return h;
+}
+
+/* An idle connection is reusable when the peer has neither closed it nor
+   sent anything unsolicited, and the socket has no pending error. */
+static int cyon_pool_conn_healthy(int fd) {
+    struct pollfd pf;
+    pf.fd = fd;
+    pf.events = POLLIN;
+    pf.revents = 0;
+    if (poll(&pf, 1, 0) < 0) return 0;
+    if (pf.revents & (POLLERR | POLLHUP | POLLNVAL | POLLRDHUP)) return 0;
+    if (pf.revents & POLLIN) return 0;      /* EOF or stray bytes */
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) return 0;
+    return 1;
+}
+
+/* Blocking connect with a deadline. Returns the fd or -errno. */
+static int cyon_pool_connect_addr(const struct sockaddr *sa, socklen_t len, int timeout_ms, int keepalive_s) {
+    int fd = socket(sa->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -errno;
+    int rc = 0;
+    if (connect(fd, sa, len) != 0) {
+        if (errno != EINPROGRESS) {
+            rc = errno;
+        } else {
+            struct pollfd pf;
+            pf.fd = fd;
+            pf.events = POLLOUT;
+            pf.revents = 0;
+            int n;
+            do n = poll(&pf, 1, timeout_ms); while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                rc = errno;
+            } else if (n == 0) {
+                rc = ETIMEDOUT;
+            } else {
+                socklen_t el = sizeof(rc);
+                if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &rc, &el) != 0) rc = errno;
+            }
+        }
+    }
+    if (rc != 0) {
+        close(fd);
+        return -rc;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (keepalive_s > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &keepalive_s, sizeof(keepalive_s));
+    }
+    cyon_socket_set_nonblocking(fd, 0);
+    return fd;
+}
+
+/* Resolve host:port into h->addrs (outside the lock; the caller owns the
+   slot it reserved, the entry itself is never freed before the pool). */
+static int cyon_pool_resolve(cyon_connpool_t *p, cyon_pool_host_t *h, const char *host, const char *port) {
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+    int rc = getaddrinfo(host, port, &hints, &res);
+    pthread_mutex_lock(&p->lock);
+    p->st.dns_lookups++;
+    if (rc != 0) {
+        pthread_mutex_unlock(&p->lock);
+        return rc == EAI_SYSTEM ? errno : (rc == EAI_NONAME ? ENOENT : EAGAIN);
+    }
+    size_t n = 0;
+    for (struct addrinfo *ai = res; ai && n < CYON_CONNPOOL_MAX_ADDRS; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(struct sockaddr_storage)) continue;
+        memcpy(&h->addrs[n], ai->ai_addr, ai->ai_addrlen);
+        h->addrlens[n++] = ai->ai_addrlen;
+    }
+    h->naddrs = n;
+    h->dns_expires_us = p->opts.dns_ttl_ms > 0 ? cyon_time_monotonic_us() + (uint64_t)p->opts.dns_ttl_ms * 1000ULL : 0;
+    pthread_mutex_unlock(&p->lock);
+    freeaddrinfo(res);
+    return n ? 0 : ENOENT;
+}
+
+static void cyon_pool_slot_free(cyon_connpool_t *p, cyon_pool_host_t *h) {
+    h->open--;
+    pthread_cond_broadcast(&p->freed);
+}
+
+int cyon_connpool_acquire(cyon_connpool_t *p, const char *host, const char *port, cyon_pool_conn_t **out) {
+    if (!p || !host || !port || !out) return EINVAL;
+    uint64_t deadline = cyon_time_monotonic_us() + (uint64_t)(p->opts.wait_ms > 0 ? p->opts.wait_ms : 0) * 1000ULL;
+    pthread_mutex_lock(&p->lock);
+    cyon_pool_host_t *h = cyon_pool_host_get(p, host, port);
+    if (!h) {
+        pthread_mutex_unlock(&p->lock);
+        return ENOMEM;
+    }
+    for (;;) {
+        /* reuse the warmest idle connection that is still good; it keeps
+           its slot while it is checked without the lock */
+        while (h->idle) {
+            cyon_pool_conn_t *c = h->idle;
+            h->idle = c->next;
+            h->nidle--;
+            p->st.idle--;
+            uint64_t now = cyon_time_monotonic_us();
+            int fresh = now - c->idle_since_us < (uint64_t)p->opts.idle_timeout_ms * 1000ULL;
+            pthread_mutex_unlock(&p->lock);
+            if (fresh && cyon_pool_conn_healthy(c->fd)) {
+                c->reused = 1;
+                c->next = NULL;
+                pthread_mutex_lock(&p->lock);
+                p->st.reuses++;
+                p->st.leased++;
+                pthread_mutex_unlock(&p->lock);
+                *out = c;
+                return 0;
+            }
+            close(c->fd);
+            free(c);
+            pthread_mutex_lock(&p->lock);
+            p->st.dropped++;
+            cyon_pool_slot_free(p, h);
+        }
+        if (h->open < p->opts.max_per_host) break;
+        if (p->opts.wait_ms < 0) {
+            pthread_mutex_unlock(&p->lock);
+            return EAGAIN;
+        }
+        struct timespec ts;
+        ts.tv_sec = (time_t)(deadline / 1000000ULL);
+        ts.tv_nsec = (long)(deadline % 1000000ULL) * 1000L;
+        if (pthread_cond_timedwait(&p->freed, &p->lock, &ts) == ETIMEDOUT &&
+            !h->idle && h->open >= p->opts.max_per_host) {
+            pthread_mutex_unlock(&p->lock);
+            return ETIMEDOUT;
+        }
+    }
+    /* reserve a slot, then resolve and connect without the lock */
+    h->open++;
+    int cached = h->naddrs > 0 && cyon_time_monotonic_us() < h->dns_expires_us;
+    if (cached) p->st.dns_hits++;
+    pthread_mutex_unlock(&p->lock);
+
+    int rc = cached ? 0 : cyon_pool_resolve(p, h, host, port);
+    int fd = -ENOENT;
+    if (rc == 0) {
+        struct sockaddr_storage addrs[CYON_CONNPOOL_MAX_ADDRS];
+        socklen_t lens[CYON_CONNPOOL_MAX_ADDRS];
+        pthread_mutex_lock(&p->lock);
+        size_t n = h->naddrs;
+        memcpy(addrs, h->addrs, n * sizeof(addrs[0]));
+        memcpy(lens, h->addrlens, n * sizeof(lens[0]));
+        pthread_mutex_unlock(&p->lock);
+        for (size_t i = 0; i < n; i++) {
+            fd = cyon_pool_connect_addr((const struct sockaddr*)&addrs[i], lens[i],
+                                        p->opts.connect_timeout_ms, p->opts.keepalive_idle_s);
+            if (fd >= 0) break;
+        }
+        if (fd < 0) rc = -fd;
+    }
+    cyon_pool_conn_t *c = NULL;
+    if (rc == 0) {
+        c = (cyon_pool_conn_t*)calloc(1, sizeof(cyon_pool_conn_t));
+        if (!c) {
+            close(fd);
+            rc = ENOMEM;
+        }
+    }
+    pthread_mutex_lock(&p->lock);
+    if (rc != 0) {
+        /* the addresses may be stale: resolve again next time */
+        h->dns_expires_us = 0;
+        cyon_pool_slot_free(p, h);
+        pthread_mutex_unlock(&p->lock);
+        return rc;
+    }
+    c->fd = fd;
+    c->host = h;
+    p->st.connects++;
+    p->st.leased++;
+    pthread_mutex_unlock(&p->lock);
+    *out = c;
+    return 0;
+}
+
+void cyon_connpool_release(cyon_connpool_t *p, cyon_pool_conn_t *c, int reuse) {
+    if (!p || !c) return;
+    cyon_pool_host_t *h = c->host;
+    pthread_mutex_lock(&p->lock);
+    p->st.leased--;
+    if (reuse && h->nidle < p->opts.max_idle_per_host) {
+        c->idle_since_us = cyon_time_monotonic_us();
+        c->next = h->idle;
+        h->idle = c;
+        h->nidle++;
+        p->st.idle++;
+        pthread_cond_broadcast(&p->freed);
+        pthread_mutex_unlock(&p->lock);
+        return;
+    }
+    cyon_pool_slot_free(p, h);
+    pthread_mutex_unlock(&p->lock);
+    close(c->fd);
+    free(c);
+}
+
+int cyon_pool_conn_fd(const cyon_pool_conn_t *c) {
+    return c ? c->fd : -1;
+}
+
+int cyon_pool_conn_reused(const cyon_pool_conn_t *c) {
+    return c ? c->reused : 0;
+}
+
+size_t cyon_connpool_prune(cyon_connpool_t *p) {
+    if (!p) return 0;
+    uint64_t now = cyon_time_monotonic_us();
+    uint64_t limit = (uint64_t)p->opts.idle_timeout_ms * 1000ULL;
+    cyon_pool_conn_t *check = NULL, *expired = NULL, *bad = NULL;
+    /* take the idle lists out: expired connections go at once, the rest are
+       health-checked without the lock and the good ones put back */
+    pthread_mutex_lock(&p->lock);
+    for (size_t i = 0; i < CYON_CONNPOOL_BUCKETS; i++) {
+        for (cyon_pool_host_t *h = p->buckets[i]; h; h = h->next) {
+            while (h->idle) {
+                cyon_pool_conn_t *c = h->idle;
+                h->idle = c->next;
+                h->nidle--;
+                p->st.idle--;
+                if (now - c->idle_since_us >= limit) {
+                    p->st.dropped++;
+                    cyon_pool_slot_free(p, h);
+                    c->next = expired;
+                    expired = c;
+                } else {
+                    c->next = check;
+                    check = c;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    /* reversing once more restores most-recently-used order */
+    cyon_pool_conn_t *good = NULL;
+    while (check) {
+        cyon_pool_conn_t *c = check;
+        check = c->next;
+        cyon_pool_conn_t **list = cyon_pool_conn_healthy(c->fd) ? &good : &bad;
+        c->next = *list;
+        *list = c;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    while (good) {
+        cyon_pool_conn_t *c = good;
+        good = c->next;
+        cyon_pool_host_t *h = c->host;
+        if (h->nidle >= p->opts.max_idle_per_host) {
+            c->next = bad;
+            bad = c;
+            continue;
+        }
+        /* behind connections released meanwhile, which are warmer */
+        cyon_pool_conn_t **pp = &h->idle;
+        while (*pp) pp = &(*pp)->next;
+        c->next = NULL;
+        *pp = c;
+        h->nidle++;
+        p->st.idle++;
+    }
+    for (cyon_pool_conn_t *c = bad; c; c = c->next) {
+        p->st.dropped++;
+        cyon_pool_slot_free(p, c->host);
+    }
+    pthread_cond_broadcast(&p->freed);
+    pthread_mutex_unlock(&p->lock);
+
+    size_t n = 0;
+    cyon_pool_conn_t *lists[2] = { expired, bad };
+    for (int i = 0; i < 2; i++) {
+        while (lists[i]) {
+            cyon_pool_conn_t *c = lists[i];
+            lists[i] = c->next;
+            close(c->fd);
+            free(c);
+            n++;
+        }
+    }
+    return n;
+}
+
+void cyon_connpool_stats(cyon_connpool_t *p, cyon_connpool_stats_t *st) {
+    if (!p || !st) return;
+    pthread_mutex_lock(&p->lock);
+    *st = p->st;
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* ---- Reactor ----
+   Two backends behind the same callbacks.
+
+   epoll: every fd is registered once, edge-triggered. Connections are
+   registered for both directions up front, so a stalled writer costs no
+   epoll_ctl: EPOLLOUT simply fires when the socket drains. Reads go until
+   the kernel returns short (a new edge follows any later arrival), writes
+   go until EAGAIN.
+
+   io_uring: listeners keep one multishot accept and connections one
+   multishot recv armed; received data lands in a provided buffer ring
+   and is handed to on_data straight from there. Connection sockets are
+   installed in the fixed file table. Output written during an iteration
+   is coalesced into one send per connection, and every SQE queued in an
+   iteration goes to the kernel with the next wait, in one syscall.
+
+   Closed objects stay allocated until the end of the iteration (and, with
+   io_uring, until their last completion), so events already fetched for
+   them can be skipped safely. */
+
+#define CYON_REACTOR_MAX_EVENTS 256
+#define CYON_CONN_IN_INITIAL    16384
+#define CYON_CONN_IN_MIN_SPACE  4096
+#define CYON_CONN_IN_MAX        (1u << 20)
+#define CYON_URING_ENTRIES      256
+#define CYON_URING_FIXED_FILES  4096
+#define CYON_URING_BUF_COUNT    256
+#define CYON_URING_BUF_SIZE     16384
+#define CYON_URING_BGID         0
+#define CYON_URING_ACCEPT_RETRY_US 10000
+
+/* user_data = object pointer | tag */
+#define CYON_URING_TAG_MAIN 0ULL        /* recv, accept, poll */
+#define CYON_URING_TAG_SEND 1ULL
+#define CYON_URING_TAG_AUX  2ULL        /* fixed file install */
+#define CYON_URING_TAG_MASK 3ULL
+
+enum { CYON_IO_KIND_WAKE, CYON_IO_KIND_WATCH, CYON_IO_KIND_LISTEN, CYON_IO_KIND_CONN };
+
+typedef struct cyon_reactor_io {
+    int kind;
+    int fd;
+    int closed;
+    int inflight;                       /* io_uring requests not yet completed */
+    struct cyon_reactor_io *dead_next;
+} cyon_reactor_io_t;
+
+typedef struct {
+    cyon_reactor_io_t io;
+    cyon_io_cb cb;
+    void *user;
+    int events;
+} cyon_reactor_watch_t;
+
+typedef struct cyon_reactor_listener {
+    cyon_reactor_io_t io;
+    cyon_conn_handlers_t h;
+    void *user;
+    cyon_reactor_t *r;
+    int armed;
+    int exclusive;          /* io_uring: shared with other loops */
+    cyon_timer_t retry;
+    struct cyon_reactor_listener *next;
+} cyon_reactor_listener_t;
+
+/* File range queued with cyon_conn_sendfile; it goes out once the output
+   queued before it (at bytes into the stream) has been taken. */
+typedef struct cyon_conn_file {
+    int fd;
+    int own;
+    off_t off;
+    size_t left;
+    uint64_t at;
+    struct cyon_conn_file *next;
+} cyon_conn_file_t;
+
+struct cyon_conn_s {
+    cyon_reactor_io_t io;
+    cyon_reactor_t *r;
+    cyon_conn_handlers_t h;
+    void *user;
+    char *in;
+    size_t in_off, in_len, in_cap;
+    char *out;                          /* queued, not yet handed to the kernel */
+    size_t out_off, out_len, out_cap;
+    uint64_t out_total;                 /* bytes ever queued in out */
+    uint64_t out_taken;                 /* bytes ever removed from out */
+    cyon_conn_file_t *files;            /* sendfile segments, in order */
+    cyon_conn_file_t *files_tail;
+    size_t file_bytes;
+    char *wbuf;                         /* io_uring: send in flight */
+    size_t woff, wlen, wcap;
+    int file_wait;                      /* io_uring: polling for sendfile room */
+    int slot;                           /* io_uring fixed file slot or -1 */
+    int recv_armed;
+    int recv_paused;
+    int sending;
+    int reading;                        /* input is delivered */
+    int readable;                       /* epoll: unread input left in the socket */
+    int rdhup;                          /* epoll: peer shut down, read until EOF */
+    int eof;
+    int closing;                        /* close once output is flushed */
+    int err;                            /* deferred failure from a write */
+    int queued;                         /* on r->ready */
+    unsigned int timeout_ms;
+    cyon_timer_t idle;
+    cyon_conn_t *ready_next;
+    cyon_conn_t *prev, *next;           /* r->conns */
+};
+
+typedef struct cyon_reactor_post {
+    void (*fn)(cyon_reactor_t *r, void *arg);
+    void *arg;
+    struct cyon_reactor_post *next;
+} cyon_reactor_post_t;
+
+struct cyon_reactor_s {
+    int epfd;                           /* epoll backend */
+    cyon_uring_t *ring;                 /* io_uring backend */
+    cyon_reactor_io_t wake;             /* eventfd for posts */
+    cyon_timer_wheel_t *wheel;
+    cyon_reactor_watch_t **watches;     /* indexed by fd */
+    size_t nwatches;
+    cyon_reactor_listener_t *listeners;
+    cyon_conn_t *conns;
+    size_t nconns;
+    cyon_conn_t *ready;                 /* need work outside an event */
+    cyon_conn_t *ready_tail;
+    cyon_reactor_io_t *dead;            /* freed at the end of the iteration */
+    size_t zombies;                     /* closed, waiting for completions */
+    pthread_mutex_t post_lock;
+    cyon_reactor_post_t *posts;
+    cyon_reactor_post_t *posts_tail;
+    int exclusive;                      /* share listeners with other loops */
+    uint64_t syscalls;                  /* I/O calls outside io_uring_enter */
+    int stopping;
+    int stopped;
+    uint64_t stop_deadline_us;
+};
+
+static const int cyon_fd_none = -1;
+
+static void cyon_reactor_bury(cyon_reactor_t *r, cyon_reactor_io_t *io) {
+    io->dead_next = r->dead;
+    r->dead = io;
+}
+
+/* Mark io closed; free it once nothing in flight refers to it. */
+static void cyon_reactor_retire(cyon_reactor_t *r, cyon_reactor_io_t *io) {
+    io->closed = 1;
+    if (io->inflight == 0) cyon_reactor_bury(r, io);
+    else r->zombies++;
+}
+
+static void cyon_reactor_io_done(cyon_reactor_t *r, cyon_reactor_io_t *io) {
+    if (--io->inflight == 0 && io->closed && io->kind != CYON_IO_KIND_WAKE) {
+        r->zombies--;
+        cyon_reactor_bury(r, io);
+    }
+}
+
+static void cyon_reactor_free_io(cyon_reactor_io_t *io) {
+    if (io->kind == CYON_IO_KIND_CONN) {
+        cyon_conn_t *c = (cyon_conn_t*)io;
+        free(c->in);
+        free(c->out);
+        free(c->wbuf);
+    }
+    free(io);
+}
+
+static void cyon_reactor_reap(cyon_reactor_t *r) {
+    while (r->dead) {
+        cyon_reactor_io_t *io = r->dead;
+        r->dead = io->dead_next;
+        cyon_reactor_free_io(io);
+    }
+}
+
+/* io_uring: an SQE whose completion is routed to io (counted in flight). */
+static struct io_uring_sqe *cyon_reactor_sqe(cyon_reactor_t *r, cyon_reactor_io_t *io, uint64_t tag) {
+    struct io_uring_sqe *sqe = cyon_uring_sqe(r->ring);
+    if (!sqe) return NULL;
+    sqe->user_data = (uint64_t)(uintptr_t)io | tag;
+    io->inflight++;
+    return sqe;
+}
+
+/* io_uring: cancel the request(s) tagged (io, tag); no completion on success.
+   EBUSY when no SQE could be had even after flushing the queue. */
+static int cyon_reactor_cancel(cyon_reactor_t *r, cyon_reactor_io_t *io, uint64_t tag) {
+    struct io_uring_sqe *sqe = cyon_uring_sqe(r->ring);
+    if (!sqe) return EBUSY;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (uint64_t)(uintptr_t)io | tag;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    return 0;
+}
+
+static int cyon_epoll_to_io(uint32_t e) {
+    int m = 0;
+    if (e & (EPOLLIN | EPOLLRDHUP)) m |= CYON_IO_READ;
+    if (e & EPOLLOUT) m |= CYON_IO_WRITE;
+    if (e & EPOLLHUP) m |= CYON_IO_HUP;
+    if (e & EPOLLERR) m |= CYON_IO_ERR;
+    return m;
+}
+
+static void cyon_conn_schedule(cyon_conn_t *c) {
+    if (c->queued || c->io.closed) return;
+    c->queued = 1;
+    c->ready_next = NULL;
+    if (c->r->ready_tail) c->r->ready_tail->ready_next = c;
+    else c->r->ready = c;
+    c->r->ready_tail = c;
+}
+
+static void cyon_conn_touch(cyon_conn_t *c) {
+    if (c->timeout_ms)
+        cyon_timer_start(c->r->wheel, &c->idle, (uint64_t)c->timeout_ms * 1000, 0, CYON_TIMER_COARSE);
+}
+
+static int cyon_conn_flushed(const cyon_conn_t *c) {
+    return c->out_len == 0 && !c->files && !c->sending && c->woff == c->wlen;
+}
+
+/* Queued bytes that precede the next file segment. */
+static size_t cyon_conn_out_ready(const cyon_conn_t *c) {
+    return c->files ? (size_t)(c->files->at - c->out_taken) : c->out_len;
+}
+
+static void cyon_conn_file_pop(cyon_conn_t *c) {
+    cyon_conn_file_t *f = c->files;
+    c->files = f->next;
+    if (!c->files) c->files_tail = NULL;
+    c->file_bytes -= f->left;
+    if (f->own) close(f->fd);
+    free(f);
+}
+
+/* sendfile the head segment: 0 once it is fully sent, EAGAIN when the
+   socket is full, or an errno (EIO if the file ended early). */
+static int cyon_conn_file_step(cyon_conn_t *c) {
+    cyon_conn_file_t *f = c->files;
+    while (f->left > 0) {
+        c->r->syscalls++;
+        ssize_t n = sendfile(c->io.fd, f->fd, &f->off, f->left);
+        if (n > 0) {
+            f->left -= (size_t)n;
+            c->file_bytes -= (size_t)n;
+            continue;
+        }
+        if (n == 0) return EIO;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return EAGAIN;
+        return errno;
+    }
+    cyon_conn_file_pop(c);
+    return 0;
+}
+
+/* Unregister and close the socket, report on_close, free later. */
+static void cyon_conn_finish(cyon_conn_t *c, int err) {
+    cyon_reactor_t *r = c->r;
+    if (c->io.closed) return;
+    int stuck = 0;
+    if (r->ring) {
+        if (c->recv_armed && cyon_reactor_cancel(r, &c->io, CYON_URING_TAG_MAIN) != 0) stuck = 1;
+        if (c->sending && cyon_reactor_cancel(r, &c->io, CYON_URING_TAG_SEND) != 0) stuck = 1;
+        if (c->slot >= 0) {
+            struct io_uring_sqe *sqe = cyon_uring_sqe(r->ring);
+            if (sqe) {
+                sqe->opcode = IORING_OP_FILES_UPDATE;
+                sqe->addr = (uint64_t)(uintptr_t)&cyon_fd_none;
+                sqe->len = 1;
+                sqe->off = (uint64_t)c->slot;
+                sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+            }
+            cyon_uring_file_free(r->ring, c->slot);
+            c->slot = -1;
+        }
+    } else {
+        epoll_ctl(r->epfd, EPOLL_CTL_DEL, c->io.fd, NULL);
+    }
+    /* An uncancelled request keeps the file open past close(); shutdown
+       still sends the FIN and ends the request with a completion. */
+    if (stuck) shutdown(c->io.fd, SHUT_RDWR);
+    close(c->io.fd);
+    while (c->files) cyon_conn_file_pop(c);
+    cyon_timer_cancel(r->wheel, &c->idle);
+    if (c->prev) c->prev->next = c->next;
+    else r->conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    r->nconns--;
+    cyon_reactor_retire(r, &c->io);
+    if (c->h.on_close) c->h.on_close(c, err, c->user);
+}
+
+static void cyon_conn_deliver(cyon_conn_t *c) {
+    if (!c->h.on_data) {
+        c->in_off = c->in_len = 0;
+        return;
+    }
+    while (c->in_len > 0 && c->reading && !c->closing && !c->io.closed) {
+        size_t used = c->h.on_data(c, c->in + c->in_off, c->in_len, c->user);
+        if (c->io.closed) return;
+        if (used == 0) break;
+        if (used > c->in_len) used = c->in_len;
+        c->in_off += used;
+        c->in_len -= used;
+    }
+    if (c->in_len == 0) c->in_off = 0;
+}
+
+/* Make room for at least need more input bytes. */
+static int cyon_conn_in_reserve(cyon_conn_t *c, size_t need) {
+    if (c->in_off + c->in_len + need <= c->in_cap) return 0;
+    if (c->in_off) {
+        memmove(c->in, c->in + c->in_off, c->in_len);
+        c->in_off = 0;
+    }
+    if (c->in_len + need <= c->in_cap) return 0;
+    size_t cap = c->in_cap ? c->in_cap : CYON_CONN_IN_INITIAL;
+    while (cap < c->in_len + need) cap *= 2;
+    char *p = (char*)realloc(c->in, cap);
+    if (!p) return ENOMEM;
+    c->in = p;
+    c->in_cap = cap;
+    return 0;
+}
+
+/* ---- epoll backend ---- */
+
+static int cyon_conn_flush(cyon_conn_t *c) {
+    for (;;) {
+        size_t ready = cyon_conn_out_ready(c);
+        while (ready > 0) {
+            c->r->syscalls++;
+            ssize_t n = send(c->io.fd, c->out + c->out_off, ready, MSG_NOSIGNAL);
+            if (n > 0) {
+                c->out_off += (size_t)n;
+                c->out_len -= (size_t)n;
+                c->out_taken += (uint64_t)n;
+                ready -= (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+            return n < 0 ? errno : EIO;
+        }
+        if (c->out_len == 0) c->out_off = 0;
+        if (!c->files) return 0;
+        int rc = cyon_conn_file_step(c);
+        if (rc == EAGAIN) return 0;
+        if (rc != 0) return rc;
+    }
+}
+
+/* Read until short read, EOF, error or a full buffer (sets readable). */
+static int cyon_conn_fill(cyon_conn_t *c) {
+    c->readable = 0;
+    for (;;) {
+        if (c->in_off + c->in_len + CYON_CONN_IN_MIN_SPACE > c->in_cap) {
+            if (c->in_len + CYON_CONN_IN_MIN_SPACE > c->in_cap && c->in_cap >= CYON_CONN_IN_MAX) {
+                c->readable = 1;
+                return 0;
+            }
+            int rc = cyon_conn_in_reserve(c, CYON_CONN_IN_MIN_SPACE);
+            if (rc != 0) return rc;
+        }
+        size_t space = c->in_cap - c->in_off - c->in_len;
+        c->r->syscalls++;
+        ssize_t n = recv(c->io.fd, c->in + c->in_off + c->in_len, space, 0);
+        if (n > 0) {
+            c->in_len += (size_t)n;
+            /* a short read drains the socket, but after RDHUP no further
+               edge will come to report the EOF */
+            if ((size_t)n < space && !c->rdhup) return 0;
+            continue;
+        }
+        if (n == 0) {
+            c->eof = 1;
+            return 0;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+        return errno;
+    }
+}
+
+static void cyon_conn_on_readable(cyon_conn_t *c) {
+    if (!c->reading || c->closing) {
+        c->readable = 1;
+        return;
+    }
+    for (;;) {
+        int err = cyon_conn_fill(c);
+        size_t before = c->in_len;
+        if (c->in_len) cyon_conn_touch(c);
+        cyon_conn_deliver(c);
+        if (c->io.closed) return;
+        if (err) {
+            cyon_conn_finish(c, err);
+            return;
+        }
+        if (!c->readable || !c->reading || c->closing) break;
+        /* buffer was full: keep going only if the handler made room */
+        if (c->in_len == before) {
+            cyon_conn_finish(c, ENOBUFS);
+            return;
+        }
+    }
+    if (c->eof && !c->closing) cyon_conn_close(c);
+}
+
+static void cyon_conn_on_writable(cyon_conn_t *c) {
+    if (c->out_len == 0 && !c->files) return;
+    int err = cyon_conn_flush(c);
+    if (err) {
+        cyon_conn_finish(c, err);
+        return;
+    }
+    cyon_conn_touch(c);
+    if (c->out_len > 0 || c->files) return;
+    if (c->closing) cyon_conn_finish(c, 0);
+    else if (c->h.on_drain) c->h.on_drain(c, c->user);
+}
+
+/* ---- io_uring backend ---- */
+
+static void cyon_conn_target(const cyon_conn_t *c, struct io_uring_sqe *sqe) {
+    if (c->slot >= 0) {
+        sqe->fd = c->slot;
+        sqe->flags |= IOSQE_FIXED_FILE;
+    } else {
+        sqe->fd = c->io.fd;
+    }
+}
+
+static void cyon_conn_arm_recv(cyon_conn_t *c) {
+    struct io_uring_sqe *sqe = cyon_reactor_sqe(c->r, &c->io, CYON_URING_TAG_MAIN);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECV;
+    cyon_conn_target(c, sqe);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = CYON_URING_BGID;
+    c->recv_armed = 1;
+}
+
+/* Hand the next run of queued output to the kernel. File segments go out
+   with sendfile (io_uring has no equivalent op); when the socket is full
+   a one-shot poll waits for room. */
+static void cyon_conn_send_next(cyon_conn_t *c) {
+    while (c->woff == c->wlen) {
+        size_t n = cyon_conn_out_ready(c);
+        if (n > 0 && n == c->out_len) {
+            char *b = c->wbuf;
+            size_t cap = c->wcap;
+            c->wbuf = c->out;
+            c->wcap = c->out_cap;
+            c->woff = c->out_off;
+            c->wlen = c->out_off + c->out_len;
+            c->out = b;
+            c->out_cap = cap;
+            c->out_off = c->out_len = 0;
+            c->out_taken += n;
+            break;
+        }
+        if (n > 0) {
+            /* only the part ahead of a file segment */
+            if (n > c->wcap) {
+                char *b = (char*)realloc(c->wbuf, n);
+                if (!b) {
+                    c->err = ENOMEM;
+                    cyon_conn_schedule(c);
+                    return;
+                }
+                c->wbuf = b;
+                c->wcap = n;
+            }
+            memcpy(c->wbuf, c->out + c->out_off, n);
+            c->woff = 0;
+            c->wlen = n;
+            c->out_off += n;
+            c->out_len -= n;
+            c->out_taken += n;
+            break;
+        }
+        if (!c->files) return;
+        int rc = cyon_conn_file_step(c);
+        if (rc == 0) continue;
+        if (rc != EAGAIN) {
+            c->err = rc;
+            cyon_conn_schedule(c);
+            return;
+        }
+        struct io_uring_sqe *sqe = cyon_reactor_sqe(c->r, &c->io, CYON_URING_TAG_SEND);
+        if (!sqe) {
+            cyon_conn_schedule(c);
+            return;
+        }
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = c->io.fd;
+        sqe->poll32_events = POLLOUT;
+        c->sending = 1;
+        c->file_wait = 1;
+        return;
+    }
+    struct io_uring_sqe *sqe = cyon_reactor_sqe(c->r, &c->io, CYON_URING_TAG_SEND);
+    if (!sqe) {
+        cyon_conn_schedule(c);
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    cyon_conn_target(c, sqe);
+    sqe->addr = (uint64_t)(uintptr_t)(c->wbuf + c->woff);
+    sqe->len = (unsigned)((c->wlen - c->woff) > 0x7fffffff ? 0x7fffffff : c->wlen - c->woff);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    c->sending = 1;
+}
+
+/* Input from a provided buffer: offered to on_data in place when nothing
+   is buffered, copied into the connection buffer otherwise. */
+static void cyon_conn_ingest(cyon_conn_t *c, const char *data, size_t n) {
+    cyon_conn_touch(c);
+    if (!c->h.on_data || c->closing) return;
+    if (c->in_len == 0 && c->reading) {
+        while (n > 0) {
+            size_t used = c->h.on_data(c, data, n, c->user);
+            if (c->io.closed || c->closing) return;
+            if (used == 0) break;
+            if (used > n) used = n;
+            data += used;
+            n -= used;
+            if (!c->reading) break;
+        }
+        if (n == 0) return;
+    }
+    if (cyon_conn_in_reserve(c, n) != 0) {
+        cyon_conn_finish(c, ENOMEM);
+        return;
+    }
+    memcpy(c->in + c->in_off + c->in_len, data, n);
+    c->in_len += n;
+    if (c->reading) cyon_conn_deliver(c);
+    if (c->io.closed || c->in_len < CYON_CONN_IN_MAX) return;
+    if (c->reading) {
+        cyon_conn_finish(c, ENOBUFS);
+    } else if (c->recv_armed && !c->recv_paused) {
+        /* no SQE: tried again on the next ingest */
+        if (cyon_reactor_cancel(c->r, &c->io, CYON_URING_TAG_MAIN) == 0) c->recv_paused = 1;
+    }
+}
+
+static void cyon_conn_on_recv(cyon_conn_t *c, const struct io_uring_cqe *cqe) {
+    cyon_reactor_t *r = c->r;
+    if (!(cqe->flags & IORING_CQE_F_MORE)) c->recv_armed = 0;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        if (cqe->res > 0 && !c->io.closed)
+            cyon_conn_ingest(c, (const char*)cyon_uring_buf(r->ring, bid), (size_t)cqe->res);
+        cyon_uring_buf_recycle(r->ring, bid);
+    }
+    if (c->io.closed) return;
+    if (cqe->res == 0) {
+        c->eof = 1;
+        if (c->reading && !c->closing) cyon_conn_close(c);
+    } else if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECANCELED) {
+        cyon_conn_finish(c, -cqe->res);
+    } else if (!c->recv_armed) {
+        cyon_conn_schedule(c);      /* re-arm once buffers are back */
+    }
+}
+
+static void cyon_conn_on_sent(cyon_conn_t *c, int res) {
+    int polled = c->file_wait;
+    c->sending = 0;
+    c->file_wait = 0;
+    if (c->io.closed) return;
+    if (res < 0) {
+        cyon_conn_finish(c, -res);
+        return;
+    }
+    cyon_conn_touch(c);
+    if (!polled) {
+        c->woff += (size_t)res;
+        if (c->woff == c->wlen) c->woff = c->wlen = 0;
+    }
+    cyon_conn_send_next(c);
+    if (c->sending || c->err || !cyon_conn_flushed(c)) return;
+    if (c->closing) cyon_conn_finish(c, 0);
+    else if (c->h.on_drain) c->h.on_drain(c, c->user);
+}
+
+static void cyon_reactor_arm_poll(cyon_reactor_t *r, cyon_reactor_io_t *io, unsigned events) {
+    struct io_uring_sqe *sqe = cyon_reactor_sqe(r, io, CYON_URING_TAG_MAIN);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = io->fd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = events;
+}
+
+/* A listener shared by several loops waits with a one-shot EPOLLEXCLUSIVE
+   poll and then accepts the backlog itself: a multishot accept per loop
+   would wake every loop for each connection. */
+static void cyon_reactor_arm_accept(cyon_reactor_t *r, cyon_reactor_listener_t *l) {
+    struct io_uring_sqe *sqe = cyon_reactor_sqe(r, &l->io, CYON_URING_TAG_MAIN);
+    if (!sqe) return;
+    l->armed = 1;
+    if (l->exclusive) {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = l->io.fd;
+        sqe->poll32_events = POLLIN | EPOLLEXCLUSIVE;
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = l->io.fd;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+}
+
+static int cyon_reactor_accept(cyon_reactor_t *r, cyon_reactor_listener_t *l);
+
+/* Accepting failed (EMFILE and the like): io_uring re-arms; epoll drains
+   the backlog again, since an edge-triggered listener gets no new event
+   for connections that are already queued. */
+static void cyon_reactor_accept_retry(cyon_timer_t *t, void *user) {
+    (void)t;
+    cyon_reactor_listener_t *l = (cyon_reactor_listener_t*)user;
+    cyon_reactor_t *r = l->r;
+    if (l->io.closed || r->stopping) return;
+    if (r->ring) {
+        if (!l->armed) cyon_reactor_arm_accept(r, l);
+    } else if (cyon_reactor_accept(r, l) != 0) {
+        cyon_timer_start(r->wheel, &l->retry, CYON_URING_ACCEPT_RETRY_US, 0, 0);
+    }
+}
+
+static void cyon_reactor_run_posts(cyon_reactor_t *r);
+
+static void cyon_reactor_complete(cyon_reactor_t *r, const struct io_uring_cqe *cqe) {
+    if (cqe->user_data == 0) return;
+    cyon_reactor_io_t *io = (cyon_reactor_io_t*)(uintptr_t)(cqe->user_data & ~CYON_URING_TAG_MASK);
+    uint64_t tag = cqe->user_data & CYON_URING_TAG_MASK;
+    int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    switch (io->kind) {
+    case CYON_IO_KIND_WAKE:
+        cyon_reactor_run_posts(r);
+        if (!more) {
+            io->inflight--;
+            cyon_reactor_arm_poll(r, io, POLLIN);
+        }
+        return;
+    case CYON_IO_KIND_WATCH: {
+        cyon_reactor_watch_t *w = (cyon_reactor_watch_t*)io;
+        if (!io->closed && cqe->res > 0) w->cb(r, io->fd, cyon_epoll_to_io((uint32_t)cqe->res), w->user);
+        if (!more && !io->closed) {
+            io->inflight--;
+            cyon_reactor_arm_poll(r, io, (unsigned)w->events);
+            return;
+        }
+        break;
+    }
+    case CYON_IO_KIND_LISTEN: {
+        cyon_reactor_listener_t *l = (cyon_reactor_listener_t*)io;
+        if (l->exclusive) {
+            int err = 0;
+            if (!io->closed && !r->stopping && cqe->res > 0) err = cyon_reactor_accept(r, l);
+            l->armed = 0;
+            /* the poll is level-triggered: re-arming while stopping would
+               fire again at once */
+            if (!io->closed && !r->stopping) {
+                if (err || (cqe->res < 0 && cqe->res != -ECANCELED))
+                    cyon_timer_start(r->wheel, &l->retry, CYON_URING_ACCEPT_RETRY_US, 0, 0);
+                else
+                    cyon_reactor_arm_accept(r, l);
+            }
+            break;
+        }
+        if (cqe->res >= 0) {
+            if (io->closed || r->stopping) close(cqe->res);
+            else cyon_reactor_adopt(r, cqe->res, &l->h, l->user, NULL);
+        }
+        if (!more) {
+            l->armed = 0;
+            /* an error ends the multishot; back off briefly before re-arming */
+            if (!io->closed) {
+                if (cqe->res < 0 && cqe->res != -ECANCELED)
+                    cyon_timer_start(r->wheel, &l->retry, CYON_URING_ACCEPT_RETRY_US, 0, 0);
+                else
+                    cyon_reactor_arm_accept(r, l);
+            }
+        }
+        break;
+    }
+    case CYON_IO_KIND_CONN: {
+        cyon_conn_t *c = (cyon_conn_t*)io;
+        if (tag == CYON_URING_TAG_SEND) {
+            cyon_conn_on_sent(c, cqe->res);
+        } else if (tag == CYON_URING_TAG_AUX) {
+            if (cqe->res < 0 && !io->closed) cyon_conn_finish(c, -cqe->res);
+        } else {
+            cyon_conn_on_recv(c, cqe);
+        }
+        break;
+    }
+    }
+    if (!more) cyon_reactor_io_done(r, io);
+}
+
+/* Work deferred out of callbacks: write failures, closes with nothing
+   left to flush, reading resumed after a pause and, with io_uring,
+   pending sends and recv re-arms. */
+static void cyon_reactor_run_ready(cyon_reactor_t *r) {
+    while (r->ready) {
+        cyon_conn_t *c = r->ready;
+        r->ready = c->ready_next;
+        if (!r->ready) r->ready_tail = NULL;
+        c->queued = 0;
+        if (c->io.closed) continue;
+        if (c->err) {
+            cyon_conn_finish(c, c->err);
+        } else if (c->closing && cyon_conn_flushed(c)) {
+            cyon_conn_finish(c, 0);
+        } else if (r->ring) {
+            if (!c->sending) cyon_conn_send_next(c);
+            if (c->reading && c->in_len && !c->closing) cyon_conn_deliver(c);
+            if (c->io.closed) continue;
+            if (c->eof) {
+                if (c->reading && !c->closing) cyon_conn_close(c);
+            } else if (!c->recv_armed && !c->closing && (c->reading || c->in_len < CYON_CONN_IN_MAX)) {
+                c->recv_paused = 0;
+                cyon_conn_arm_recv(c);
+            }
+        } else if (c->readable && c->reading) {
+            cyon_conn_on_readable(c);
+        }
+    }
+}
+
+int cyon_conn_write(cyon_conn_t *c, const void *data, size_t len) {
+    if (!c || (!data && len)) return EINVAL;
+    if (c->io.closed || c->closing || c->err) return EPIPE;
+    if (len == 0) return 0;
+    const char *p = (const char*)data;
+    if (!c->r->ring && c->out_len == 0 && !c->files) {
+        while (len > 0) {
+            c->r->syscalls++;
+            ssize_t n = send(c->io.fd, p, len, MSG_NOSIGNAL);
+            if (n > 0) {
+                p += n;
+                len -= (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            c->err = n < 0 ? errno : EIO;
+            cyon_conn_schedule(c);
+            return c->err;
+        }
+        cyon_conn_touch(c);
+        if (len == 0) return 0;
+    }
+    if (c->out_off + c->out_len + len > c->out_cap) {
+        if (c->out_off) {
+            memmove(c->out, c->out + c->out_off, c->out_len);
+            c->out_off = 0;
+        }
+        if (c->out_len + len > c->out_cap) {
+            size_t cap = c->out_cap ? c->out_cap : 4096;
+            while (cap < c->out_len + len) cap *= 2;
+            char *q = (char*)realloc(c->out, cap);
+            if (!q) return ENOMEM;
+            c->out = q;
+            c->out_cap = cap;
+        }
+    }
+    memcpy(c->out + c->out_off + c->out_len, p, len);
+    c->out_len += len;
+    c->out_total += len;
+    if (c->r->ring && !c->sending) cyon_conn_schedule(c);
+    return 0;
+}
+
+int cyon_conn_sendfile(cyon_conn_t *c, int file_fd, off_t offset, size_t count, int close_fd) {
+    if (file_fd < 0) return EINVAL;
+    /* once handed over, file_fd is closed on every failure */
+    int rc = 0;
+    if (!c || offset < 0) {
+        rc = EINVAL;
+    } else if (c->io.closed || c->closing || c->err) {
+        rc = EPIPE;
+    } else if (count == 0) {
+        struct stat st;
+        if (fstat(file_fd, &st) != 0) {
+            rc = errno;
+        } else if (st.st_size <= offset) {
+            if (close_fd) close(file_fd);
+            return 0;
+        } else {
+            count = (size_t)(st.st_size - offset);
+        }
+    }
+    cyon_conn_file_t *f = rc == 0 ? (cyon_conn_file_t*)malloc(sizeof(cyon_conn_file_t)) : NULL;
+    if (!f) {
+        if (close_fd) close(file_fd);
+        return rc ? rc : ENOMEM;
+    }
+    f->fd = file_fd;
+    f->own = close_fd != 0;
+    f->off = offset;
+    f->left = count;
+    f->at = c->out_total;
+    f->next = NULL;
+    if (c->files_tail) c->files_tail->next = f;
+    else c->files = f;
+    c->files_tail = f;
+    c->file_bytes += count;
+    if (c->r->ring) {
+        if (!c->sending) cyon_conn_schedule(c);
+    } else if (c->out_len == 0 && c->files == f) {
+        rc = cyon_conn_flush(c);
+        if (rc != 0) {
+            c->err = rc;
+            cyon_conn_schedule(c);
+            return rc;
+        }
+        cyon_conn_touch(c);
+    }
+    return 0;
+}
+
+int cyon_conn_close(cyon_conn_t *c) {
+    if (!c) return EINVAL;
+    if (c->io.closed || c->closing) return 0;
+    c->closing = 1;
+    if (cyon_conn_flushed(c)) cyon_conn_schedule(c);
+    return 0;
+}
+
+int cyon_conn_abort(cyon_conn_t *c, int err) {
+    if (!c) return EINVAL;
+    cyon_conn_finish(c, err);
+    return 0;
+}
+
+int cyon_conn_set_timeout(cyon_conn_t *c, unsigned int ms) {
+    if (!c) return EINVAL;
+    if (c->io.closed) return EPIPE;
+    c->timeout_ms = ms;
+    if (ms) cyon_conn_touch(c);
+    else cyon_timer_cancel(c->r->wheel, &c->idle);
+    return 0;
+}
+
+int cyon_conn_set_reading(cyon_conn_t *c, int on) {
+    if (!c) return EINVAL;
+    c->reading = on != 0;
+    if (!c->reading) return 0;
+    if (c->r->ring) {
+        cyon_conn_schedule(c);
+    } else if (c->readable || c->in_len) {
+        c->readable = 1;
+        cyon_conn_schedule(c);
+    }
+    return 0;
+}
+
+int cyon_conn_fd(const cyon_conn_t *c) { return c ? c->io.fd : -1; }
+cyon_reactor_t *cyon_conn_reactor(const cyon_conn_t *c) { return c ? c->r : NULL; }
+void *cyon_conn_user(const cyon_conn_t *c) { return c ? c->user : NULL; }
+void cyon_conn_set_user(cyon_conn_t *c, void *user) { if (c) c->user = user; }
+size_t cyon_conn_pending_output(const cyon_conn_t *c) {
+    return c ? c->out_len + (c->wlen - c->woff) + c->file_bytes : 0;
+}
+
+static void cyon_conn_on_idle(cyon_timer_t *t, void *user) {
+    (void)t;
+    cyon_conn_finish((cyon_conn_t*)user, ETIMEDOUT);
+}
+
+int cyon_reactor_adopt(cyon_reactor_t *r, int fd, const cyon_conn_handlers_t *h, void *user, cyon_conn_t **out) {
+    if (!r || fd < 0 || !h) return EINVAL;
+    if (r->stopping) {
+        close(fd);
+        return ECANCELED;
+    }
+    int rc = cyon_socket_set_nonblocking(fd, 1);
+    if (rc != 0) {
+        close(fd);
+        return rc;
+    }
+    cyon_conn_t *c = (cyon_conn_t*)calloc(1, sizeof(cyon_conn_t));
+    if (!c) {
+        close(fd);
+        return ENOMEM;
+    }
+    c->io.kind = CYON_IO_KIND_CONN;
+    c->io.fd = fd;
+    c->r = r;
+    c->h = *h;
+    c->user = user;
+    c->reading = 1;
+    c->slot = -1;
+    cyon_timer_init(&c->idle, cyon_conn_on_idle, c);
+    if (r->ring) {
+        /* install in the fixed table ahead of the first recv; the SQE reads
+           c->io.fd at submit time, so it holds the connection alive */
+        int slot = cyon_uring_file_alloc(r->ring);
+        if (slot >= 0) {
+            struct io_uring_sqe *sqe = cyon_reactor_sqe(r, &c->io, CYON_URING_TAG_AUX);
+            if (sqe) {
+                sqe->opcode = IORING_OP_FILES_UPDATE;
+                sqe->addr = (uint64_t)(uintptr_t)&c->io.fd;
+                sqe->len = 1;
+                sqe->off = (uint64_t)slot;
+                c->slot = slot;
+            } else {
+                cyon_uring_file_free(r->ring, slot);
+            }
+        }
+        cyon_conn_schedule(c);
+    } else {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = &c->io;
+        if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            rc = errno;
+            close(fd);
+            free(c);
+            return rc;
+        }
+    }
+    c->next = r->conns;
+    if (r->conns) r->conns->prev = c;
+    r->conns = c;
+    r->nconns++;
+    if (out) *out = c;
+    if (c->h.on_open) c->h.on_open(c, c->user);
+    return 0;
+}
+
+/* Drain the backlog. Returns 0 once it is empty, or the errno (EMFILE
+   and similar) that stopped it; on epoll the rest then waits for the next
+   connection to raise a new edge. */
+static int cyon_reactor_accept(cyon_reactor_t *r, cyon_reactor_listener_t *l) {
+    while (!l->io.closed) {
+        r->syscalls++;
+        int fd = accept4(l->io.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : errno;
+        }
+        cyon_reactor_adopt(r, fd, &l->h, l->user, NULL);
+    }
+    return 0;
+}
+
+static int cyon_reactor_listen_ex(cyon_reactor_t *r, int listen_fd, const cyon_conn_handlers_t *h,
+                                  void *user, int exclusive) {
+    if (!r || listen_fd < 0 || !h) return EINVAL;
+    if (r->stopping) return ECANCELED;
+    int rc = cyon_socket_set_nonblocking(listen_fd, 1);
+    if (rc != 0) return rc;
+    cyon_reactor_listener_t *l = (cyon_reactor_listener_t*)calloc(1, sizeof(cyon_reactor_listener_t));
+    if (!l) return ENOMEM;
+    l->io.kind = CYON_IO_KIND_LISTEN;
+    l->io.fd = listen_fd;
+    l->h = *h;
+    l->user = user;
+    l->r = r;
+    l->exclusive = exclusive;
+    cyon_timer_init(&l->retry, cyon_reactor_accept_retry, l);
+    if (r->ring) {
+        cyon_reactor_arm_accept(r, l);
+        if (!l->armed) {
+            free(l);
+            return EBUSY;
+        }
+    } else {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLET | (exclusive ? EPOLLEXCLUSIVE : 0);
+        ev.data.ptr = &l->io;
+        if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, listen_fd, &ev) != 0) {
+            rc = errno;
+            free(l);
+            return rc;
+        }
+    }
+    l->next = r->listeners;
+    r->listeners = l;
+    return 0;
+}
+
+int cyon_reactor_listen(cyon_reactor_t *r, int listen_fd, const cyon_conn_handlers_t *h, void *user) {
+    return cyon_reactor_listen_ex(r, listen_fd, h, user, r ? r->exclusive : 0);
+}
+
+static void cyon_reactor_close_listener(cyon_reactor_t *r, cyon_reactor_listener_t *l) {
+    if (r->ring) {
+        if (l->armed) cyon_reactor_cancel(r, &l->io, CYON_URING_TAG_MAIN);
+    } else {
+        epoll_ctl(r->epfd, EPOLL_CTL_DEL, l->io.fd, NULL);
+    }
+    cyon_timer_cancel(r->wheel, &l->retry);
+    cyon_reactor_retire(r, &l->io);
+}
+
+int cyon_reactor_watch(cyon_reactor_t *r, int fd, int events, cyon_io_cb cb, void *user) {
+    if (!r || fd < 0 || !cb) return EINVAL;
+    if ((size_t)fd >= r->nwatches) {
+        size_t n = r->nwatches ? r->nwatches : 64;
+        while (n <= (size_t)fd) n *= 2;
+        cyon_reactor_watch_t **p = (cyon_reactor_watch_t**)realloc(r->watches, n * sizeof(*p));
+        if (!p) return ENOMEM;
+        memset(p + r->nwatches, 0, (n - r->nwatches) * sizeof(*p));
+        r->watches = p;
+        r->nwatches = n;
+    }
+    if (r->watches[fd]) return EEXIST;
+    cyon_reactor_watch_t *w = (cyon_reactor_watch_t*)calloc(1, sizeof(cyon_reactor_watch_t));
+    if (!w) return ENOMEM;
+    w->io.kind = CYON_IO_KIND_WATCH;
+    w->io.fd = fd;
+    w->cb = cb;
+    w->user = user;
+    uint32_t mask = 0;
+    if (events & CYON_IO_READ) mask |= EPOLLIN | EPOLLRDHUP;
+    if (events & CYON_IO_WRITE) mask |= EPOLLOUT;
+    w->events = (int)mask;
+    if (r->ring) {
+        /* multishot poll reports each new readiness, like EPOLLET */
+        cyon_reactor_arm_poll(r, &w->io, mask);
+        if (w->io.inflight == 0) {
+            free(w);
+            return EBUSY;
+        }
+    } else {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = mask | EPOLLET;
+        ev.data.ptr = &w->io;
+        if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            int rc = errno;
+            free(w);
+            return rc;
+        }
+    }
+    r->watches[fd] = w;
+    return 0;
+}
+
+int cyon_reactor_unwatch(cyon_reactor_t *r, int fd) {
+    if (!r || fd < 0 || (size_t)fd >= r->nwatches || !r->watches[fd]) return ENOENT;
+    cyon_reactor_watch_t *w = r->watches[fd];
+    r->watches[fd] = NULL;
+    if (r->ring) {
+        struct io_uring_sqe *sqe = cyon_uring_sqe(r->ring);
+        if (sqe) {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->addr = (uint64_t)(uintptr_t)&w->io;
+            sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        }
+    } else {
+        epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, NULL);
+    }
+    cyon_reactor_retire(r, &w->io);
+    return 0;
+}
+
+int cyon_reactor_post(cyon_reactor_t *r, void (*fn)(cyon_reactor_t *r, void *arg), void *arg) {
+    if (!r || !fn) return EINVAL;
+    cyon_reactor_post_t *p = (cyon_reactor_post_t*)malloc(sizeof(cyon_reactor_post_t));
+    if (!p) return ENOMEM;
+    p->fn = fn;
+    p->arg = arg;
+    p->next = NULL;
+    pthread_mutex_lock(&r->post_lock);
+    int was_empty = r->posts == NULL;
+    if (r->posts_tail) r->posts_tail->next = p;
+    else r->posts = p;
+    r->posts_tail = p;
+    pthread_mutex_unlock(&r->post_lock);
+    if (was_empty) {
+        uint64_t one = 1;
+        while (write(r->wake.fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    }
+    return 0;
+}
+
+static void cyon_reactor_run_posts(cyon_reactor_t *r) {
+    uint64_t v;
+    while (read(r->wake.fd, &v, sizeof(v)) < 0 && errno == EINTR) {}
+    pthread_mutex_lock(&r->post_lock);
+    cyon_reactor_post_t *p = r->posts;
+    r->posts = r->posts_tail = NULL;
+    pthread_mutex_unlock(&r->post_lock);
+    while (p) {
+        cyon_reactor_post_t *next = p->next;
+        p->fn(r, p->arg);
+        free(p);
+        p = next;
+    }
+}
+
+static void cyon_reactor_begin_stop(cyon_reactor_t *r, void *arg) {
+    if (r->stopping) return;
+    int grace_ms = (int)(intptr_t)arg;
+    r->stopping = 1;
+    r->stop_deadline_us = cyon_time_monotonic_us() + (uint64_t)(grace_ms > 0 ? grace_ms : 0) * 1000;
+    while (r->listeners) {
+        cyon_reactor_listener_t *l = r->listeners;
+        r->listeners = l->next;
+        cyon_reactor_close_listener(r, l);
+    }
+    for (cyon_conn_t *c = r->conns; c; c = c->next) cyon_conn_close(c);
+}
+
+int cyon_reactor_stop(cyon_reactor_t *r, int grace_ms) {
+    return cyon_reactor_post(r, cyon_reactor_begin_stop, (void*)(intptr_t)grace_ms);
+}
+
+static int cyon_reactor_wait_epoll(cyon_reactor_t *r, int t) {
+    struct epoll_event evs[CYON_REACTOR_MAX_EVENTS];
+    r->syscalls++;
+    int n = epoll_wait(r->epfd, evs, CYON_REACTOR_MAX_EVENTS, t);
+    if (n < 0) {
+        if (errno != EINTR) return errno;
+        n = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        cyon_reactor_io_t *io = (cyon_reactor_io_t*)evs[i].data.ptr;
+        uint32_t e = evs[i].events;
+        if (io->closed) continue;
+        switch (io->kind) {
+        case CYON_IO_KIND_WAKE:
+            cyon_reactor_run_posts(r);
+            break;
+        case CYON_IO_KIND_LISTEN: {
+            cyon_reactor_listener_t *l = (cyon_reactor_listener_t*)io;
+            if (cyon_reactor_accept(r, l) != 0)
+                cyon_timer_start(r->wheel, &l->retry, CYON_URING_ACCEPT_RETRY_US, 0, 0);
+            break;
+        }
+        case CYON_IO_KIND_WATCH: {
+            cyon_reactor_watch_t *w = (cyon_reactor_watch_t*)io;
+            w->cb(r, io->fd, cyon_epoll_to_io(e), w->user);
+            break;
+        }
+        case CYON_IO_KIND_CONN: {
+            cyon_conn_t *c = (cyon_conn_t*)io;
+            if (e & EPOLLERR) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(io->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                cyon_conn_finish(c, err ? err : EIO);
+                break;
+            }
+            if (e & (EPOLLRDHUP | EPOLLHUP)) c->rdhup = 1;
+            if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) cyon_conn_on_readable(c);
+            if ((e & EPOLLOUT) && !io->closed) cyon_conn_on_writable(c);
+            break;
+        }
+        }
+    }
+    return 0;
+}
+
+static int cyon_reactor_wait_uring(cyon_reactor_t *r, int t) {
+    int rc = cyon_uring_submit(r->ring, t == 0 ? 0 : 1, t);
+    if (rc != 0 && rc != ETIME) return rc;
+    struct io_uring_cqe *cqe;
+    while ((cqe = cyon_uring_peek(r->ring)) != NULL) {
+        struct io_uring_cqe copy = *cqe;
+        cyon_uring_advance(r->ring, 1);
+        cyon_reactor_complete(r, &copy);
+    }
+    return 0;
+}
+
+int cyon_reactor_run_once(cyon_reactor_t *r, int timeout_ms) {
+    if (!r) return EINVAL;
+    int t = cyon_timer_wheel_next_timeout_ms(r->wheel);
+    if (timeout_ms >= 0 && (t < 0 || timeout_ms < t)) t = timeout_ms;
+    if (r->ready) t = 0;
+    if (r->stopping) {
+        uint64_t now = cyon_time_monotonic_us();
+        int left = now >= r->stop_deadline_us ? 0 : (int)((r->stop_deadline_us - now + 999) / 1000);
+        if (t < 0 || left < t) t = left;
+    }
+    int rc = r->ring ? cyon_reactor_wait_uring(r, t) : cyon_reactor_wait_epoll(r, t);
+    if (rc != 0) return rc;
+    cyon_timer_wheel_advance(r->wheel, cyon_time_monotonic_us());
+    if (r->stopping && r->nconns > 0 && cyon_time_monotonic_us() >= r->stop_deadline_us) {
+        while (r->conns) cyon_conn_finish(r->conns, ECANCELED);
+    }
+    cyon_reactor_run_ready(r);
+    if (r->stopping && r->nconns == 0) r->stopped = 1;
+    cyon_reactor_reap(r);
+    return 0;
+}
+
+int cyon_reactor_run(cyon_reactor_t *r) {
+    if (!r) return EINVAL;
+    while (!r->stopped) {
+        int rc = cyon_reactor_run_once(r, -1);
+        if (rc != 0) return rc;
+    }
+    /* let queued cancels and closes reach the kernel */
+    if (r->ring) cyon_uring_submit(r->ring, 0, 0);
+    return 0;
+}
+
+/* io_uring needs multishot recv (Linux 6.0, which also added SEND_ZC, so
+   that opcode serves as the probe) and a provided buffer ring. */
+static int cyon_reactor_init_uring(cyon_reactor_t *r) {
+    if (!cyon_uring_available() || !cyon_uring_supports(IORING_OP_SEND_ZC)) return ENOSYS;
+    int rc = cyon_uring_create(&r->ring, CYON_URING_ENTRIES);
+    if (rc != 0) return rc;
+    rc = cyon_uring_bufs_init(r->ring, CYON_URING_BGID, CYON_URING_BUF_COUNT, CYON_URING_BUF_SIZE);
+    if (rc != 0) {
+        cyon_uring_destroy(r->ring);
+        r->ring = NULL;
+        return rc;
+    }
+    /* without a fixed table connections fall back to plain descriptors */
+    cyon_uring_files_init(r->ring, CYON_URING_FIXED_FILES);
+    cyon_reactor_arm_poll(r, &r->wake, POLLIN);
+    return 0;
+}
+
+int cyon_reactor_create_ex(cyon_reactor_t **out, int backend) {
+    if (!out) return EINVAL;
+    cyon_reactor_t *r = (cyon_reactor_t*)calloc(1, sizeof(cyon_reactor_t));
+    if (!r) return ENOMEM;
+    int rc = 0;
+    r->epfd = -1;
+    r->wake.kind = CYON_IO_KIND_WAKE;
+    r->wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wake.fd < 0) rc = errno;
+    if (rc == 0) rc = cyon_timer_wheel_create(&r->wheel, 1000);
+    if (rc == 0 && backend != CYON_REACTOR_EPOLL) {
+        rc = cyon_reactor_init_uring(r);
+        if (rc != 0 && backend == CYON_REACTOR_AUTO) rc = 0;
+    }
+    if (rc == 0 && !r->ring) {
+        r->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (r->epfd < 0) rc = errno;
+        if (rc == 0) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = &r->wake;
+            if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake.fd, &ev) != 0) rc = errno;
+        }
+    }
+    if (rc != 0) {
+        if (r->ring) cyon_uring_destroy(r->ring);
+        if (r->wheel) cyon_timer_wheel_destroy(r->wheel);
+        if (r->wake.fd >= 0) close(r->wake.fd);
+        if (r->epfd >= 0) close(r->epfd);
+        free(r);
+        return rc;
+    }
+    pthread_mutex_init(&r->post_lock, NULL);
+    *out = r;
+    return 0;
+}
+
+int cyon_reactor_create(cyon_reactor_t **out) {
+    return cyon_reactor_create_ex(out, CYON_REACTOR_AUTO);
+}
+
+int cyon_reactor_backend(const cyon_reactor_t *r) {
+    if (!r) return -1;
+    return r->ring ? CYON_REACTOR_URING : CYON_REACTOR_EPOLL;
+}
+
+void cyon_reactor_destroy(cyon_reactor_t *r) {
+    if (!r) return;
+    /* on_close still runs, so per-connection contexts are freed; nothing
+       new can be adopted or listened on from inside it */
+    r->stopping = 1;
+    while (r->conns) cyon_conn_finish(r->conns, ECANCELED);
+    while (r->listeners) {
+        cyon_reactor_listener_t *l = r->listeners;
+        r->listeners = l->next;
+        cyon_reactor_close_listener(r, l);
+    }
+    for (size_t i = 0; i < r->nwatches; i++)
+        if (r->watches[i]) cyon_reactor_unwatch(r, (int)i);
+    if (r->ring) {
+        /* collect the cancellations so every object can be freed */
+        for (int i = 0; i < 100 && r->zombies > 0; i++) {
+            cyon_uring_submit(r->ring, 1, 10);
+            struct io_uring_cqe *cqe;
+            while ((cqe = cyon_uring_peek(r->ring)) != NULL) {
+                struct io_uring_cqe copy = *cqe;
+                cyon_uring_advance(r->ring, 1);
+                cyon_reactor_io_t *io = (cyon_reactor_io_t*)(uintptr_t)(copy.user_data & ~CYON_URING_TAG_MASK);
+                if (io && io->kind != CYON_IO_KIND_WAKE) cyon_reactor_complete(r, &copy);
+            }
+        }
+    }
+    cyon_reactor_reap(r);
+    while (r->posts) {
+        cyon_reactor_post_t *p = r->posts;
+        r->posts = p->next;
+        free(p);
+    }
+    free(r->watches);
+    if (r->ring) cyon_uring_destroy(r->ring);
+    cyon_timer_wheel_destroy(r->wheel);
+    close(r->wake.fd);
+    if (r->epfd >= 0) close(r->epfd);
+    pthread_mutex_destroy(&r->post_lock);
+    free(r);
+}
+
+cyon_timer_wheel_t *cyon_reactor_wheel(cyon_reactor_t *r) {
+    return r ? r->wheel : NULL;
+}
+
+size_t cyon_reactor_conn_count(cyon_reactor_t *r) {
+    return r ? r->nconns : 0;
+}
+
+uint64_t cyon_reactor_syscalls(const cyon_reactor_t *r) {
+    if (!r) return 0;
+    return r->syscalls + (r->ring ? cyon_uring_enter_count(r->ring) : 0);
+}
+
+/* Multi-reactor group */
+
+struct cyon_reactor_group_s {
+    size_t n;
+    int pin;
+    int running;
+    cyon_reactor_t **loops;
+    cyon_thread_t **threads;
+    int *owned;                 /* listeners opened by listen_reuseport */
+    size_t nowned;
+};
+
+static void *cyon_reactor_group_main(void *arg) {
+    cyon_reactor_run((cyon_reactor_t*)arg);
+    return NULL;
+}
+
+int cyon_reactor_group_create(cyon_reactor_group_t **out, size_t n, int pin) {
+    if (!out) return EINVAL;
+    if (n == 0) {
+        long c = sysconf(_SC_NPROCESSORS_ONLN);
+        n = c > 0 ? (size_t)c : 1;
+    }
+    cyon_reactor_group_t *g = (cyon_reactor_group_t*)calloc(1, sizeof(cyon_reactor_group_t));
+    if (!g) return ENOMEM;
+    g->n = n;
+    g->pin = pin;
+    g->loops = (cyon_reactor_t**)calloc(n, sizeof(cyon_reactor_t*));
+    g->threads = (cyon_thread_t**)calloc(n, sizeof(cyon_thread_t*));
+    if (!g->loops || !g->threads) {
+        cyon_reactor_group_destroy(g);
+        return ENOMEM;
+    }
+    for (size_t i = 0; i < n; i++) {
+        int rc = cyon_reactor_create(&g->loops[i]);
+        if (rc != 0) {
+            cyon_reactor_group_destroy(g);
+            return rc;
+        }
+        g->loops[i]->exclusive = 1;
+    }
+    *out = g;
+    return 0;
+}
+
+size_t cyon_reactor_group_size(const cyon_reactor_group_t *g) {
+    return g ? g->n : 0;
+}
+
+cyon_reactor_t *cyon_reactor_group_get(cyon_reactor_group_t *g, size_t i) {
+    return g && i < g->n ? g->loops[i] : NULL;
+}
+
+int cyon_reactor_group_listen(cyon_reactor_group_t *g, int listen_fd, const cyon_conn_handlers_t *h, void *user) {
+    if (!g) return EINVAL;
+    if (g->running) return EBUSY;
+    for (size_t i = 0; i < g->n; i++) {
+        int rc = cyon_reactor_listen_ex(g->loops[i], listen_fd, h, user, 1);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+int cyon_reactor_group_listen_reuseport(cyon_reactor_group_t *g, const char *host, const char *port,
+                                        const cyon_listen_opts_t *opts, const cyon_conn_handlers_t *h,
+                                        void *user) {
+    if (!g || !h) return EINVAL;
+    if (g->running) return EBUSY;
+    int *owned = (int*)realloc(g->owned, (g->nowned + g->n) * sizeof(int));
+    if (!owned) return ENOMEM;
+    g->owned = owned;
+    int *fds = owned + g->nowned;
+    int rc = cyon_tcp_listen_reuseport(host, port, opts, fds, g->n);
+    if (rc < 0) return -rc;
+    g->nowned += g->n;
+    for (size_t i = 0; i < g->n; i++) {
+        rc = cyon_reactor_listen_ex(g->loops[i], fds[i], h, user, 0);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+int cyon_reactor_group_start(cyon_reactor_group_t *g) {
+    if (!g) return EINVAL;
+    if (g->running) return EBUSY;
+    int *cpus = NULL;
+    size_t ncpus = 0;
+    if (g->pin) {
+        const cyon_topology_t *t = cyon_topology_get();
+        if (t->ncpus > 0 && (cpus = (int*)malloc(t->ncpus * sizeof(int))) != NULL)
+            ncpus = cyon_topology_order(CYON_PLACE_SCATTER, cpus, t->ncpus);
+    }
+    int rc = 0;
+    size_t i;
+    for (i = 0; i < g->n; i++) {
+        if (ncpus > 0) rc = cyon_thread_create_on(&g->threads[i], cyon_reactor_group_main, g->loops[i], 0,
+                                                  &cpus[i % ncpus], 1);
+        else rc = cyon_thread_create(&g->threads[i], cyon_reactor_group_main, g->loops[i], 0);
+        if (rc != 0) break;
+    }
+    free(cpus);
+    g->running = 1;
+    if (rc != 0) {
+        cyon_reactor_group_stop(g, 0);
+        return rc;
+    }
+    return 0;
+}
+
+int cyon_reactor_group_stop(cyon_reactor_group_t *g, int grace_ms) {
+    if (!g) return EINVAL;
+    if (!g->running) return 0;
+    for (size_t i = 0; i < g->n; i++) cyon_reactor_stop(g->loops[i], grace_ms);
+    for (size_t i = 0; i < g->n; i++) {
+        if (g->threads[i]) cyon_thread_join(g->threads[i]);
+        g->threads[i] = NULL;
+    }
+    g->running = 0;
+    return 0;
+}
+
+void cyon_reactor_group_destroy(cyon_reactor_group_t *g) {
+    if (!g) return;
+    cyon_reactor_group_stop(g, 0);
+    if (g->loops)
+        for (size_t i = 0; i < g->n; i++) cyon_reactor_destroy(g->loops[i]);
+    for (size_t i = 0; i < g->nowned; i++) close(g->owned[i]);
+    free(g->owned);
+    free(g->loops);
+    free(g->threads);
+    free(g);
+}
+
+/* ---- Zero-copy transfers ---- */
+
+#define CYON_SPLICE_PIPE_SIZE (1 << 20)
+#define CYON_SPLICE_CHUNK     (1 << 16)
+
+ssize_t cyon_sendfile(int sock, int file_fd, off_t *offset, size_t count) {
+    if (sock < 0 || file_fd < 0 || !offset) return -EINVAL;
+    size_t sent = 0;
+    while (sent < count) {
+        ssize_t n = sendfile(sock, file_fd, offset, count - sent);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n == 0) break;
+        if (errno == EINTR) continue;
+        if (sent > 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return -errno;
+    }
+    return (ssize_t)sent;
+}
+
+/* Wait until fd is writable (non-blocking sockets). */
+static int cyon_wait_fd(int fd, short events) {
+    struct pollfd p;
+    p.fd = fd;
+    p.events = events;
+    p.revents = 0;
+    for (;;) {
+        int n = poll(&p, 1, -1);
+        if (n > 0) return 0;
+        if (n < 0 && errno != EINTR) return errno;
+    }
+}
+
+int cyon_sendfile_all(int sock, int file_fd, off_t offset, size_t count) {
+    if (sock < 0 || file_fd < 0 || offset < 0) return EINVAL;
+    if (count == 0) {
+        struct stat st;
+        if (fstat(file_fd, &st) != 0) return errno;
+        if (st.st_size <= offset) return 0;
+        count = (size_t)(st.st_size - offset);
+    }
+    while (count > 0) {
+        ssize_t n = cyon_sendfile(sock, file_fd, &offset, count);
+        if (n == -EAGAIN || n == -EWOULDBLOCK) {
+            int rc = cyon_wait_fd(sock, POLLOUT);
+            if (rc != 0) return rc;
+            continue;
+        }
+        if (n < 0) return (int)-n;
+        if (n == 0) return EIO;     /* file shorter than count */
+        count -= (size_t)n;
+    }
+    return 0;
+}
+
+int cyon_splice_open(cyon_splice_t *sp) {
+    if (!sp) return EINVAL;
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) return errno;
+    /* a larger pipe moves more per splice; keep the default if refused */
+    fcntl(fds[0], F_SETPIPE_SZ, CYON_SPLICE_PIPE_SIZE);
+    sp->rd = fds[0];
+    sp->wr = fds[1];
+    sp->buffered = 0;
+    return 0;
+}
+
+void cyon_splice_close(cyon_splice_t *sp) {
+    if (!sp) return;
+    if (sp->rd >= 0) close(sp->rd);
+    if (sp->wr >= 0) close(sp->wr);
+    sp->rd = sp->wr = -1;
+    sp->buffered = 0;
+}
+
+ssize_t cyon_splice_step(cyon_splice_t *sp, int in_fd, int out_fd, size_t max, int *eof) {
+    if (!sp || sp->rd < 0 || in_fd < 0 || out_fd < 0) return -EINVAL;
+    size_t moved = 0;
+    int in_blocked = 0;
+    if (eof) *eof = 0;
+    for (;;) {
+        if (max && moved >= max) break;
+        if (!in_blocked && sp->buffered < CYON_SPLICE_CHUNK) {
+            size_t want = CYON_SPLICE_CHUNK;
+            if (max && max - moved < want) want = max - moved;
+            if (want > sp->buffered) {
+                ssize_t n = splice(in_fd, NULL, sp->wr, NULL, want - sp->buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (n > 0) {
+                    sp->buffered += (size_t)n;
+                } else if (n == 0) {
+                    in_blocked = 1;
+                    if (eof) *eof = 1;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    in_blocked = 1;
+                } else if (errno != EINTR) {
+                    return moved ? (ssize_t)moved : -errno;
+                }
+            }
+        }
+        if (sp->buffered == 0) {
+            if (in_blocked) break;
+            continue;
+        }
+        ssize_t n = splice(sp->rd, NULL, out_fd, NULL, sp->buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            sp->buffered -= (size_t)n;
+            moved += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;          /* data stays in the pipe for the next call */
+        } else {
+            return moved ? (ssize_t)moved : (n < 0 ? -errno : -EIO);
+        }
+    }
+    return (ssize_t)moved;
+}
+
+/* ---- Buffered connection ---- */
+
+#define CYON_BUFCONN_IOV_MAX 64
+
+struct cyon_bufconn_s {
+    int fd;
+    int not_socket;         /* sendmsg refused: use writev */
+    int eof;
+    int mirrored;           /* rbuf is mapped twice back to back */
+    char *rbuf;
+    size_t rcap;
+    size_t rhead;           /* start of buffered data */
+    size_t rlen;
+    size_t scanned;         /* bytes already searched for the delimiter */
+    char *wbuf;
+    size_t wcap;
+    size_t wlen;
+    uint64_t read_calls;
+    uint64_t write_calls;
+};
+
+/* Map cap bytes of a memfd twice in a row so data that wraps around the
+   end of the ring is still contiguous in memory. */
+static char *cyon_ring_map(size_t cap) {
+    int fd = memfd_create("cyon-ring", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+    char *base = NULL;
+    if (ftruncate(fd, (off_t)cap) == 0) {
+        base = (char*)mmap(NULL, cap * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+        } else if (mmap(base, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                   mmap(base + cap, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, cap * 2);
+            base = NULL;
+        }
+    }
+    close(fd);
+    return base;
+}
+
+int cyon_bufconn_create(cyon_bufconn_t **out, int fd, size_t read_size, size_t write_size) {
+    if (!out || fd < 0) return EINVAL;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t pg = page > 0 ? (size_t)page : 4096;
+    if (!read_size) read_size = CYON_BUFCONN_DEFAULT_SIZE;
+    if (!write_size) write_size = CYON_BUFCONN_DEFAULT_SIZE;
+    read_size = (read_size + pg - 1) / pg * pg;
+    cyon_bufconn_t *b = (cyon_bufconn_t*)calloc(1, sizeof(cyon_bufconn_t));
+    if (!b) return ENOMEM;
+    b->fd = fd;
+    b->rcap = read_size;
+    b->rbuf = cyon_ring_map(read_size);
+    if (b->rbuf) b->mirrored = 1;
+    else b->rbuf = (char*)malloc(read_size);
+    b->wcap = write_size;
+    b->wbuf = (char*)malloc(write_size);
+    if (!b->rbuf || !b->wbuf) {
+        cyon_bufconn_destroy(b);
+        return ENOMEM;
+    }
+    *out = b;
+    return 0;
+}
+
+void cyon_bufconn_destroy(cyon_bufconn_t *b) {
+    if (!b) return;
+    if (b->mirrored) munmap(b->rbuf, b->rcap * 2);
+    else free(b->rbuf);
+    free(b->wbuf);
+    free(b);
+}
+
+int cyon_bufconn_fd(const cyon_bufconn_t *b) {
+    return b ? b->fd : -1;
+}
+
+size_t cyon_bufconn_buffered(const cyon_bufconn_t *b) {
+    return b ? b->rlen : 0;
+}
+
+void cyon_bufconn_stats(const cyon_bufconn_t *b, uint64_t *read_calls, uint64_t *write_calls) {
+    if (read_calls) *read_calls = b ? b->read_calls : 0;
+    if (write_calls) *write_calls = b ? b->write_calls : 0;
+}
+
+/* Write iov[0..n) completely, waiting on non-blocking fds. */
+static int cyon_bufconn_sendv(cyon_bufconn_t *b, struct iovec *iov, int n) {
+    while (n > 0) {
+        ssize_t w;
+        b->write_calls++;
+        if (!b->not_socket) {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = (size_t)n;
+            w = sendmsg(b->fd, &msg, MSG_NOSIGNAL);
+            if (w < 0 && errno == ENOTSOCK) {
+                b->not_socket = 1;
+                continue;
+            }
+        } else {
+            w = writev(b->fd, iov, n);
+        }
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                int rc = cyon_wait_fd(b->fd, POLLOUT);
+                if (rc != 0) return rc;
+                continue;
+            }
+            return errno;
+        }
+        size_t left = (size_t)w;
+        while (n > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char*)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return 0;
+}
+
+int cyon_bufconn_flush(cyon_bufconn_t *b) {
+    if (!b) return EINVAL;
+    if (b->wlen == 0) return 0;
+    struct iovec iov;
+    iov.iov_base = b->wbuf;
+    iov.iov_len = b->wlen;
+    int rc = cyon_bufconn_sendv(b, &iov, 1);
+    if (rc == 0) b->wlen = 0;
+    return rc;
+}
+
+int cyon_bufconn_writev(cyon_bufconn_t *b, const struct iovec *iov, int iovcnt) {
+    if (!b || (!iov && iovcnt > 0) || iovcnt < 0) return EINVAL;
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+    if (b->wlen + total <= b->wcap) {
+        for (int i = 0; i < iovcnt; i++) {
+            memcpy(b->wbuf + b->wlen, iov[i].iov_base, iov[i].iov_len);
+            b->wlen += iov[i].iov_len;
+        }
+        return 0;
+    }
+    /* Doesn't fit: pieces smaller than a quarter of the buffer are copied
+       (merged with their neighbours), the rest is referenced in place, and
+       everything leaves in vectored calls of up to CYON_BUFCONN_IOV_MAX. */
+    struct iovec vec[CYON_BUFCONN_IOV_MAX];
+    int nv = 0;
+    size_t small = b->wcap / 4;
+    size_t mark = 0;            /* start of wbuf not yet referenced by vec */
+    for (int i = 0; i < iovcnt; i++) {
+        const char *p = (const char*)iov[i].iov_base;
+        size_t len = iov[i].iov_len;
+        if (len == 0) continue;
+        if (len <= small && b->wlen + len <= b->wcap) {
+            memcpy(b->wbuf + b->wlen, p, len);
+            b->wlen += len;
+            continue;
+        }
+        if (nv + 2 > CYON_BUFCONN_IOV_MAX) {
+            if (b->wlen > mark) {
+                vec[nv].iov_base = b->wbuf + mark;
+                vec[nv++].iov_len = b->wlen - mark;
+            }
+            int rc = cyon_bufconn_sendv(b, vec, nv);
+            if (rc != 0) return rc;
+            nv = 0;
+            b->wlen = mark = 0;
+            if (len <= small) {
+                memcpy(b->wbuf, p, len);
+                b->wlen = len;
+                continue;
+            }
+        }
+        if (b->wlen > mark) {
+            vec[nv].iov_base = b->wbuf + mark;
+            vec[nv++].iov_len = b->wlen - mark;
+            mark = b->wlen;
+        }
+        if (len <= small) {
+            /* the buffer itself is full */
+            int rc = cyon_bufconn_sendv(b, vec, nv);
+            if (rc != 0) return rc;
+            nv = 0;
+            memcpy(b->wbuf, p, len);
+            b->wlen = len;
+            mark = 0;
+            continue;
+        }
+        vec[nv].iov_base = (void*)p;
+        vec[nv++].iov_len = len;
+    }
+    if (b->wlen > mark) {
+        vec[nv].iov_base = b->wbuf + mark;
+        vec[nv++].iov_len = b->wlen - mark;
+    }
+    int rc = cyon_bufconn_sendv(b, vec, nv);
+    if (rc == 0) b->wlen = 0;
+    return rc;
+}
+
+int cyon_bufconn_write(cyon_bufconn_t *b, const void *data, size_t len) {
+    struct iovec iov;
+    iov.iov_base = (void*)data;
+    iov.iov_len = len;
+    return cyon_bufconn_writev(b, &iov, 1);
+}
+
+/* Read more input into the ring. Returns bytes added, 0 at end of
+   stream or when full, or -errno. */
+static ssize_t cyon_bufconn_fill(cyon_bufconn_t *b) {
+    if (b->eof || b->rlen == b->rcap) return 0;
+    int rc = cyon_bufconn_flush(b);
+    if (rc != 0) return -rc;
+    if (!b->mirrored && b->rhead + b->rlen == b->rcap) {
+        memmove(b->rbuf, b->rbuf + b->rhead, b->rlen);
+        b->rhead = 0;
+    }
+    size_t tail = (b->rhead + b->rlen) % b->rcap;
+    size_t space = b->mirrored ? b->rcap - b->rlen : b->rcap - (b->rhead + b->rlen);
+    for (;;) {
+        b->read_calls++;
+        ssize_t n = read(b->fd, b->rbuf + (b->mirrored ? tail : b->rhead + b->rlen), space);
+        if (n > 0) {
+            b->rlen += (size_t)n;
+            return n;
+        }
+        if (n == 0) {
+            b->eof = 1;
+            return 0;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            rc = cyon_wait_fd(b->fd, POLLIN);
+            if (rc != 0) return -rc;
+            continue;
+        }
+        return -errno;
+    }
+}
+
+void cyon_bufconn_consume(cyon_bufconn_t *b, size_t n) {
+    if (!b) return;
+    if (n > b->rlen) n = b->rlen;
+    b->rlen -= n;
+    b->rhead = b->rlen ? (b->rhead + n) % b->rcap : 0;
+    b->scanned = 0;
+}
+
+ssize_t cyon_bufconn_read(cyon_bufconn_t *b, void *dst, size_t len) {
+    if (!b || (!dst && len)) return -EINVAL;
+    if (len == 0) return 0;
+    if (b->rlen == 0) {
+        /* large reads skip the ring */
+        if (len >= b->rcap && !b->eof) {
+            int rc = cyon_bufconn_flush(b);
+            if (rc != 0) return -rc;
+            for (;;) {
+                b->read_calls++;
+                ssize_t n = read(b->fd, dst, len);
+                if (n >= 0) {
+                    if (n == 0) b->eof = 1;
+                    return n;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    rc = cyon_wait_fd(b->fd, POLLIN);
+                    if (rc != 0) return -rc;
+                    continue;
+                }
+                return -errno;
+            }
+        }
+        ssize_t n = cyon_bufconn_fill(b);
+        if (n <= 0) return n;
+    }
+    size_t n = len < b->rlen ? len : b->rlen;
+    memcpy(dst, b->rbuf + b->rhead, n);
+    cyon_bufconn_consume(b, n);
+    return (ssize_t)n;
+}
+
+int cyon_bufconn_read_full(cyon_bufconn_t *b, void *dst, size_t len) {
+    char *p = (char*)dst;
+    while (len > 0) {
+        ssize_t n = cyon_bufconn_read(b, p, len);
+        if (n < 0) return (int)-n;
+        if (n == 0) return EPIPE;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+ssize_t cyon_bufconn_peek_until(cyon_bufconn_t *b, const void *delim, size_t dlen, const char **rec) {
+    if (!b || !delim || dlen == 0 || !rec) return -EINVAL;
+    for (;;) {
+        const char *data = b->rbuf + b->rhead;
+        if (b->rlen >= dlen) {
+            /* resume where the last scan stopped, minus a partial match */
+            size_t from = b->scanned > dlen - 1 ? b->scanned - (dlen - 1) : 0;
+            const char *hit = dlen == 1 ? (const char*)memchr(data + from, *(const char*)delim, b->rlen - from)
+                                        : (const char*)memmem(data + from, b->rlen - from, delim, dlen);
+            if (hit) {
+                *rec = data;
+                return (ssize_t)(hit - data + dlen);
+            }
+            b->scanned = b->rlen;
+        }
+        if (b->rlen == b->rcap) return -EMSGSIZE;
+        if (b->eof) {
+            *rec = data;
+            return (ssize_t)b->rlen;
+        }
+        size_t before = b->rhead;
+        ssize_t n = cyon_bufconn_fill(b);
+        if (n < 0) return n;
+        if (b->rhead != before) b->scanned = 0;     /* compacted */
+    }
+}
+
+ssize_t cyon_bufconn_peek(cyon_bufconn_t *b, size_t n, const char **data) {
+    if (!b || !data) return -EINVAL;
+    if (n > b->rcap) return -EMSGSIZE;
+    while (b->rlen < n && !b->eof) {
+        ssize_t r = cyon_bufconn_fill(b);
+        if (r < 0) return r;
+    }
+    *data = b->rbuf + b->rhead;
+    return (ssize_t)(b->rlen < n ? b->rlen : n);
+}
+
+ssize_t cyon_bufconn_readline(cyon_bufconn_t *b, char *dst, size_t cap) {
+    if (!b || !dst || cap == 0) return -EINVAL;
+    const char *rec;
+    ssize_t n = cyon_bufconn_peek_until(b, "\n", 1, &rec);
+    if (n < 0) return n;
+    if (n == 0) return CYON_BUFCONN_EOF;
+    size_t len = (size_t)n;
+    size_t take = len;
+    if (len > 0 && rec[len - 1] == '\n') len--;
+    if (len > 0 && rec[len - 1] == '\r') len--;
+    if (len + 1 > cap) return -EMSGSIZE;
+    memcpy(dst, rec, len);
+    dst[len] = '\0';
+    cyon_bufconn_consume(b, take);
+    return (ssize_t)len;
+}
+
+/* ---- Batched UDP ---- */
+
+#define CYON_UDP_MAX_SEGS 64          /* UDP_MAX_SEGMENTS on older kernels */
+#define CYON_UDP_GSO_MAX 65000        /* payload of one segmented send */
+#define CYON_UDP_CTL_SIZE 32          /* UDP_GRO on receive, UDP_SEGMENT on send */
+
+struct cyon_udp_s {
+    int fd;
+    int gso;
+    int gro;
+    size_t batch;
+    size_t buf_size;
+    char *bufs;                         /* batch receive buffers */
+    struct sockaddr_storage *addrs;
+    struct mmsghdr *mm;
+    struct iovec *iov;                  /* batch, times CYON_UDP_MAX_SEGS with gso */
+    size_t niov;
+    char *ctl;                          /* batch control buffers */
+    size_t *runs;                       /* datagrams covered by each send header */
+    cyon_udp_msg_t *ready;              /* received, not yet handed out */
+    size_t nready;
+    size_t rpos;
+    size_t rcap;
+    cyon_udp_stats_t st;
+};
+
+void cyon_udp_destroy(cyon_udp_t *u) {
+    if (!u) return;
+    if (u->fd >= 0) close(u->fd);
+    free(u->bufs);
+    free(u->addrs);
+    free(u->mm);
+    free(u->iov);
+    free(u->ctl);
+    free(u->runs);
+    free(u->ready);
+    free(u);
+}
+
+static int cyon_udp_open(cyon_udp_t **out, const char *host, const char *port, const cyon_udp_opts_t *opts,
+                         int passive) {
+    if (!out || (!passive && !host)) return EINVAL;
+    cyon_udp_opts_t o;
+    memset(&o, 0, sizeof(o));
+    if (opts) o = *opts;
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    int rc = getaddrinfo(host, port ? port : "0", &hints, &res);
+    if (rc != 0) return rc == EAI_SYSTEM ? errno : EADDRNOTAVAIL;
+    int fd = -1;
+    rc = EADDRNOTAVAIL;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            rc = errno;
+            continue;
+        }
+        if ((passive ? bind(fd, ai->ai_addr, ai->ai_addrlen) : connect(fd, ai->ai_addr, ai->ai_addrlen)) == 0) break;
+        rc = errno;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return rc;
+
+    cyon_udp_t *u = (cyon_udp_t*)calloc(1, sizeof(cyon_udp_t));
+    if (!u) {
+        close(fd);
+        return ENOMEM;
+    }
+    u->fd = fd;
+    int one = 1;
+    if (o.rcvbuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &o.rcvbuf, sizeof(o.rcvbuf));
+    if (o.sndbuf > 0) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &o.sndbuf, sizeof(o.sndbuf));
+    if (o.gso) {
+        /* a zero default segment size only probes for support */
+        int zero = 0;
+        u->gso = setsockopt(fd, SOL_UDP, UDP_SEGMENT, &zero, sizeof(zero)) == 0;
+    }
+    if (o.gro) u->gro = setsockopt(fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0;
+    u->batch = o.batch ? o.batch : 64;
+    u->buf_size = o.buf_size ? o.buf_size : (u->gro ? 65536 : 2048);
+    u->bufs = (char*)malloc(u->batch * u->buf_size);
+    u->addrs = (struct sockaddr_storage*)calloc(u->batch, sizeof(struct sockaddr_storage));
+    u->mm = (struct mmsghdr*)calloc(u->batch, sizeof(struct mmsghdr));
+    u->niov = u->gso ? u->batch * CYON_UDP_MAX_SEGS : u->batch;
+    u->iov = (struct iovec*)calloc(u->niov, sizeof(struct iovec));
+    u->ctl = (char*)calloc(u->batch, CYON_UDP_CTL_SIZE);
+    u->runs = (size_t*)calloc(u->batch, sizeof(size_t));
+    if (!u->bufs || !u->addrs || !u->mm || !u->iov || !u->ctl || !u->runs) {
+        cyon_udp_destroy(u);
+        return ENOMEM;
+    }
+    *out = u;
+    return 0;
+}
+
+int cyon_udp_bind(cyon_udp_t **out, const char *host, const char *port, const cyon_udp_opts_t *opts) {
+    return cyon_udp_open(out, host, port, opts, 1);
+}
+
+int cyon_udp_connect(cyon_udp_t **out, const char *host, const char *port, const cyon_udp_opts_t *opts) {
+    return cyon_udp_open(out, host, port, opts, 0);
+}
+
+int cyon_udp_fd(const cyon_udp_t *u) {
+    return u ? u->fd : -1;
+}
+
+int cyon_udp_gso(const cyon_udp_t *u) {
+    return u ? u->gso : 0;
+}
+
+int cyon_udp_gro(const cyon_udp_t *u) {
+    return u ? u->gro : 0;
+}
+
+void cyon_udp_stats(const cyon_udp_t *u, cyon_udp_stats_t *st) {
+    if (!st) return;
+    memset(st, 0, sizeof(*st));
+    if (!u) return;
+    *st = u->st;
+    /* the socket's own drop counter also sees datagrams that never
+       reached the queue */
+    uint32_t mem[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(mem);
+    if (getsockopt(u->fd, SOL_SOCKET, SO_MEMINFO, mem, &len) == 0 && len > SK_MEMINFO_DROPS * sizeof(uint32_t))
+        st->rx_dropped = mem[SK_MEMINFO_DROPS];
+}
+
+/* Append one received datagram (or GRO segment) to the ready list. */
+static int cyon_udp_push(cyon_udp_t *u, char *data, size_t len, const struct sockaddr *addr, socklen_t addrlen) {
+    if (u->nready == u->rcap) {
+        size_t cap = u->rcap ? u->rcap * 2 : u->batch * 2;
+        cyon_udp_msg_t *r = (cyon_udp_msg_t*)realloc(u->ready, cap * sizeof(cyon_udp_msg_t));
+        if (!r) return ENOMEM;
+        u->ready = r;
+        u->rcap = cap;
+    }
+    cyon_udp_msg_t *m = &u->ready[u->nready++];
+    m->data = data;
+    m->len = len;
+    m->addr = addr;
+    m->addrlen = addrlen;
+    u->st.rx_datagrams++;
+    u->st.rx_bytes += len;
+    return 0;
+}
+
+/* Wait for the socket; 0 when ready, ETIME on timeout. */
+static int cyon_udp_wait(int fd, short events, int timeout_ms) {
+    struct pollfd p;
+    p.fd = fd;
+    p.events = events;
+    p.revents = 0;
+    int n = poll(&p, 1, timeout_ms);
+    if (n > 0) return 0;
+    if (n == 0) return ETIME;
+    return errno == EINTR ? 0 : errno;
+}
+
+/* One recvmmsg into the pooled buffers. Returns the datagram count, 0 on
+   timeout, or -errno. */
+static ssize_t cyon_udp_fill(cyon_udp_t *u, int timeout_ms) {
+    uint64_t deadline = timeout_ms > 0 ? cyon_time_monotonic_us() + (uint64_t)timeout_ms * 1000 : 0;
+    int r;
+    for (;;) {
+        for (size_t i = 0; i < u->batch; i++) {
+            struct msghdr *h = &u->mm[i].msg_hdr;
+            u->iov[i].iov_base = u->bufs + i * u->buf_size;
+            u->iov[i].iov_len = u->buf_size;
+            h->msg_name = &u->addrs[i];
+            h->msg_namelen = sizeof(struct sockaddr_storage);
+            h->msg_iov = &u->iov[i];
+            h->msg_iovlen = 1;
+            h->msg_control = u->ctl + i * CYON_UDP_CTL_SIZE;
+            h->msg_controllen = CYON_UDP_CTL_SIZE;
+            h->msg_flags = 0;
+        }
+        r = recvmmsg(u->fd, u->mm, (unsigned)u->batch, 0, NULL);
+        if (r > 0) break;
+        if (r == 0 || errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -errno;
+        int wait = timeout_ms;
+        if (timeout_ms > 0) {
+            uint64_t now = cyon_time_monotonic_us();
+            if (now >= deadline) return 0;
+            wait = (int)((deadline - now + 999) / 1000);
+        }
+        if (timeout_ms == 0) return 0;
+        int rc = cyon_udp_wait(u->fd, POLLIN, wait);
+        if (rc == ETIME) return 0;
+        if (rc != 0) return -rc;
+    }
+    u->st.rx_calls++;
+    u->nready = 0;
+    u->rpos = 0;
+    for (int i = 0; i < r; i++) {
+        struct msghdr *h = &u->mm[i].msg_hdr;
+        char *data = u->bufs + (size_t)i * u->buf_size;
+        size_t len = u->mm[i].msg_len;
+        size_t seg = 0;
+        if (h->msg_flags & MSG_TRUNC) u->st.rx_truncated++;
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(h); c; c = CMSG_NXTHDR(h, c)) {
+            if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+                int g;
+                memcpy(&g, CMSG_DATA(c), sizeof(g));
+                if (g > 0) seg = (size_t)g;
+            }
+        }
+        const struct sockaddr *addr = (const struct sockaddr*)&u->addrs[i];
+        if (!seg || seg >= len) seg = len;
+        size_t off = 0;
+        do {
+            size_t n = len - off < seg ? len - off : seg;
+            if (cyon_udp_push(u, data + off, n, addr, h->msg_namelen) != 0) return -ENOMEM;
+            off += n;
+        } while (off < len);
+    }
+    return (ssize_t)u->nready;
+}
+
+ssize_t cyon_udp_recv(cyon_udp_t *u, cyon_udp_msg_t *msgs, size_t max, int timeout_ms) {
+    if (!u || (!msgs && max)) return -EINVAL;
+    if (max == 0) return 0;
+    if (u->rpos == u->nready) {
+        ssize_t r = cyon_udp_fill(u, timeout_ms);
+        if (r <= 0) return r;
+    }
+    size_t n = u->nready - u->rpos;
+    if (n > max) n = max;
+    memcpy(msgs, u->ready + u->rpos, n * sizeof(cyon_udp_msg_t));
+    u->rpos += n;
+    return (ssize_t)n;
+}
+
+static int cyon_udp_same_dest(const cyon_udp_msg_t *a, const cyon_udp_msg_t *b) {
+    if (a->addr == b->addr) return 1;
+    return a->addr && b->addr && a->addrlen == b->addrlen && memcmp(a->addr, b->addr, a->addrlen) == 0;
+}
+
+/* Errors that concern one datagram rather than the socket. */
+static int cyon_udp_droppable(int err) {
+    return err == ECONNREFUSED || err == EMSGSIZE || err == ENOBUFS || err == EHOSTUNREACH ||
+           err == ENETUNREACH || err == EPERM || err == EACCES || err == EDESTADDRREQ;
+}
+
+ssize_t cyon_udp_send(cyon_udp_t *u, const cyon_udp_msg_t *msgs, size_t n) {
+    if (!u || (!msgs && n)) return -EINVAL;
+    size_t done = 0;
+    size_t plain_until = 0;     /* a segmented send of these was refused */
+    while (done < n) {
+        /* up to batch headers, each one datagram or a segmented run */
+        size_t k = 0;
+        size_t i = done;
+        size_t iv = 0;
+        while (i < n && k < u->batch && iv < u->niov) {
+            size_t run = 1;
+            size_t total = msgs[i].len;
+            if (u->gso && i >= plain_until) {
+                size_t seg = msgs[i].len;
+                while (seg && i + run < n && iv + run < u->niov && run < CYON_UDP_MAX_SEGS &&
+                       msgs[i + run].len <= seg && total + msgs[i + run].len <= CYON_UDP_GSO_MAX &&
+                       cyon_udp_same_dest(&msgs[i], &msgs[i + run])) {
+                    total += msgs[i + run].len;
+                    /* only the last segment may be short */
+                    if (msgs[i + run++].len < seg) break;
+                }
+            }
+            struct msghdr *h = &u->mm[k].msg_hdr;
+            memset(h, 0, sizeof(*h));
+            h->msg_name = (void*)msgs[i].addr;
+            h->msg_namelen = msgs[i].addr ? msgs[i].addrlen : 0;
+            h->msg_iov = &u->iov[iv];
+            h->msg_iovlen = run;
+            for (size_t j = 0; j < run; j++) {
+                u->iov[iv + j].iov_base = msgs[i + j].data;
+                u->iov[iv + j].iov_len = msgs[i + j].len;
+            }
+            if (run > 1) {
+                h->msg_control = u->ctl + k * CYON_UDP_CTL_SIZE;
+                h->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                memset(h->msg_control, 0, h->msg_controllen);
+                struct cmsghdr *c = CMSG_FIRSTHDR(h);
+                c->cmsg_level = SOL_UDP;
+                c->cmsg_type = UDP_SEGMENT;
+                c->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t seg = (uint16_t)msgs[i].len;
+                memcpy(CMSG_DATA(c), &seg, sizeof(seg));
+            }
+            u->runs[k] = run;
+            u->mm[k].msg_len = 0;
+            i += run;
+            iv += run;
+            k++;
+        }
+        int r = sendmmsg(u->fd, u->mm, (unsigned)k, MSG_NOSIGNAL);
+        u->st.tx_calls++;
+        if (r > 0) {
+            for (int j = 0; j < r; j++) {
+                u->st.tx_datagrams += u->runs[j];
+                u->st.tx_bytes += u->mm[j].msg_len;
+                done += u->runs[j];
+            }
+            continue;
+        }
+        int err = r < 0 ? errno : EAGAIN;
+        if (err == EINTR) continue;
+        if (err == EAGAIN || err == EWOULDBLOCK) {
+            int rc = cyon_udp_wait(u->fd, POLLOUT, -1);
+            if (rc != 0) return done ? (ssize_t)done : -rc;
+            continue;
+        }
+        if (u->runs[0] > 1 && (err == EIO || err == EINVAL || err == EMSGSIZE)) {
+            /* no checksum offload on the route, or segments over the MTU */
+            plain_until = done + u->runs[0];
+            continue;
+        }
+        if (!cyon_udp_droppable(err)) return done ? (ssize_t)done : -err;
+        u->st.tx_dropped += u->runs[0];
+        done += u->runs[0];
+    }
+    return (ssize_t)done;
+}
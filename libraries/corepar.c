@@ -0,0 +1,389 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyonpar.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+static atomic_size_t cyon_par_threshold_n = CYON_PAR_THRESHOLD;
+
+void cyon_par_set_threshold(size_t n) {
+    atomic_store_explicit(&cyon_par_threshold_n, n ? n : 1, memory_order_relaxed);
+}
+
+size_t cyon_par_threshold(void) {
+    return atomic_load_explicit(&cyon_par_threshold_n, memory_order_relaxed);
+}
+
+/* Shared job: chunks are claimed from `next` by the caller and by helper
+   tasks on the pool. Helpers that arrive after the caller returned only
+   drop their reference, so the job lives on the heap. */
+typedef struct {
+    atomic_size_t next;
+    atomic_size_t done;
+    atomic_int refs;
+    size_t nchunks;
+    size_t n;
+    size_t chunk;
+    void (*body)(size_t chunk_index, size_t begin, size_t end, void *ctx);
+    void *ctx;
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} cyon_par_job_t;
+
+static void cyon_par_job_release(cyon_par_job_t *job) {
+    if (atomic_fetch_sub_explicit(&job->refs, 1, memory_order_acq_rel) == 1) {
+        pthread_cond_destroy(&job->finished);
+        pthread_mutex_destroy(&job->lock);
+        free(job);
+    }
+}
+
+static void cyon_par_job_work(cyon_par_job_t *job) {
+    for (;;) {
+        size_t c = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (c >= job->nchunks) break;
+        size_t begin = c * job->chunk;
+        size_t end = begin + job->chunk < job->n ? begin + job->chunk : job->n;
+        job->body(c, begin, end, job->ctx);
+        if (atomic_fetch_add_explicit(&job->done, 1, memory_order_acq_rel) + 1 == job->nchunks) {
+            pthread_mutex_lock(&job->lock);
+            pthread_cond_broadcast(&job->finished);
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+}
+
+static void *cyon_par_helper(void *arg) {
+    cyon_par_job_t *job = (cyon_par_job_t*)arg;
+    cyon_par_job_work(job);
+    cyon_par_job_release(job);
+    return NULL;
+}
+
+/* Chunk size for n elements: at least grain, at most MAX_CHUNKS chunks. */
+static size_t cyon_par_chunk_size(size_t n, size_t grain) {
+    if (grain == 0) grain = cyon_par_threshold() / 4;
+    if (grain == 0) grain = 1;
+    size_t min_chunk = (n + CYON_PAR_MAX_CHUNKS - 1) / CYON_PAR_MAX_CHUNKS;
+    return grain > min_chunk ? grain : min_chunk;
+}
+
+/* Run body over nchunks chunks of `chunk` elements each. */
+static int cyon_par_run(size_t n, size_t chunk,
+                        void (*body)(size_t, size_t, size_t, void*), void *ctx) {
+    size_t nchunks = (n + chunk - 1) / chunk;
+    if (nchunks <= 1) {
+        if (n) body(0, 0, n, ctx);
+        return 0;
+    }
+    cyon_threadpool_t *pool = cyon_threadpool_shared();
+    size_t helpers = pool ? cyon_threadpool_size(pool) : 0;
+    if (helpers > nchunks - 1) helpers = nchunks - 1;
+    if (helpers == 0) {
+        for (size_t c = 0; c < nchunks; ++c) {
+            size_t begin = c * chunk;
+            body(c, begin, begin + chunk < n ? begin + chunk : n, ctx);
+        }
+        return 0;
+    }
+    cyon_par_job_t *job = (cyon_par_job_t*)malloc(sizeof(cyon_par_job_t));
+    if (!job) return ENOMEM;
+    atomic_init(&job->next, 0);
+    atomic_init(&job->done, 0);
+    atomic_init(&job->refs, 1);
+    job->nchunks = nchunks;
+    job->n = n;
+    job->chunk = chunk;
+    job->body = body;
+    job->ctx = ctx;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->finished, NULL);
+    for (size_t i = 0; i < helpers; ++i) {
+        atomic_fetch_add_explicit(&job->refs, 1, memory_order_relaxed);
+        if (cyon_threadpool_submit(pool, cyon_par_helper, job) != 0) {
+            atomic_fetch_sub_explicit(&job->refs, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    cyon_par_job_work(job);
+    pthread_mutex_lock(&job->lock);
+    while (atomic_load_explicit(&job->done, memory_order_acquire) < nchunks)
+        pthread_cond_wait(&job->finished, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+    cyon_par_job_release(job);
+    return 0;
+}
+
+/* ---- for ---- */
+
+typedef struct {
+    void (*body)(size_t, size_t, void*);
+    void *ctx;
+} cyon_par_for_ctx_t;
+
+static void cyon_par_for_body(size_t c, size_t begin, size_t end, void *arg) {
+    (void)c;
+    cyon_par_for_ctx_t *f = (cyon_par_for_ctx_t*)arg;
+    f->body(begin, end, f->ctx);
+}
+
+int cyon_par_for(size_t n, size_t grain, void (*body)(size_t begin, size_t end, void *ctx), void *ctx) {
+    if (!body) return EINVAL;
+    cyon_par_for_ctx_t f = { body, ctx };
+    return cyon_par_run(n, cyon_par_chunk_size(n, grain), cyon_par_for_body, &f);
+}
+
+/* ---- reduce ---- */
+
+typedef struct {
+    unsigned char *partials;
+    size_t result_size;
+    void (*chunk)(size_t, size_t, void*, void*);
+    void *ctx;
+} cyon_par_reduce_ctx_t;
+
+static void cyon_par_reduce_body(size_t c, size_t begin, size_t end, void *arg) {
+    cyon_par_reduce_ctx_t *r = (cyon_par_reduce_ctx_t*)arg;
+    r->chunk(begin, end, r->partials + c * r->result_size, r->ctx);
+}
+
+int cyon_par_reduce(size_t n, size_t grain, void *result, size_t result_size, const void *identity,
+                    void (*chunk)(size_t begin, size_t end, void *partial, void *ctx),
+                    void (*combine)(void *acc, const void *partial, void *ctx), void *ctx) {
+    if (!result || !identity || result_size == 0 || !chunk || !combine) return EINVAL;
+    memcpy(result, identity, result_size);
+    if (n == 0) return 0;
+    size_t csize = cyon_par_chunk_size(n, grain);
+    size_t nchunks = (n + csize - 1) / csize;
+    if (nchunks == 1) {
+        chunk(0, n, result, ctx);
+        return 0;
+    }
+    unsigned char *partials = (unsigned char*)malloc(nchunks * result_size);
+    if (!partials) return ENOMEM;
+    for (size_t c = 0; c < nchunks; ++c) memcpy(partials + c * result_size, identity, result_size);
+    cyon_par_reduce_ctx_t r = { partials, result_size, chunk, ctx };
+    int rc = cyon_par_run(n, csize, cyon_par_reduce_body, &r);
+    if (rc == 0)
+        for (size_t c = 0; c < nchunks; ++c) combine(result, partials + c * result_size, ctx);
+    free(partials);
+    return rc;
+}
+
+/* ---- double helpers ---- */
+
+typedef struct {
+    const double *a;
+    const double *b;
+    double *out;
+    double (*fn)(double, void*);
+    void *ctx;
+} cyon_par_f64_ctx_t;
+
+static void cyon_par_map_body(size_t begin, size_t end, void *arg) {
+    cyon_par_f64_ctx_t *m = (cyon_par_f64_ctx_t*)arg;
+    for (size_t i = begin; i < end; ++i) m->out[i] = m->fn(m->a[i], m->ctx);
+}
+
+int cyon_par_map_f64(const double *in, double *out, size_t n, double (*fn)(double, void*), void *ctx) {
+    if (!in || !out || !fn) return EINVAL;
+    cyon_par_f64_ctx_t m = { in, NULL, out, fn, ctx };
+    if (n < cyon_par_threshold()) {
+        cyon_par_map_body(0, n, &m);
+        return 0;
+    }
+    return cyon_par_for(n, 0, cyon_par_map_body, &m);
+}
+
+static void cyon_par_sum_chunk(size_t begin, size_t end, void *partial, void *arg) {
+    const cyon_par_f64_ctx_t *s = (const cyon_par_f64_ctx_t*)arg;
+    double acc = 0.0;
+    for (size_t i = begin; i < end; ++i) acc += s->a[i];
+    *(double*)partial += acc;
+}
+
+static void cyon_par_dot_chunk(size_t begin, size_t end, void *partial, void *arg) {
+    const cyon_par_f64_ctx_t *s = (const cyon_par_f64_ctx_t*)arg;
+    double acc = 0.0;
+    for (size_t i = begin; i < end; ++i) acc += s->a[i] * s->b[i];
+    *(double*)partial += acc;
+}
+
+static void cyon_par_sqdiff_chunk(size_t begin, size_t end, void *partial, void *arg) {
+    const cyon_par_f64_ctx_t *s = (const cyon_par_f64_ctx_t*)arg;
+    double acc = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        double d = s->a[i] - s->b[i];
+        acc += d * d;
+    }
+    *(double*)partial += acc;
+}
+
+static void cyon_par_add_f64(void *acc, const void *partial, void *ctx) {
+    (void)ctx;
+    *(double*)acc += *(const double*)partial;
+}
+
+static double cyon_par_reduce_f64(const double *a, const double *b, size_t n,
+                                  void (*chunk)(size_t, size_t, void*, void*)) {
+    cyon_par_f64_ctx_t s = { a, b, NULL, NULL, NULL };
+    double result = 0.0, zero = 0.0;
+    if (n < cyon_par_threshold()) {
+        chunk(0, n, &result, &s);
+        return result;
+    }
+    if (cyon_par_reduce(n, 0, &result, sizeof(double), &zero, chunk, cyon_par_add_f64, &s) != 0) {
+        result = 0.0;
+        chunk(0, n, &result, &s);
+    }
+    return result;
+}
+
+double cyon_par_sum_f64(const double *a, size_t n) {
+    if (!a) return 0.0;
+    return cyon_par_reduce_f64(a, NULL, n, cyon_par_sum_chunk);
+}
+
+double cyon_par_dot_f64(const double *a, const double *b, size_t n) {
+    if (!a || !b) return 0.0;
+    return cyon_par_reduce_f64(a, b, n, cyon_par_dot_chunk);
+}
+
+double cyon_par_sqdiff_f64(const double *a, const double *b, size_t n) {
+    if (!a || !b) return 0.0;
+    return cyon_par_reduce_f64(a, b, n, cyon_par_sqdiff_chunk);
+}
+
+/* ---- scan ---- */
+
+/* Two passes over the same chunks: chunk totals, then a sequential scan of
+   the totals, then each chunk's prefix sums offset by its predecessor. */
+typedef struct {
+    const void *in;
+    void *out;
+    void *sums;     /* per-chunk totals, then exclusive offsets */
+    size_t chunk;
+    int pass;
+} cyon_par_scan_ctx_t;
+
+#define CYON_PAR_SCAN_BODY(T) \
+    static void cyon_par_scan_body_##T(size_t c, size_t begin, size_t end, void *arg) { \
+        cyon_par_scan_ctx_t *s = (cyon_par_scan_ctx_t*)arg; \
+        const T *in = (const T*)s->in; \
+        T *out = (T*)s->out; \
+        T *sums = (T*)s->sums; \
+        if (s->pass == 0) { \
+            T acc = 0; \
+            for (size_t i = begin; i < end; ++i) acc += in[i]; \
+            sums[c] = acc; \
+        } else { \
+            T acc = sums[c]; \
+            for (size_t i = begin; i < end; ++i) { acc += in[i]; out[i] = acc; } \
+        } \
+    }
+
+CYON_PAR_SCAN_BODY(double)
+CYON_PAR_SCAN_BODY(int64_t)
+
+#define CYON_PAR_SCAN_IMPL(T, in, out, n) do { \
+        if (!(in) || !(out)) return EINVAL; \
+        if ((n) < cyon_par_threshold()) { \
+            T acc = 0; \
+            for (size_t i = 0; i < (n); ++i) { acc += (in)[i]; (out)[i] = acc; } \
+            return 0; \
+        } \
+        size_t csize = cyon_par_chunk_size((n), 0); \
+        size_t nchunks = ((n) + csize - 1) / csize; \
+        T *sums = (T*)malloc(nchunks * sizeof(T)); \
+        if (!sums) return ENOMEM; \
+        cyon_par_scan_ctx_t s = { (in), (out), sums, csize, 0 }; \
+        int rc = cyon_par_run((n), csize, cyon_par_scan_body_##T, &s); \
+        if (rc == 0) { \
+            T acc = 0; \
+            for (size_t c = 0; c < nchunks; ++c) { T t = sums[c]; sums[c] = acc; acc += t; } \
+            s.pass = 1; \
+            rc = cyon_par_run((n), csize, cyon_par_scan_body_##T, &s); \
+        } \
+        free(sums); \
+        return rc; \
+    } while (0)
+
+int cyon_par_scan_f64(const double *in, double *out, size_t n) {
+    CYON_PAR_SCAN_IMPL(double, in, out, n);
+}
+
+int cyon_par_scan_i64(const int64_t *in, int64_t *out, size_t n) {
+    CYON_PAR_SCAN_IMPL(int64_t, in, out, n);
+}
+
+/* ---- sort ---- */
+
+typedef struct {
+    unsigned char *src;
+    unsigned char *dst;
+    size_t n;
+    size_t size;
+    size_t run;     /* sorted run length being merged */
+    int (*cmp)(const void*, const void*);
+} cyon_par_sort_ctx_t;
+
+static void cyon_par_sort_runs(size_t c, size_t begin, size_t end, void *arg) {
+    (void)c;
+    cyon_par_sort_ctx_t *s = (cyon_par_sort_ctx_t*)arg;
+    qsort(s->src + begin * s->size, end - begin, s->size, s->cmp);
+}
+
+/* Merge pair p: runs [2p*run, (2p+1)*run) and [(2p+1)*run, (2p+2)*run). */
+static void cyon_par_merge_pair(size_t p, size_t begin, size_t end, void *arg) {
+    (void)begin; (void)end;
+    cyon_par_sort_ctx_t *s = (cyon_par_sort_ctx_t*)arg;
+    size_t lo = 2 * p * s->run;
+    size_t mid = lo + s->run < s->n ? lo + s->run : s->n;
+    size_t hi = mid + s->run < s->n ? mid + s->run : s->n;
+    size_t i = lo, j = mid, k = lo, sz = s->size;
+    while (i < mid && j < hi) {
+        if (s->cmp(s->src + j * sz, s->src + i * sz) < 0) {
+            memcpy(s->dst + k * sz, s->src + j * sz, sz); ++j;
+        } else {
+            memcpy(s->dst + k * sz, s->src + i * sz, sz); ++i;
+        }
+        ++k;
+    }
+    if (i < mid) memcpy(s->dst + k * sz, s->src + i * sz, (mid - i) * sz);
+    if (j < hi) memcpy(s->dst + k * sz, s->src + j * sz, (hi - j) * sz);
+}
+
+int cyon_par_sort(void *base, size_t n, size_t size, int (*cmp)(const void*, const void*)) {
+    if (!base || size == 0 || !cmp) return EINVAL;
+    if (n < cyon_par_threshold()) {
+        qsort(base, n, size, cmp);
+        return 0;
+    }
+    size_t run = cyon_par_chunk_size(n, 0);
+    unsigned char *tmp = (unsigned char*)malloc(n * size);
+    if (!tmp) {
+        qsort(base, n, size, cmp);
+        return 0;
+    }
+    cyon_par_sort_ctx_t s = { (unsigned char*)base, tmp, n, size, run, cmp };
+    int rc = cyon_par_run(n, run, cyon_par_sort_runs, &s);
+    /* each round merges pairs of runs, one chunk of work per pair; a round
+       that fails has not started, so src still holds the last complete one */
+    while (rc == 0 && s.run < n) {
+        size_t pairs = (n + 2 * s.run - 1) / (2 * s.run);
+        rc = cyon_par_run(pairs, 1, cyon_par_merge_pair, &s);
+        if (rc != 0) break;
+        unsigned char *t = s.src; s.src = s.dst; s.dst = t;
+        s.run *= 2;
+    }
+    if (s.src != (unsigned char*)base) memcpy(base, s.src, n * size);
+    free(tmp);
+    /* out of memory for the pool job: finish on the caller, like the
+       fallback above */
+    if (rc != 0) qsort(base, n, size, cmp);
+    return 0;
+}
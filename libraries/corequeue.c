@@ -0,0 +1,309 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define CYON_CACHELINE 64
+
+/* Bounded ring of fixed-size elements. Every cell carries a sequence number
+   (Vyukov): a producer may fill cell i when seq == pos, a consumer may drain it
+   when seq == pos + 1. Sides declared single-threaded skip the CAS on their
+   position counter, which gives the SPSC and MPSC specializations. */
+typedef struct {
+    atomic_size_t seq;
+} cyon_queue_cell_t;
+
+struct cyon_queue_s {
+    _Alignas(CYON_CACHELINE) atomic_size_t enqueue_pos;
+    _Alignas(CYON_CACHELINE) atomic_size_t dequeue_pos;
+    _Alignas(CYON_CACHELINE) unsigned char *cells;
+    size_t mask;
+    size_t elem_size;
+    size_t stride;
+    int single_producer;
+    int single_consumer;
+};
+
+static inline cyon_queue_cell_t *cyon_queue_cell(cyon_queue_t *q, size_t pos) {
+    return (cyon_queue_cell_t*)(q->cells + (pos & q->mask) * q->stride);
+}
+
+static inline void *cyon_queue_cell_data(cyon_queue_cell_t *c) {
+    return (unsigned char*)c + sizeof(cyon_queue_cell_t);
+}
+
+/* Create a queue of at least capacity elements (rounded up to a power of two).
+   kind is CYON_QUEUE_MPMC, CYON_QUEUE_SPSC or CYON_QUEUE_MPSC. Returns 0 on success. */
+int cyon_queue_create(cyon_queue_t **out, int kind, size_t capacity, size_t elem_size) {
+    if (!out || capacity == 0 || elem_size == 0) return EINVAL;
+    if (kind != CYON_QUEUE_MPMC && kind != CYON_QUEUE_SPSC && kind != CYON_QUEUE_MPSC) return EINVAL;
+    size_t cap = 2;
+    while (cap < capacity) {
+        if (cap > SIZE_MAX / 2) return EINVAL;
+        cap <<= 1;
+    }
+    cyon_queue_t *q = (cyon_queue_t*)aligned_alloc(CYON_CACHELINE, sizeof(cyon_queue_t));
+    if (!q) return ENOMEM;
+    memset(q, 0, sizeof(*q));
+    q->elem_size = elem_size;
+    q->stride = (sizeof(cyon_queue_cell_t) + elem_size + 7) & ~(size_t)7;
+    q->mask = cap - 1;
+    q->cells = (unsigned char*)malloc(cap * q->stride);
+    if (!q->cells) { free(q); return ENOMEM; }
+    for (size_t i = 0; i < cap; ++i) atomic_init(&cyon_queue_cell(q, i)->seq, i);
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    q->single_producer = (kind == CYON_QUEUE_SPSC);
+    q->single_consumer = (kind == CYON_QUEUE_SPSC || kind == CYON_QUEUE_MPSC);
+    *out = q;
+    return 0;
+}
+
+void cyon_queue_destroy(cyon_queue_t *q) {
+    if (!q) return;
+    free(q->cells);
+    free(q);
+}
+
+size_t cyon_queue_capacity(const cyon_queue_t *q) {
+    return q ? q->mask + 1 : 0;
+}
+
+size_t cyon_queue_elem_size(const cyon_queue_t *q) {
+    return q ? q->elem_size : 0;
+}
+
+/* Snapshot of the element count; exact only while the queue is quiescent. */
+size_t cyon_queue_size_approx(cyon_queue_t *q) {
+    if (!q) return 0;
+    size_t tail = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    return tail >= head ? tail - head : 0;
+}
+
+/* Copy elem into the queue. Returns 0, or EAGAIN when full. */
+int cyon_queue_try_push(cyon_queue_t *q, const void *elem) {
+    if (!q || !elem) return EINVAL;
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    cyon_queue_cell_t *c;
+    for (;;) {
+        c = cyon_queue_cell(q, pos);
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (q->single_producer) {
+                atomic_store_explicit(&q->enqueue_pos, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return EAGAIN;
+        } else {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    memcpy(cyon_queue_cell_data(c), elem, q->elem_size);
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+/* Copy the oldest element into out. Returns 0, or EAGAIN when empty. */
+int cyon_queue_try_pop(cyon_queue_t *q, void *out) {
+    if (!q || !out) return EINVAL;
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    cyon_queue_cell_t *c;
+    for (;;) {
+        c = cyon_queue_cell(q, pos);
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (q->single_consumer) {
+                atomic_store_explicit(&q->dequeue_pos, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return EAGAIN;
+        } else {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    memcpy(out, cyon_queue_cell_data(c), q->elem_size);
+    atomic_store_explicit(&c->seq, pos + q->mask + 1, memory_order_release);
+    return 0;
+}
+
+/* Futex-style wait on a 32-bit word: returns when *addr != val, on wake-up,
+   or once the timeout (ns, <0 = none) expires. Falls back to sleeping elsewhere. */
+static void cyon_futex_wait(atomic_uint *addr, unsigned val, long long timeout_ns) {
+#ifdef __linux__
+    struct timespec ts, *tp = NULL;
+    if (timeout_ns >= 0) {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        tp = &ts;
+    }
+    syscall(SYS_futex, (unsigned*)addr, FUTEX_WAIT_PRIVATE, val, tp, NULL, 0);
+#else
+    (void)val;
+    struct timespec ts = { 0, 50000 };
+    if (timeout_ns >= 0 && timeout_ns < 50000) ts.tv_nsec = (long)timeout_ns;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static void cyon_futex_wake_all(atomic_uint *addr) {
+#ifdef __linux__
+    syscall(SYS_futex, (unsigned*)addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
+/* Channel: a queue plus two event words. Waiters announce themselves so the
+   fast path of send/recv never makes a syscall when nobody is blocked. */
+struct cyon_chan_s {
+    cyon_queue_t *q;
+    _Alignas(CYON_CACHELINE) atomic_uint not_empty;
+    atomic_uint recv_waiters;
+    _Alignas(CYON_CACHELINE) atomic_uint not_full;
+    atomic_uint send_waiters;
+    atomic_int closed;
+};
+
+int cyon_chan_create(cyon_chan_t **out, int kind, size_t capacity, size_t elem_size) {
+    if (!out) return EINVAL;
+    cyon_chan_t *c = (cyon_chan_t*)aligned_alloc(CYON_CACHELINE, sizeof(cyon_chan_t));
+    if (!c) return ENOMEM;
+    memset(c, 0, sizeof(*c));
+    int rc = cyon_queue_create(&c->q, kind, capacity, elem_size);
+    if (rc != 0) { free(c); return rc; }
+    atomic_init(&c->not_empty, 0);
+    atomic_init(&c->recv_waiters, 0);
+    atomic_init(&c->not_full, 0);
+    atomic_init(&c->send_waiters, 0);
+    atomic_init(&c->closed, 0);
+    *out = c;
+    return 0;
+}
+
+/* Destroy the channel; items still queued are dropped. No thread may be using it. */
+void cyon_chan_destroy(cyon_chan_t *c) {
+    if (!c) return;
+    cyon_queue_destroy(c->q);
+    free(c);
+}
+
+static inline void cyon_chan_signal(atomic_uint *word, atomic_uint *waiters) {
+    atomic_fetch_add_explicit(word, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(waiters, memory_order_seq_cst) != 0) cyon_futex_wake_all(word);
+}
+
+static long long cyon_chan_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Non-blocking send. Returns 0, EAGAIN when full, or EPIPE when closed. */
+int cyon_chan_try_send(cyon_chan_t *c, const void *elem) {
+    if (!c) return EINVAL;
+    if (atomic_load_explicit(&c->closed, memory_order_acquire)) return EPIPE;
+    int rc = cyon_queue_try_push(c->q, elem);
+    if (rc == 0) cyon_chan_signal(&c->not_empty, &c->recv_waiters);
+    return rc;
+}
+
+/* Non-blocking receive. Returns 0, EAGAIN when empty, or EPIPE when closed and drained. */
+int cyon_chan_try_recv(cyon_chan_t *c, void *out) {
+    if (!c) return EINVAL;
+    int rc = cyon_queue_try_pop(c->q, out);
+    if (rc == 0) {
+        cyon_chan_signal(&c->not_full, &c->send_waiters);
+        return 0;
+    }
+    if (rc == EAGAIN && atomic_load_explicit(&c->closed, memory_order_acquire)) {
+        /* re-check: an item may have landed just before close */
+        rc = cyon_queue_try_pop(c->q, out);
+        if (rc == 0) { cyon_chan_signal(&c->not_full, &c->send_waiters); return 0; }
+        return EPIPE;
+    }
+    return rc;
+}
+
+/* Spin briefly, then park on word until op stops returning EAGAIN. */
+static int cyon_chan_block(cyon_chan_t *c, atomic_uint *word, atomic_uint *waiters,
+                           int (*op)(cyon_chan_t*, void*), void *arg, int timeout_ms) {
+    long long deadline = timeout_ms >= 0 ? cyon_chan_now_ns() + (long long)timeout_ms * 1000000LL : -1;
+    for (int spin = 0; spin < 64; ++spin) {
+        int rc = op(c, arg);
+        if (rc != EAGAIN) return rc;
+        sched_yield();
+    }
+    for (;;) {
+        unsigned seen = atomic_load_explicit(word, memory_order_seq_cst);
+        atomic_fetch_add_explicit(waiters, 1, memory_order_seq_cst);
+        int rc = op(c, arg);
+        if (rc != EAGAIN) {
+            atomic_fetch_sub_explicit(waiters, 1, memory_order_seq_cst);
+            return rc;
+        }
+        long long left = -1;
+        if (deadline >= 0) {
+            left = deadline - cyon_chan_now_ns();
+            if (left <= 0) {
+                atomic_fetch_sub_explicit(waiters, 1, memory_order_seq_cst);
+                return ETIMEDOUT;
+            }
+        }
+        cyon_futex_wait(word, seen, left);
+        atomic_fetch_sub_explicit(waiters, 1, memory_order_seq_cst);
+    }
+}
+
+static int cyon_chan_send_op(cyon_chan_t *c, void *elem) {
+    return cyon_chan_try_send(c, elem);
+}
+
+static int cyon_chan_recv_op(cyon_chan_t *c, void *out) {
+    return cyon_chan_try_recv(c, out);
+}
+
+/* Blocking send; timeout_ms < 0 waits forever. Returns 0, ETIMEDOUT or EPIPE. */
+int cyon_chan_send(cyon_chan_t *c, const void *elem, int timeout_ms) {
+    if (!c || !elem) return EINVAL;
+    return cyon_chan_block(c, &c->not_full, &c->send_waiters, cyon_chan_send_op, (void*)elem, timeout_ms);
+}
+
+/* Blocking receive; timeout_ms < 0 waits forever.
+   Returns 0, ETIMEDOUT, or EPIPE once the channel is closed and drained. */
+int cyon_chan_recv(cyon_chan_t *c, void *out, int timeout_ms) {
+    if (!c || !out) return EINVAL;
+    return cyon_chan_block(c, &c->not_empty, &c->recv_waiters, cyon_chan_recv_op, out, timeout_ms);
+}
+
+/* Close: later sends fail with EPIPE, receivers drain what is left.
+   A send racing with close may still be delivered. Returns EALREADY if closed. */
+int cyon_chan_close(cyon_chan_t *c) {
+    if (!c) return EINVAL;
+    if (atomic_exchange_explicit(&c->closed, 1, memory_order_acq_rel)) return EALREADY;
+    cyon_chan_signal(&c->not_empty, &c->recv_waiters);
+    cyon_chan_signal(&c->not_full, &c->send_waiters);
+    return 0;
+}
+
+int cyon_chan_is_closed(cyon_chan_t *c) {
+    return c ? atomic_load_explicit(&c->closed, memory_order_acquire) : 1;
+}
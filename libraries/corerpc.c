@@ -0,0 +1,597 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyonrpc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdatomic.h>
+
+#define CYON_RPC_MAX_FRAME  524288
+#define CYON_RPC_OUT_FLUSH  65536       /* staged replies forcing a write */
+#define CYON_RPC_HEAD_MAX   (3 * CYON_VARINT_MAX)
+
+/* ---- Varints and frames ---- */
+
+size_t cyon_varint_size(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+size_t cyon_varint_encode(uint64_t v, void *out) {
+    unsigned char *p = (unsigned char*)out;
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+int cyon_varint_decode(const void *buf, size_t len, uint64_t *v) {
+    const unsigned char *p = (const unsigned char*)buf;
+    uint64_t x = 0;
+    for (size_t i = 0; i < CYON_VARINT_MAX; i++) {
+        if (i == len) return 0;
+        /* the tenth byte holds the top bit only */
+        if (i == CYON_VARINT_MAX - 1 && p[i] > 1) return -EINVAL;
+        x |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            /* overlong encodings would let a header and its re-encoding
+               differ in length */
+            if (i > 0 && p[i] == 0) return -EINVAL;
+            if (v) *v = x;
+            return (int)i + 1;
+        }
+    }
+    return -EINVAL;
+}
+
+ssize_t cyon_frame_parse(const void *buf, size_t len, size_t max, const char **msg, size_t *msg_len) {
+    if (!buf && len) return -EINVAL;
+    uint64_t n;
+    int h = cyon_varint_decode(buf, len, &n);
+    if (h <= 0) return h;
+    if (n > max) return -EMSGSIZE;
+    if ((size_t)h + n > len) return 0;
+    if (msg) *msg = (const char*)buf + h;
+    if (msg_len) *msg_len = (size_t)n;
+    return (ssize_t)((size_t)h + n);
+}
+
+int cyon_frame_write(cyon_bufconn_t *b, const void *msg, size_t len) {
+    struct iovec iov;
+    iov.iov_base = (void*)msg;
+    iov.iov_len = len;
+    return cyon_frame_writev(b, &iov, 1);
+}
+
+int cyon_frame_writev(cyon_bufconn_t *b, const struct iovec *iov, int iovcnt) {
+    if (!b || (!iov && iovcnt > 0) || iovcnt < 0) return EINVAL;
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+    unsigned char head[CYON_VARINT_MAX];
+    /* the header is copied into the write buffer next to the payload */
+    int rc = cyon_bufconn_write(b, head, cyon_varint_encode(total, head));
+    return rc ? rc : cyon_bufconn_writev(b, iov, iovcnt);
+}
+
+ssize_t cyon_frame_peek(cyon_bufconn_t *b, const char **msg, size_t max) {
+    if (!b || !msg) return -EINVAL;
+    size_t want = 1;
+    for (;;) {
+        const char *data;
+        ssize_t got = cyon_bufconn_peek(b, want, &data);
+        if (got < 0) return got;
+        if ((size_t)got < want) return got == 0 ? CYON_BUFCONN_EOF : -EPIPE;
+        size_t avail = cyon_bufconn_buffered(b);
+        size_t len;
+        ssize_t n = cyon_frame_parse(data, avail, max, msg, &len);
+        if (n < 0) return n;
+        if (n > 0) return (ssize_t)len;
+        uint64_t body;
+        int h = cyon_varint_decode(data, avail, &body);
+        want = h > 0 ? (size_t)h + (size_t)body : avail + 1;
+    }
+}
+
+void cyon_frame_consume(cyon_bufconn_t *b, size_t len) {
+    cyon_bufconn_consume(b, cyon_varint_size(len) + len);
+}
+
+/* Frame header plus the two leading varints of an RPC message. */
+static size_t cyon_rpc_head(unsigned char *out, uint64_t id, uint64_t code, size_t body) {
+    unsigned char ids[2 * CYON_VARINT_MAX];
+    size_t n = cyon_varint_encode(id, ids);
+    n += cyon_varint_encode(code, ids + n);
+    size_t h = cyon_varint_encode(n + body, out);
+    memcpy(out + h, ids, n);
+    return h + n;
+}
+
+/* Split an RPC payload into id, method or status, and body. */
+static int cyon_rpc_split(const char *msg, size_t len, uint64_t *id, uint64_t *code, const char **body,
+                          size_t *body_len) {
+    int a = cyon_varint_decode(msg, len, id);
+    if (a <= 0) return EPROTO;
+    int b = cyon_varint_decode(msg + a, len - (size_t)a, code);
+    if (b <= 0) return EPROTO;
+    *body = msg + a + b;
+    *body_len = len - (size_t)a - (size_t)b;
+    return 0;
+}
+
+/* ---- Server ---- */
+
+typedef struct {
+    cyon_rpc_handler fn;
+    void *user;
+} cyon_rpc_method_t;
+
+typedef struct cyon_rpc_conn_s cyon_rpc_conn_t;
+
+struct cyon_rpc_server_s {
+    cyon_rpc_opts_t opts;
+    cyon_conn_handlers_t handlers;
+    cyon_rpc_method_t methods[CYON_RPC_MAX_METHODS];
+    atomic_uint_fast64_t calls;
+};
+
+struct cyon_rpc_call_s {
+    cyon_rpc_conn_t *x;
+    uint64_t id;
+    uint32_t method;
+    cyon_rpc_call_t *next;          /* free list */
+};
+
+struct cyon_rpc_conn_s {
+    cyon_rpc_server_t *srv;
+    cyon_conn_t *c;                 /* NULL once the connection closed */
+    int in_data;                    /* inside on_data: replies are staged */
+    size_t outstanding;             /* calls not yet answered */
+    cyon_rpc_call_t *free_calls;
+    char *out;                      /* staged replies */
+    size_t out_len;
+    size_t out_cap;
+};
+
+static void cyon_rpc_conn_free(cyon_rpc_conn_t *x) {
+    while (x->free_calls) {
+        cyon_rpc_call_t *n = x->free_calls->next;
+        free(x->free_calls);
+        x->free_calls = n;
+    }
+    free(x->out);
+    free(x);
+}
+
+static int cyon_rpc_stage(cyon_rpc_conn_t *x, const void *data, size_t len) {
+    if (x->out_len + len > x->out_cap) {
+        size_t cap = x->out_cap ? x->out_cap : 4096;
+        while (cap < x->out_len + len) cap *= 2;
+        char *p = (char*)realloc(x->out, cap);
+        if (!p) return ENOMEM;
+        x->out = p;
+        x->out_cap = cap;
+    }
+    memcpy(x->out + x->out_len, data, len);
+    x->out_len += len;
+    return 0;
+}
+
+static int cyon_rpc_flush(cyon_rpc_conn_t *x) {
+    if (x->out_len == 0) return 0;
+    int rc = x->c ? cyon_conn_write(x->c, x->out, x->out_len) : EPIPE;
+    x->out_len = 0;
+    if (x->out_cap > 4 * CYON_RPC_OUT_FLUSH) {
+        free(x->out);
+        x->out = NULL;
+        x->out_cap = 0;
+    }
+    return rc;
+}
+
+int cyon_rpc_reply(cyon_rpc_call_t *call, int status, const void *data, size_t len) {
+    if (!call || (!data && len)) return EINVAL;
+    cyon_rpc_conn_t *x = call->x;
+    int rc = EPIPE;
+    if (x->c) {
+        unsigned char head[CYON_RPC_HEAD_MAX];
+        size_t h = cyon_rpc_head(head, call->id, (uint32_t)status, len);
+        rc = cyon_rpc_stage(x, head, h);
+        if (rc == 0 && len) rc = cyon_rpc_stage(x, data, len);
+        if (rc == 0 && (!x->in_data || x->out_len >= CYON_RPC_OUT_FLUSH)) rc = cyon_rpc_flush(x);
+    }
+    call->next = x->free_calls;
+    x->free_calls = call;
+    x->outstanding--;
+    /* the last deferred reply after the connection went away */
+    if (!x->c && !x->in_data && x->outstanding == 0) cyon_rpc_conn_free(x);
+    return rc;
+}
+
+uint32_t cyon_rpc_call_method(const cyon_rpc_call_t *call) {
+    return call ? call->method : 0;
+}
+
+cyon_reactor_t *cyon_rpc_call_reactor(const cyon_rpc_call_t *call) {
+    return call && call->x->c ? cyon_conn_reactor(call->x->c) : NULL;
+}
+
+static void cyon_rpc_on_open(cyon_conn_t *c, void *user) {
+    cyon_rpc_server_t *s = (cyon_rpc_server_t*)user;
+    cyon_rpc_conn_t *x = (cyon_rpc_conn_t*)calloc(1, sizeof(cyon_rpc_conn_t));
+    if (!x) {
+        cyon_conn_set_user(c, NULL);
+        cyon_conn_abort(c, ENOMEM);
+        return;
+    }
+    x->srv = s;
+    x->c = c;
+    cyon_conn_set_user(c, x);
+    if (s->opts.idle_timeout_ms) cyon_conn_set_timeout(c, s->opts.idle_timeout_ms);
+}
+
+static size_t cyon_rpc_on_data(cyon_conn_t *c, const char *data, size_t len, void *user) {
+    cyon_rpc_conn_t *x = (cyon_rpc_conn_t*)user;
+    if (!x) return len;
+    cyon_rpc_server_t *s = x->srv;
+    size_t total = 0;
+    x->in_data = 1;
+    while (total < len && x->c) {
+        const char *msg;
+        size_t mlen;
+        ssize_t n = cyon_frame_parse(data + total, len - total, s->opts.max_frame, &msg, &mlen);
+        if (n == 0) break;
+        uint64_t id, method;
+        const char *body;
+        size_t blen;
+        if (n < 0 || cyon_rpc_split(msg, mlen, &id, &method, &body, &blen) != 0) {
+            cyon_conn_abort(c, EPROTO);
+            break;
+        }
+        total += (size_t)n;
+        cyon_rpc_call_t *call = x->free_calls;
+        if (call) x->free_calls = call->next;
+        else call = (cyon_rpc_call_t*)malloc(sizeof(cyon_rpc_call_t));
+        if (!call) {
+            cyon_conn_abort(c, ENOMEM);
+            break;
+        }
+        call->x = x;
+        call->id = id;
+        call->method = (uint32_t)method;
+        x->outstanding++;
+        atomic_fetch_add_explicit(&s->calls, 1, memory_order_relaxed);
+        if (method < CYON_RPC_MAX_METHODS && s->methods[method].fn)
+            s->methods[method].fn(call, body, blen, s->methods[method].user);
+        else
+            cyon_rpc_reply(call, ENOSYS, NULL, 0);
+    }
+    x->in_data = 0;
+    cyon_rpc_flush(x);
+    if (!x->c) {
+        /* closed while handling: free unless deferred calls still hold x */
+        if (x->outstanding == 0) cyon_rpc_conn_free(x);
+        return len;
+    }
+    return total;
+}
+
+static void cyon_rpc_on_close(cyon_conn_t *c, int err, void *user) {
+    cyon_rpc_conn_t *x = (cyon_rpc_conn_t*)user;
+    (void)c;
+    (void)err;
+    if (!x) return;
+    x->c = NULL;
+    if (x->in_data || x->outstanding) return;
+    cyon_rpc_conn_free(x);
+}
+
+int cyon_rpc_server_create(cyon_rpc_server_t **out, const cyon_rpc_opts_t *opts) {
+    if (!out) return EINVAL;
+    cyon_rpc_server_t *s = (cyon_rpc_server_t*)calloc(1, sizeof(cyon_rpc_server_t));
+    if (!s) return ENOMEM;
+    if (opts) s->opts = *opts;
+    if (!s->opts.max_frame) s->opts.max_frame = CYON_RPC_MAX_FRAME;
+    s->handlers.on_open = cyon_rpc_on_open;
+    s->handlers.on_data = cyon_rpc_on_data;
+    s->handlers.on_close = cyon_rpc_on_close;
+    atomic_init(&s->calls, 0);
+    *out = s;
+    return 0;
+}
+
+void cyon_rpc_server_destroy(cyon_rpc_server_t *s) {
+    free(s);
+}
+
+int cyon_rpc_server_register(cyon_rpc_server_t *s, uint32_t method, cyon_rpc_handler fn, void *user) {
+    if (!s || !fn) return EINVAL;
+    if (method >= CYON_RPC_MAX_METHODS) return ERANGE;
+    s->methods[method].fn = fn;
+    s->methods[method].user = user;
+    return 0;
+}
+
+int cyon_rpc_server_listen(cyon_rpc_server_t *s, cyon_reactor_t *r, int listen_fd) {
+    if (!s || !r) return EINVAL;
+    return cyon_reactor_listen(r, listen_fd, &s->handlers, s);
+}
+
+int cyon_rpc_server_listen_group(cyon_rpc_server_t *s, cyon_reactor_group_t *g, int listen_fd) {
+    if (!s || !g) return EINVAL;
+    return cyon_reactor_group_listen(g, listen_fd, &s->handlers, s);
+}
+
+int cyon_rpc_server_adopt(cyon_rpc_server_t *s, cyon_reactor_t *r, int fd) {
+    if (!s || !r) return EINVAL;
+    return cyon_reactor_adopt(r, fd, &s->handlers, s, NULL);
+}
+
+uint64_t cyon_rpc_server_calls(const cyon_rpc_server_t *s) {
+    return s ? atomic_load_explicit(&((cyon_rpc_server_t*)s)->calls, memory_order_relaxed) : 0;
+}
+
+/* ---- Client ---- */
+
+typedef struct {
+    uint64_t id;                    /* 0 = free */
+    cyon_rpc_done done;
+    void *user;
+} cyon_rpc_pending_t;
+
+struct cyon_rpc_client_s {
+    int fd;
+    cyon_bufconn_t *b;
+    size_t max_frame;
+    uint64_t next_id;
+    cyon_rpc_pending_t *slots;      /* open addressing on id */
+    size_t mask;
+    size_t pending;
+    int failed;                     /* connection error, sticky */
+};
+
+int cyon_rpc_client_create(cyon_rpc_client_t **out, int fd, const cyon_rpc_opts_t *opts) {
+    if (!out || fd < 0) return EINVAL;
+    cyon_rpc_client_t *c = (cyon_rpc_client_t*)calloc(1, sizeof(cyon_rpc_client_t));
+    if (!c) return ENOMEM;
+    c->fd = fd;
+    c->max_frame = opts && opts->max_frame ? opts->max_frame : CYON_RPC_MAX_FRAME;
+    c->next_id = 1;
+    c->mask = 63;
+    c->slots = (cyon_rpc_pending_t*)calloc(c->mask + 1, sizeof(cyon_rpc_pending_t));
+    /* the read buffer must hold the largest frame */
+    int rc = c->slots ? cyon_bufconn_create(&c->b, fd, c->max_frame + CYON_RPC_HEAD_MAX, 0) : ENOMEM;
+    if (rc != 0) {
+        free(c->slots);
+        free(c);
+        return rc;
+    }
+    *out = c;
+    return 0;
+}
+
+static cyon_rpc_pending_t *cyon_rpc_find(cyon_rpc_client_t *c, uint64_t id) {
+    for (size_t i = id & c->mask;; i = (i + 1) & c->mask) {
+        if (c->slots[i].id == id) return &c->slots[i];
+        if (c->slots[i].id == 0) return NULL;
+    }
+}
+
+static void cyon_rpc_insert(cyon_rpc_pending_t *slots, size_t mask, const cyon_rpc_pending_t *p) {
+    size_t i = p->id & mask;
+    while (slots[i].id) i = (i + 1) & mask;
+    slots[i] = *p;
+}
+
+/* Remove a slot, shifting later entries of its probe run back. */
+static void cyon_rpc_remove(cyon_rpc_client_t *c, cyon_rpc_pending_t *p) {
+    size_t i = (size_t)(p - c->slots);
+    for (size_t j = (i + 1) & c->mask; c->slots[j].id; j = (j + 1) & c->mask) {
+        size_t home = c->slots[j].id & c->mask;
+        /* j's entry may move to i when i lies between its home and j */
+        if (((j - home) & c->mask) >= ((j - i) & c->mask)) {
+            c->slots[i] = c->slots[j];
+            i = j;
+        }
+    }
+    c->slots[i].id = 0;
+    c->pending--;
+}
+
+/* Fail every outstanding call with err. */
+static void cyon_rpc_fail(cyon_rpc_client_t *c, int err) {
+    if (!c->failed) c->failed = err;
+    for (size_t i = 0; i <= c->mask && c->pending; i++) {
+        if (!c->slots[i].id) continue;
+        cyon_rpc_pending_t p = c->slots[i];
+        c->slots[i].id = 0;
+        c->pending--;
+        p.done(err, NULL, 0, p.user);
+    }
+}
+
+void cyon_rpc_client_destroy(cyon_rpc_client_t *c) {
+    if (!c) return;
+    cyon_rpc_fail(c, ECANCELED);
+    cyon_bufconn_destroy(c->b);
+    close(c->fd);
+    free(c->slots);
+    free(c);
+}
+
+size_t cyon_rpc_client_pending(const cyon_rpc_client_t *c) {
+    return c ? c->pending : 0;
+}
+
+int cyon_rpc_client_send(cyon_rpc_client_t *c, uint32_t method, const void *req, size_t len,
+                         cyon_rpc_done done, void *user) {
+    if (!c || !done || (!req && len)) return EINVAL;
+    if (c->failed) return c->failed;
+    if (len > c->max_frame - CYON_RPC_HEAD_MAX) return EMSGSIZE;
+    /* keep the table at most half full */
+    if ((c->pending + 1) * 2 > c->mask + 1) {
+        size_t mask = c->mask * 2 + 1;
+        cyon_rpc_pending_t *slots = (cyon_rpc_pending_t*)calloc(mask + 1, sizeof(cyon_rpc_pending_t));
+        if (!slots) return ENOMEM;
+        for (size_t i = 0; i <= c->mask; i++)
+            if (c->slots[i].id) cyon_rpc_insert(slots, mask, &c->slots[i]);
+        free(c->slots);
+        c->slots = slots;
+        c->mask = mask;
+    }
+    cyon_rpc_pending_t p;
+    p.id = c->next_id++;
+    p.done = done;
+    p.user = user;
+    unsigned char head[CYON_RPC_HEAD_MAX];
+    struct iovec iov[2];
+    iov[0].iov_base = head;
+    iov[0].iov_len = cyon_rpc_head(head, p.id, method, len);
+    iov[1].iov_base = (void*)req;
+    iov[1].iov_len = len;
+    int rc = cyon_bufconn_writev(c->b, iov, len ? 2 : 1);
+    if (rc != 0) {
+        cyon_rpc_fail(c, rc);
+        return rc;
+    }
+    cyon_rpc_insert(c->slots, c->mask, &p);
+    c->pending++;
+    return 0;
+}
+
+int cyon_rpc_client_flush(cyon_rpc_client_t *c) {
+    if (!c) return EINVAL;
+    if (c->failed) return c->failed;
+    int rc = cyon_bufconn_flush(c->b);
+    if (rc != 0) cyon_rpc_fail(c, rc);
+    return rc;
+}
+
+/* Dispatch the responses already buffered; returns how many matched a
+   call, or -errno on a protocol error. */
+static int cyon_rpc_dispatch(cyon_rpc_client_t *c) {
+    int done = 0;
+    for (;;) {
+        size_t avail = cyon_bufconn_buffered(c->b);
+        const char *data;
+        if (avail == 0 || cyon_bufconn_peek(c->b, avail, &data) <= 0) return done;
+        const char *msg;
+        size_t mlen;
+        ssize_t n = cyon_frame_parse(data, avail, c->max_frame, &msg, &mlen);
+        if (n == 0) return done;
+        uint64_t id, status;
+        const char *body;
+        size_t blen;
+        if (n < 0 || cyon_rpc_split(msg, mlen, &id, &status, &body, &blen) != 0) {
+            cyon_rpc_fail(c, EPROTO);
+            return -EPROTO;
+        }
+        /* consumed before the callback, which may poll this client again;
+           the bytes stay in place until the next read */
+        cyon_bufconn_consume(c->b, (size_t)n);
+        /* unknown ids belong to calls that timed out */
+        cyon_rpc_pending_t *p = id ? cyon_rpc_find(c, id) : NULL;
+        if (p) {
+            cyon_rpc_pending_t call = *p;
+            cyon_rpc_remove(c, p);
+            call.done((int)(uint32_t)status, body, blen, call.user);
+            done++;
+        }
+    }
+}
+
+int cyon_rpc_client_poll(cyon_rpc_client_t *c, int timeout_ms) {
+    if (!c) return -EINVAL;
+    int rc = cyon_rpc_client_flush(c);
+    if (rc != 0) return -rc;
+    uint64_t deadline = timeout_ms > 0 ? cyon_time_monotonic_us() + (uint64_t)timeout_ms * 1000 : 0;
+    for (;;) {
+        int done = cyon_rpc_dispatch(c);
+        if (done != 0 || c->pending == 0) return done;
+        int wait = timeout_ms;
+        if (timeout_ms > 0) {
+            uint64_t now = cyon_time_monotonic_us();
+            if (now >= deadline) return 0;
+            wait = (int)((deadline - now + 999) / 1000);
+        }
+        struct pollfd pfd;
+        pfd.fd = c->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int n = poll(&pfd, 1, wait);
+        if (n == 0) return 0;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        /* readable: one read brings at least a byte or the end */
+        size_t avail = cyon_bufconn_buffered(c->b);
+        const char *data;
+        ssize_t got = cyon_bufconn_peek(c->b, avail + 1, &data);
+        if (got < 0 || (size_t)got <= avail) {
+            int err = got == -EMSGSIZE ? EPROTO : got < 0 ? (int)-got : EPIPE;
+            cyon_rpc_fail(c, err);
+            return -err;
+        }
+    }
+}
+
+typedef struct {
+    int done;
+    int status;
+    void *resp;
+    size_t len;
+    int keep;
+} cyon_rpc_wait_t;
+
+static void cyon_rpc_call_done(int status, const void *resp, size_t len, void *user) {
+    cyon_rpc_wait_t *w = (cyon_rpc_wait_t*)user;
+    w->done = 1;
+    w->status = status;
+    if (w->keep && status == 0) {
+        w->resp = malloc(len ? len : 1);
+        if (!w->resp) w->status = ENOMEM;
+        else if (len) memcpy(w->resp, resp, len);
+        w->len = len;
+    }
+}
+
+int cyon_rpc_call(cyon_rpc_client_t *c, uint32_t method, const void *req, size_t len,
+                  void **resp, size_t *resp_len, int timeout_ms) {
+    if (!c) return EINVAL;
+    cyon_rpc_wait_t w;
+    memset(&w, 0, sizeof(w));
+    w.keep = resp != NULL;
+    uint64_t id = c->next_id;
+    int rc = cyon_rpc_client_send(c, method, req, len, cyon_rpc_call_done, &w);
+    if (rc != 0) return rc;
+    uint64_t deadline = timeout_ms > 0 ? cyon_time_monotonic_us() + (uint64_t)timeout_ms * 1000 : 0;
+    while (!w.done) {
+        int wait = timeout_ms;
+        if (timeout_ms > 0) {
+            uint64_t now = cyon_time_monotonic_us();
+            wait = now >= deadline ? 0 : (int)((deadline - now + 999) / 1000);
+        }
+        int n = cyon_rpc_client_poll(c, wait);
+        if (n < 0 || w.done) break;
+        if (n == 0 && timeout_ms >= 0 && (timeout_ms == 0 || cyon_time_monotonic_us() >= deadline)) {
+            /* forget the call; a late response is dropped by id */
+            cyon_rpc_pending_t *p = cyon_rpc_find(c, id);
+            if (p) cyon_rpc_remove(c, p);
+            return ETIMEDOUT;
+        }
+    }
+    if (!w.done) return c->failed ? c->failed : EIO;
+    if (resp) *resp = w.resp;
+    if (resp_len) *resp_len = w.len;
+    return w.status;
+}
@@ -1,12 +1,17 @@
+#define _GNU_SOURCE
 #include "cyonstd.h"
 #include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
 
 /* Simple opaque thread handle. */
-typedef struct {
+struct cyon_thread_s {
     pthread_t thr;
-} cyon_thread_t;
+};
 
 /* Create thread, detach flag determines whether to detach.
    start_routine receives the provided arg. Returns 0 on success. */
@@ -32,6 +37,46 @@ int cyon_thread_join(cyon_thread_t *t) {
     return rc;
 }
 
+/* Fill a cpu_set_t from a CPU id list. Returns 0, or EINVAL if none is usable. */
+static int cyon_cpuset_from_list(cpu_set_t *set, const int *cpus, size_t n) {
+    CPU_ZERO(set);
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) continue;
+        CPU_SET(cpus[i], set);
+        used++;
+    }
+    return used ? 0 : EINVAL;
+}
+
+/* Like cyon_thread_create, but the thread starts already restricted to cpus,
+   so it never runs (or first-touches memory) anywhere else. */
+int cyon_thread_create_on(cyon_thread_t **out_thread, void *(*start_routine)(void*), void *arg, int detach,
+                          const int *cpus, size_t ncpus) {
+    if (!out_thread || !start_routine || !cpus || ncpus == 0) return EINVAL;
+    cpu_set_t set;
+    if (cyon_cpuset_from_list(&set, cpus, ncpus) != 0) return EINVAL;
+    cyon_thread_t *t = (cyon_thread_t*)malloc(sizeof(cyon_thread_t));
+    if (!t) return ENOMEM;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (detach) pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    int rc = pthread_create(&t->thr, &attr, start_routine, arg);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) { free(t); return rc; }
+    *out_thread = t;
+    return 0;
+}
+
+/* Restrict a running thread to cpus. Returns 0 on success. */
+int cyon_thread_set_affinity(cyon_thread_t *t, const int *cpus, size_t ncpus) {
+    if (!t || !cpus || ncpus == 0) return EINVAL;
+    cpu_set_t set;
+    if (cyon_cpuset_from_list(&set, cpus, ncpus) != 0) return EINVAL;
+    return pthread_setaffinity_np(t->thr, sizeof(set), &set);
+}
+
 /* Detach an existing thread handle. Returns 0 on success. */
 int cyon_thread_detach(cyon_thread_t *t) {
     if (!t) return EINVAL;
@@ -40,9 +85,9 @@ int cyon_thread_detach(cyon_thread_t *t) {
 }
 
 /* Mutex wrapper. */
-typedef struct {
+struct cyon_mutex_s {
     pthread_mutex_t m;
-} cyon_mutex_t;
+};
 
 /* Create mutex. Returns 0 on success. */
 int cyon_mutex_create(cyon_mutex_t **out) {
@@ -77,10 +122,10 @@ int cyon_mutex_destroy(cyon_mutex_t *m) {
 }
 
 /* Condition variable wrapper. */
-typedef struct {
+struct cyon_cond_s {
     pthread_cond_t cv;
     pthread_mutex_t m;
-} cyon_cond_t;
+};
 
 /* Create cond. Returns 0 on success. */
 int cyon_cond_create(cyon_cond_t **out) {
@@ -95,15 +140,34 @@ int cyon_cond_create(cyon_cond_t **out) {
     return 0;
 }
 
+/* Legacy waits on the private mutex. It must be held across the wait, which
+   keeps these well-defined, but they cannot guard a caller's predicate:
+   prefer cyon_cond_wait_mutex. */
 int cyon_cond_wait(cyon_cond_t *c) {
     if (!c) return EINVAL;
+    pthread_mutex_lock(&c->m);
     int rc = pthread_cond_wait(&c->cv, &c->m);
+    pthread_mutex_unlock(&c->m);
     return rc;
 }
 
 int cyon_cond_timedwait(cyon_cond_t *c, const struct timespec *abstime) {
     if (!c || !abstime) return EINVAL;
-    return pthread_cond_timedwait(&c->cv, &c->m, abstime);
+    pthread_mutex_lock(&c->m);
+    int rc = pthread_cond_timedwait(&c->cv, &c->m, abstime);
+    pthread_mutex_unlock(&c->m);
+    return rc;
+}
+
+/* Wait with the caller's mutex, which must be locked by the caller. */
+int cyon_cond_wait_mutex(cyon_cond_t *c, cyon_mutex_t *m) {
+    if (!c || !m) return EINVAL;
+    return pthread_cond_wait(&c->cv, &m->m);
+}
+
+int cyon_cond_timedwait_mutex(cyon_cond_t *c, cyon_mutex_t *m, const struct timespec *abstime) {
+    if (!c || !m || !abstime) return EINVAL;
+    return pthread_cond_timedwait(&c->cv, &m->m, abstime);
 }
 
 int cyon_cond_signal(cyon_cond_t *c) {
@@ -128,4 +192,508 @@ int cyon_cond_destroy(cyon_cond_t *c) {
 typedef struct {
     void *(*func)(void*);
     void *arg;
-} cyon_task_t;
\ No newline at end of file
+} cyon_task_t;
+/* Fixed-size worker pool with a mutex-protected ring of tasks. */
+struct cyon_threadpool_s {
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    cyon_task_t *ring;
+    size_t cap;
+    size_t head;
+    size_t count;
+    int stopping;
+    size_t nthreads;
+    pthread_t *threads;
+    int node;                    /* NUMA node for CYON_PLACE_NODE pools, else -1 */
+    cyon_node_arena_t *arena;    /* created on first cyon_threadpool_arena() */
+};
+
+static void *cyon_threadpool_worker(void *arg) {
+    cyon_threadpool_t *p = (cyon_threadpool_t*)arg;
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->count == 0 && !p->stopping) pthread_cond_wait(&p->has_work, &p->lock);
+        if (p->count == 0 && p->stopping) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        cyon_task_t task = p->ring[p->head];
+        p->head = (p->head + 1) % p->cap;
+        p->count--;
+        pthread_mutex_unlock(&p->lock);
+        task.func(task.arg);
+    }
+    return NULL;
+}
+
+/* Create a pool whose worker i is started with affinity cpusets[i] (or
+   unrestricted when cpusets is NULL). */
+static int cyon_threadpool_start(cyon_threadpool_t **out, size_t nthreads, int node,
+                                 const cpu_set_t *cpusets) {
+    cyon_threadpool_t *p = (cyon_threadpool_t*)calloc(1, sizeof(cyon_threadpool_t));
+    if (!p) return ENOMEM;
+    p->node = node;
+    p->cap = 64;
+    p->ring = (cyon_task_t*)malloc(p->cap * sizeof(cyon_task_t));
+    p->threads = (pthread_t*)calloc(nthreads, sizeof(pthread_t));
+    if (!p->ring || !p->threads) { free(p->ring); free(p->threads); free(p); return ENOMEM; }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->has_work, NULL);
+    for (size_t i = 0; i < nthreads; ++i) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (cpusets) pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpusets[i]);
+        int rc = pthread_create(&p->threads[i], &attr, cyon_threadpool_worker, p);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            p->nthreads = i;
+            cyon_threadpool_destroy(p);
+            return rc;
+        }
+    }
+    p->nthreads = nthreads;
+    *out = p;
+    return 0;
+}
+
+/* Create pool with nthreads workers (0 = online CPU count). Returns 0 on success. */
+int cyon_threadpool_create(cyon_threadpool_t **out, size_t nthreads) {
+    if (!out) return EINVAL;
+    if (nthreads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = n > 0 ? (size_t)n : 1;
+    }
+    return cyon_threadpool_start(out, nthreads, -1, NULL);
+}
+
+/* Create a pool placed on the machine topology.
+   CYON_PLACE_COMPACT pins worker i to the i-th CPU filling cores and nodes
+   in order; CYON_PLACE_SCATTER spreads workers across nodes and cores first;
+   CYON_PLACE_NODE keeps every worker on the CPUs of node (nthreads 0 = all
+   of them). Workers wrap around when there are more workers than CPUs. */
+int cyon_threadpool_create_placed(cyon_threadpool_t **out, size_t nthreads, int policy, int node) {
+    if (!out) return EINVAL;
+    if (policy == CYON_PLACE_NONE) return cyon_threadpool_create(out, nthreads);
+    const cyon_topology_t *topo = cyon_topology_get();
+    size_t ncpus = topo->ncpus;
+    if (ncpus == 0) return ENOTSUP;
+    int *order = (int*)malloc(ncpus * sizeof(int));
+    if (!order) return ENOMEM;
+    size_t n;
+    if (policy == CYON_PLACE_NODE) {
+        if (node < 0 || (size_t)node >= topo->nnodes) { free(order); return EINVAL; }
+        n = cyon_topology_node_cpus(node, order, ncpus);
+    } else if (policy == CYON_PLACE_COMPACT || policy == CYON_PLACE_SCATTER) {
+        n = cyon_topology_order(policy, order, ncpus);
+        node = -1;
+    } else {
+        free(order);
+        return EINVAL;
+    }
+    if (n == 0) { free(order); return ENODEV; }
+    if (nthreads == 0) nthreads = n;
+    cpu_set_t *sets = (cpu_set_t*)calloc(nthreads, sizeof(cpu_set_t));
+    if (!sets) { free(order); return ENOMEM; }
+    for (size_t i = 0; i < nthreads; i++) {
+        if (policy == CYON_PLACE_NODE) cyon_cpuset_from_list(&sets[i], order, n);
+        else cyon_cpuset_from_list(&sets[i], &order[i % n], 1);
+    }
+    int rc = cyon_threadpool_start(out, nthreads, node, sets);
+    free(sets);
+    free(order);
+    return rc;
+}
+
+/* One CYON_PLACE_NODE pool per NUMA node that has CPUs. Returns the number
+   of pools written to pools (at most cap) or 0 on failure. */
+size_t cyon_threadpool_create_per_node(cyon_threadpool_t **pools, size_t cap, size_t threads_per_node) {
+    if (!pools) return 0;
+    const cyon_topology_t *topo = cyon_topology_get();
+    size_t made = 0;
+    for (size_t node = 0; node < topo->nnodes && made < cap; node++) {
+        if (cyon_topology_node_cpus((int)node, NULL, 0) == 0) continue;
+        if (cyon_threadpool_create_placed(&pools[made], threads_per_node, CYON_PLACE_NODE, (int)node) != 0) {
+            while (made > 0) cyon_threadpool_destroy(pools[--made]);
+            return 0;
+        }
+        made++;
+    }
+    return made;
+}
+
+int cyon_threadpool_node(const cyon_threadpool_t *p) {
+    return p ? p->node : -1;
+}
+
+/* Arena on the pool's node, for data its workers own. Node-less pools get
+   an arena on the caller's current node. */
+cyon_node_arena_t *cyon_threadpool_arena(cyon_threadpool_t *p) {
+    if (!p) return NULL;
+    pthread_mutex_lock(&p->lock);
+    if (!p->arena) {
+        int node = p->node >= 0 ? p->node : cyon_current_node();
+        if (cyon_node_arena_create(&p->arena, node < 0 ? 0 : node, 0) != 0) p->arena = NULL;
+    }
+    cyon_node_arena_t *a = p->arena;
+    pthread_mutex_unlock(&p->lock);
+    return a;
+}
+
+/* Queue func(arg) for execution. The queue grows as needed. Returns 0 on success. */
+int cyon_threadpool_submit(cyon_threadpool_t *p, void *(*func)(void*), void *arg) {
+    if (!p || !func) return EINVAL;
+    pthread_mutex_lock(&p->lock);
+    if (p->stopping) { pthread_mutex_unlock(&p->lock); return ECANCELED; }
+    if (p->count == p->cap) {
+        size_t ncap = p->cap * 2;
+        cyon_task_t *nr = (cyon_task_t*)malloc(ncap * sizeof(cyon_task_t));
+        if (!nr) { pthread_mutex_unlock(&p->lock); return ENOMEM; }
+        for (size_t i = 0; i < p->count; ++i) nr[i] = p->ring[(p->head + i) % p->cap];
+        free(p->ring);
+        p->ring = nr;
+        p->cap = ncap;
+        p->head = 0;
+    }
+    p->ring[(p->head + p->count) % p->cap] = (cyon_task_t){ func, arg };
+    p->count++;
+    pthread_cond_signal(&p->has_work);
+    pthread_mutex_unlock(&p->lock);
+    return 0;
+}
+
+size_t cyon_threadpool_size(const cyon_threadpool_t *p) {
+    return p ? p->nthreads : 0;
+}
+
+/* Run remaining tasks, join workers and free the pool. Returns 0 on success. */
+int cyon_threadpool_destroy(cyon_threadpool_t *p) {
+    if (!p) return EINVAL;
+    pthread_mutex_lock(&p->lock);
+    p->stopping = 1;
+    pthread_cond_broadcast(&p->has_work);
+    pthread_mutex_unlock(&p->lock);
+    for (size_t i = 0; i < p->nthreads; ++i) pthread_join(p->threads[i], NULL);
+    pthread_cond_destroy(&p->has_work);
+    pthread_mutex_destroy(&p->lock);
+    cyon_node_arena_destroy(p->arena);
+    free(p->threads);
+    free(p->ring);
+    free(p);
+    return 0;
+}
+
+static cyon_threadpool_t *cyon_shared_pool = NULL;
+static pthread_once_t cyon_shared_pool_once = PTHREAD_ONCE_INIT;
+
+static void cyon_shared_pool_init(void) {
+    if (cyon_threadpool_create(&cyon_shared_pool, 0) != 0) cyon_shared_pool = NULL;
+}
+
+cyon_threadpool_t *cyon_threadpool_shared(void) {
+    pthread_once(&cyon_shared_pool_once, cyon_shared_pool_init);
+    return cyon_shared_pool;
+}
+
+/* Future state. Completion is published under lock; callbacks registered
+   before completion are kept in a list and run by the completing thread. */
+typedef struct cyon_future_cb_node {
+    cyon_future_cb cb;
+    void *user;
+    struct cyon_future_cb_node *next;
+} cyon_future_cb_node_t;
+
+struct cyon_future_s {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cv;
+    atomic_int refs;
+    int done;
+    int err;
+    void *value;
+    size_t winner;
+    cyon_future_cb_node_t *callbacks;
+};
+
+int cyon_future_create(cyon_future_t **out) {
+    if (!out) return EINVAL;
+    cyon_future_t *f = (cyon_future_t*)calloc(1, sizeof(cyon_future_t));
+    if (!f) return ENOMEM;
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->done_cv, NULL);
+    atomic_init(&f->refs, 1);
+    *out = f;
+    return 0;
+}
+
+void cyon_future_retain(cyon_future_t *f) {
+    if (f) atomic_fetch_add_explicit(&f->refs, 1, memory_order_relaxed);
+}
+
+static int cyon_future_complete(cyon_future_t *f, void *value, int err, size_t winner);
+
+void cyon_future_release(cyon_future_t *f) {
+    if (!f) return;
+    if (atomic_fetch_sub_explicit(&f->refs, 1, memory_order_acq_rel) != 1) return;
+    if (!f->done && f->callbacks) {
+        /* nobody is left to complete it: cancel, so that then/when_all
+           targets waiting on it fail instead of hanging. Nothing else can
+           reach f, so the reference is taken back for the callbacks, which
+           may retain and release it like any other future */
+        atomic_store_explicit(&f->refs, 1, memory_order_relaxed);
+        cyon_future_complete(f, NULL, ECANCELED, 0);
+        cyon_future_release(f);
+        return;
+    }
+    pthread_cond_destroy(&f->done_cv);
+    pthread_mutex_destroy(&f->lock);
+    free(f);
+}
+
+static int cyon_future_complete(cyon_future_t *f, void *value, int err, size_t winner) {
+    if (!f) return EINVAL;
+    pthread_mutex_lock(&f->lock);
+    if (f->done) { pthread_mutex_unlock(&f->lock); return EALREADY; }
+    f->done = 1;
+    f->value = value;
+    f->err = err;
+    f->winner = winner;
+    cyon_future_cb_node_t *list = f->callbacks;
+    f->callbacks = NULL;
+    pthread_cond_broadcast(&f->done_cv);
+    pthread_mutex_unlock(&f->lock);
+
+    /* callbacks were pushed LIFO; run them in registration order */
+    cyon_future_cb_node_t *rev = NULL;
+    while (list) { cyon_future_cb_node_t *next = list->next; list->next = rev; rev = list; list = next; }
+    cyon_future_retain(f);
+    while (rev) {
+        cyon_future_cb_node_t *next = rev->next;
+        rev->cb(f, rev->user);
+        free(rev);
+        rev = next;
+    }
+    cyon_future_release(f);
+    return 0;
+}
+
+/* Returns 0, or EALREADY if the future was already completed. */
+int cyon_future_resolve(cyon_future_t *f, void *value) {
+    return cyon_future_complete(f, value, 0, 0);
+}
+
+int cyon_future_reject(cyon_future_t *f, int err) {
+    return cyon_future_complete(f, NULL, err ? err : -1, 0);
+}
+
+int cyon_future_on_complete(cyon_future_t *f, cyon_future_cb cb, void *user) {
+    if (!f || !cb) return EINVAL;
+    pthread_mutex_lock(&f->lock);
+    if (!f->done) {
+        cyon_future_cb_node_t *n = (cyon_future_cb_node_t*)malloc(sizeof(cyon_future_cb_node_t));
+        if (!n) { pthread_mutex_unlock(&f->lock); return ENOMEM; }
+        n->cb = cb;
+        n->user = user;
+        n->next = f->callbacks;
+        f->callbacks = n;
+        pthread_mutex_unlock(&f->lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&f->lock);
+    cb(f, user);
+    return 0;
+}
+
+int cyon_future_is_ready(cyon_future_t *f) {
+    if (!f) return 0;
+    pthread_mutex_lock(&f->lock);
+    int done = f->done;
+    pthread_mutex_unlock(&f->lock);
+    return done;
+}
+
+size_t cyon_future_winner(cyon_future_t *f) {
+    if (!f) return 0;
+    pthread_mutex_lock(&f->lock);
+    size_t w = f->winner;
+    pthread_mutex_unlock(&f->lock);
+    return w;
+}
+
+int cyon_future_get(cyon_future_t *f, void **value, int timeout_ms) {
+    if (!f) return EINVAL;
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000L; }
+    }
+    pthread_mutex_lock(&f->lock);
+    while (!f->done) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&f->done_cv, &f->lock);
+        } else if (pthread_cond_timedwait(&f->done_cv, &f->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    int rc = f->done ? f->err : ETIMEDOUT;
+    if (f->done && rc == 0 && value) *value = f->value;
+    pthread_mutex_unlock(&f->lock);
+    return rc;
+}
+
+/* Pool trampoline shared by async and then: owns one reference to target. */
+typedef struct {
+    cyon_future_t *target;
+    void *(*fn)(void*);
+    void *(*cont)(void*, void*);
+    void *arg;
+    void *input;
+} cyon_future_job_t;
+
+static void *cyon_future_run_job(void *p) {
+    cyon_future_job_t *job = (cyon_future_job_t*)p;
+    void *result = job->cont ? job->cont(job->input, job->arg) : job->fn(job->arg);
+    cyon_future_resolve(job->target, result);
+    cyon_future_release(job->target);
+    free(job);
+    return NULL;
+}
+
+static int cyon_future_schedule(cyon_future_job_t *job) {
+    cyon_threadpool_t *pool = cyon_threadpool_shared();
+    int rc = pool ? cyon_threadpool_submit(pool, cyon_future_run_job, job) : ENOMEM;
+    if (rc != 0) {
+        cyon_future_reject(job->target, rc);
+        cyon_future_release(job->target);
+        free(job);
+    }
+    return rc;
+}
+
+int cyon_future_async(cyon_future_t **out, void *(*fn)(void*), void *arg) {
+    if (!out || !fn) return EINVAL;
+    cyon_future_t *f;
+    int rc = cyon_future_create(&f);
+    if (rc != 0) return rc;
+    cyon_future_job_t *job = (cyon_future_job_t*)calloc(1, sizeof(cyon_future_job_t));
+    if (!job) { cyon_future_release(f); return ENOMEM; }
+    cyon_future_retain(f);
+    job->target = f;
+    job->fn = fn;
+    job->arg = arg;
+    cyon_future_schedule(job);
+    *out = f;
+    return 0;
+}
+
+static void cyon_future_then_cb(cyon_future_t *src, void *user) {
+    cyon_future_job_t *job = (cyon_future_job_t*)user;
+    if (src->err != 0) {
+        cyon_future_reject(job->target, src->err);
+        cyon_future_release(job->target);
+        free(job);
+        return;
+    }
+    job->input = src->value;
+    cyon_future_schedule(job);
+}
+
+int cyon_future_then(cyon_future_t **out, cyon_future_t *f, void *(*fn)(void *value, void *arg), void *arg) {
+    if (!out || !f || !fn) return EINVAL;
+    cyon_future_t *next;
+    int rc = cyon_future_create(&next);
+    if (rc != 0) return rc;
+    cyon_future_job_t *job = (cyon_future_job_t*)calloc(1, sizeof(cyon_future_job_t));
+    if (!job) { cyon_future_release(next); return ENOMEM; }
+    cyon_future_retain(next);
+    job->target = next;
+    job->cont = fn;
+    job->arg = arg;
+    rc = cyon_future_on_complete(f, cyon_future_then_cb, job);
+    if (rc != 0) {
+        cyon_future_release(next);
+        cyon_future_release(next);
+        free(job);
+        return rc;
+    }
+    *out = next;
+    return 0;
+}
+
+/* Shared countdown for when_all / when_any. */
+typedef struct {
+    cyon_future_t *target;
+    atomic_size_t remaining;
+    atomic_int refs;
+    int any;
+} cyon_future_join_t;
+
+typedef struct {
+    cyon_future_join_t *join;
+    size_t index;
+} cyon_future_join_arm_t;
+
+static void cyon_future_join_unref(cyon_future_join_t *j) {
+    if (atomic_fetch_sub_explicit(&j->refs, 1, memory_order_acq_rel) == 1) {
+        cyon_future_release(j->target);
+        free(j);
+    }
+}
+
+static void cyon_future_join_cb(cyon_future_t *src, void *user) {
+    cyon_future_join_arm_t *arm = (cyon_future_join_arm_t*)user;
+    cyon_future_join_t *j = arm->join;
+    if (j->any) {
+        cyon_future_complete(j->target, src->value, src->err, arm->index);
+    } else if (src->err) {
+        cyon_future_reject(j->target, src->err);
+    } else if (atomic_fetch_sub_explicit(&j->remaining, 1, memory_order_acq_rel) == 1) {
+        cyon_future_resolve(j->target, NULL);
+    }
+    free(arm);
+    cyon_future_join_unref(j);
+}
+
+static int cyon_future_join(cyon_future_t **out, cyon_future_t *const *fs, size_t n, int any) {
+    if (!out || (!fs && n > 0)) return EINVAL;
+    cyon_future_t *target;
+    int rc = cyon_future_create(&target);
+    if (rc != 0) return rc;
+    if (n == 0) {
+        if (any) cyon_future_reject(target, EINVAL);
+        else cyon_future_resolve(target, NULL);
+        *out = target;
+        return 0;
+    }
+    cyon_future_join_t *j = (cyon_future_join_t*)calloc(1, sizeof(cyon_future_join_t));
+    if (!j) { cyon_future_release(target); return ENOMEM; }
+    cyon_future_retain(target);
+    j->target = target;
+    j->any = any;
+    atomic_init(&j->remaining, n);
+    atomic_init(&j->refs, 1);
+    for (size_t i = 0; i < n; ++i) {
+        cyon_future_join_arm_t *arm = (cyon_future_join_arm_t*)malloc(sizeof(cyon_future_join_arm_t));
+        if (!arm) { cyon_future_reject(target, ENOMEM); break; }
+        arm->join = j;
+        arm->index = i;
+        atomic_fetch_add_explicit(&j->refs, 1, memory_order_relaxed);
+        if (cyon_future_on_complete(fs[i], cyon_future_join_cb, arm) != 0) {
+            free(arm);
+            cyon_future_join_unref(j);
+            cyon_future_reject(target, ENOMEM);
+            break;
+        }
+    }
+    cyon_future_join_unref(j);
+    *out = target;
+    return 0;
+}
+
+int cyon_future_when_all(cyon_future_t **out, cyon_future_t *const *fs, size_t n) {
+    return cyon_future_join(out, fs, n, 0);
+}
+
+int cyon_future_when_any(cyon_future_t **out, cyon_future_t *const *fs, size_t n) {
+    return cyon_future_join(out, fs, n, 1);
+}
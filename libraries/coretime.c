@@ -5,6 +5,10 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
 
 /* Return current unix epoch seconds. */
 long cyon_time_now_seconds(void) {
@@ -42,4 +46,301 @@ int cyon_epoch_to_year(long epoch) {
     struct tm tm;
     if (!localtime_r((time_t*)&epoch, &tm)) return -1;
     return tm.tm_year + 1900;
-}
\ No newline at end of file
+}
+
+/* Monotonic clock in microseconds. */
+uint64_t cyon_time_monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/* ---- hierarchical timer wheel ---- */
+
+#define CYON_TIMER_MASK (CYON_TIMER_SLOTS - 1)
+
+enum { CYON_TIMER_IDLE = 0, CYON_TIMER_QUEUED = 1, CYON_TIMER_FIRING = 2 };
+
+struct cyon_timer_wheel_s {
+    uint64_t tick_us;
+    uint64_t start_us;
+    uint64_t tick;                  /* last processed tick */
+    size_t count;
+    uint64_t occupied[CYON_TIMER_LEVELS];
+    cyon_timer_t slots[CYON_TIMER_LEVELS][CYON_TIMER_SLOTS]; /* list sentinels */
+    int tfd;
+    uint64_t armed_tick;            /* tick the timerfd is armed for, 0 = disarmed */
+};
+
+static void cyon_timer_list_init(cyon_timer_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static void cyon_timer_unlink(cyon_timer_wheel_t *w, cyon_timer_t *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    /* the sentinel knows its own slot: clear the occupancy bit when it empties */
+    if (t->next == t->prev && t->next->state < 0) {
+        int lvl = -t->next->state - 1;
+        int idx = t->next->flags;
+        w->occupied[lvl] &= ~(1ULL << idx);
+    }
+    t->next = t->prev = NULL;
+}
+
+/* Place t by its expiry. Ticks at or before min_tick land in min_tick's slot. */
+static void cyon_timer_insert(cyon_timer_wheel_t *w, cyon_timer_t *t, uint64_t min_tick) {
+    uint64_t exp = t->expires < min_tick ? min_tick : t->expires;
+    uint64_t delta = exp - w->tick;
+    int lvl = 0;
+    while (lvl < CYON_TIMER_LEVELS - 1 &&
+           delta >= (1ULL << (CYON_TIMER_LEVEL_BITS * (lvl + 1))))
+        lvl++;
+    if (lvl == CYON_TIMER_LEVELS - 1 &&
+        delta >= (1ULL << (CYON_TIMER_LEVEL_BITS * CYON_TIMER_LEVELS))) {
+        /* beyond the wheel's span: park in the last slot and re-cascade later */
+        exp = w->tick + (1ULL << (CYON_TIMER_LEVEL_BITS * CYON_TIMER_LEVELS)) - 1;
+    }
+    int idx = (int)((exp >> (CYON_TIMER_LEVEL_BITS * lvl)) & CYON_TIMER_MASK);
+    cyon_timer_t *head = &w->slots[lvl][idx];
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+    w->occupied[lvl] |= 1ULL << idx;
+    t->state = CYON_TIMER_QUEUED;
+}
+
+int cyon_timer_wheel_create(cyon_timer_wheel_t **out, uint64_t tick_us) {
+    if (!out || tick_us == 0) return EINVAL;
+    cyon_timer_wheel_t *w = (cyon_timer_wheel_t*)calloc(1, sizeof(cyon_timer_wheel_t));
+    if (!w) return ENOMEM;
+    w->tick_us = tick_us;
+    w->start_us = cyon_time_monotonic_us();
+    w->tfd = -1;
+    for (int l = 0; l < CYON_TIMER_LEVELS; l++) {
+        for (int i = 0; i < CYON_TIMER_SLOTS; i++) {
+            cyon_timer_t *h = &w->slots[l][i];
+            cyon_timer_list_init(h);
+            h->state = -(l + 1);   /* sentinel marker: level */
+            h->flags = i;          /* and slot index */
+        }
+    }
+    *out = w;
+    return 0;
+}
+
+void cyon_timer_wheel_destroy(cyon_timer_wheel_t *w) {
+    if (!w) return;
+    for (int l = 0; l < CYON_TIMER_LEVELS; l++) {
+        for (int i = 0; i < CYON_TIMER_SLOTS; i++) {
+            cyon_timer_t *h = &w->slots[l][i];
+            while (h->next != h) {
+                cyon_timer_t *t = h->next;
+                cyon_timer_unlink(w, t);
+                t->state = CYON_TIMER_IDLE;
+            }
+        }
+    }
+    if (w->tfd >= 0) close(w->tfd);
+    free(w);
+}
+
+void cyon_timer_init(cyon_timer_t *t, cyon_timer_cb cb, void *user) {
+    if (!t) return;
+    memset(t, 0, sizeof(*t));
+    t->cb = cb;
+    t->user = user;
+}
+
+static void cyon_timer_rearm_fd(cyon_timer_wheel_t *w);
+
+int cyon_timer_start(cyon_timer_wheel_t *w, cyon_timer_t *t, uint64_t delay_us, uint64_t period_us, int flags) {
+    if (!w || !t || !t->cb) return EINVAL;
+    if (t->state == CYON_TIMER_QUEUED) {
+        cyon_timer_unlink(w, t);
+        w->count--;
+    }
+    /* the wheel may lag the clock when the loop was busy; count from now */
+    uint64_t now_tick = (cyon_time_monotonic_us() - w->start_us) / w->tick_us;
+    if (now_tick < w->tick) now_tick = w->tick;
+    uint64_t delay = (delay_us + w->tick_us - 1) / w->tick_us;
+    t->expires = now_tick + (delay ? delay : 1);
+    t->period = period_us ? (period_us + w->tick_us - 1) / w->tick_us : 0;
+    t->flags = flags;
+    if (flags & CYON_TIMER_COARSE) {
+        /* round up to the granularity of the level it will sit on */
+        uint64_t delta = t->expires - w->tick;
+        int lvl = 0;
+        while (lvl < CYON_TIMER_LEVELS - 1 && delta >= (1ULL << (CYON_TIMER_LEVEL_BITS * (lvl + 1)))) lvl++;
+        uint64_t g = 1ULL << (CYON_TIMER_LEVEL_BITS * lvl);
+        t->expires = (t->expires + g - 1) & ~(g - 1);
+    }
+    cyon_timer_insert(w, t, w->tick + 1);
+    w->count++;
+    if (w->tfd >= 0 && (w->armed_tick == 0 || t->expires < w->armed_tick)) cyon_timer_rearm_fd(w);
+    return 0;
+}
+
+int cyon_timer_cancel(cyon_timer_wheel_t *w, cyon_timer_t *t) {
+    if (!w || !t) return EINVAL;
+    if (t->state == CYON_TIMER_QUEUED) {
+        cyon_timer_unlink(w, t);
+        w->count--;
+    }
+    t->state = CYON_TIMER_IDLE;
+    return 0;
+}
+
+int cyon_timer_pending(const cyon_timer_t *t) {
+    return t && t->state == CYON_TIMER_QUEUED;
+}
+
+size_t cyon_timer_wheel_count(const cyon_timer_wheel_t *w) {
+    return w ? w->count : 0;
+}
+
+static uint64_t cyon_timer_rotr(uint64_t v, unsigned r) {
+    r &= 63;
+    return r ? (v >> r) | (v << (64 - r)) : v;
+}
+
+/* Earliest tick after w->tick at which some occupied slot is processed
+   (fired on level 0, cascaded above). 0 when the wheel is empty. */
+static uint64_t cyon_timer_next_tick(cyon_timer_wheel_t *w) {
+    uint64_t best = 0;
+    for (int l = 0; l < CYON_TIMER_LEVELS; l++) {
+        if (!w->occupied[l]) continue;
+        unsigned shift = CYON_TIMER_LEVEL_BITS * (unsigned)l;
+        uint64_t base = (w->tick >> shift) + 1;    /* next slot boundary on this level */
+        uint64_t r = cyon_timer_rotr(w->occupied[l], (unsigned)(base & CYON_TIMER_MASK));
+        uint64_t t = (base + (uint64_t)__builtin_ctzll(r)) << shift;
+        if (best == 0 || t < best) best = t;
+    }
+    return best;
+}
+
+/* Move every timer of slot (lvl, idx) down the hierarchy. */
+static void cyon_timer_cascade(cyon_timer_wheel_t *w, int lvl, int idx) {
+    cyon_timer_t *head = &w->slots[lvl][idx];
+    cyon_timer_t list;
+    if (head->next == head) return;
+    list.next = head->next;
+    list.prev = head->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    cyon_timer_list_init(head);
+    w->occupied[lvl] &= ~(1ULL << idx);
+    while (list.next != &list) {
+        cyon_timer_t *t = list.next;
+        list.next = t->next;
+        t->next->prev = &list;
+        cyon_timer_insert(w, t, w->tick);
+    }
+}
+
+static size_t cyon_timer_fire_slot(cyon_timer_wheel_t *w, int idx) {
+    cyon_timer_t *head = &w->slots[0][idx];
+    size_t fired = 0;
+    while (head->next != head) {
+        cyon_timer_t *t = head->next;
+        cyon_timer_unlink(w, t);
+        w->count--;
+        t->state = CYON_TIMER_FIRING;
+        t->cb(t, t->user);
+        fired++;
+        if (t->state == CYON_TIMER_FIRING) {
+            if (t->period) {
+                t->expires += t->period;
+                if (t->expires <= w->tick) {
+                    uint64_t behind = w->tick - t->expires;
+                    t->expires += (behind / t->period + 1) * t->period;
+                }
+                cyon_timer_insert(w, t, w->tick + 1);
+                w->count++;
+            } else {
+                t->state = CYON_TIMER_IDLE;
+            }
+        }
+    }
+    return fired;
+}
+
+size_t cyon_timer_wheel_advance(cyon_timer_wheel_t *w, uint64_t now_us) {
+    if (!w) return 0;
+    uint64_t target = now_us > w->start_us ? (now_us - w->start_us) / w->tick_us : 0;
+    size_t fired = 0;
+    while (w->tick < target) {
+        uint64_t next = cyon_timer_next_tick(w);
+        if (next == 0 || next > target) {
+            w->tick = target;
+            break;
+        }
+        w->tick = next;
+        /* cascade from the highest level that wrapped at this tick */
+        int top = 0;
+        while (top < CYON_TIMER_LEVELS - 1 &&
+               ((w->tick >> (CYON_TIMER_LEVEL_BITS * (top + 1))) << (CYON_TIMER_LEVEL_BITS * (top + 1))) == w->tick)
+            top++;
+        for (int l = top; l >= 1; l--) {
+            if ((w->tick & ((1ULL << (CYON_TIMER_LEVEL_BITS * l)) - 1)) != 0) continue;
+            int idx = (int)((w->tick >> (CYON_TIMER_LEVEL_BITS * l)) & CYON_TIMER_MASK);
+            cyon_timer_cascade(w, l, idx);
+        }
+        fired += cyon_timer_fire_slot(w, (int)(w->tick & CYON_TIMER_MASK));
+    }
+    if (w->tfd >= 0) cyon_timer_rearm_fd(w);
+    return fired;
+}
+
+int cyon_timer_wheel_next_timeout_ms(cyon_timer_wheel_t *w) {
+    if (!w) return -1;
+    uint64_t next = cyon_timer_next_tick(w);
+    if (next == 0) return -1;
+    uint64_t due_us = w->start_us + next * w->tick_us;
+    uint64_t now = cyon_time_monotonic_us();
+    if (due_us <= now) return 0;
+    uint64_t ms = (due_us - now + 999) / 1000;
+    return ms > (uint64_t)INT32_MAX ? INT32_MAX : (int)ms;
+}
+
+static void cyon_timer_rearm_fd(cyon_timer_wheel_t *w) {
+#ifdef __linux__
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    uint64_t next = cyon_timer_next_tick(w);
+    w->armed_tick = next;
+    if (next != 0) {
+        uint64_t due_us = w->start_us + next * w->tick_us;
+        its.it_value.tv_sec = (time_t)(due_us / 1000000ULL);
+        its.it_value.tv_nsec = (long)(due_us % 1000000ULL) * 1000L;
+    }
+    timerfd_settime(w->tfd, TFD_TIMER_ABSTIME, &its, NULL);
+#else
+    (void)w;
+#endif
+}
+
+int cyon_timer_wheel_fd(cyon_timer_wheel_t *w) {
+    if (!w) return -1;
+#ifdef __linux__
+    if (w->tfd < 0) {
+        w->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (w->tfd >= 0) cyon_timer_rearm_fd(w);
+    }
+    return w->tfd;
+#else
+    return -1;
+#endif
+}
+
+size_t cyon_timer_wheel_on_fd(cyon_timer_wheel_t *w) {
+    if (!w) return 0;
+    if (w->tfd >= 0) {
+        uint64_t expirations;
+        ssize_t r = read(w->tfd, &expirations, sizeof(expirations));
+        (void)r;
+    }
+    return cyon_timer_wheel_advance(w, cyon_time_monotonic_us());
+}
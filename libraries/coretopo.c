@@ -0,0 +1,371 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef CYON_SYSFS_CPU
+#define CYON_SYSFS_CPU  "/sys/devices/system/cpu"
+#endif
+#ifndef CYON_SYSFS_NODE
+#define CYON_SYSFS_NODE "/sys/devices/system/node"
+#endif
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+/* Read a small sysfs file into buf. Returns 0 on success. */
+static int cyon_topo_read(const char *path, char *buf, size_t cap) {
+    FILE *f = fopen(path, "r");
+    if (!f) return errno ? errno : ENOENT;
+    size_t n = fread(buf, 1, cap - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    return 0;
+}
+
+static int cyon_topo_read_int(const char *path, int fallback) {
+    char buf[64];
+    if (cyon_topo_read(path, buf, sizeof(buf)) != 0) return fallback;
+    return atoi(buf);
+}
+
+/* Parse a kernel cpu list ("0-3,8,10-11"), calling fn for every id. */
+static void cyon_topo_parse_list(const char *s, void (*fn)(int id, void *user), void *user) {
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10);
+        if (end == s) { s++; continue; }
+        long b = a;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long i = a; i <= b; i++) fn((int)i, user);
+        if (*s == ',') s++;
+    }
+}
+
+typedef struct {
+    int *ids;
+    size_t n;
+    size_t cap;
+} cyon_topo_idlist_t;
+
+static void cyon_topo_collect(int id, void *user) {
+    cyon_topo_idlist_t *l = (cyon_topo_idlist_t*)user;
+    if (l->n == l->cap) {
+        size_t ncap = l->cap ? l->cap * 2 : 64;
+        int *ni = (int*)realloc(l->ids, ncap * sizeof(int));
+        if (!ni) return;
+        l->ids = ni;
+        l->cap = ncap;
+    }
+    l->ids[l->n++] = id;
+}
+
+static cyon_topology_t g_topo;
+static pthread_once_t g_topo_once = PTHREAD_ONCE_INIT;
+
+static cyon_cpu_info_t *cyon_topo_find(int cpu) {
+    for (size_t i = 0; i < g_topo.ncpus; i++)
+        if (g_topo.cpus[i].cpu == cpu) return &g_topo.cpus[i];
+    return NULL;
+}
+
+static void cyon_topo_set_node(int cpu, void *user) {
+    cyon_cpu_info_t *c = cyon_topo_find(cpu);
+    if (c) c->node = *(int*)user;
+}
+
+/* Discover online CPUs, their package/core ids and NUMA node from sysfs.
+   Without sysfs every online CPU is treated as its own core on node 0. */
+static void cyon_topo_discover(void) {
+    char buf[4096];
+    cyon_topo_idlist_t online = { NULL, 0, 0 };
+    if (cyon_topo_read(CYON_SYSFS_CPU "/online", buf, sizeof(buf)) == 0)
+        cyon_topo_parse_list(buf, cyon_topo_collect, &online);
+    if (online.n == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long i = 0; i < (n > 0 ? n : 1); i++) cyon_topo_collect((int)i, &online);
+    }
+    g_topo.cpus = (cyon_cpu_info_t*)calloc(online.n ? online.n : 1, sizeof(cyon_cpu_info_t));
+    if (!g_topo.cpus) { free(online.ids); return; }
+    g_topo.ncpus = online.n;
+
+    char path[256];
+    for (size_t i = 0; i < online.n; i++) {
+        cyon_cpu_info_t *c = &g_topo.cpus[i];
+        c->cpu = online.ids[i];
+        snprintf(path, sizeof(path), CYON_SYSFS_CPU "/cpu%d/topology/physical_package_id", c->cpu);
+        c->package = cyon_topo_read_int(path, 0);
+        snprintf(path, sizeof(path), CYON_SYSFS_CPU "/cpu%d/topology/core_id", c->cpu);
+        c->core = cyon_topo_read_int(path, c->cpu);
+        c->node = 0;
+    }
+    free(online.ids);
+
+    /* NUMA nodes: each nodeN/cpulist names its CPUs */
+    cyon_topo_idlist_t nodes = { NULL, 0, 0 };
+    if (cyon_topo_read(CYON_SYSFS_NODE "/online", buf, sizeof(buf)) == 0)
+        cyon_topo_parse_list(buf, cyon_topo_collect, &nodes);
+    int max_node = 0;
+    for (size_t k = 0; k < nodes.n; k++) {
+        int node = nodes.ids[k];
+        snprintf(path, sizeof(path), CYON_SYSFS_NODE "/node%d/cpulist", node);
+        if (cyon_topo_read(path, buf, sizeof(buf)) == 0)
+            cyon_topo_parse_list(buf, cyon_topo_set_node, &node);
+        if (node > max_node) max_node = node;
+    }
+    free(nodes.ids);
+    g_topo.nnodes = (size_t)max_node + 1;
+
+    /* number SMT siblings within each (package, core) and count cores */
+    int max_pkg = 0;
+    for (size_t i = 0; i < g_topo.ncpus; i++) {
+        cyon_cpu_info_t *c = &g_topo.cpus[i];
+        if (c->package > max_pkg) max_pkg = c->package;
+        c->smt = 0;
+        for (size_t j = 0; j < i; j++) {
+            cyon_cpu_info_t *o = &g_topo.cpus[j];
+            if (o->package == c->package && o->core == c->core) c->smt++;
+        }
+        if (c->smt == 0) g_topo.ncores++;
+    }
+    g_topo.npackages = (size_t)max_pkg + 1;
+}
+
+const cyon_topology_t *cyon_topology_get(void) {
+    pthread_once(&g_topo_once, cyon_topo_discover);
+    return &g_topo;
+}
+
+/* CPUs of one NUMA node, in id order. Returns how many exist (may exceed cap). */
+size_t cyon_topology_node_cpus(int node, int *cpus, size_t cap) {
+    const cyon_topology_t *t = cyon_topology_get();
+    size_t n = 0;
+    for (size_t i = 0; i < t->ncpus; i++) {
+        if (t->cpus[i].node != node) continue;
+        if (cpus && n < cap) cpus[n] = t->cpus[i].cpu;
+        n++;
+    }
+    return n;
+}
+
+static int cyon_topo_cmp_compact(const void *a, const void *b) {
+    const cyon_cpu_info_t *x = (const cyon_cpu_info_t*)a;
+    const cyon_cpu_info_t *y = (const cyon_cpu_info_t*)b;
+    if (x->node != y->node) return x->node - y->node;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+/* Scatter key: SMT index first, then the core's rank on its node, then node,
+   so consecutive workers land on different nodes and different cores. */
+typedef struct {
+    cyon_cpu_info_t info;
+    int rank;
+} cyon_topo_ranked_t;
+
+static int cyon_topo_cmp_scatter(const void *a, const void *b) {
+    const cyon_topo_ranked_t *x = (const cyon_topo_ranked_t*)a;
+    const cyon_topo_ranked_t *y = (const cyon_topo_ranked_t*)b;
+    if (x->info.smt != y->info.smt) return x->info.smt - y->info.smt;
+    if (x->rank != y->rank) return x->rank - y->rank;
+    if (x->info.node != y->info.node) return x->info.node - y->info.node;
+    return x->info.cpu - y->info.cpu;
+}
+
+/* Fill cpus with the placement order for policy (CYON_PLACE_COMPACT or
+   CYON_PLACE_SCATTER). Returns the number of CPUs written. */
+size_t cyon_topology_order(int policy, int *cpus, size_t cap) {
+    const cyon_topology_t *t = cyon_topology_get();
+    size_t n = t->ncpus;
+    if (n == 0 || !cpus) return 0;
+    cyon_topo_ranked_t *v = (cyon_topo_ranked_t*)calloc(n, sizeof(cyon_topo_ranked_t));
+    if (!v) return 0;
+    for (size_t i = 0; i < n; i++) v[i].info = t->cpus[i];
+    if (policy == CYON_PLACE_SCATTER) {
+        /* rank = index of the CPU's core among primary threads of its node */
+        for (size_t i = 0; i < n; i++) {
+            int rank = 0;
+            for (size_t j = 0; j < n; j++) {
+                const cyon_cpu_info_t *o = &t->cpus[j];
+                if (o->node == v[i].info.node && o->smt == 0 &&
+                    cyon_topo_cmp_compact(o, &v[i].info) < 0 &&
+                    !(o->package == v[i].info.package && o->core == v[i].info.core))
+                    rank++;
+            }
+            v[i].rank = rank;
+        }
+        qsort(v, n, sizeof(cyon_topo_ranked_t), cyon_topo_cmp_scatter);
+    } else {
+        for (size_t i = 0; i < n; i++) v[i].rank = 0;
+        qsort(v, n, sizeof(cyon_topo_ranked_t), cyon_topo_cmp_compact);
+    }
+    size_t w = n < cap ? n : cap;
+    for (size_t i = 0; i < w; i++) cpus[i] = v[i].info.cpu;
+    free(v);
+    return w;
+}
+
+int cyon_current_cpu(void) {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+int cyon_current_node(void) {
+    int cpu = cyon_current_cpu();
+    if (cpu < 0) return -1;
+    cyon_topology_get();
+    cyon_cpu_info_t *c = cyon_topo_find(cpu);
+    return c ? c->node : -1;
+}
+
+/* Pin the calling thread to the given CPUs. Returns 0 on success. */
+int cyon_thread_pin_self(const int *cpus, size_t n) {
+    if (!cpus || n == 0) return EINVAL;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < n; i++)
+        if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) CPU_SET(cpus[i], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    return ENOTSUP;
+#endif
+}
+
+/* ---- node-local arenas ----
+   Chunks are mmap'd and bound to the node with mbind(MPOL_PREFERRED), so
+   pages come from that node when it has memory and spill over otherwise.
+   Allocation is a bump pointer; nothing is freed until reset/destroy. */
+
+typedef struct cyon_node_chunk_s {
+    struct cyon_node_chunk_s *next;
+    size_t size;
+    size_t used;
+} cyon_node_chunk_t;
+
+struct cyon_node_arena_s {
+    cyon_lock_t lock;
+    int node;
+    size_t chunk_size;
+    cyon_node_chunk_t *chunks;
+    size_t total;
+};
+
+static void cyon_node_bind(void *addr, size_t len, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node < 0 || node >= 1024) return;
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    /* best effort: without NUMA support the kernel returns ENOSYS/EINVAL and
+       first-touch placement by node-local workers still applies */
+    syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask, (unsigned long)1024, 0);
+#else
+    (void)addr; (void)len; (void)node;
+#endif
+}
+
+static cyon_node_chunk_t *cyon_node_chunk_new(int node, size_t size) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    cyon_node_bind(p, size, node);
+    cyon_node_chunk_t *c = (cyon_node_chunk_t*)p;
+    c->next = NULL;
+    c->size = size;
+    c->used = (sizeof(cyon_node_chunk_t) + 63) & ~(size_t)63;
+    return c;
+}
+
+int cyon_node_arena_create(cyon_node_arena_t **out, int node, size_t chunk_size) {
+    if (!out) return EINVAL;
+    cyon_node_arena_t *a = (cyon_node_arena_t*)calloc(1, sizeof(cyon_node_arena_t));
+    if (!a) return ENOMEM;
+    cyon_lock_init(&a->lock, "node_arena");
+    a->node = node;
+    a->chunk_size = chunk_size ? chunk_size : (size_t)4 << 20;
+    *out = a;
+    return 0;
+}
+
+void *cyon_node_arena_alloc(cyon_node_arena_t *a, size_t size, size_t align) {
+    if (!a || size == 0) return NULL;
+    if (align == 0) align = 16;
+    if (align & (align - 1)) return NULL;
+    cyon_lock_acquire(&a->lock);
+    cyon_node_chunk_t *c = a->chunks;
+    size_t off = c ? (c->used + align - 1) & ~(align - 1) : 0;
+    if (!c || off + size > c->size) {
+        size_t need = ((sizeof(cyon_node_chunk_t) + 63) & ~(size_t)63) + size + align;
+        size_t csize = need > a->chunk_size ? need : a->chunk_size;
+        cyon_node_chunk_t *nc = cyon_node_chunk_new(a->node, csize);
+        if (!nc) { cyon_lock_release(&a->lock); return NULL; }
+        nc->next = a->chunks;
+        a->chunks = nc;
+        a->total += csize;
+        c = nc;
+        off = (c->used + align - 1) & ~(align - 1);
+    }
+    c->used = off + size;
+    cyon_lock_release(&a->lock);
+    return (char*)c + off;
+}
+
+int cyon_node_arena_node(const cyon_node_arena_t *a) {
+    return a ? a->node : -1;
+}
+
+size_t cyon_node_arena_reserved(cyon_node_arena_t *a) {
+    if (!a) return 0;
+    cyon_lock_acquire(&a->lock);
+    size_t t = a->total;
+    cyon_lock_release(&a->lock);
+    return t;
+}
+
+/* Drop every allocation but keep the newest chunk mapped for reuse. */
+void cyon_node_arena_reset(cyon_node_arena_t *a) {
+    if (!a) return;
+    cyon_lock_acquire(&a->lock);
+    cyon_node_chunk_t *keep = a->chunks;
+    cyon_node_chunk_t *c = keep ? keep->next : NULL;
+    while (c) {
+        cyon_node_chunk_t *next = c->next;
+        munmap(c, c->size);
+        c = next;
+    }
+    if (keep) {
+        keep->next = NULL;
+        keep->used = (sizeof(cyon_node_chunk_t) + 63) & ~(size_t)63;
+        a->total = keep->size;
+    }
+    cyon_lock_release(&a->lock);
+}
+
+void cyon_node_arena_destroy(cyon_node_arena_t *a) {
+    if (!a) return;
+    cyon_node_chunk_t *c = a->chunks;
+    while (c) {
+        cyon_node_chunk_t *next = c->next;
+        munmap(c, c->size);
+        c = next;
+    }
+    free(a);
+}
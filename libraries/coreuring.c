@@ -0,0 +1,326 @@
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include "cyonuring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define cyon_load_acquire(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define cyon_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+struct cyon_uring_s {
+    int fd;
+    unsigned features;
+    void *sq_map;
+    size_t sq_map_len;
+    void *cq_map;
+    size_t cq_map_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+    unsigned *sq_khead;
+    unsigned *sq_ktail;
+    unsigned *sq_kflags;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_tail;               /* local; published on submit */
+    unsigned *cq_khead;
+    unsigned *cq_ktail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+    uint64_t enters;
+    /* fixed files */
+    int *free_slots;
+    unsigned nfree;
+    unsigned nslots;
+    /* provided buffers */
+    struct io_uring_buf_ring *br;
+    size_t br_len;
+    char *bufs;
+    unsigned buf_count;
+    unsigned buf_size;
+    unsigned short bgid;
+    unsigned short br_tail;
+};
+
+static int cyon_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int cyon_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                            void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int cyon_uring_register(int fd, unsigned op, void *arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+static pthread_once_t cyon_uring_probe_once = PTHREAD_ONCE_INIT;
+static int cyon_uring_ok = 0;
+static unsigned char cyon_uring_ops[256];
+
+static void *cyon_uring_probe_run(void *arg) {
+    (void)arg;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = cyon_uring_setup(4, &p);
+    if (fd < 0) return NULL;
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *pr = (struct io_uring_probe*)calloc(1, len);
+    if (pr && cyon_uring_register(fd, IORING_REGISTER_PROBE, pr, 256) == 0) {
+        for (unsigned i = 0; i < pr->ops_len; i++)
+            if (pr->ops[i].flags & IO_URING_OP_SUPPORTED) cyon_uring_ops[pr->ops[i].op] = 1;
+        /* timeouts on the wait and CQ overflow without loss are required */
+        cyon_uring_ok = (p.features & IORING_FEAT_EXT_ARG) && (p.features & IORING_FEAT_NODROP) &&
+                        (p.features & IORING_FEAT_SINGLE_MMAP);
+    }
+    free(pr);
+    close(fd);
+    return NULL;
+}
+
+/* Tearing a ring down makes the kernel queue exit work to the thread that
+   set it up with TWA_SIGNAL, which cuts a blocking call with a timeout
+   short with EINTR some time later. Probe on a thread of our own so the
+   caller never sees that. */
+static void cyon_uring_probe(void) {
+    const char *env = getenv("CYON_NO_URING");
+    if (env && *env && *env != '0') return;
+    pthread_t t;
+    if (pthread_create(&t, NULL, cyon_uring_probe_run, NULL) != 0) return;
+    pthread_join(t, NULL);
+}
+
+int cyon_uring_available(void) {
+    pthread_once(&cyon_uring_probe_once, cyon_uring_probe);
+    return cyon_uring_ok;
+}
+
+int cyon_uring_supports(int op) {
+    if (!cyon_uring_available() || op < 0 || op > 255) return 0;
+    return cyon_uring_ops[op];
+}
+
+int cyon_uring_create(cyon_uring_t **out, unsigned entries) {
+    if (!out) return EINVAL;
+    if (!cyon_uring_available()) return ENOSYS;
+    unsigned n = 1;
+    while (n < entries) n <<= 1;
+    cyon_uring_t *u = (cyon_uring_t*)calloc(1, sizeof(cyon_uring_t));
+    if (!u) return ENOMEM;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+    p.cq_entries = n * 4;
+    u->fd = cyon_uring_setup(n, &p);
+    if (u->fd < 0 && errno == EINVAL) {
+        /* older kernels: no task-run hints */
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = n * 4;
+        u->fd = cyon_uring_setup(n, &p);
+    }
+    if (u->fd < 0) {
+        int rc = errno;
+        free(u);
+        return rc;
+    }
+    u->features = p.features;
+    u->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (cq_len > u->sq_map_len) u->sq_map_len = cq_len;
+    u->sq_map = mmap(NULL, u->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = (struct io_uring_sqe*)mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                         u->fd, IORING_OFF_SQES);
+    if (u->sq_map == MAP_FAILED || u->sqes == MAP_FAILED) {
+        int rc = errno;
+        if (u->sq_map != MAP_FAILED) munmap(u->sq_map, u->sq_map_len);
+        if (u->sqes != MAP_FAILED) munmap(u->sqes, u->sqes_len);
+        close(u->fd);
+        free(u);
+        return rc;
+    }
+    char *sq = (char*)u->sq_map;
+    u->cq_map = u->sq_map;          /* IORING_FEAT_SINGLE_MMAP, checked by the probe */
+    u->sq_khead = (unsigned*)(sq + p.sq_off.head);
+    u->sq_ktail = (unsigned*)(sq + p.sq_off.tail);
+    u->sq_kflags = (unsigned*)(sq + p.sq_off.flags);
+    u->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    u->sq_entries = *(unsigned*)(sq + p.sq_off.ring_entries);
+    u->sq_tail = *u->sq_ktail;
+    /* identity index array: slot i always holds SQE i */
+    unsigned *array = (unsigned*)(sq + p.sq_off.array);
+    for (unsigned i = 0; i < u->sq_entries; i++) array[i] = i;
+    u->cq_khead = (unsigned*)(sq + p.cq_off.head);
+    u->cq_ktail = (unsigned*)(sq + p.cq_off.tail);
+    u->cq_mask = *(unsigned*)(sq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe*)(sq + p.cq_off.cqes);
+    *out = u;
+    return 0;
+}
+
+void cyon_uring_destroy(cyon_uring_t *u) {
+    if (!u) return;
+    close(u->fd);                   /* the kernel cancels whatever is in flight */
+    munmap(u->sqes, u->sqes_len);
+    munmap(u->sq_map, u->sq_map_len);
+    if (u->br) munmap(u->br, u->br_len);
+    free(u->bufs);
+    free(u->free_slots);
+    free(u);
+}
+
+struct io_uring_sqe *cyon_uring_sqe(cyon_uring_t *u) {
+    if (!u) return NULL;
+    if (u->sq_tail - cyon_load_acquire(u->sq_khead) >= u->sq_entries) {
+        if (cyon_uring_submit(u, 0, 0) != 0) return NULL;
+        if (u->sq_tail - cyon_load_acquire(u->sq_khead) >= u->sq_entries) return NULL;
+    }
+    struct io_uring_sqe *sqe = &u->sqes[u->sq_tail & u->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    u->sq_tail++;
+    return sqe;
+}
+
+int cyon_uring_submit(cyon_uring_t *u, unsigned wait_nr, int timeout_ms) {
+    if (!u) return EINVAL;
+    cyon_store_release(u->sq_ktail, u->sq_tail);
+    unsigned to_submit = u->sq_tail - cyon_load_acquire(u->sq_khead);
+    unsigned flags = 0;
+    unsigned kflags = cyon_load_acquire(u->sq_kflags);
+    if (wait_nr > 0 || (kflags & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW))) flags |= IORING_ENTER_GETEVENTS;
+    if (to_submit == 0 && flags == 0) return 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    void *argp = NULL;
+    size_t argsz = 0;
+    if (wait_nr > 0 && timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        argp = &arg;
+        argsz = sizeof(arg);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    for (;;) {
+        u->enters++;
+        int rc = cyon_uring_enter(u->fd, to_submit, wait_nr, flags, argp, argsz);
+        if (rc >= 0) return 0;
+        if (errno == EINTR) {
+            if (wait_nr > 0) return 0;
+            continue;
+        }
+        /* ETIME: timed out; EBUSY: completions must be reaped first */
+        if (errno == ETIME || errno == EBUSY) return errno == ETIME ? ETIME : 0;
+        return errno;
+    }
+}
+
+struct io_uring_cqe *cyon_uring_peek(cyon_uring_t *u) {
+    unsigned head = *u->cq_khead;
+    if (head == cyon_load_acquire(u->cq_ktail)) return NULL;
+    return &u->cqes[head & u->cq_mask];
+}
+
+void cyon_uring_advance(cyon_uring_t *u, unsigned n) {
+    cyon_store_release(u->cq_khead, *u->cq_khead + n);
+}
+
+uint64_t cyon_uring_enter_count(const cyon_uring_t *u) {
+    return u ? u->enters : 0;
+}
+
+int cyon_uring_files_init(cyon_uring_t *u, unsigned n) {
+    if (!u || n == 0 || u->free_slots) return EINVAL;
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = n;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    if (cyon_uring_register(u->fd, IORING_REGISTER_FILES2, &reg, sizeof(reg)) < 0) return errno;
+    u->free_slots = (int*)malloc(n * sizeof(int));
+    if (!u->free_slots) return ENOMEM;
+    for (unsigned i = 0; i < n; i++) u->free_slots[i] = (int)(n - 1 - i);
+    u->nfree = n;
+    u->nslots = n;
+    return 0;
+}
+
+int cyon_uring_file_alloc(cyon_uring_t *u) {
+    if (!u || u->nfree == 0) return -1;
+    return u->free_slots[--u->nfree];
+}
+
+void cyon_uring_file_free(cyon_uring_t *u, int slot) {
+    if (u && slot >= 0 && (unsigned)slot < u->nslots && u->nfree < u->nslots) u->free_slots[u->nfree++] = slot;
+}
+
+int cyon_uring_bufs_init(cyon_uring_t *u, unsigned short bgid, unsigned count, unsigned size) {
+    if (!u || u->br || count == 0 || count > 32768 || (count & (count - 1)) || size == 0) return EINVAL;
+    u->br_len = count * sizeof(struct io_uring_buf);
+    u->br = (struct io_uring_buf_ring*)mmap(NULL, u->br_len, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (u->br == MAP_FAILED) {
+        u->br = NULL;
+        return errno;
+    }
+    u->bufs = (char*)malloc((size_t)count * size);
+    if (!u->bufs) {
+        munmap(u->br, u->br_len);
+        u->br = NULL;
+        return ENOMEM;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)u->br;
+    reg.ring_entries = count;
+    reg.bgid = bgid;
+    if (cyon_uring_register(u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        int rc = errno;
+        munmap(u->br, u->br_len);
+        free(u->bufs);
+        u->br = NULL;
+        u->bufs = NULL;
+        return rc;
+    }
+    u->bgid = bgid;
+    u->buf_count = count;
+    u->buf_size = size;
+    u->br_tail = 0;
+    for (unsigned i = 0; i < count; i++) {
+        struct io_uring_buf *b = &u->br->bufs[i];
+        b->addr = (uint64_t)(uintptr_t)(u->bufs + (size_t)i * size);
+        b->len = size;
+        b->bid = (unsigned short)i;
+    }
+    u->br_tail = (unsigned short)count;
+    cyon_store_release(&u->br->tail, u->br_tail);
+    return 0;
+}
+
+void *cyon_uring_buf(cyon_uring_t *u, unsigned short bid) {
+    if (!u || !u->bufs || bid >= u->buf_count) return NULL;
+    return u->bufs + (size_t)bid * u->buf_size;
+}
+
+unsigned cyon_uring_buf_size(const cyon_uring_t *u) {
+    return u ? u->buf_size : 0;
+}
+
+void cyon_uring_buf_recycle(cyon_uring_t *u, unsigned short bid) {
+    if (!u || !u->br || bid >= u->buf_count) return;
+    struct io_uring_buf *b = &u->br->bufs[u->br_tail & (u->buf_count - 1)];
+    b->addr = (uint64_t)(uintptr_t)(u->bufs + (size_t)bid * u->buf_size);
+    b->len = u->buf_size;
+    b->bid = bid;
+    u->br_tail++;
+    cyon_store_release(&u->br->tail, u->br_tail);
+}
@@ -0,0 +1,195 @@
+/* HTTP request parsing: cyon_http_parse_request on complete, partial,
+   pipelined and malformed heads, then the server over a socketpair with a
+   pipelined mix of Content-Length, chunked (extensions, trailers, fed a few
+   bytes at a time) and bodiless requests, and a malformed chunk size.
+   build: gcc -Iinclude tests/test_http.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+static int http_eq(cyon_slice_t s, const char *lit) {
+    return s.len == strlen(lit) && memcmp(s.ptr, lit, s.len) == 0;
+}
+
+static ssize_t http_parse(const char *text, cyon_http_request_t *req) {
+    size_t scanned = 0;
+    return cyon_http_parse_request(text, strlen(text), &scanned, req);
+}
+
+static int http_parse_run(void) {
+    cyon_http_request_t req;
+    const char *get = "GET /a/b?x=1&y=2 HTTP/1.1\r\nHost: h\r\nX-Long:   padded value \t\r\n\r\n";
+    int ok = http_parse(get, &req) == (ssize_t)strlen(get);
+    ok = ok && http_eq(req.method, "GET") && http_eq(req.target, "/a/b?x=1&y=2") && http_eq(req.path, "/a/b")
+            && http_eq(req.query, "x=1&y=2") && req.minor == 1 && req.nheaders == 2 && req.keep_alive
+            && req.content_length == -1 && !req.chunked && req.body.len == 0;
+    ok = ok && http_eq(cyon_http_header(&req, "x-long"), "padded value")
+            && cyon_http_header(&req, "missing").ptr == NULL;
+    printf("http-parse basic: %s\n", ok ? "OK" : "FAIL");
+    int fail = !ok;
+
+    /* one byte at a time, carrying scanned: incomplete until the blank line */
+    size_t len = strlen(get), scanned = 0;
+    ok = 1;
+    for (size_t i = 1; ok && i < len; i++) ok = cyon_http_parse_request(get, i, &scanned, &req) == 0;
+    ok = ok && cyon_http_parse_request(get, len, &scanned, &req) == (ssize_t)len && http_eq(req.path, "/a/b");
+    printf("http-parse incremental: %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* pipelined: the next head starts where the previous request ended */
+    const char *pipe = "POST /p HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+                       "PUT /q HTTP/1.0\r\nConnection: keep-alive\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+                       "GET /r HTTP/1.0\r\n\r\n";
+    size_t off = 0;
+    scanned = 0;
+    ssize_t h = cyon_http_parse_request(pipe, strlen(pipe), &scanned, &req);
+    ok = h > 0 && http_eq(req.method, "POST") && req.content_length == 3;
+    off = (size_t)h + 3;
+    scanned = 0;
+    h = cyon_http_parse_request(pipe + off, strlen(pipe) - off, &scanned, &req);
+    ok = ok && h > 0 && http_eq(req.path, "/q") && req.minor == 0 && req.keep_alive && req.chunked;
+    off += (size_t)h;
+    scanned = 0;
+    h = cyon_http_parse_request(pipe + off, strlen(pipe) - off, &scanned, &req);
+    ok = ok && h > 0 && off + (size_t)h == strlen(pipe) && http_eq(req.path, "/r") && !req.keep_alive;
+    printf("http-parse pipelined: %s\n", ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    static const struct { const char *text; ssize_t want; } bad[] = {
+        { "GET  / HTTP/1.1\r\n\r\n", -EBADMSG },
+        { "GET /\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/2.0\r\n\r\n", -EBADMSG },
+        { "G(T / HTTP/1.1\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nNo colon\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\n : v\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nA: b\x01\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n", -EBADMSG },
+        { "GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", -ENOTSUP },
+    };
+    ok = 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ssize_t got = http_parse(bad[i].text, &req);
+        if (got != bad[i].want) {
+            printf("  bad[%zu]: got %zd want %zd\n", i, got, bad[i].want);
+            ok = 0;
+        }
+    }
+    char many[4096];
+    size_t n = (size_t)sprintf(many, "GET / HTTP/1.1\r\n");
+    for (int i = 0; i <= CYON_HTTP_MAX_HEADERS; i++) n += (size_t)sprintf(many + n, "H%d: v\r\n", i);
+    sprintf(many + n, "\r\n");
+    ok = ok && http_parse(many, &req) == -EMSGSIZE;
+    printf("http-parse malformed: %s\n", ok ? "OK" : "FAIL");
+    return fail | !ok;
+}
+
+#define HTTP_MAX_SEEN 8
+
+static int http_seen;
+static char http_paths[HTTP_MAX_SEEN][16];
+static char *http_bodies[HTTP_MAX_SEEN];
+static size_t http_body_lens[HTTP_MAX_SEEN];
+
+static void http_on_request(cyon_http_ctx_t *x, const cyon_http_request_t *req, void *user) {
+    (void)user;
+    if (http_seen < HTTP_MAX_SEEN) {
+        int i = http_seen;
+        snprintf(http_paths[i], sizeof(http_paths[i]), "%.*s", (int)req->path.len, req->path.ptr);
+        http_bodies[i] = malloc(req->body.len + 1);
+        if (req->body.len) memcpy(http_bodies[i], req->body.ptr, req->body.len);
+        http_body_lens[i] = req->body.len;
+    }
+    http_seen++;
+    cyon_http_respond(x, 200, "text/plain", "ok", 2);
+}
+
+static void http_reset(void) {
+    for (int i = 0; i < HTTP_MAX_SEEN && i < http_seen; i++) free(http_bodies[i]);
+    http_seen = 0;
+}
+
+/* Write text to the server in pieces of step bytes, then collect replies. */
+static size_t http_exchange(const char *text, size_t step, char *reply, size_t cap) {
+    cyon_reactor_t *r;
+    cyon_http_server_t *s;
+    int sv[2];
+    size_t got = 0;
+    if (cyon_reactor_create(&r) != 0) return 0;
+    if (cyon_http_server_create(&s, NULL, http_on_request, NULL) != 0) return 0;
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return 0;
+    cyon_http_server_adopt(s, r, sv[0]);
+    size_t len = strlen(text);
+    for (size_t off = 0; off < len; off += step) {
+        size_t k = len - off < step ? len - off : step;
+        if (write(sv[1], text + off, k) != (ssize_t)k) break;
+        cyon_reactor_run_once(r, 0);
+    }
+    for (int i = 0; i < 20; i++) {
+        cyon_reactor_run_once(r, 10);
+        ssize_t n;
+        while (got + 1 < cap && (n = recv(sv[1], reply + got, cap - 1 - got, MSG_DONTWAIT)) > 0) got += (size_t)n;
+    }
+    reply[got] = '\0';
+    cyon_reactor_destroy(r);
+    cyon_http_server_destroy(s);
+    close(sv[1]);
+    return got;
+}
+
+static int http_count(const char *hay, const char *needle) {
+    int n = 0;
+    for (const char *p = hay; (p = strstr(p, needle)) != NULL; p++) n++;
+    return n;
+}
+
+static int http_server_run(size_t step) {
+    static const char text[] =
+        "POST /cl HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+        "POST /chunked HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "4;name=value\r\nWiki\r\n"
+        "A\r\npedia in\r\n\r\n"
+        "e\r\nchunks.\r\n\r\nxyz\r\n"
+        "0\r\nTrailer-One: 1\r\nTrailer-Two: 2\r\n\r\n"
+        "GET /last HTTP/1.1\r\n\r\n";
+    static const char chunked_body[] = "Wikipedia in\r\nchunks.\r\n\r\nxyz";
+    char reply[8192];
+    http_exchange(text, step, reply, sizeof(reply));
+    int ok = http_seen == 3 && http_count(reply, "HTTP/1.1 200 OK\r\n") == 3;
+    ok = ok && strcmp(http_paths[0], "/cl") == 0 && http_body_lens[0] == 5 && memcmp(http_bodies[0], "hello", 5) == 0;
+    ok = ok && strcmp(http_paths[1], "/chunked") == 0 && http_body_lens[1] == sizeof(chunked_body) - 1
+            && memcmp(http_bodies[1], chunked_body, sizeof(chunked_body) - 1) == 0;
+    ok = ok && strcmp(http_paths[2], "/last") == 0 && http_body_lens[2] == 0;
+    printf("http-server pipelined step=%zu: requests=%d %s\n", step, http_seen, ok ? "OK" : "FAIL");
+    http_reset();
+    return ok ? 0 : 1;
+}
+
+static int http_bad_chunk_run(void) {
+    char reply[8192];
+    http_exchange("POST /bad HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\nab\r\n0\r\n\r\n"
+                  "GET /after HTTP/1.1\r\n\r\n", 7, reply, sizeof(reply));
+    /* the stream is out of sync after a bad frame: 400, and nothing more */
+    int ok = http_seen == 0 && strncmp(reply, "HTTP/1.1 400 ", 13) == 0 && http_count(reply, "HTTP/1.1 ") == 1;
+    printf("http-server bad chunk: %s\n", ok ? "OK" : "FAIL");
+    http_reset();
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);   /* the server may close before all input is written */
+    int fail = http_parse_run();
+    fail |= http_server_run(1);
+    fail |= http_server_run(7);
+    fail |= http_server_run(4096);
+    fail |= http_bad_chunk_run();
+    return fail;
+}
@@ -0,0 +1,202 @@
+/* Block line reader: cyon_scanlines and cyon_scanlines_par must see the
+   same lines, in the same order, as a plain split of the file. The file is
+   laid out so the 1 MiB part boundaries fall right after a newline, on a
+   newline, between "\r" and "\n", and inside a line longer than a whole
+   part (and than a read block); it has empty lines, CRLF lines and no
+   final newline. Each reader also runs on a FIFO, which takes the block
+   path, and an early stop must come back as the callback's value.
+   build: gcc -Iinclude tests/test_lines.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define LINES_MIB ((size_t)1 << 20)
+#define LINES_MUL 0x100000001b3ULL
+
+/* Order-sensitive fold: h = h * MUL + hash(line) per line, so partials
+   combine as acc.h * part.pw + part.h. */
+typedef struct {
+    uint64_t n;
+    uint64_t h;
+    uint64_t pw;
+} lines_fold_t;
+
+static const lines_fold_t lines_identity = { 0, 0, 1 };
+
+static char *lines_buf;
+static size_t lines_len;
+static uint64_t lines_rng = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t lines_next(void) {
+    lines_rng ^= lines_rng << 13;
+    lines_rng ^= lines_rng >> 7;
+    lines_rng ^= lines_rng << 17;
+    return lines_rng;
+}
+
+static uint64_t lines_hash(cyon_slice_t line) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ line.len;
+    for (size_t i = 0; i < line.len; i++) h = (h ^ (unsigned char)line.ptr[i]) * LINES_MUL;
+    return h;
+}
+
+static void lines_fold(lines_fold_t *f, cyon_slice_t line) {
+    f->n++;
+    f->h = f->h * LINES_MUL + lines_hash(line);
+    f->pw *= LINES_MUL;
+}
+
+/* One line of len content bytes (plus "\r" when crlf) and a newline. */
+static void lines_put(size_t len, int crlf, int newline) {
+    for (size_t i = 0; i < len; i++) lines_buf[lines_len++] = (char)('a' + (lines_next() % 26));
+    if (crlf) lines_buf[lines_len++] = '\r';
+    if (newline) lines_buf[lines_len++] = '\n';
+}
+
+static void lines_random_until(size_t target) {
+    while (lines_len + 3100 < target) {
+        uint64_t r = lines_next();
+        lines_put(r % 8 == 0 ? 0 : (size_t)(r >> 8) % 3000, r % 5 == 0, 1);
+    }
+}
+
+/* Finish a line so that its newline lands at offset nl. */
+static void lines_end_at(size_t nl, int crlf) {
+    lines_put(nl - lines_len - (size_t)crlf, crlf, 1);
+}
+
+static void lines_build(void) {
+    lines_buf = malloc(6 * LINES_MIB);
+    lines_random_until(LINES_MIB);
+    lines_end_at(LINES_MIB - 1, 0);            /* a part starts on a fresh line */
+    lines_random_until(2 * LINES_MIB);
+    lines_end_at(2 * LINES_MIB, 0);            /* a part starts on a newline */
+    lines_random_until(3 * LINES_MIB);
+    lines_end_at(3 * LINES_MIB, 1);            /* "\r" | "\n" across parts */
+    lines_random_until(3 * LINES_MIB + LINES_MIB / 2);
+    lines_put(LINES_MIB + LINES_MIB * 3 / 5, 0, 1);   /* spans all of [4, 5) MiB */
+    lines_random_until(5 * LINES_MIB + LINES_MIB / 2);
+    lines_put(1234, 0, 0);                     /* no final newline */
+}
+
+static int lines_layout_ok(void) {
+    return lines_buf[LINES_MIB - 1] == '\n' && lines_buf[2 * LINES_MIB] == '\n'
+        && lines_buf[3 * LINES_MIB - 1] == '\r' && lines_buf[3 * LINES_MIB] == '\n'
+        && !memchr(lines_buf + 4 * LINES_MIB - 1, '\n', LINES_MIB + 2) && lines_buf[lines_len - 1] != '\n';
+}
+
+static lines_fold_t lines_reference(void) {
+    lines_fold_t f = lines_identity;
+    const char *p = lines_buf, *end = lines_buf + lines_len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *e = nl ? nl : end;
+        cyon_slice_t line = { p, (size_t)(e - p) };
+        if (line.len && e[-1] == '\r') line.len--;
+        lines_fold(&f, line);
+        p = nl ? nl + 1 : end;
+    }
+    return f;
+}
+
+typedef struct {
+    lines_fold_t f;
+    uint64_t stop_at;    /* 0 = never */
+} lines_seq_t;
+
+static int lines_seq_cb(cyon_slice_t line, void *user) {
+    lines_seq_t *s = (lines_seq_t*)user;
+    lines_fold(&s->f, line);
+    return s->stop_at && s->f.n == s->stop_at ? 7 : 0;
+}
+
+static int lines_par_cb(cyon_slice_t line, void *partial, void *ctx) {
+    uint64_t *stop_at = (uint64_t*)ctx;
+    lines_fold_t *f = (lines_fold_t*)partial;
+    lines_fold(f, line);
+    /* any part may stop; the line count only has to be reached somewhere */
+    return *stop_at && f->n == *stop_at ? 7 : 0;
+}
+
+static void lines_combine(void *acc, const void *partial, void *ctx) {
+    (void)ctx;
+    lines_fold_t *a = (lines_fold_t*)acc;
+    const lines_fold_t *p = (const lines_fold_t*)partial;
+    a->n += p->n;
+    a->h = a->h * p->pw + p->h;
+    a->pw *= p->pw;
+}
+
+static void *lines_feed_fifo(void *arg) {
+    int fd = open((const char*)arg, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    for (size_t off = 0; off < lines_len;) {
+        ssize_t w = write(fd, lines_buf + off, lines_len - off);
+        if (w <= 0) break;
+        off += (size_t)w;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int lines_run(const char *path, int fifo, const lines_fold_t *want) {
+    const char *kind = fifo ? "fifo" : "file";
+    pthread_t th;
+    lines_seq_t s = { lines_identity, 0 };
+    uint64_t stop_at = 0;
+    lines_fold_t par;
+
+    if (fifo) pthread_create(&th, NULL, lines_feed_fifo, (void*)path);
+    int rc = cyon_scanlines(path, lines_seq_cb, &s);
+    if (fifo) pthread_join(th, NULL);
+    int ok = rc == 0 && s.f.n == want->n && s.f.h == want->h;
+    printf("lines serial %s: rc=%d lines=%llu %s\n", kind, rc, (unsigned long long)s.f.n, ok ? "OK" : "FAIL");
+    int fail = !ok;
+
+    if (fifo) pthread_create(&th, NULL, lines_feed_fifo, (void*)path);
+    rc = cyon_scanlines_par(path, &par, sizeof(par), &lines_identity, lines_par_cb, lines_combine, &stop_at);
+    if (fifo) pthread_join(th, NULL);
+    ok = rc == 0 && par.n == want->n && par.h == want->h;
+    printf("lines parallel %s: rc=%d lines=%llu %s\n", kind, rc, (unsigned long long)par.n, ok ? "OK" : "FAIL");
+    fail |= !ok;
+
+    /* stopping early: the callback's value comes back from both (files
+       only, so no FIFO writer is left blocked) */
+    if (fifo) return fail;
+    s = (lines_seq_t){ lines_identity, 1000 };
+    stop_at = 500;
+    ok = cyon_scanlines(path, lines_seq_cb, &s) == 7 && s.f.n == 1000;
+    ok = ok && cyon_scanlines_par(path, &par, sizeof(par), &lines_identity, lines_par_cb, lines_combine, &stop_at) == 7;
+    printf("lines stop %s: %s\n", kind, ok ? "OK" : "FAIL");
+    return fail | !ok;
+}
+
+int main(void) {
+    lines_build();
+    lines_fold_t want = lines_reference();
+    if (!lines_layout_ok()) {
+        printf("lines layout: FAIL\n");
+        return 1;
+    }
+    char path[] = "/tmp/cyon-lines-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    int fail = write(fd, lines_buf, lines_len) != (ssize_t)lines_len;
+    close(fd);
+    fail |= lines_run(path, 0, &want);
+    unlink(path);
+    if (mkfifo(path, 0600) == 0) {
+        fail |= lines_run(path, 1, &want);
+        unlink(path);
+    }
+    free(lines_buf);
+    return fail;
+}
@@ -0,0 +1,105 @@
+/* cyon_mmap windowing: views anywhere in a file whose size is not a page
+   multiple, through a small window (ranges straddling windows, larger than
+   the window, short at end of file, past it) and a whole-file mapping,
+   plus writes through a window and CREATE leaving a longer file alone.
+   build: gcc -Iinclude tests/test_mmap.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MMAP_FILE_SIZE 100003
+#define MMAP_WINDOW 8192
+
+static unsigned char mmap_byte(uint64_t i) {
+    return (unsigned char)(i * 131 + (i >> 8));
+}
+
+static int mmap_check(cyon_mmap_t *m, uint64_t off, size_t len) {
+    void *p;
+    ssize_t n = cyon_mmap_view(m, off, len, &p);
+    size_t want = off + len > MMAP_FILE_SIZE ? MMAP_FILE_SIZE - (size_t)off : len;
+    if (n != (ssize_t)want) {
+        printf("  view(%llu, %zu) = %zd, want %zu\n", (unsigned long long)off, len, n, want);
+        return 0;
+    }
+    for (size_t i = 0; i < want; i++) {
+        if (((unsigned char*)p)[i] != mmap_byte(off + i)) {
+            printf("  view(%llu, %zu): byte %zu differs\n", (unsigned long long)off, len, i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int mmap_read_run(const char *path, int windowed) {
+    cyon_mmap_t *m;
+    int rc = windowed ? cyon_mmap_open_window(&m, path, CYON_MMAP_READ, MMAP_WINDOW)
+                      : cyon_mmap_open(&m, path, CYON_MMAP_READ, 0);
+    if (rc != 0) {
+        printf("mmap-read: open failed: %s\n", strerror(rc));
+        return 1;
+    }
+    int ok = cyon_mmap_size(m) == MMAP_FILE_SIZE && (cyon_mmap_data(m) == NULL) == windowed;
+    static const size_t lens[] = { 1, 100, 4095, 4096, 4097, MMAP_WINDOW, MMAP_WINDOW + 1, 20000 };
+    /* forward, backward and across window edges */
+    for (uint64_t off = 0; ok && off < MMAP_FILE_SIZE; off += 977)
+        for (size_t j = 0; ok && j < sizeof(lens) / sizeof(lens[0]); j++) ok = mmap_check(m, off, lens[j]);
+    for (uint64_t off = MMAP_FILE_SIZE; ok && off-- > MMAP_FILE_SIZE - 9000;) ok = mmap_check(m, off, 33);
+    for (uint64_t k = 1; ok && k * MMAP_WINDOW < MMAP_FILE_SIZE; k++) ok = mmap_check(m, k * MMAP_WINDOW - 7, 14);
+    ok = ok && mmap_check(m, 0, MMAP_FILE_SIZE) && mmap_check(m, 12345, MMAP_FILE_SIZE);
+    void *p = NULL;
+    ok = ok && cyon_mmap_view(m, MMAP_FILE_SIZE, 10, &p) == 0 && p != NULL;
+    ok = ok && cyon_mmap_view(m, MMAP_FILE_SIZE + 1, 10, &p) == -EINVAL;
+    ok = ok && cyon_mmap_advise(m, 0, 0, CYON_MMAP_SEQUENTIAL) == 0 && mmap_check(m, 50000, 9000);
+    printf("mmap-read %s: %s\n", windowed ? "window" : "whole", ok ? "OK" : "FAIL");
+    cyon_mmap_close(m);
+    return ok ? 0 : 1;
+}
+
+static int mmap_write_run(const char *path) {
+    cyon_mmap_t *m;
+    unlink(path);
+    int ok = cyon_mmap_open_window(&m, path, CYON_MMAP_WRITE | CYON_MMAP_CREATE, MMAP_WINDOW) == 0;
+    ok = ok && cyon_mmap_resize(m, MMAP_FILE_SIZE) == 0 && cyon_mmap_size(m) == MMAP_FILE_SIZE;
+    /* fill in pieces that each straddle a window boundary */
+    for (uint64_t off = 0; ok && off < MMAP_FILE_SIZE; off += 5000) {
+        void *p;
+        ssize_t n = cyon_mmap_view(m, off, 5000, &p);
+        ok = n > 0;
+        for (ssize_t i = 0; ok && i < n; i++) ((unsigned char*)p)[i] = mmap_byte(off + (uint64_t)i);
+    }
+    ok = ok && cyon_mmap_sync(m, 1) == 0;
+    if (ok) cyon_mmap_close(m);
+    /* CREATE with a smaller size must not cut the file back */
+    ok = ok && cyon_mmap_open(&m, path, CYON_MMAP_WRITE | CYON_MMAP_CREATE, 4096) == 0;
+    ok = ok && cyon_mmap_size(m) == MMAP_FILE_SIZE && mmap_check(m, 0, MMAP_FILE_SIZE);
+    if (ok) cyon_mmap_close(m);
+    struct stat st;
+    ok = ok && stat(path, &st) == 0 && st.st_size == MMAP_FILE_SIZE;
+    printf("mmap-write window: %s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    char path[] = "/tmp/cyon-mmap-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    unsigned char *buf = malloc(MMAP_FILE_SIZE);
+    for (size_t i = 0; i < MMAP_FILE_SIZE; i++) buf[i] = mmap_byte(i);
+    int fail = write(fd, buf, MMAP_FILE_SIZE) != MMAP_FILE_SIZE;
+    close(fd);
+    free(buf);
+    fail |= mmap_read_run(path, 1);
+    fail |= mmap_read_run(path, 0);
+    fail |= mmap_write_run(path);
+    fail |= mmap_read_run(path, 1);    /* what the window wrote reads back */
+    unlink(path);
+    return fail;
+}
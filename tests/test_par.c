@@ -0,0 +1,100 @@
+/* Parallel sort and scan against their serial counterparts: qsort for
+   cyon_par_sort (ints and wide records with many duplicates, odd sizes so
+   the last run is short) and a running sum for the prefix scans, in place
+   and out of place. Doubles hold small integers so sums compare exactly.
+   build: gcc -Iinclude tests/test_par.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t key;
+    uint32_t pad;
+    uint64_t a, b;     /* derived from key: checks records move whole */
+} par_rec_t;
+
+static uint64_t par_rng = 88172645463325252ULL;
+
+static uint64_t par_next(void) {
+    par_rng ^= par_rng << 13;
+    par_rng ^= par_rng >> 7;
+    par_rng ^= par_rng << 17;
+    return par_rng;
+}
+
+static int par_cmp_int(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int par_cmp_rec(const void *a, const void *b) {
+    const par_rec_t *x = (const par_rec_t*)a, *y = (const par_rec_t*)b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int par_sort_run(size_t n) {
+    int *v = malloc(n * sizeof(int)), *ref = malloc(n * sizeof(int));
+    par_rec_t *r = malloc(n * sizeof(par_rec_t));
+    uint32_t *keys = malloc(n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (int)(par_next() % (n / 4 + 1)) - (int)(n / 8);
+        keys[i] = (uint32_t)(par_next() % 1000);
+        r[i] = (par_rec_t){ keys[i], 0, keys[i] * 3ULL, ~(uint64_t)keys[i] };
+    }
+    memcpy(ref, v, n * sizeof(int));
+    qsort(ref, n, sizeof(int), par_cmp_int);
+    qsort(keys, n, sizeof(uint32_t), par_cmp_int);
+    int ok = cyon_par_sort(v, n, sizeof(int), par_cmp_int) == 0 && memcmp(v, ref, n * sizeof(int)) == 0;
+    ok = ok && cyon_par_sort(r, n, sizeof(par_rec_t), par_cmp_rec) == 0;
+    for (size_t i = 0; ok && i < n; i++)
+        ok = r[i].key == keys[i] && r[i].a == keys[i] * 3ULL && r[i].b == ~(uint64_t)keys[i];
+    /* already sorted input stays put */
+    ok = ok && cyon_par_sort(v, n, sizeof(int), par_cmp_int) == 0 && memcmp(v, ref, n * sizeof(int)) == 0;
+    printf("par-sort n=%zu threshold=%zu: %s\n", n, cyon_par_threshold(), ok ? "OK" : "FAIL");
+    free(v); free(ref); free(r); free(keys);
+    return ok ? 0 : 1;
+}
+
+static int par_scan_run(size_t n) {
+    int64_t *in = malloc(n * sizeof(int64_t)), *out = malloc(n * sizeof(int64_t)), *ref = malloc(n * sizeof(int64_t));
+    double *fin = malloc(n * sizeof(double)), *fout = malloc(n * sizeof(double)), *fref = malloc(n * sizeof(double));
+    int64_t acc = 0;
+    double facc = 0;
+    for (size_t i = 0; i < n; i++) {
+        in[i] = (int64_t)(par_next() % 2001) - 1000;
+        fin[i] = (double)(int64_t)(par_next() % 201) - 100.0;
+        acc += in[i];
+        ref[i] = acc;
+        facc += fin[i];
+        fref[i] = facc;
+    }
+    int ok = cyon_par_scan_i64(in, out, n) == 0 && memcmp(out, ref, n * sizeof(int64_t)) == 0;
+    ok = ok && cyon_par_scan_f64(fin, fout, n) == 0 && memcmp(fout, fref, n * sizeof(double)) == 0;
+    /* in place */
+    ok = ok && cyon_par_scan_i64(in, in, n) == 0 && memcmp(in, ref, n * sizeof(int64_t)) == 0;
+    ok = ok && cyon_par_scan_f64(fin, fin, n) == 0 && memcmp(fin, fref, n * sizeof(double)) == 0;
+    printf("par-scan n=%zu threshold=%zu: %s\n", n, cyon_par_threshold(), ok ? "OK" : "FAIL");
+    free(in); free(out); free(ref); free(fin); free(fout); free(fref);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int fail = 0;
+    /* below the threshold, just above it, and many runs of uneven length */
+    fail |= par_sort_run(1000);
+    fail |= par_sort_run(cyon_par_threshold() + 1);
+    fail |= par_sort_run(1000003);
+    fail |= par_scan_run(1000);
+    fail |= par_scan_run(cyon_par_threshold() + 1);
+    fail |= par_scan_run(1000003);
+    /* a low threshold forces the parallel path on tiny inputs */
+    cyon_par_set_threshold(16);
+    fail |= par_sort_run(17);
+    fail |= par_sort_run(999);
+    fail |= par_scan_run(17);
+    fail |= par_scan_run(999);
+    return fail;
+}
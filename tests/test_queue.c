@@ -0,0 +1,113 @@
+/* Bounded queues: capacity rounds up to a power of two and a full/empty
+   queue refuses with EAGAIN; under several producers every element arrives
+   exactly once and each producer's elements stay in order (MPMC, MPSC).
+   build: gcc -Iinclude tests/test_queue.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define QUEUE_PRODUCERS 4
+#define QUEUE_CONSUMERS 2
+#define QUEUE_PER_PRODUCER 100000
+
+typedef struct {
+    cyon_queue_t *q;
+    int id;
+    long long *last;            /* consumer: last sequence seen per producer */
+    unsigned char *seen;        /* shared: one byte per element */
+    int bad;
+    long taken;
+} queue_worker_t;
+
+static atomic_long queue_remaining;
+
+static void *queue_produce(void *arg) {
+    queue_worker_t *w = (queue_worker_t*)arg;
+    for (long long i = 0; i < QUEUE_PER_PRODUCER; i++) {
+        unsigned long long v = ((unsigned long long)w->id << 32) | (unsigned long long)i;
+        while (cyon_queue_try_push(w->q, &v) == EAGAIN) sched_yield();
+    }
+    return NULL;
+}
+
+static void *queue_consume(void *arg) {
+    queue_worker_t *w = (queue_worker_t*)arg;
+    while (atomic_load(&queue_remaining) > 0) {
+        unsigned long long v;
+        if (cyon_queue_try_pop(w->q, &v) != 0) { sched_yield(); continue; }
+        atomic_fetch_sub(&queue_remaining, 1);
+        int p = (int)(v >> 32);
+        long long seq = (long long)(v & 0xffffffffu);
+        if (p < 0 || p >= QUEUE_PRODUCERS || seq >= QUEUE_PER_PRODUCER) { w->bad = 1; continue; }
+        if (seq <= w->last[p]) w->bad = 1;      /* one producer's items must not reorder */
+        w->last[p] = seq;
+        if (w->seen[(size_t)p * QUEUE_PER_PRODUCER + (size_t)seq]++) w->bad = 1;
+        w->taken++;
+    }
+    return NULL;
+}
+
+static int queue_capacity_run(int kind, const char *name) {
+    cyon_queue_t *q;
+    int ok = cyon_queue_create(&q, kind, 5, sizeof(int)) == 0 && cyon_queue_capacity(q) == 8;
+    int v, n = 0;
+    for (int i = 0; ok && i < 8; i++) ok = cyon_queue_try_push(q, &i) == 0;
+    v = 99;
+    ok = ok && cyon_queue_try_push(q, &v) == EAGAIN && cyon_queue_size_approx(q) == 8;
+    /* wrap around a few times, always FIFO */
+    for (int round = 0; ok && round < 3; round++) {
+        for (int i = 0; ok && i < 8; i++) ok = cyon_queue_try_pop(q, &v) == 0 && v == n++;
+        ok = ok && cyon_queue_try_pop(q, &v) == EAGAIN;
+        for (int i = 0; ok && i < 8; i++) { int x = n + i; ok = cyon_queue_try_push(q, &x) == 0; }
+    }
+    cyon_queue_destroy(q);
+    ok = ok && cyon_queue_create(&q, kind, 0, sizeof(int)) == EINVAL;
+    ok = ok && cyon_queue_create(&q, 7, 4, sizeof(int)) == EINVAL;
+    printf("queue-capacity %s: %s\n", name, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int queue_order_run(int kind, const char *name, int consumers) {
+    cyon_queue_t *q;
+    if (cyon_queue_create(&q, kind, 64, sizeof(unsigned long long)) != 0) return 1;
+    unsigned char *seen = calloc((size_t)QUEUE_PRODUCERS * QUEUE_PER_PRODUCER, 1);
+    long long last[QUEUE_CONSUMERS][QUEUE_PRODUCERS];
+    queue_worker_t prod[QUEUE_PRODUCERS], cons[QUEUE_CONSUMERS];
+    pthread_t pt[QUEUE_PRODUCERS], ct[QUEUE_CONSUMERS];
+    atomic_store(&queue_remaining, (long)QUEUE_PRODUCERS * QUEUE_PER_PRODUCER);
+    for (int i = 0; i < consumers; i++) {
+        for (int p = 0; p < QUEUE_PRODUCERS; p++) last[i][p] = -1;
+        cons[i] = (queue_worker_t){ q, i, last[i], seen, 0, 0 };
+        pthread_create(&ct[i], NULL, queue_consume, &cons[i]);
+    }
+    for (int i = 0; i < QUEUE_PRODUCERS; i++) {
+        prod[i] = (queue_worker_t){ q, i, NULL, NULL, 0, 0 };
+        pthread_create(&pt[i], NULL, queue_produce, &prod[i]);
+    }
+    for (int i = 0; i < QUEUE_PRODUCERS; i++) pthread_join(pt[i], NULL);
+    for (int i = 0; i < consumers; i++) pthread_join(ct[i], NULL);
+    long taken = 0;
+    int ok = 1;
+    for (int i = 0; i < consumers; i++) { taken += cons[i].taken; ok &= !cons[i].bad; }
+    ok = ok && taken == (long)QUEUE_PRODUCERS * QUEUE_PER_PRODUCER && cyon_queue_size_approx(q) == 0;
+    printf("queue-order %s: taken=%ld %s\n", name, taken, ok ? "OK" : "FAIL");
+    free(seen);
+    cyon_queue_destroy(q);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int fail = queue_capacity_run(CYON_QUEUE_MPMC, "mpmc");
+    fail |= queue_capacity_run(CYON_QUEUE_MPSC, "mpsc");
+    fail |= queue_capacity_run(CYON_QUEUE_SPSC, "spsc");
+    fail |= queue_order_run(CYON_QUEUE_MPMC, "mpmc", QUEUE_CONSUMERS);
+    fail |= queue_order_run(CYON_QUEUE_MPSC, "mpsc", 1);
+    return fail;
+}
@@ -0,0 +1,58 @@
+/* Reactor EOF delivery: the peer writes a few bytes and shuts down its
+   write side at once, so data and FIN can arrive in one edge. on_close must
+   still fire on every backend.
+   build: gcc -Iinclude tests/test_reactor_eof.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static size_t got;
+static int closed;
+
+static size_t eof_on_data(cyon_conn_t *c, const char *data, size_t len, void *user) {
+    (void)c;
+    (void)data;
+    (void)user;
+    got += len;
+    return len;
+}
+
+static void eof_on_close(cyon_conn_t *c, int err, void *user) {
+    (void)c;
+    (void)user;
+    closed = err == 0 ? 1 : -1;
+}
+
+static int eof_run(int backend) {
+    cyon_reactor_t *r;
+    if (cyon_reactor_create_ex(&r, backend) != 0) return 0;   /* backend unavailable */
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return 1;
+    cyon_conn_handlers_t h;
+    memset(&h, 0, sizeof(h));
+    h.on_data = eof_on_data;
+    h.on_close = eof_on_close;
+    got = 0;
+    closed = 0;
+    /* data and FIN are both queued before the reactor first looks */
+    if (write(sv[1], "hello", 5) != 5) return 1;
+    shutdown(sv[1], SHUT_WR);
+    if (cyon_reactor_adopt(r, sv[0], &h, NULL, NULL) != 0) return 1;
+    for (int i = 0; i < 50 && !closed; i++) cyon_reactor_run_once(r, 20);
+    int ok = got == 5 && closed == 1 && cyon_reactor_conn_count(r) == 0;
+    printf("reactor-eof %s: got=%zu closed=%d conns=%zu %s\n", backend == CYON_REACTOR_URING ? "io_uring" : "epoll",
+           got, closed, cyon_reactor_conn_count(r), ok ? "OK" : "FAIL");
+    cyon_reactor_destroy(r);
+    close(sv[1]);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int fail = eof_run(CYON_REACTOR_EPOLL);
+    fail |= eof_run(CYON_REACTOR_URING);
+    return fail;
+}
@@ -0,0 +1,166 @@
+/* Varint and frame codecs: encode/decode round-trips on every length
+   boundary, truncated and non-minimal varints, cyon_frame_parse on whole,
+   partial and oversized frames, then frames through a buffered socketpair
+   up to a clean CYON_BUFCONN_EOF or a stream cut mid-frame.
+   build: gcc -Iinclude tests/test_rpc_frame.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static int frame_varint_run(void) {
+    static const uint64_t vals[] = {
+        0, 1, 127, 128, 255, 300, 16383, 16384, 2097151, 2097152,
+        UINT32_MAX, (uint64_t)1 << 35, (uint64_t)1 << 56, ((uint64_t)1 << 63) - 1, (uint64_t)1 << 63, UINT64_MAX,
+    };
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(vals) / sizeof(vals[0]); i++) {
+        unsigned char buf[CYON_VARINT_MAX + 1];
+        uint64_t v = 0;
+        size_t n = cyon_varint_encode(vals[i], buf);
+        ok = n == cyon_varint_size(vals[i]) && n <= CYON_VARINT_MAX;
+        ok = ok && cyon_varint_decode(buf, n, &v) == (int)n && v == vals[i];
+        /* trailing bytes are not part of the varint */
+        buf[n] = 0xff;
+        ok = ok && cyon_varint_decode(buf, n + 1, &v) == (int)n && v == vals[i];
+        /* every strict prefix is incomplete */
+        for (size_t k = 0; ok && k < n; k++) ok = cyon_varint_decode(buf, k, &v) == 0;
+        if (!ok) printf("  varint %llu failed\n", (unsigned long long)vals[i]);
+    }
+    ok = ok && cyon_varint_size(127) == 1 && cyon_varint_size(128) == 2 && cyon_varint_size(UINT64_MAX) == 10;
+    uint64_t v;
+    static const unsigned char overlong[] = { 0x80, 0x00 };
+    static const unsigned char overlong2[] = { 0xff, 0x80, 0x00 };
+    static const unsigned char too_big[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02 };
+    static const unsigned char too_long[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x81, 0x00 };
+    ok = ok && cyon_varint_decode(overlong, sizeof(overlong), &v) == -EINVAL;
+    ok = ok && cyon_varint_decode(overlong2, sizeof(overlong2), &v) == -EINVAL;
+    ok = ok && cyon_varint_decode(too_big, sizeof(too_big), &v) == -EINVAL;
+    ok = ok && cyon_varint_decode(too_long, sizeof(too_long), &v) == -EINVAL;
+    ok = ok && cyon_varint_decode("\x00", 1, &v) == 1 && v == 0;
+    printf("frame-varint: %s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int frame_parse_run(void) {
+    unsigned char buf[400];
+    const char *msg;
+    size_t len;
+    size_t h = cyon_varint_encode(300, buf);
+    for (int i = 0; i < 300; i++) buf[h + (size_t)i] = (unsigned char)i;
+    int ok = cyon_frame_parse(buf, h + 300, 1000, &msg, &len) == (ssize_t)(h + 300)
+             && len == 300 && msg == (const char*)buf + h;
+    for (size_t k = 0; ok && k < h + 300; k++) ok = cyon_frame_parse(buf, k, 1000, &msg, &len) == 0;
+    ok = ok && cyon_frame_parse(buf, h + 300, 299, &msg, &len) == -EMSGSIZE;
+    /* the size check needs only the header */
+    ok = ok && cyon_frame_parse(buf, h, 299, &msg, &len) == -EMSGSIZE;
+    ok = ok && cyon_frame_parse("\x80\x00", 2, 1000, &msg, &len) == -EINVAL;
+    ok = ok && cyon_frame_parse("\x00", 1, 0, &msg, &len) == 1 && len == 0;
+    ok = ok && cyon_frame_parse(NULL, 0, 0, &msg, &len) == 0;
+    printf("frame-parse: %s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static const size_t frame_sizes[] = { 0, 1, 127, 128, 0, 16383, 16384, 60000, 3 };
+#define FRAME_NSIZES (sizeof(frame_sizes) / sizeof(frame_sizes[0]))
+
+typedef struct {
+    int fd;
+    int cut;     /* end the stream part-way through a frame */
+} frame_writer_t;
+
+static void frame_fill(char *p, size_t len, size_t seed) {
+    for (size_t i = 0; i < len; i++) p[i] = (char)(seed * 31 + i * 7);
+}
+
+static void *frame_write_all(void *arg) {
+    frame_writer_t *w = (frame_writer_t*)arg;
+    cyon_bufconn_t *b;
+    char *payload = malloc(60000);
+    if (cyon_bufconn_create(&b, w->fd, 0, 0) == 0) {
+        for (size_t i = 0; i < FRAME_NSIZES; i++) {
+            frame_fill(payload, frame_sizes[i], i);
+            if (i % 2) {
+                /* the same frame from two pieces */
+                struct iovec iov[2] = { { payload, frame_sizes[i] / 2 },
+                                        { payload + frame_sizes[i] / 2, frame_sizes[i] - frame_sizes[i] / 2 } };
+                cyon_frame_writev(b, iov, 2);
+            } else {
+                cyon_frame_write(b, payload, frame_sizes[i]);
+            }
+        }
+        if (w->cut) {
+            unsigned char head[CYON_VARINT_MAX];
+            cyon_bufconn_write(b, head, cyon_varint_encode(10, head));
+            cyon_bufconn_write(b, "abc", 3);
+        }
+        cyon_bufconn_flush(b);
+        cyon_bufconn_destroy(b);
+    }
+    shutdown(w->fd, SHUT_WR);
+    free(payload);
+    return NULL;
+}
+
+static int frame_stream_run(int cut) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return 1;
+    frame_writer_t w = { sv[1], cut };
+    pthread_t th;
+    pthread_create(&th, NULL, frame_write_all, &w);
+    cyon_bufconn_t *b;
+    int ok = cyon_bufconn_create(&b, sv[0], 0, 0) == 0;
+    char *want = malloc(60000);
+    for (size_t i = 0; ok && i < FRAME_NSIZES; i++) {
+        const char *msg;
+        ssize_t n = cyon_frame_peek(b, &msg, 1 << 20);
+        frame_fill(want, frame_sizes[i], i);
+        ok = n == (ssize_t)frame_sizes[i] && memcmp(msg, want, frame_sizes[i]) == 0;
+        if (!ok) printf("  frame %zu: got %zd want %zu\n", i, n, frame_sizes[i]);
+        cyon_frame_consume(b, frame_sizes[i]);
+    }
+    const char *msg;
+    ssize_t end = cyon_frame_peek(b, &msg, 1 << 20);
+    ok = ok && end == (cut ? -EPIPE : CYON_BUFCONN_EOF);
+    printf("frame-stream %s: end=%zd %s\n", cut ? "cut" : "clean", end, ok ? "OK" : "FAIL");
+    pthread_join(th, NULL);
+    cyon_bufconn_destroy(b);
+    close(sv[0]);
+    close(sv[1]);
+    free(want);
+    return ok ? 0 : 1;
+}
+
+/* Frames over max, or over the read buffer, are refused before reading them. */
+static int frame_limit_run(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return 1;
+    unsigned char head[CYON_VARINT_MAX];
+    size_t h = cyon_varint_encode(1 << 20, head);
+    int ok = write(sv[1], head, h) == (ssize_t)h;
+    cyon_bufconn_t *b;
+    const char *msg;
+    ok = ok && cyon_bufconn_create(&b, sv[0], 4096, 0) == 0;
+    ok = ok && cyon_frame_peek(b, &msg, 1000) == -EMSGSIZE;
+    ok = ok && cyon_frame_peek(b, &msg, (size_t)1 << 30) == -EMSGSIZE;
+    printf("frame-limit: %s\n", ok ? "OK" : "FAIL");
+    cyon_bufconn_destroy(b);
+    close(sv[0]);
+    close(sv[1]);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int fail = frame_varint_run();
+    fail |= frame_parse_run();
+    fail |= frame_stream_run(0);
+    fail |= frame_stream_run(1);
+    fail |= frame_limit_run();
+    return fail;
+}
@@ -0,0 +1,145 @@
+/* Timer wheel cascade: timers placed on every level boundary must fire on
+   exactly their tick when the wheel is stepped one tick at a time, in order
+   when it jumps, never after cancel, and periodic/coarse timers keep their
+   contracts. A 1 s tick keeps the real clock from moving the wheel.
+   build: gcc -Iinclude tests/test_timer_wheel.c libraries/libcyon_std.a -lpthread -lm */
+
+#define _GNU_SOURCE
+#include "cyonstd.h"
+#include <stdio.h>
+#include <string.h>
+
+#define WHEEL_TICK 1000000ULL
+#define WHEEL_MAX_TIMERS 32
+
+static const uint64_t wheel_delays[] = {
+    1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097,
+    262143, 262144, 262145, 300000,
+};
+#define WHEEL_NDELAYS (sizeof(wheel_delays) / sizeof(wheel_delays[0]))
+
+static uint64_t wheel_t0;
+static uint64_t wheel_now;           /* tick being advanced to */
+static uint64_t wheel_fired_at[WHEEL_MAX_TIMERS];
+static int wheel_fired_n[WHEEL_MAX_TIMERS];
+static uint64_t wheel_last;
+static int wheel_ordered;
+
+static void wheel_on_fire(cyon_timer_t *t, void *user) {
+    (void)t;
+    size_t i = (size_t)(uintptr_t)user;
+    wheel_fired_at[i] = wheel_now;
+    wheel_fired_n[i]++;
+}
+
+static void wheel_on_fire_ordered(cyon_timer_t *t, void *user) {
+    (void)user;
+    if (t->expires < wheel_last) wheel_ordered = 0;
+    wheel_last = t->expires;
+    wheel_on_fire(t, user);
+}
+
+static void wheel_reset(void) {
+    memset(wheel_fired_at, 0, sizeof(wheel_fired_at));
+    memset(wheel_fired_n, 0, sizeof(wheel_fired_n));
+}
+
+static void wheel_step(cyon_timer_wheel_t *w, uint64_t k) {
+    wheel_now = k;
+    cyon_timer_wheel_advance(w, wheel_t0 + k * WHEEL_TICK + WHEEL_TICK / 2);
+}
+
+/* Start every delay at tick base and step one tick at a time. */
+static int wheel_exact_run(uint64_t base) {
+    cyon_timer_wheel_t *w;
+    cyon_timer_t t[WHEEL_NDELAYS];
+    wheel_t0 = cyon_time_monotonic_us();
+    if (cyon_timer_wheel_create(&w, WHEEL_TICK) != 0) return 1;
+    wheel_reset();
+    for (uint64_t k = 1; k <= base; k++) wheel_step(w, k);
+    for (size_t i = 0; i < WHEEL_NDELAYS; i++) {
+        cyon_timer_init(&t[i], wheel_on_fire, (void*)(uintptr_t)i);
+        cyon_timer_start(w, &t[i], wheel_delays[i] * WHEEL_TICK, 0, 0);
+    }
+    uint64_t end = base + wheel_delays[WHEEL_NDELAYS - 1] + 2;
+    for (uint64_t k = base + 1; k <= end; k++) wheel_step(w, k);
+    int ok = cyon_timer_wheel_count(w) == 0;
+    for (size_t i = 0; i < WHEEL_NDELAYS; i++) {
+        if (wheel_fired_n[i] != 1 || wheel_fired_at[i] != base + wheel_delays[i]) {
+            printf("  delay %llu from %llu: fired %d time(s) at %llu\n", (unsigned long long)wheel_delays[i],
+                   (unsigned long long)base, wheel_fired_n[i], (unsigned long long)wheel_fired_at[i]);
+            ok = 0;
+        }
+    }
+    printf("timer-wheel exact from tick %llu: %s\n", (unsigned long long)base, ok ? "OK" : "FAIL");
+    cyon_timer_wheel_destroy(w);
+    return ok ? 0 : 1;
+}
+
+/* One advance past everything: all fire once, in expiry order; a cancelled
+   timer stays silent. */
+static int wheel_jump_run(void) {
+    cyon_timer_wheel_t *w;
+    cyon_timer_t t[WHEEL_NDELAYS], gone;
+    wheel_t0 = cyon_time_monotonic_us();
+    if (cyon_timer_wheel_create(&w, WHEEL_TICK) != 0) return 1;
+    wheel_reset();
+    for (size_t i = WHEEL_NDELAYS; i-- > 0;) {
+        cyon_timer_init(&t[i], wheel_on_fire_ordered, (void*)(uintptr_t)i);
+        cyon_timer_start(w, &t[i], wheel_delays[i] * WHEEL_TICK, 0, 0);
+    }
+    cyon_timer_init(&gone, wheel_on_fire, (void*)(uintptr_t)WHEEL_NDELAYS);
+    cyon_timer_start(w, &gone, 4096 * WHEEL_TICK, 0, 0);
+    int ok = cyon_timer_pending(&gone) && cyon_timer_cancel(w, &gone) == 0 && !cyon_timer_pending(&gone);
+    ok = ok && cyon_timer_wheel_count(w) == WHEEL_NDELAYS;
+    wheel_last = 0;
+    wheel_ordered = 1;
+    wheel_now = 400000;
+    size_t fired = cyon_timer_wheel_advance(w, wheel_t0 + 400000 * WHEEL_TICK + WHEEL_TICK / 2);
+    ok = ok && fired == WHEEL_NDELAYS && wheel_ordered && wheel_fired_n[WHEEL_NDELAYS] == 0;
+    for (size_t i = 0; i < WHEEL_NDELAYS; i++) ok = ok && wheel_fired_n[i] == 1;
+    ok = ok && cyon_timer_wheel_count(w) == 0 && cyon_timer_wheel_next_timeout_ms(w) == -1;
+    printf("timer-wheel jump: fired=%zu %s\n", fired, ok ? "OK" : "FAIL");
+    cyon_timer_wheel_destroy(w);
+    return ok ? 0 : 1;
+}
+
+static uint64_t wheel_periodic_at[8];
+static int wheel_periodic_n;
+
+static void wheel_on_periodic(cyon_timer_t *t, void *user) {
+    cyon_timer_wheel_t *w = (cyon_timer_wheel_t*)user;
+    if (wheel_periodic_n < 8) wheel_periodic_at[wheel_periodic_n] = wheel_now;
+    if (++wheel_periodic_n == 5) cyon_timer_cancel(w, t);
+}
+
+static int wheel_periodic_run(void) {
+    cyon_timer_wheel_t *w;
+    cyon_timer_t t, coarse;
+    wheel_t0 = cyon_time_monotonic_us();
+    if (cyon_timer_wheel_create(&w, WHEEL_TICK) != 0) return 1;
+    wheel_reset();
+    wheel_periodic_n = 0;
+    cyon_timer_init(&t, wheel_on_periodic, w);
+    cyon_timer_start(w, &t, 10 * WHEEL_TICK, 60 * WHEEL_TICK, 0);
+    cyon_timer_init(&coarse, wheel_on_fire, (void*)(uintptr_t)0);
+    cyon_timer_start(w, &coarse, 5000 * WHEEL_TICK, 0, CYON_TIMER_COARSE);
+    for (uint64_t k = 1; k <= 10000; k++) wheel_step(w, k);
+    int ok = wheel_periodic_n == 5;
+    for (int i = 0; ok && i < 5; i++) ok = wheel_periodic_at[i] == 10 + 60 * (uint64_t)i;
+    /* coarse: never early, at most one level-2 slot (4096 ticks) late */
+    ok = ok && wheel_fired_n[0] == 1 && wheel_fired_at[0] >= 5000 && wheel_fired_at[0] < 5000 + 4096;
+    ok = ok && cyon_timer_wheel_count(w) == 0;
+    printf("timer-wheel periodic/coarse: periodic=%d coarse_at=%llu %s\n", wheel_periodic_n,
+           (unsigned long long)wheel_fired_at[0], ok ? "OK" : "FAIL");
+    cyon_timer_wheel_destroy(w);
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int fail = wheel_exact_run(0);
+    fail |= wheel_exact_run(4000);      /* level boundaries crossed mid-slot */
+    fail |= wheel_jump_run();
+    fail |= wheel_periodic_run();
+    return fail;
+}